@@ -98,8 +98,10 @@
 #if defined(__GNUC__) && !defined(__APPLE__) && !defined(__MINGW32__) && !defined(__sun)
 	#if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
 		#include <sys/endian.h>
-	#else
+	#elif defined(_arch_dreamcast)
 		#include <machine/endian.h>
+	#else
+		#include <endian.h>
 	#endif
 
 	#if __BYTE_ORDER == __LITTLE_ENDIAN
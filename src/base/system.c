@@ -48,6 +48,8 @@
 
 	#if defined(CONF_FAMILY_KOS)
 		#include <kos.h>
+	#else
+		#include <sys/mman.h>
 	#endif
 
 #elif defined(CONF_FAMILY_WINDOWS)
@@ -262,7 +264,12 @@ void dbg_msg(const char *sys, const char *fmt, ...)
 
 static void logger_stdout(const char *line)
 {
+#if defined(CONF_FAMILY_KOS)
 	dbglog(DBG_INFO, "%s\n", line);
+#else
+	printf("%s\n", line);
+	fflush(stdout);
+#endif
 #if defined(__ANDROID__)
 	__android_log_print(ANDROID_LOG_INFO, "DDNet", "%s", line);
 #endif
@@ -299,8 +306,37 @@ void dbg_logger_file(const char *filename)
 }
 /* */
 
+/* only the number of allocations is tracked. the job pool threads allocate
+too, the lock is initialized statically as lock_create allocates itself */
+#if defined(CONF_FAMILY_KOS)
+static mutex_t mem_lock = MUTEX_INITIALIZER;
+#elif defined(CONF_FAMILY_UNIX)
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void mem_count(int total, int active)
+{
+#if defined(CONF_FAMILY_KOS)
+	mutex_lock(&mem_lock);
+	memory_stats.total_allocations += total;
+	memory_stats.active_allocations += active;
+	mutex_unlock(&mem_lock);
+#elif defined(CONF_FAMILY_UNIX)
+	pthread_mutex_lock(&mem_lock);
+	memory_stats.total_allocations += total;
+	memory_stats.active_allocations += active;
+	pthread_mutex_unlock(&mem_lock);
+#elif defined(CONF_FAMILY_WINDOWS)
+	InterlockedExchangeAdd((volatile LONG *)&memory_stats.total_allocations, total);
+	InterlockedExchangeAdd((volatile LONG *)&memory_stats.active_allocations, active);
+#else
+	#error not implemented on this platform
+#endif
+}
+
 void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment)
 {
+	mem_count(1, 1);
 	return malloc(size);
 }
 
@@ -308,6 +344,7 @@ void mem_free(void *p)
 {
 	if(p)
 	{
+		mem_count(0, -1);
 		free(p);
 	}
 }
@@ -423,6 +460,129 @@ int io_flush(IOHANDLE io)
 	return 0;
 }
 
+int io_map(const char *filename, IOMAP *map, int flags)
+{
+	IOHANDLE file;
+	long size;
+	void *data;
+
+	mem_zero(map, sizeof(*map));
+
+#if defined(CONF_FAMILY_KOS)
+	if(!(flags&IOMAP_COPY))
+	{
+		/* only file systems that keep the file in memory, like the romdisk,
+		   hand it out. the handle has to stay open while it is used */
+		file_t fd = fs_open(filename, O_RDONLY);
+		if(fd != FILEHND_INVALID)
+		{
+			size = (long)fs_total(fd);
+			data = size > 0 ? fs_mmap(fd) : 0;
+			if(data)
+			{
+				map->data = data;
+				map->size = size;
+				map->mapped = 1;
+				map->internal = fd;
+				return 1;
+			}
+			fs_close(fd);
+		}
+	}
+#elif defined(CONF_FAMILY_UNIX)
+	if(!(flags&IOMAP_COPY))
+	{
+		int fd = open(filename, O_RDONLY);
+		if(fd >= 0)
+		{
+			struct stat sb;
+			data = MAP_FAILED;
+			if(fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0)
+				data = mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if(data != MAP_FAILED)
+			{
+				map->data = data;
+				map->size = sb.st_size;
+				map->mapped = 1;
+				return 1;
+			}
+		}
+	}
+#elif defined(CONF_FAMILY_WINDOWS)
+	if(!(flags&IOMAP_COPY))
+	{
+		HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(handle != INVALID_HANDLE_VALUE)
+		{
+			DWORD filesize = GetFileSize(handle, NULL);
+			HANDLE mapping = 0;
+			if(filesize != INVALID_FILE_SIZE && filesize > 0)
+				mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+			CloseHandle(handle);
+			if(mapping)
+			{
+				/* the view keeps the mapping alive */
+				data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+				if(data)
+				{
+					map->data = data;
+					map->size = filesize;
+					map->mapped = 1;
+					return 1;
+				}
+			}
+		}
+	}
+#endif
+
+	if(!(flags&(IOMAP_FALLBACK|IOMAP_COPY)))
+		return 0;
+
+	file = io_open(filename, IOFLAG_READ);
+	if(!file)
+		return 0;
+	size = io_length(file);
+	if(size <= 0)
+	{
+		io_close(file);
+		return 0;
+	}
+	data = mem_alloc(size, 1);
+	if(io_read(file, data, size) != (unsigned)size)
+	{
+		mem_free(data);
+		io_close(file);
+		return 0;
+	}
+	io_close(file);
+
+	map->data = data;
+	map->size = size;
+	return 1;
+}
+
+void io_unmap(IOMAP *map)
+{
+	if(!map->data)
+		return;
+
+	if(!map->mapped)
+		mem_free((void *)map->data);
+	else
+	{
+#if defined(CONF_FAMILY_KOS)
+		fs_close(map->internal);
+#elif defined(CONF_FAMILY_UNIX)
+		munmap((void *)map->data, map->size);
+#elif defined(CONF_FAMILY_WINDOWS)
+		UnmapViewOfFile(map->data);
+#endif
+	}
+	mem_zero(map, sizeof(*map));
+}
+
 void *thread_init(void (*threadfunc)(void *), void *u)
 {
 #if defined(CONF_FAMILY_KOS)
@@ -481,6 +641,22 @@ void thread_yield()
 #endif
 }
 
+int thread_num_cores()
+{
+#if defined(CONF_FAMILY_KOS)
+	return 1;
+#elif defined(CONF_FAMILY_UNIX)
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 1 ? (int)n : 1;
+#elif defined(CONF_FAMILY_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 1 ? (int)info.dwNumberOfProcessors : 1;
+#else
+	#error not implemented
+#endif
+}
+
 void thread_sleep(int milliseconds)
 {
 #if defined(CONF_FAMILY_KOS)
@@ -591,7 +767,7 @@ void lock_unlock(LOCK lock)
 
 #if !defined(CONF_PLATFORM_MACOSX)
 	#if defined(CONF_FAMILY_KOS)
-	void semaphore_init(SEMAPHORE *sem) { sem_init(sem, 1); }
+	void semaphore_init(SEMAPHORE *sem) { sem_init(sem, 0); }
 	void semaphore_wait(SEMAPHORE *sem) { sem_wait(sem); }
 	void semaphore_signal(SEMAPHORE *sem) { sem_signal(sem); }
 	void semaphore_destroy(SEMAPHORE *sem) { sem_destroy(sem); }
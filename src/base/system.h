@@ -322,6 +322,64 @@ int io_close(IOHANDLE io);
 */
 int io_flush(IOHANDLE io);
 
+/*
+	Struct: IOMAP
+		A read-only view of a whole file, see <io_map>.
+
+	Fields:
+		data - The contents of the file.
+		size - Size of the file in bytes.
+		mapped - 1 if the file is mapped, 0 if it was read into memory.
+		internal - Platform data, don't touch.
+*/
+typedef struct
+{
+	const void *data;
+	unsigned size;
+	int mapped;
+	int internal;
+} IOMAP;
+
+enum {
+	IOMAP_FALLBACK = 1,
+	IOMAP_COPY = 2
+};
+
+/*
+	Function: io_map
+		Maps a whole file read-only into memory. Where the platform or
+		the file system can't map it, the file can be read into an
+		allocated buffer instead.
+
+	Parameters:
+		filename - File to map.
+		map - Receives the view. Cleared on failure.
+		flags - IOMAP_FALLBACK reads the file into memory if it can't be
+			mapped, IOMAP_COPY always reads it into memory.
+
+	Returns:
+		Returns 1 on success and 0 on failure.
+
+	Remarks:
+		- Empty files fail.
+		- The view has to be released with <io_unmap>.
+		- A mapped file must not be truncated or rewritten in place
+		while the view is used. On unix, touching the part of the view
+		that is no longer backed by the file raises SIGBUS. Use
+		IOMAP_COPY for files that can change.
+*/
+int io_map(const char *filename, IOMAP *map, int flags);
+
+/*
+	Function: io_unmap
+		Releases a view from <io_map> and clears it. Cleared views are
+		ignored.
+
+	Parameters:
+		map - The view to release.
+*/
+void io_unmap(IOMAP *map);
+
 
 /*
 	Function: io_stdin
@@ -388,6 +446,13 @@ void thread_destroy(void *thread);
 */
 void thread_yield();
 
+/*
+	Function: thread_num_cores
+		Returns the number of processors threads can run on at once,
+		at least 1.
+*/
+int thread_num_cores();
+
 /*
 	Function: thread_detach
 		Puts the thread in the detached thread, guaranteeing that
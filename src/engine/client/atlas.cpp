@@ -0,0 +1,76 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/graphics.h>
+
+#include "atlas.h"
+
+void CAtlasPacker::Reset()
+{
+	m_X = 0;
+	m_Y = 0;
+	m_RowHeight = 0;
+	m_Num = 0;
+}
+
+bool CAtlasPacker::Fits(int Width, int Height)
+{
+	return Width > 0 && Height > 0 && Width+PADDING*2 <= PAGE_WIDTH && Height+PADDING*2 <= PAGE_HEIGHT;
+}
+
+bool CAtlasPacker::Add(int Width, int Height, int *pX, int *pY)
+{
+	if(!Fits(Width, Height))
+		return false;
+
+	int w = Width+PADDING*2;
+	int h = Height+PADDING*2;
+
+	// start a new row
+	if(m_X+w > PAGE_WIDTH)
+	{
+		m_Y += m_RowHeight;
+		m_X = 0;
+		m_RowHeight = 0;
+	}
+	if(m_Y+h > PAGE_HEIGHT)
+		return false;
+
+	*pX = m_X+PADDING;
+	*pY = m_Y+PADDING;
+	m_X += w;
+	m_RowHeight = max(m_RowHeight, h);
+	m_Num++;
+	return true;
+}
+
+int CAtlasPacker::UsedHeight() const
+{
+	int Used = m_Y+m_RowHeight;
+	int Height = 8;
+	while(Height < Used)
+		Height <<= 1;
+	return min(Height, (int)PAGE_HEIGHT);
+}
+
+void CAtlasPacker::Blit(unsigned char *pPage, int x, int y, int Width, int Height, int Format, const unsigned char *pData)
+{
+	int Bpp = Format == CImageInfo::FORMAT_RGB ? 3 : 4;
+	for(int py = -PADDING; py < Height+PADDING; py++)
+	{
+		int sy = clamp(py, 0, Height-1);
+		unsigned char *pDst = &pPage[((y+py)*PAGE_WIDTH + x-PADDING)*4];
+		for(int px = -PADDING; px < Width+PADDING; px++)
+		{
+			int sx = clamp(px, 0, Width-1);
+			const unsigned char *pSrc = &pData[(sy*Width+sx)*Bpp];
+			pDst[0] = pSrc[0];
+			pDst[1] = pSrc[1];
+			pDst[2] = pSrc[2];
+			pDst[3] = Bpp == 4 ? pSrc[3] : 255;
+			pDst += 4;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_ATLAS_H
+#define ENGINE_CLIENT_ATLAS_H
+
+// shelf packer for the shared texture pages. images are placed row by row
+// with a border of repeated edge pixels so filtering does not bleed.
+class CAtlasPacker
+{
+	int m_X;
+	int m_Y;
+	int m_RowHeight;
+	int m_Num;
+
+public:
+	enum
+	{
+		PAGE_WIDTH=1024,
+		PAGE_HEIGHT=512,
+		PADDING=1,
+	};
+
+	CAtlasPacker() { Reset(); }
+
+	void Reset();
+
+	// false if the image does not fit even on an empty page
+	static bool Fits(int Width, int Height);
+	bool Add(int Width, int Height, int *pX, int *pY);
+
+	bool Empty() const { return m_Num == 0; }
+	int UsedHeight() const;
+
+	// copies an rgb or rgba image into the rgba page including its border
+	static void Blit(unsigned char *pPage, int x, int y, int Width, int Height, int Format, const unsigned char *pData);
+};
+
+#endif
@@ -2,8 +2,6 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <new>
 
-#include <kos.h>
-
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h> // qsort
@@ -57,10 +55,14 @@
 	#define _WIN32_WINNT 0x0501
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
+#elif defined(CONF_FAMILY_KOS)
+	#include <kos.h>
 #endif
 
 #include "friends.h"
 #include "serverbrowser.h"
+#include "graphics_null.h"
+#include "mapcache.h"
 #include "client.h"
 
 #include <zlib.h>
@@ -300,6 +302,7 @@ CClient::CClient() : m_DemoPlayer(&m_SnapshotDelta)
 
 	//
 	m_aCurrentMap[0] = 0;
+	m_aCurrentMapPath[0] = 0;
 	m_CurrentMapCrc = 0;
 
 	//
@@ -1080,6 +1083,7 @@ const char *CClient::LoadMap(const char *pName, const char *pFilename, unsigned
 	m_ReceivedSnapshots[g_Config.m_ClDummy] = 0;
 
 	str_copy(m_aCurrentMap, pName, sizeof(m_aCurrentMap));
+	str_copy(m_aCurrentMapPath, pFilename, sizeof(m_aCurrentMapPath));
 	m_CurrentMapCrc = m_pMap->Crc();
 
 	return 0x0;
@@ -1087,7 +1091,7 @@ const char *CClient::LoadMap(const char *pName, const char *pFilename, unsigned
 
 
 
-const char *CClient::LoadMapSearch(const char *pMapName, int WantedCrc)
+const char *CClient::LoadMapSearch(const char *pMapName, int WantedCrc, int WantedSize)
 {
 	const char *pError = 0;
 	char aBuf[128];
@@ -1095,13 +1099,21 @@ const char *CClient::LoadMapSearch(const char *pMapName, int WantedCrc)
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "client", aBuf);
 	SetState(IClient::STATE_LOADING);
 
+	// downloaded before, maybe under another name
+	if(m_MapCache.Find(WantedCrc, WantedSize, aBuf, sizeof(aBuf)))
+	{
+		pError = LoadMap(pMapName, aBuf, WantedCrc);
+		if(!pError)
+			return pError;
+	}
+
 	// try the normal maps folder
 	str_format(aBuf, sizeof(aBuf), "maps/%s.map", pMapName);
 	pError = LoadMap(pMapName, aBuf, WantedCrc);
 	if(!pError)
 		return pError;
 
-	// try the downloaded maps
+	// try the downloaded maps of older versions
 	str_format(aBuf, sizeof(aBuf), "downloadedmaps/%s_%08x.map", pMapName, WantedCrc);
 	pError = LoadMap(pMapName, aBuf, WantedCrc);
 	if(!pError)
@@ -1512,7 +1524,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 				DisconnectWithReason(pError);
 			else
 			{
-				pError = LoadMapSearch(pMap, MapCrc);
+				pError = LoadMapSearch(pMap, MapCrc, MapSize);
 
 				if(!pError)
 				{
@@ -1521,7 +1533,7 @@ void CClient::ProcessServerPacket(CNetChunk *pPacket)
 				}
 				else
 				{
-					str_format(m_aMapdownloadFilename, sizeof(m_aMapdownloadFilename), "downloadedmaps/%s_%08x.map", pMap, MapCrc);
+					CMapCache::Path(MapCrc, MapSize, m_aMapdownloadFilename, sizeof(m_aMapdownloadFilename));
 
 					char aBuf[256];
 					str_format(aBuf, sizeof(aBuf), "starting to download map to '%s'", m_aMapdownloadFilename);
@@ -2110,6 +2122,7 @@ void CClient::FinishMapDownload()
 	pError = LoadMap(m_aMapdownloadName, m_aMapdownloadFilename, m_MapdownloadCrc);
 	if(!pError)
 	{
+		m_MapCache.Add(m_aMapdownloadName, m_MapdownloadCrc, m_MapdownloadAmount);
 		ResetMapDownload();
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "client/network", "loading done");
 		SendReady();
@@ -2117,6 +2130,7 @@ void CClient::FinishMapDownload()
 	else{
 		if(m_MapdownloadFile)
 			io_close(m_MapdownloadFile);
+		Storage()->RemoveFile(m_aMapdownloadFilename, IStorage::TYPE_SAVE);
 		ResetMapDownload();
 		DisconnectWithReason(pError);
 	}
@@ -2484,6 +2498,8 @@ void CClient::InitInterfaces()
 	m_Friends.Init();
 	m_Foes.Init(true);
 
+	m_MapCache.Init(m_pStorage);
+
 	IOHANDLE newsFile = m_pStorage->OpenFile("ddnet-news.txt", IOFLAG_READ, IStorage::TYPE_SAVE);
 	if (newsFile)
 	{
@@ -2500,8 +2516,12 @@ void CClient::Run()
 	srand(time(NULL));
 
 	// init graphics
+	CGraphics_Null *pBenchGraphics = 0;
 	{
-		m_pGraphics = CreateEngineGraphics();
+		if(g_Config.m_DbgBenchDemo[0])
+			m_pGraphics = pBenchGraphics = new CGraphics_Null();
+		else
+			m_pGraphics = CreateEngineGraphics();
 
 		bool RegisterFail = false;
 		RegisterFail = RegisterFail || !Kernel()->RegisterInterface(static_cast<IEngineGraphics*>(m_pGraphics)); // register graphics as both
@@ -2580,6 +2600,21 @@ void CClient::Run()
 	// process pending commands
 	m_pConsole->StoreCommands(false);
 
+	if(g_Config.m_DbgBenchText)
+		RunTextBenchmark();
+
+	if(pBenchGraphics || g_Config.m_DbgBenchText)
+	{
+		if(pBenchGraphics)
+			RunRenderBenchmark(pBenchGraphics);
+		GameClient()->OnShutdown();
+		Disconnect();
+		m_MapCache.Flush();
+		m_pGraphics->Shutdown();
+		m_pSound->Shutdown();
+		return;
+	}
+
 	bool LastD = false;
 	bool LastQ = false;
 	bool LastE = false;
@@ -2773,6 +2808,7 @@ void CClient::Run()
 
 	GameClient()->OnShutdown();
 	Disconnect();
+	m_MapCache.Flush();
 
 	m_pGraphics->Shutdown();
 	m_pSound->Shutdown();
@@ -2949,6 +2985,106 @@ void CClient::DemoSlice(const char *pDstPath)
 	}
 }
 
+void CClient::RunRenderBenchmark(CGraphics_Null *pGraphics)
+{
+	const char *pError = DemoPlayer_Play(g_Config.m_DbgBenchDemo, IStorage::TYPE_ALL);
+	if(pError)
+	{
+		dbg_msg("bench", "failed to play demo '%s': %s", g_Config.m_DbgBenchDemo, pError);
+		return;
+	}
+
+	// every frame moves the demo forward by the same amount, independent of how long it took
+	m_DemoPlayer.SetFixedStep(time_freq()/g_Config.m_DbgBenchFps);
+	pGraphics->ResetStats();
+
+	int64 Total = 0;
+	int64 Worst = 0;
+	int Frames = 0;
+	while(State() == IClient::STATE_DEMOPLAYBACK && m_DemoPlayer.IsPlaying())
+	{
+		int64 Start = time_get();
+		Update();
+		if(State() != IClient::STATE_DEMOPLAYBACK)
+			break;
+		Render();
+		m_pGraphics->Swap();
+		int64 Time = time_get()-Start;
+
+		Total += Time;
+		Worst = max(Worst, Time);
+		Frames++;
+		m_RenderFrames++;
+
+		// the player stops on its own at the end of the demo unless it is paused there
+		if(m_DemoPlayer.BaseInfo()->m_Paused)
+			break;
+	}
+	m_DemoPlayer.SetFixedStep(0);
+
+	const CGraphics_Null::CStats &Stats = pGraphics->Stats();
+	float PerFrame = Frames ? 1.0f/Frames : 0.0f;
+	dbg_msg("bench", "demo='%s' frames=%d", g_Config.m_DbgBenchDemo, Frames);
+	dbg_msg("bench", "cpu %.3fms/frame avg, %.3fms worst", Total*1000.0f/time_freq()*PerFrame, Worst*1000.0f/time_freq());
+	dbg_msg("bench", "vertices %.1f/frame, quads %.1f/frame, draws %.1f/frame from %.1f batches",
+		Stats.m_Vertices*PerFrame, Stats.m_Quads*PerFrame, Stats.m_Draws*PerFrame, Stats.m_Batches*PerFrame);
+	dbg_msg("bench", "state changes %.1f/frame (texture sets %.1f, blend sets %.1f)",
+		Stats.m_StateChanges*PerFrame, Stats.m_TextureSets*PerFrame, Stats.m_BlendSets*PerFrame);
+	dbg_msg("bench", "command stream %.1fk/frame, %d overflows", Stats.m_CommandBytes*PerFrame/1024.0f, Stats.m_CommandOverflows);
+	dbg_msg("bench", "vertex submission %.3fms/frame, %.1fM vertices/s (%s)", Stats.m_SubmitTime*1000.0f/time_freq()*PerFrame,
+		Stats.m_SubmitTime ? Stats.m_Vertices*(float)time_freq()/Stats.m_SubmitTime/1000000.0f : 0.0f, g_Config.m_DbgBenchImmediate ? "immediate" : "packed");
+}
+
+void CClient::RunTextBenchmark()
+{
+	static const char *s_apTexts[] = {
+		"nameless tee",
+		"brainless tee",
+		"*** 'nameless tee' entered and joined the game",
+		"brainless tee: gg, that was close. one more round on this map?",
+		"Score  Name                Clan      Ping",
+		"The server is running a modified version of the game with its own rules, "
+		"check the vote menu for the maps and the settings that can be changed.",
+	};
+	const int NumTexts = sizeof(s_apTexts)/sizeof(s_apTexts[0]);
+
+	ITextRender *pTextRender = Kernel()->RequestInterface<ITextRender>();
+	int Iterations = g_Config.m_DbgBenchText;
+	int OldCache = g_Config.m_GfxTextCache;
+
+	m_pGraphics->MapScreen(0, 0, 300.0f*m_pGraphics->ScreenAspect(), 300.0f);
+	for(int Cache = 0; Cache < 2; Cache++)
+	{
+		g_Config.m_GfxTextCache = Cache;
+
+		float Width = 0.0f;
+		int64 Start = time_get();
+		for(int i = 0; i < Iterations; i++)
+			for(int t = 0; t < NumTexts; t++)
+				Width += pTextRender->TextWidth(0, 10.0f, s_apTexts[t], -1);
+		int64 WidthTime = time_get()-Start;
+
+		Start = time_get();
+		for(int i = 0; i < Iterations; i++)
+		{
+			for(int t = 0; t < NumTexts; t++)
+			{
+				CTextCursor Cursor;
+				pTextRender->SetCursor(&Cursor, 10.0f, 10.0f + t*12.0f, 10.0f, TEXTFLAG_RENDER);
+				Cursor.m_LineWidth = 200.0f;
+				pTextRender->TextEx(&Cursor, s_apTexts[t], -1);
+			}
+		}
+		int64 RenderTime = time_get()-Start;
+
+		float PerCall = 1000000.0f/time_freq()/(Iterations*NumTexts);
+		dbg_msg("bench", "text cache=%d: TextWidth %.2fus/call, TextEx %.2fus/call (%d texts x %d, width sum %.0f)",
+			Cache, WidthTime*PerCall, RenderTime*PerCall, NumTexts, Iterations, Width);
+	}
+	g_Config.m_GfxTextCache = OldCache;
+	m_pGraphics->Swap();
+}
+
 const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 {
 	int Crc;
@@ -3035,7 +3171,7 @@ void CClient::DemoRecorder_Start(const char *pFilename, bool WithTimestamp, int
 		}
 		else
 			str_format(aFilename, sizeof(aFilename), "demos/%s.demo", pFilename);
-		m_DemoRecorder[Recorder]->Start(Storage(), m_pConsole, aFilename, GameClient()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "client");
+		m_DemoRecorder[Recorder]->Start(Storage(), m_pConsole, aFilename, GameClient()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "client", 0, 0, m_aCurrentMapPath);
 	}
 }
 
@@ -3173,7 +3309,9 @@ static CClient *CreateClient()
 		Upstream latency
 */
 
+#if defined(CONF_FAMILY_KOS)
 KOS_INIT_FLAGS(INIT_DEFAULT | INIT_NET);
+#endif
 
 #if defined(CONF_PLATFORM_MACOSX) || defined(__ANDROID__)
 extern "C" int SDL_main(int argc, char **argv_) // ignore_convention
@@ -3345,7 +3483,7 @@ const char* CClient::RaceRecordStart(const char *pFilename)
 	if(State() != STATE_ONLINE)
 		dbg_msg("demorec/record", "client is not online");
 	else
-		m_DemoRecorder[RECORDER_RACE]->Start(Storage(),  m_pConsole, aFilename, GameClient()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "client");
+		m_DemoRecorder[RECORDER_RACE]->Start(Storage(),  m_pConsole, aFilename, GameClient()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "client", 0, 0, m_aCurrentMapPath);
 
 	return m_aCurrentMap;
 }
@@ -77,6 +77,7 @@ class CClient : public IClient, public CDemoPlayer::IListner
 	class CFriends m_Friends;
 	class CFriends m_Foes;
 	class CMapChecker m_MapChecker;
+	class CMapCache m_MapCache;
 
 	char m_aServerAddressStr[256];
 
@@ -113,6 +114,7 @@ class CClient : public IClient, public CDemoPlayer::IListner
 
 	//
 	char m_aCurrentMap[256];
+	char m_aCurrentMapPath[256];
 	unsigned m_CurrentMapCrc;
 
 	bool m_TimeoutCodeSent[2];
@@ -276,7 +278,7 @@ public:
 	virtual const char *ErrorString();
 
 	const char *LoadMap(const char *pName, const char *pFilename, unsigned WantedCrc);
-	const char *LoadMapSearch(const char *pMapName, int WantedCrc);
+	const char *LoadMapSearch(const char *pMapName, int WantedCrc, int WantedSize = -1);
 
 	static int PlayerScoreNameComp(const void *a, const void *b);
 
@@ -302,6 +304,8 @@ public:
 	void InitInterfaces();
 
 	void Run();
+	void RunRenderBenchmark(class CGraphics_Null *pGraphics);
+	void RunTextBenchmark();
 
 	bool CtrlShiftKey(int Key, bool &Last);
 
@@ -5,9 +5,9 @@
 #include <base/math.h>
 
 #include <base/system.h>
-#include <engine/external/pnglite/pnglite.h>
 
 #include <engine/shared/config.h>
+#include <engine/shared/png.h>
 #include <engine/graphics.h>
 #include <engine/storage.h>
 #include <engine/keys.h>
@@ -24,34 +24,61 @@
 #undef GL_MAX_TEXTURE_SIZE
 #define GL_MAX_TEXTURE_SIZE 256
 
+// KGL takes 16-bit texels as they are, twiddled ones skip its own twiddling pass
+#if defined(GL_UNSIGNED_SHORT_4_4_4_4_REV_TWID)
+	#define CONF_TEXTURE_16BIT 1
+#endif
+
+static unsigned PackColor(float r, float g, float b, float a)
+{
+	unsigned R = clamp(round_to_int(r*255.0f), 0, 255);
+	unsigned G = clamp(round_to_int(g*255.0f), 0, 255);
+	unsigned B = clamp(round_to_int(b*255.0f), 0, 255);
+	unsigned A = clamp(round_to_int(a*255.0f), 0, 255);
+#if defined(GL_BGRA)
+	return (A<<24)|(R<<16)|(G<<8)|B;
+#else
+	// plain rgba byte order
+	return (A<<24)|(B<<16)|(G<<8)|R;
+#endif
+}
+
 void CGraphics_PVR::Flush()
 {
 	if(m_NumVertices == 0)
 		return;
 
+	// the arrays point at m_aVertices, see Init
 	if(m_RenderEnable)
-	{
-		glBegin(g_Config.m_GfxQuadAsTriangle ? GL_TRIANGLES : GL_QUADS);
-
-		for (int i=0; i<m_NumVertices; i++)
-		{
-			glColor4f(m_aVertices[i].m_Color.r, m_aVertices[i].m_Color.g, m_aVertices[i].m_Color.b, m_aVertices[i].m_Color.a);
-			glTexCoord2f(m_aVertices[i].m_Tex.u, m_aVertices[i].m_Tex.v);
-			glVertex3f(m_aVertices[i].m_Pos.x, m_aVertices[i].m_Pos.y, m_aVertices[i].m_Pos.z);
-		}
-
-		glEnd();
-	}
+		glDrawArrays(g_Config.m_GfxQuadAsTriangle ? GL_TRIANGLES : GL_QUADS, 0, m_NumVertices);
 
 	// Reset pointer
 	m_NumVertices = 0;
 }
 
-void CGraphics_PVR::AddVertices(int Count)
+void CGraphics_PVR::SetTexCoord(int Corner, float u, float v)
 {
-	m_NumVertices += Count;
-	if((m_NumVertices + Count) >= MAX_VERTICES)
+	// atlas images map their 0..1 range onto their part of the page
+	m_aTexture[Corner].u = m_aUVOffset[0] + u*m_aUVScale[0];
+	m_aTexture[Corner].v = m_aUVOffset[1] + v*m_aUVScale[1];
+}
+
+CGraphics_PVR::CVertex *CGraphics_PVR::AddVertices(int Count)
+{
+	// make room before writing, never after
+	if(m_NumVertices + Count > MAX_VERTICES)
 		Flush();
+	CVertex *pVertices = &m_aVertices[m_NumVertices];
+	m_NumVertices += Count;
+	return pVertices;
+}
+
+void CGraphics_PVR::SetVertex(CVertex *pVertex, float x, float y, int Corner)
+{
+	pVertex->m_Pos.x = x;
+	pVertex->m_Pos.y = y;
+	pVertex->m_Tex = m_aTexture[Corner];
+	pVertex->m_Color = m_aColor[Corner];
 }
 
 void CGraphics_PVR::Rotate(const CPoint &rCenter, CVertex *pPoints, int NumPoints)
@@ -70,41 +97,6 @@ void CGraphics_PVR::Rotate(const CPoint &rCenter, CVertex *pPoints, int NumPoint
 	}
 }
 
-unsigned char CGraphics_PVR::Sample(int w, int h, const unsigned char *pData, int u, int v, int Offset, int ScaleW, int ScaleH, int Bpp)
-{
-	int Value = 0;
-	for(int x = 0; x < ScaleW; x++)
-		for(int y = 0; y < ScaleH; y++)
-			Value += pData[((v+y)*w+(u+x))*Bpp+Offset];
-	return Value/(ScaleW*ScaleH);
-}
-
-unsigned char *CGraphics_PVR::Rescale(int Width, int Height, int NewWidth, int NewHeight, int Format, const unsigned char *pData)
-{
-	unsigned char *pTmpData;
-	int ScaleW = Width/NewWidth;
-	int ScaleH = Height/NewHeight;
-
-	int Bpp = 3;
-	if(Format == CImageInfo::FORMAT_RGBA)
-		Bpp = 4;
-
-	pTmpData = (unsigned char *)mem_alloc(NewWidth*NewHeight*Bpp, 1);
-
-	int c = 0;
-	for(int y = 0; y < NewHeight; y++)
-		for(int x = 0; x < NewWidth; x++, c++)
-		{
-			pTmpData[c*Bpp] = Sample(Width, Height, pData, x*ScaleW, y*ScaleH, 0, ScaleW, ScaleH, Bpp);
-			pTmpData[c*Bpp+1] = Sample(Width, Height, pData, x*ScaleW, y*ScaleH, 1, ScaleW, ScaleH, Bpp);
-			pTmpData[c*Bpp+2] = Sample(Width, Height, pData, x*ScaleW, y*ScaleH, 2, ScaleW, ScaleH, Bpp);
-			if(Bpp == 4)
-				pTmpData[c*Bpp+3] = Sample(Width, Height, pData, x*ScaleW, y*ScaleH, 3, ScaleW, ScaleH, Bpp);
-		}
-
-	return pTmpData;
-}
-
 CGraphics_PVR::CGraphics_PVR()
 {
 	m_NumVertices = 0;
@@ -125,6 +117,15 @@ CGraphics_PVR::CGraphics_PVR()
 
 	m_RenderEnable = true;
 	m_DoScreenshot = false;
+
+	m_pAtlasData = 0;
+	m_AtlasPage = -1;
+	m_AtlasDepth = 0;
+
+	m_CurTexture = -2;
+	m_CurBlend = -1;
+	m_aUVOffset[0] = m_aUVOffset[1] = 0.0f;
+	m_aUVScale[0] = m_aUVScale[1] = 1.0f;
 }
 
 void CGraphics_PVR::ClipEnable(int x, int y, int w, int h)
@@ -155,21 +156,35 @@ void CGraphics_PVR::ClipDisable()
 	//glDisable(GL_SCISSOR_TEST);
 }
 
+void CGraphics_PVR::SetBlend(int Blend)
+{
+	if(Blend == m_CurBlend)
+		return;
+
+	Flush();
+	m_CurBlend = Blend;
+	if(Blend == BLEND_NONE)
+		glDisable(GL_BLEND);
+	else
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, Blend == BLEND_ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
+
 void CGraphics_PVR::BlendNone()
 {
-	glDisable(GL_BLEND);
+	SetBlend(BLEND_NONE);
 }
 
 void CGraphics_PVR::BlendNormal()
 {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	SetBlend(BLEND_NORMAL);
 }
 
 void CGraphics_PVR::BlendAdditive()
 {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	SetBlend(BLEND_ADDITIVE);
 }
 
 void CGraphics_PVR::WrapNormal()
@@ -189,6 +204,7 @@ int CGraphics_PVR::MemoryUsage() const
 
 void CGraphics_PVR::MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY)
 {
+	Flush();
 	m_ScreenX0 = TopLeftX;
 	m_ScreenY0 = TopLeftY;
 	m_ScreenX1 = BottomRightX;
@@ -209,6 +225,7 @@ void CGraphics_PVR::GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottom
 void CGraphics_PVR::LinesBegin()
 {
 	dbg_assert(m_Drawing == 0, "called Graphics()->LinesBegin twice");
+	Flush();
 	m_Drawing = DRAWING_LINES;
 	SetColor(1,1,1,1);
 }
@@ -226,23 +243,11 @@ void CGraphics_PVR::LinesDraw(const CLineItem *pArray, int Num)
 
 	for(int i = 0; i < Num; ++i)
 	{
-		m_aVertices[m_NumVertices + 2*i].m_Pos.x = pArray[i].m_X0;
-		m_aVertices[m_NumVertices + 2*i].m_Pos.y = pArray[i].m_Y0;
-		m_aVertices[m_NumVertices + 2*i].m_Tex = m_aTexture[0];
-		m_aVertices[m_NumVertices + 2*i].m_Color = m_aColor[0];
-
-		m_aVertices[m_NumVertices + 2*i + 1].m_Pos.x = pArray[i].m_X1;
-		m_aVertices[m_NumVertices + 2*i + 1].m_Pos.y = pArray[i].m_Y1;
-		m_aVertices[m_NumVertices + 2*i + 1].m_Tex = m_aTexture[1];
-		m_aVertices[m_NumVertices + 2*i + 1].m_Color = m_aColor[1];
-
-		m_aVertices[m_NumVertices + 2*i + 2].m_Pos.x = pArray[i].m_X1;
-		m_aVertices[m_NumVertices + 2*i + 2].m_Pos.y = pArray[i].m_Y1;
-		m_aVertices[m_NumVertices + 2*i + 2].m_Tex = m_aTexture[1];
-		m_aVertices[m_NumVertices + 2*i + 2].m_Color = m_aColor[1];
+		CVertex *pVertices = AddVertices(3);
+		SetVertex(&pVertices[0], pArray[i].m_X0, pArray[i].m_Y0, 0);
+		SetVertex(&pVertices[1], pArray[i].m_X1, pArray[i].m_Y1, 1);
+		SetVertex(&pVertices[2], pArray[i].m_X1, pArray[i].m_Y1, 1);
 	}
-
-	AddVertices(3*Num);
 }
 
 int CGraphics_PVR::UnloadTexture(int Index)
@@ -253,18 +258,248 @@ int CGraphics_PVR::UnloadTexture(int Index)
 	if(Index < 0)
 		return 0;
 
+	int Page = m_aTextures[Index].m_Page;
+	m_aTextures[Index].m_Page = -1;
 	m_aTextures[Index].m_Next = m_FirstFreeTexture;
 	m_TextureMemoryUsage -= m_aTextures[Index].m_MemSize;
 	m_FirstFreeTexture = Index;
+
+	// the page goes away with its last image
+	if(Page >= 0 && --m_aTextures[Page].m_Refs == 0 && Page != m_AtlasPage)
+	{
+		Flush();
+		if(m_CurTexture == Page)
+			m_CurTexture = -2;
+		glDeleteTextures(1, &m_aTextures[Page].m_Tex);
+		m_aTextures[Page].m_Next = m_FirstFreeTexture;
+		m_TextureMemoryUsage -= m_aTextures[Page].m_MemSize;
+		m_FirstFreeTexture = Page;
+	}
 	return 0;
 }
 
+int CGraphics_PVR::AllocTexture()
+{
+	int Tex = m_FirstFreeTexture;
+	m_FirstFreeTexture = m_aTextures[Tex].m_Next;
+	m_aTextures[Tex].m_Next = -1;
+	m_aTextures[Tex].m_MemSize = 0;
+	m_aTextures[Tex].m_Flags = 0;
+	m_aTextures[Tex].m_Page = -1;
+	m_aTextures[Tex].m_Refs = 0;
+	return Tex;
+}
+
+void CGraphics_PVR::AtlasBegin()
+{
+	m_AtlasDepth++;
+}
+
+void CGraphics_PVR::AtlasEnd()
+{
+	dbg_assert(m_AtlasDepth > 0, "called Graphics()->AtlasEnd without begin");
+	if(--m_AtlasDepth > 0)
+		return;
+	UploadAtlasPage();
+	if(m_pAtlasData)
+		mem_free(m_pAtlasData);
+	m_pAtlasData = 0;
+}
+
+int CGraphics_PVR::AddAtlasImage(int Width, int Height, int Format, const unsigned char *pData)
+{
+	int x, y;
+	if(!CAtlasPacker::Fits(Width, Height))
+		return -1;
+	if(!m_AtlasPacker.Add(Width, Height, &x, &y))
+	{
+		UploadAtlasPage();
+		if(!m_AtlasPacker.Add(Width, Height, &x, &y))
+			return -1;
+	}
+
+	if(m_AtlasPage < 0)
+	{
+		m_AtlasPage = AllocTexture();
+		m_aTextures[m_AtlasPage].m_Tex = 0;
+		if(!m_pAtlasData)
+			m_pAtlasData = (unsigned char *)mem_alloc(CAtlasPacker::PAGE_WIDTH*CAtlasPacker::PAGE_HEIGHT*4, 1);
+		mem_zero(m_pAtlasData, CAtlasPacker::PAGE_WIDTH*CAtlasPacker::PAGE_HEIGHT*4);
+	}
+
+	CAtlasPacker::Blit(m_pAtlasData, x, y, Width, Height, Format, pData);
+
+	int Tex = AllocTexture();
+	m_aTextures[Tex].m_Page = m_AtlasPage;
+	m_aTextures[Tex].m_aRect[0] = x;
+	m_aTextures[Tex].m_aRect[1] = y;
+	m_aTextures[Tex].m_aRect[2] = Width;
+	m_aTextures[Tex].m_aRect[3] = Height;
+	m_aTextures[m_AtlasPage].m_Refs++;
+	return Tex;
+}
+
+void CGraphics_PVR::UploadAtlasPage()
+{
+	if(m_AtlasPage < 0)
+		return;
+
+	CTexture *pPage = &m_aTextures[m_AtlasPage];
+	int Height = m_AtlasPacker.UsedHeight();
+
+	// every image was unloaded before the page was done
+	if(pPage->m_Refs == 0)
+	{
+		pPage->m_Next = m_FirstFreeTexture;
+		m_FirstFreeTexture = m_AtlasPage;
+		m_AtlasPage = -1;
+		m_AtlasPacker.Reset();
+		return;
+	}
+
+	Flush();
+	glGenTextures(1, &pPage->m_Tex);
+	glBindTexture(GL_TEXTURE_2D, pPage->m_Tex);
+	m_CurTexture = -2;
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, CAtlasPacker::PAGE_WIDTH, Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_pAtlasData);
+
+	pPage->m_aRect[0] = 0;
+	pPage->m_aRect[1] = 0;
+	pPage->m_aRect[2] = CAtlasPacker::PAGE_WIDTH;
+	pPage->m_aRect[3] = Height;
+	pPage->m_MemSize = CAtlasPacker::PAGE_WIDTH*Height*4;
+	m_TextureMemoryUsage += pPage->m_MemSize;
+
+	if(g_Config.m_Debug)
+		dbg_msg("graphics/atlas", "page %d, %d images, 1024x%d", m_AtlasPage, pPage->m_Refs, Height);
+
+	m_AtlasPage = -1;
+	m_AtlasPacker.Reset();
+}
+
 int CGraphics_PVR::LoadTextureRawSub(int TextureID, int x, int y, int Width, int Height, int Format, const void *pData)
 {
     return 0;
 }
 
+int CGraphics_PVR::TextureOptions(int Flags)
+{
+	int Options = 0;
+	if(Flags&TEXLOAD_NORESAMPLE)
+		Options |= CTextureConverter::OPTION_NORESAMPLE;
+	if(g_Config.m_GfxTextureQuality == 0)
+		Options |= CTextureConverter::OPTION_LOWQUALITY;
+	return Options;
+}
+
+bool CGraphics_PVR::UseTextureCache(int Format, int Flags) const
+{
+#if !defined(CONF_TEXTURE_16BIT)
+	// the cached texels are quantized, only worth it where they are uploaded as they are
+	return false;
+#endif
+	// atlas pages keep rgba pixels and are built at runtime
+	return g_Config.m_GfxTextureCache && !g_Config.m_DbgStress &&
+		(Format == CImageInfo::FORMAT_RGBA || Format == CImageInfo::FORMAT_RGB) &&
+		!(Flags&TEXLOAD_ATLAS && m_AtlasDepth > 0 && g_Config.m_GfxAtlas);
+}
+
+int CGraphics_PVR::LoadCachedTexture(unsigned Hash, int Options)
+{
+	char aFilename[64];
+	CTextureConverter::CacheName(aFilename, sizeof(aFilename), Hash, Options);
+	IOHANDLE File = m_pStorage->OpenFile(aFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+		return -1;
+
+	CTextureConverter::CHeader Header;
+	unsigned short *pTexels = CTextureConverter::Load(File, &Header);
+	io_close(File);
+	if(!pTexels)
+		return -1;
+	if(Header.m_Hash != Hash)
+	{
+		mem_free(pTexels);
+		return -1;
+	}
+
+	// the pending batch was meant for the texture bound right now
+	Flush();
+	int Tex = UploadTexture(&Header, pTexels);
+	mem_free(pTexels);
+	return Tex;
+}
+
+void CGraphics_PVR::SaveCachedTexture(const CTextureConverter::CHeader *pHeader, int Options, const unsigned short *pData)
+{
+	char aFilename[64];
+	CTextureConverter::CacheName(aFilename, sizeof(aFilename), pHeader->m_Hash, Options);
+	IOHANDLE File = m_pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	bool Result = CTextureConverter::Save(File, pHeader, pData);
+	io_close(File);
+	if(!Result)
+		m_pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	else if(g_Config.m_Debug)
+		dbg_msg("graphics/texcache", "stored %s", aFilename);
+}
+
+int CGraphics_PVR::UploadTexture(const CTextureConverter::CHeader *pHeader, const unsigned short *pData)
+{
+	int Width = pHeader->m_Width;
+	int Height = pHeader->m_Height;
+	int Tex = AllocTexture();
+
+	glGenTextures(1, &m_aTextures[Tex].m_Tex);
+	glBindTexture(GL_TEXTURE_2D, m_aTextures[Tex].m_Tex);
+	m_CurTexture = -2;
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+#if defined(CONF_TEXTURE_16BIT)
+	static const int s_aTypes[CTextureConverter::NUM_FORMATS] = {
+		GL_UNSIGNED_SHORT_5_6_5, GL_UNSIGNED_SHORT_1_5_5_5_REV, GL_UNSIGNED_SHORT_4_4_4_4_REV};
+	static const int s_aTwiddledTypes[CTextureConverter::NUM_FORMATS] = {
+		GL_UNSIGNED_SHORT_5_6_5_TWID, GL_UNSIGNED_SHORT_1_5_5_5_REV_TWID, GL_UNSIGNED_SHORT_4_4_4_4_REV_TWID};
+	int Oglformat = pHeader->m_Format == CTextureConverter::FORMAT_RGB565 ? GL_RGB : GL_RGBA;
+	int Type = pHeader->m_Flags&CTextureConverter::FLAG_TWIDDLED ? s_aTwiddledTypes[pHeader->m_Format] : s_aTypes[pHeader->m_Format];
+	glTexImage2D(GL_TEXTURE_2D, 0, Oglformat, Width, Height, 0, Oglformat, Type, pData);
+	m_aTextures[Tex].m_MemSize = Width*Height*2;
+#else
+	// UseTextureCache keeps 32-bit builds away from here
+	dbg_assert(0, "16-bit texture upload without CONF_TEXTURE_16BIT");
+#endif
+
+	m_aTextures[Tex].m_aRect[0] = 0;
+	m_aTextures[Tex].m_aRect[1] = 0;
+	m_aTextures[Tex].m_aRect[2] = Width;
+	m_aTextures[Tex].m_aRect[3] = Height;
+
+	m_TextureMemoryUsage += m_aTextures[Tex].m_MemSize;
+	return Tex;
+}
+
 int CGraphics_PVR::LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags)
+{
+	bool Cache = UseTextureCache(Format, Flags);
+	unsigned Hash = 0;
+	if(Cache)
+	{
+		Hash = CTextureConverter::Hash(pData, Width*Height*(Format == CImageInfo::FORMAT_RGBA ? 4 : 3));
+		int Tex = LoadCachedTexture(Hash, TextureOptions(Flags));
+		if(Tex >= 0)
+			return Tex;
+	}
+	return LoadTextureImpl(Width, Height, Format, pData, StoreFormat, Flags, Cache, Hash);
+}
+
+int CGraphics_PVR::LoadTextureImpl(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags, bool Cache, unsigned Hash)
 {
 	uint8_t* pTexData = (uint8_t*)pData;
 	uint8_t* pTmpData = 0;
@@ -275,32 +510,39 @@ int CGraphics_PVR::LoadTextureRaw(int Width, int Height, int Format, const void
 	if(g_Config.m_DbgStress)
 		return 	m_InvalidTexture;
 
-	// grab texture
-	Tex = m_FirstFreeTexture;
-	m_FirstFreeTexture = m_aTextures[Tex].m_Next;
-	m_aTextures[Tex].m_Next = -1;
+	// the pending batch was meant for the texture bound right now
+	Flush();
 
-	if(!(Flags&TEXLOAD_NORESAMPLE) && (Format == CImageInfo::FORMAT_RGBA || Format == CImageInfo::FORMAT_RGB))
+	if(Cache)
 	{
-		if(Width > GL_MAX_TEXTURE_SIZE || Height > GL_MAX_TEXTURE_SIZE)
-		{
-			int NewWidth = min(Width, GL_MAX_TEXTURE_SIZE);
-			float div = NewWidth/(float)Width;
-			int NewHeight = Height * div;
-			pTmpData = Rescale(Width, Height, NewWidth, NewHeight, Format, pTexData);
-			pTexData = pTmpData;
-			Width = NewWidth;
-			Height = NewHeight;
-		}
-		else if(Width > 16 && Height > 16 && g_Config.m_GfxTextureQuality == 0)
+		CTextureConverter::CHeader Header;
+		int Options = TextureOptions(Flags);
+		unsigned short *pTexels = CTextureConverter::Build(Width, Height, Format, pTexData, Options, true, &Header);
+		Header.m_Hash = Hash;
+		SaveCachedTexture(&Header, Options, pTexels);
+		Tex = UploadTexture(&Header, pTexels);
+		mem_free(pTexels);
+		return Tex;
+	}
+
+	pTmpData = CTextureConverter::Downscale(&Width, &Height, Format, pTexData, TextureOptions(Flags));
+	if(pTmpData)
+		pTexData = pTmpData;
+
+	if(Flags&TEXLOAD_ATLAS && m_AtlasDepth > 0 && g_Config.m_GfxAtlas && (Format == CImageInfo::FORMAT_RGBA || Format == CImageInfo::FORMAT_RGB))
+	{
+		Tex = AddAtlasImage(Width, Height, Format, pTexData);
+		if(Tex >= 0)
 		{
-			pTmpData = Rescale(Width, Height, Width/2, Height/2, Format, pTexData);
-			pTexData = pTmpData;
-			Width /= 2;
-			Height /= 2;
+			if(pTmpData)
+				mem_free(pTmpData);
+			return Tex;
 		}
 	}
 
+	// grab texture
+	Tex = AllocTexture();
+
 	int PixelSize = 4;
 	if(StoreFormat == CImageInfo::FORMAT_RGB)
 		PixelSize = 3;
@@ -315,6 +557,7 @@ int CGraphics_PVR::LoadTextureRaw(int Width, int Height, int Format, const void
 
 	glGenTextures(1, &m_aTextures[Tex].m_Tex);
 	glBindTexture(GL_TEXTURE_2D, m_aTextures[Tex].m_Tex);
+	m_CurTexture = -2;
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -326,6 +569,10 @@ int CGraphics_PVR::LoadTextureRaw(int Width, int Height, int Format, const void
 	{
 		m_aTextures[Tex].m_MemSize = Width*Height*PixelSize;
 	}
+	m_aTextures[Tex].m_aRect[0] = 0;
+	m_aTextures[Tex].m_aRect[1] = 0;
+	m_aTextures[Tex].m_aRect[2] = Width;
+	m_aTextures[Tex].m_aRect[3] = Height;
 
 	m_TextureMemoryUsage += m_aTextures[Tex].m_MemSize;
 	return Tex;
@@ -340,12 +587,37 @@ int CGraphics_PVR::LoadTexture(const char *pFilename, int StorageType, int Store
 
 	if(l < 3)
 		return m_InvalidTexture;
-	if(LoadPNG(&Img, pFilename, StorageType))
+
+	char aCompleteFilename[512];
+	IOMAP Map;
+	if(!m_pStorage->MapFile(pFilename, StorageType, &Map, true, aCompleteFilename, sizeof(aCompleteFilename)))
+	{
+		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
+		return m_InvalidTexture;
+	}
+
+	// the cache is keyed by the file, a hit skips the png decoding too
+	unsigned Hash = 0;
+	bool Cache = UseTextureCache(CImageInfo::FORMAT_RGBA, Flags);
+	if(Cache)
+	{
+		Hash = CTextureConverter::Hash(Map.data, Map.size);
+		ID = LoadCachedTexture(Hash, TextureOptions(Flags));
+		if(ID >= 0)
+		{
+			io_unmap(&Map);
+			return ID;
+		}
+	}
+
+	bool Loaded = CPngLoader::Load(&Map, aCompleteFilename, &Img);
+	io_unmap(&Map);
+	if(Loaded)
 	{
 		if (StoreFormat == CImageInfo::FORMAT_AUTO)
 			StoreFormat = Img.m_Format;
 
-		ID = LoadTextureRaw(Img.m_Width, Img.m_Height, Img.m_Format, Img.m_pData, StoreFormat, Flags);
+		ID = LoadTextureImpl(Img.m_Width, Img.m_Height, Img.m_Format, Img.m_pData, StoreFormat, Flags, Cache, Hash);
 		mem_free(Img.m_pData);
 		if(ID != m_InvalidTexture && g_Config.m_Debug)
 			dbg_msg("graphics/texture", "loaded %s", pFilename);
@@ -357,50 +629,7 @@ int CGraphics_PVR::LoadTexture(const char *pFilename, int StorageType, int Store
 
 int CGraphics_PVR::LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType)
 {
-	char aCompleteFilename[512];
-	unsigned char *pBuffer;
-	png_t Png; // ignore_convention
-
-	// open file for reading
-	png_init(0,0); // ignore_convention
-
-	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aCompleteFilename, sizeof(aCompleteFilename));
-	if(File)
-		io_close(File);
-	else
-	{
-		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
-		return 0;
-	}
-
-	int Error = png_open_file(&Png, aCompleteFilename); // ignore_convention
-	if(Error != PNG_NO_ERROR)
-	{
-		dbg_msg("game/png", "failed to open file. filename='%s'", aCompleteFilename);
-		if(Error != PNG_FILE_ERROR)
-			png_close_file(&Png); // ignore_convention
-		return 0;
-	}
-
-	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA)) // ignore_convention
-	{
-		dbg_msg("game/png", "invalid format. filename='%s'", aCompleteFilename);
-		png_close_file(&Png); // ignore_convention
-		return 0;
-	}
-
-	pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
-	png_get_data(&Png, pBuffer); // ignore_convention
-	png_close_file(&Png); // ignore_convention
-
-	pImg->m_Width = Png.width; // ignore_convention
-	pImg->m_Height = Png.height; // ignore_convention
-	if(Png.color_type == PNG_TRUECOLOR) // ignore_convention
-		pImg->m_Format = CImageInfo::FORMAT_RGB;
-	else if(Png.color_type == PNG_TRUECOLOR_ALPHA) // ignore_convention
-		pImg->m_Format = CImageInfo::FORMAT_RGBA;
-	pImg->m_pData = pBuffer;
-	return 1;
+	return CPngLoader::Load(m_pStorage, pFilename, StorageType, pImg);
 }
 
 void CGraphics_PVR::ScreenshotDirect(const char *pFilename)
@@ -412,19 +641,45 @@ void CGraphics_PVR::TextureSet(int TextureID)
 {
 	dbg_assert(m_Drawing == 0, "called Graphics()->TextureSet within begin");
 
+	m_aUVOffset[0] = m_aUVOffset[1] = 0.0f;
+	m_aUVScale[0] = m_aUVScale[1] = 1.0f;
+
 	if(TextureID == -1)
 	{
-		glDisable(GL_TEXTURE_2D);
+		if(m_CurTexture != -1)
+		{
+			Flush();
+			glDisable(GL_TEXTURE_2D);
+			m_CurTexture = -1;
+		}
+		return;
 	}
-	else
+
+	// images on the same atlas page keep drawing into one batch
+	const CTexture *pTex = &m_aTextures[TextureID];
+	int Page = pTex->m_Page >= 0 ? pTex->m_Page : TextureID;
+	if(pTex->m_Page >= 0)
+	{
+		const CTexture *pPage = &m_aTextures[Page];
+		m_aUVOffset[0] = pTex->m_aRect[0]/(float)pPage->m_aRect[2];
+		m_aUVOffset[1] = pTex->m_aRect[1]/(float)pPage->m_aRect[3];
+		m_aUVScale[0] = pTex->m_aRect[2]/(float)pPage->m_aRect[2];
+		m_aUVScale[1] = pTex->m_aRect[3]/(float)pPage->m_aRect[3];
+	}
+
+	if(Page != m_CurTexture)
 	{
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, m_aTextures[TextureID].m_Tex);
+		Flush();
+		if(m_CurTexture < 0)
+			glEnable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, m_aTextures[Page].m_Tex);
+		m_CurTexture = Page;
 	}
 }
 
 void CGraphics_PVR::Clear(float r, float g, float b)
 {
+	Flush();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glClearColor(r, g, b, 1.0f);
     glClearDepth(1.0f);
@@ -444,7 +699,8 @@ void CGraphics_PVR::QuadsBegin()
 void CGraphics_PVR::QuadsEnd()
 {
 	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsEnd without begin");
-	Flush();
+	// the vertices stay queued until the state changes, so consecutive
+	// batches with the same texture and blend mode end up in one draw
 	m_Drawing = 0;
 }
 
@@ -459,44 +715,35 @@ void CGraphics_PVR::SetColorVertex(const CColorVertex *pArray, int Num)
 	dbg_assert(m_Drawing != 0, "called Graphics()->SetColorVertex without begin");
 
 	for(int i = 0; i < Num; ++i)
-	{
-		m_aColor[pArray[i].m_Index].r = pArray[i].m_R;
-		m_aColor[pArray[i].m_Index].g = pArray[i].m_G;
-		m_aColor[pArray[i].m_Index].b = pArray[i].m_B;
-		m_aColor[pArray[i].m_Index].a = pArray[i].m_A;
-	}
+		m_aColor[pArray[i].m_Index] = PackColor(pArray[i].m_R, pArray[i].m_G, pArray[i].m_B, pArray[i].m_A);
 }
 
 void CGraphics_PVR::SetColor(float r, float g, float b, float a)
 {
 	dbg_assert(m_Drawing != 0, "called Graphics()->SetColor without begin");
-	CColorVertex Array[4] = {
-		CColorVertex(0, r, g, b, a),
-		CColorVertex(1, r, g, b, a),
-		CColorVertex(2, r, g, b, a),
-		CColorVertex(3, r, g, b, a)};
-	SetColorVertex(Array, 4);
+	unsigned Color = PackColor(r, g, b, a);
+	for(int i = 0; i < 4; ++i)
+		m_aColor[i] = Color;
 }
 
 void CGraphics_PVR::QuadsSetSubset(float TlU, float TlV, float BrU, float BrV)
 {
 	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsSetSubset without begin");
 
-	m_aTexture[0].u = TlU;	m_aTexture[1].u = BrU;
-	m_aTexture[0].v = TlV;	m_aTexture[1].v = TlV;
-
-	m_aTexture[3].u = TlU;	m_aTexture[2].u = BrU;
-	m_aTexture[3].v = BrV;	m_aTexture[2].v = BrV;
+	SetTexCoord(0, TlU, TlV);
+	SetTexCoord(1, BrU, TlV);
+	SetTexCoord(2, BrU, BrV);
+	SetTexCoord(3, TlU, BrV);
 }
 
 void CGraphics_PVR::QuadsSetSubsetFree(
 	float x0, float y0, float x1, float y1,
 	float x2, float y2, float x3, float y3)
 {
-	m_aTexture[0].u = x0; m_aTexture[0].v = y0;
-	m_aTexture[1].u = x1; m_aTexture[1].v = y1;
-	m_aTexture[2].u = x2; m_aTexture[2].v = y2;
-	m_aTexture[3].u = x3; m_aTexture[3].v = y3;
+	SetTexCoord(0, x0, y0);
+	SetTexCoord(1, x1, y1);
+	SetTexCoord(2, x2, y2);
+	SetTexCoord(3, x3, y3);
 }
 
 void CGraphics_PVR::QuadsDraw(CQuadItem *pArray, int Num)
@@ -510,164 +757,102 @@ void CGraphics_PVR::QuadsDraw(CQuadItem *pArray, int Num)
 	QuadsDrawTL(pArray, Num);
 }
 
+void CGraphics_PVR::AddQuad(const float *pX, const float *pY, const int *pCorners)
+{
+	if(g_Config.m_GfxQuadAsTriangle)
+	{
+		CVertex *pVertices = AddVertices(6);
+		SetVertex(&pVertices[0], pX[0], pY[0], pCorners[0]);
+		SetVertex(&pVertices[1], pX[1], pY[1], pCorners[1]);
+		SetVertex(&pVertices[2], pX[2], pY[2], pCorners[2]);
+		pVertices[3] = pVertices[0];
+		pVertices[4] = pVertices[2];
+		SetVertex(&pVertices[5], pX[3], pY[3], pCorners[3]);
+	}
+	else
+	{
+		CVertex *pVertices = AddVertices(4);
+		for(int i = 0; i < 4; i++)
+			SetVertex(&pVertices[i], pX[i], pY[i], pCorners[i]);
+	}
+}
+
 void CGraphics_PVR::QuadsDrawTL(const CQuadItem *pArray, int Num)
 {
+	static const int s_aCorners[4] = {0, 1, 2, 3};
 	CPoint Center;
 	Center.z = 0;
 
 	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawTL without begin");
 
-	if(g_Config.m_GfxQuadAsTriangle)
+	for(int i = 0; i < Num; ++i)
 	{
-		for(int i = 0; i < Num; ++i)
-		{
-			// first triangle
-			m_aVertices[m_NumVertices + 6*i].m_Pos.x = pArray[i].m_X;
-			m_aVertices[m_NumVertices + 6*i].m_Pos.y = pArray[i].m_Y;
-			m_aVertices[m_NumVertices + 6*i].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 6*i].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 6*i + 1].m_Pos.x = pArray[i].m_X + pArray[i].m_Width;
-			m_aVertices[m_NumVertices + 6*i + 1].m_Pos.y = pArray[i].m_Y;
-			m_aVertices[m_NumVertices + 6*i + 1].m_Tex = m_aTexture[1];
-			m_aVertices[m_NumVertices + 6*i + 1].m_Color = m_aColor[1];
-
-			m_aVertices[m_NumVertices + 6*i + 2].m_Pos.x = pArray[i].m_X + pArray[i].m_Width;
-			m_aVertices[m_NumVertices + 6*i + 2].m_Pos.y = pArray[i].m_Y + pArray[i].m_Height;
-			m_aVertices[m_NumVertices + 6*i + 2].m_Tex = m_aTexture[2];
-			m_aVertices[m_NumVertices + 6*i + 2].m_Color = m_aColor[2];
-
-			// second triangle
-			m_aVertices[m_NumVertices + 6*i + 3].m_Pos.x = pArray[i].m_X;
-			m_aVertices[m_NumVertices + 6*i + 3].m_Pos.y = pArray[i].m_Y;
-			m_aVertices[m_NumVertices + 6*i + 3].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 6*i + 3].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 6*i + 4].m_Pos.x = pArray[i].m_X + pArray[i].m_Width;
-			m_aVertices[m_NumVertices + 6*i + 4].m_Pos.y = pArray[i].m_Y + pArray[i].m_Height;
-			m_aVertices[m_NumVertices + 6*i + 4].m_Tex = m_aTexture[2];
-			m_aVertices[m_NumVertices + 6*i + 4].m_Color = m_aColor[2];
-
-			m_aVertices[m_NumVertices + 6*i + 5].m_Pos.x = pArray[i].m_X;
-			m_aVertices[m_NumVertices + 6*i + 5].m_Pos.y = pArray[i].m_Y + pArray[i].m_Height;
-			m_aVertices[m_NumVertices + 6*i + 5].m_Tex = m_aTexture[3];
-			m_aVertices[m_NumVertices + 6*i + 5].m_Color = m_aColor[3];
-
-			if(m_Rotation != 0)
-			{
-				Center.x = pArray[i].m_X + pArray[i].m_Width/2;
-				Center.y = pArray[i].m_Y + pArray[i].m_Height/2;
-
-				Rotate(Center, &m_aVertices[m_NumVertices + 6*i], 6);
-			}
-		}
+		float aX[4] = {pArray[i].m_X, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X};
+		float aY[4] = {pArray[i].m_Y, pArray[i].m_Y, pArray[i].m_Y + pArray[i].m_Height, pArray[i].m_Y + pArray[i].m_Height};
+		AddQuad(aX, aY, s_aCorners);
 
-		AddVertices(3*2*Num);
-	}
-	else
-	{
-		for(int i = 0; i < Num; ++i)
+		if(m_Rotation != 0)
 		{
-			m_aVertices[m_NumVertices + 4*i].m_Pos.x = pArray[i].m_X;
-			m_aVertices[m_NumVertices + 4*i].m_Pos.y = pArray[i].m_Y;
-			m_aVertices[m_NumVertices + 4*i].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 4*i].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 4*i + 1].m_Pos.x = pArray[i].m_X + pArray[i].m_Width;
-			m_aVertices[m_NumVertices + 4*i + 1].m_Pos.y = pArray[i].m_Y;
-			m_aVertices[m_NumVertices + 4*i + 1].m_Tex = m_aTexture[1];
-			m_aVertices[m_NumVertices + 4*i + 1].m_Color = m_aColor[1];
-
-			m_aVertices[m_NumVertices + 4*i + 2].m_Pos.x = pArray[i].m_X + pArray[i].m_Width;
-			m_aVertices[m_NumVertices + 4*i + 2].m_Pos.y = pArray[i].m_Y + pArray[i].m_Height;
-			m_aVertices[m_NumVertices + 4*i + 2].m_Tex = m_aTexture[2];
-			m_aVertices[m_NumVertices + 4*i + 2].m_Color = m_aColor[2];
-
-			m_aVertices[m_NumVertices + 4*i + 3].m_Pos.x = pArray[i].m_X;
-			m_aVertices[m_NumVertices + 4*i + 3].m_Pos.y = pArray[i].m_Y + pArray[i].m_Height;
-			m_aVertices[m_NumVertices + 4*i + 3].m_Tex = m_aTexture[3];
-			m_aVertices[m_NumVertices + 4*i + 3].m_Color = m_aColor[3];
-
-			if(m_Rotation != 0)
-			{
-				Center.x = pArray[i].m_X + pArray[i].m_Width/2;
-				Center.y = pArray[i].m_Y + pArray[i].m_Height/2;
-
-				Rotate(Center, &m_aVertices[m_NumVertices + 4*i], 4);
-			}
-		}
+			int Count = g_Config.m_GfxQuadAsTriangle ? 6 : 4;
+			Center.x = pArray[i].m_X + pArray[i].m_Width/2;
+			Center.y = pArray[i].m_Y + pArray[i].m_Height/2;
 
-		AddVertices(4*Num);
+			Rotate(Center, &m_aVertices[m_NumVertices - Count], Count);
+		}
 	}
 }
 
 void CGraphics_PVR::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
 {
+	static const int s_aCorners[4] = {0, 1, 3, 2};
+
 	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawFreeform without begin");
 
-	if(g_Config.m_GfxQuadAsTriangle)
+	for(int i = 0; i < Num; ++i)
 	{
-		for(int i = 0; i < Num; ++i)
-		{
-			m_aVertices[m_NumVertices + 6*i].m_Pos.x = pArray[i].m_X0;
-			m_aVertices[m_NumVertices + 6*i].m_Pos.y = pArray[i].m_Y0;
-			m_aVertices[m_NumVertices + 6*i].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 6*i].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 6*i + 1].m_Pos.x = pArray[i].m_X1;
-			m_aVertices[m_NumVertices + 6*i + 1].m_Pos.y = pArray[i].m_Y1;
-			m_aVertices[m_NumVertices + 6*i + 1].m_Tex = m_aTexture[1];
-			m_aVertices[m_NumVertices + 6*i + 1].m_Color = m_aColor[1];
-
-			m_aVertices[m_NumVertices + 6*i + 2].m_Pos.x = pArray[i].m_X3;
-			m_aVertices[m_NumVertices + 6*i + 2].m_Pos.y = pArray[i].m_Y3;
-			m_aVertices[m_NumVertices + 6*i + 2].m_Tex = m_aTexture[3];
-			m_aVertices[m_NumVertices + 6*i + 2].m_Color = m_aColor[3];
-
-			m_aVertices[m_NumVertices + 6*i + 3].m_Pos.x = pArray[i].m_X0;
-			m_aVertices[m_NumVertices + 6*i + 3].m_Pos.y = pArray[i].m_Y0;
-			m_aVertices[m_NumVertices + 6*i + 3].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 6*i + 3].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 6*i + 4].m_Pos.x = pArray[i].m_X3;
-			m_aVertices[m_NumVertices + 6*i + 4].m_Pos.y = pArray[i].m_Y3;
-			m_aVertices[m_NumVertices + 6*i + 4].m_Tex = m_aTexture[3];
-			m_aVertices[m_NumVertices + 6*i + 4].m_Color = m_aColor[3];
-
-			m_aVertices[m_NumVertices + 6*i + 5].m_Pos.x = pArray[i].m_X2;
-			m_aVertices[m_NumVertices + 6*i + 5].m_Pos.y = pArray[i].m_Y2;
-			m_aVertices[m_NumVertices + 6*i + 5].m_Tex = m_aTexture[2];
-			m_aVertices[m_NumVertices + 6*i + 5].m_Color = m_aColor[2];
-		}
+		float aX[4] = {pArray[i].m_X0, pArray[i].m_X1, pArray[i].m_X3, pArray[i].m_X2};
+		float aY[4] = {pArray[i].m_Y0, pArray[i].m_Y1, pArray[i].m_Y3, pArray[i].m_Y2};
+		AddQuad(aX, aY, s_aCorners);
+	}
+}
+
+void CGraphics_PVR::QuadsDrawTextured(const CTexturedQuadItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 2, 3};
 
-		AddVertices(3*2*Num);
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawTextured without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		for(int c = 0; c < 4; c++)
+			SetTexCoord(c, pArray[i].m_aU[c], pArray[i].m_aV[c]);
+
+		float aX[4] = {pArray[i].m_X, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X};
+		float aY[4] = {pArray[i].m_Y, pArray[i].m_Y, pArray[i].m_Y + pArray[i].m_Height, pArray[i].m_Y + pArray[i].m_Height};
+		AddQuad(aX, aY, s_aCorners);
 	}
-	else
+}
+
+void CGraphics_PVR::QuadsDrawPrepared(const CPreparedQuadItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 2, 3};
+
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawPrepared without begin");
+
+	for(int i = 0; i < Num; ++i)
 	{
-		for(int i = 0; i < Num; ++i)
+		for(int c = 0; c < 4; c++)
 		{
-			m_aVertices[m_NumVertices + 4*i].m_Pos.x = pArray[i].m_X0;
-			m_aVertices[m_NumVertices + 4*i].m_Pos.y = pArray[i].m_Y0;
-			m_aVertices[m_NumVertices + 4*i].m_Tex = m_aTexture[0];
-			m_aVertices[m_NumVertices + 4*i].m_Color = m_aColor[0];
-
-			m_aVertices[m_NumVertices + 4*i + 1].m_Pos.x = pArray[i].m_X1;
-			m_aVertices[m_NumVertices + 4*i + 1].m_Pos.y = pArray[i].m_Y1;
-			m_aVertices[m_NumVertices + 4*i + 1].m_Tex = m_aTexture[1];
-			m_aVertices[m_NumVertices + 4*i + 1].m_Color = m_aColor[1];
-
-			m_aVertices[m_NumVertices + 4*i + 2].m_Pos.x = pArray[i].m_X3;
-			m_aVertices[m_NumVertices + 4*i + 2].m_Pos.y = pArray[i].m_Y3;
-			m_aVertices[m_NumVertices + 4*i + 2].m_Tex = m_aTexture[3];
-			m_aVertices[m_NumVertices + 4*i + 2].m_Color = m_aColor[3];
-
-			m_aVertices[m_NumVertices + 4*i + 3].m_Pos.x = pArray[i].m_X2;
-			m_aVertices[m_NumVertices + 4*i + 3].m_Pos.y = pArray[i].m_Y2;
-			m_aVertices[m_NumVertices + 4*i + 3].m_Tex = m_aTexture[2];
-			m_aVertices[m_NumVertices + 4*i + 3].m_Color = m_aColor[2];
+			const float *pColor = pArray[i].m_aColors[c];
+			SetTexCoord(c, pArray[i].m_aU[c], pArray[i].m_aV[c]);
+
+			// most items have one color, pack it once
+			if(c > 0 && mem_comp(pColor, pArray[i].m_aColors[c-1], sizeof(pArray[i].m_aColors[c])) == 0)
+				m_aColor[c] = m_aColor[c-1];
+			else
+				m_aColor[c] = PackColor(pColor[0], pColor[1], pColor[2], pColor[3]);
 		}
-
-		AddVertices(4*Num);
+		AddQuad(pArray[i].m_aX, pArray[i].m_aY, s_aCorners);
 	}
 }
 
@@ -731,6 +916,18 @@ int CGraphics_PVR::Init()
 	glEnable(GL_ALPHA_TEST);
 	glDepthMask(0);
 
+	// vertices are handed over in one go from m_aVertices
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(CVertex), &m_aVertices[0].m_Pos);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(CVertex), &m_aVertices[0].m_Tex);
+#if defined(GL_BGRA)
+	glColorPointer(GL_BGRA, GL_UNSIGNED_BYTE, sizeof(CVertex), &m_aVertices[0].m_Color);
+#else
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(CVertex), &m_aVertices[0].m_Color);
+#endif
+
 	// create null texture, will get id=0
 	static const unsigned char aNullTextureData[] = {
 		0xff,0x00,0x00,0xff, 0xff,0x00,0x00,0xff, 0x00,0xff,0x00,0xff, 0x00,0xff,0x00,0xff,
@@ -787,6 +984,7 @@ void CGraphics_PVR::TakeCustomScreenshot(const char *pFilename)
 
 void CGraphics_PVR::Swap()
 {
+	Flush();
 	glutSwapBuffers();
 }
 
@@ -3,6 +3,10 @@
 #ifndef ENGINE_CLIENT_GRAPHICS_H
 #define ENGINE_CLIENT_GRAPHICS_H
 
+#include <engine/shared/texconv.h>
+
+#include "atlas.h"
+
 class CGraphics_PVR : public IEngineGraphics
 {
 protected:
@@ -11,29 +15,33 @@ protected:
 
 	//
 	typedef struct { float x, y, z; } CPoint;
-	typedef struct { float r, g, b, a; } CColor;
 	typedef struct { float u, v; } CTexCoord;
 
+	// laid out for glDrawArrays, the color is packed 32-bit argb
 	struct CVertex
 	{
 		CPoint m_Pos;
-		CColor m_Color;
 		CTexCoord m_Tex;
+		unsigned m_Color;
 	};
 
 	enum
 	{
-		MAX_VERTICES = 32*1024,
+		MAX_VERTICES = 8*1024,
 		MAX_TEXTURES = 1024*4,
 
 		DRAWING_QUADS=1,
-		DRAWING_LINES=2
+		DRAWING_LINES=2,
+
+		BLEND_NONE=0,
+		BLEND_NORMAL,
+		BLEND_ADDITIVE,
 	};
 
 	CVertex m_aVertices[MAX_VERTICES];
 	int m_NumVertices;
 
-	CColor m_aColor[4];
+	unsigned m_aColor[4];
 	CTexCoord m_aTexture[4];
 
 	bool m_RenderEnable;
@@ -56,18 +64,45 @@ protected:
 		int m_MemSize;
 		int m_Flags;
 		int m_Next;
+		int m_Page; // slot of the atlas page holding this image, -1 if it has its own texture
+		int m_Refs; // images living on this page
+		int m_aRect[4]; // x, y, w, h on the page, a page covers itself
 	};
 
 	CTexture m_aTextures[MAX_TEXTURES];
 	int m_FirstFreeTexture;
 	int m_TextureMemoryUsage;
 
+	// atlas page being filled, uploaded when it is full or on AtlasEnd
+	CAtlasPacker m_AtlasPacker;
+	unsigned char *m_pAtlasData;
+	int m_AtlasPage;
+	int m_AtlasDepth; // AtlasBegin calls without their AtlasEnd
+
+	// bound state, batches are only flushed when it really changes
+	int m_CurTexture;
+	int m_CurBlend;
+	float m_aUVOffset[2];
+	float m_aUVScale[2];
+
 	void Flush();
-	void AddVertices(int Count);
+	CVertex *AddVertices(int Count);
+	void SetTexCoord(int Corner, float u, float v);
+	void SetBlend(int Blend);
+	int AllocTexture();
+	int AddAtlasImage(int Width, int Height, int Format, const unsigned char *pData);
+	void UploadAtlasPage();
+	void SetVertex(CVertex *pVertex, float x, float y, int Corner);
+	void AddQuad(const float *pX, const float *pY, const int *pCorners);
 	void Rotate(const CPoint &rCenter, CVertex *pPoints, int NumPoints);
 
-	static unsigned char Sample(int w, int h, const unsigned char *pData, int u, int v, int Offset, int ScaleW, int ScaleH, int Bpp);
-	static unsigned char *Rescale(int Width, int Height, int NewWidth, int NewHeight, int Format, const unsigned char *pData);
+	// 16-bit textures, converted once and kept in texcache/
+	static int TextureOptions(int Flags);
+	bool UseTextureCache(int Format, int Flags) const;
+	int LoadCachedTexture(unsigned Hash, int Options);
+	void SaveCachedTexture(const CTextureConverter::CHeader *pHeader, int Options, const unsigned short *pData);
+	int UploadTexture(const CTextureConverter::CHeader *pHeader, const unsigned short *pData);
+	int LoadTextureImpl(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags, bool Cache, unsigned Hash);
 
 public:
 	CGraphics_PVR();
@@ -103,6 +138,9 @@ public:
 
 	virtual void TextureSet(int TextureID);
 
+	virtual void AtlasBegin();
+	virtual void AtlasEnd();
+
 	virtual void Clear(float r, float g, float b);
 
 	virtual void QuadsBegin();
@@ -120,6 +158,8 @@ public:
 	virtual void QuadsDraw(CQuadItem *pArray, int Num);
 	virtual void QuadsDrawTL(const CQuadItem *pArray, int Num);
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
+	virtual void QuadsDrawTextured(const CTexturedQuadItem *pArray, int Num);
+	virtual void QuadsDrawPrepared(const CPreparedQuadItem *pArray, int Num);
 	virtual void QuadsText(float x, float y, float Size, const char *pText);
 
 	virtual int Init();
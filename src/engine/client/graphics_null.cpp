@@ -0,0 +1,730 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/config.h>
+#include <engine/shared/png.h>
+#include <engine/storage.h>
+
+#include <math.h> // cosf, sinf
+
+#include "graphics_null.h"
+
+static unsigned PackColor(float r, float g, float b, float a)
+{
+	return (clamp(round_to_int(a*255.0f), 0, 255)<<24) | (clamp(round_to_int(r*255.0f), 0, 255)<<16) |
+		(clamp(round_to_int(g*255.0f), 0, 255)<<8) | clamp(round_to_int(b*255.0f), 0, 255);
+}
+
+bool CGraphics_Null::AddCommand(int Cmd, const void *pData, int Size)
+{
+	if(m_CommandSize+1+Size > COMMAND_BUFFER_SIZE)
+	{
+		// the stream only lives for one frame, start over and remember it
+		m_Stats.m_CommandOverflows++;
+		m_CommandSize = 0;
+		if(1+Size > COMMAND_BUFFER_SIZE)
+			return false;
+	}
+
+	m_aCommands[m_CommandSize++] = Cmd;
+	mem_copy(&m_aCommands[m_CommandSize], pData, Size);
+	m_CommandSize += Size;
+	m_Stats.m_CommandBytes += 1+Size;
+	return true;
+}
+
+void CGraphics_Null::SetState(int Cmd, int *pCur, int Value)
+{
+	if(*pCur == Value)
+		return;
+	Flush();
+	*pCur = Value;
+	AddCommand(Cmd, &Value, sizeof(Value));
+	m_Stats.m_StateChanges++;
+}
+
+// what the immediate mode backend did, every vertex as three calls with
+// float arguments
+void CGraphics_Null::SubmitImmediate()
+{
+	for(int i = 0; i < m_NumVertices; i++)
+	{
+		const CVertex *pVertex = &m_aVertices[i];
+		unsigned Color = pVertex->m_Color;
+		float aColor[4] = {((Color>>16)&0xff)/255.0f, ((Color>>8)&0xff)/255.0f, (Color&0xff)/255.0f, (Color>>24)/255.0f};
+		float aTexCoord[2] = {pVertex->m_U, pVertex->m_V};
+		float aPos[3] = {pVertex->m_X, pVertex->m_Y, 0.0f};
+		AddCommand(CMD_COLOR, aColor, sizeof(aColor));
+		AddCommand(CMD_TEXCOORD, aTexCoord, sizeof(aTexCoord));
+		AddCommand(CMD_VERTEX, aPos, sizeof(aPos));
+	}
+}
+
+void CGraphics_Null::Flush()
+{
+	if(m_NumVertices == 0)
+		return;
+
+	int64 Start = time_get();
+	unsigned char aHeader[1+sizeof(int)];
+	aHeader[0] = m_Drawing == DRAWING_LINES ? PRIMTYPE_LINES : PRIMTYPE_QUADS;
+	mem_copy(&aHeader[1], &m_NumVertices, sizeof(int));
+	if(!AddCommand(CMD_DRAW, aHeader, sizeof(aHeader)))
+		m_Stats.m_CommandOverflows++;
+	else if(g_Config.m_DbgBenchImmediate)
+		SubmitImmediate();
+	else if(m_CommandSize+m_NumVertices*(int)sizeof(CVertex) <= COMMAND_BUFFER_SIZE)
+	{
+		mem_copy(&m_aCommands[m_CommandSize], m_aVertices, m_NumVertices*sizeof(CVertex));
+		m_CommandSize += m_NumVertices*sizeof(CVertex);
+		m_Stats.m_CommandBytes += m_NumVertices*sizeof(CVertex);
+	}
+	else
+		m_Stats.m_CommandOverflows++;
+	m_Stats.m_SubmitTime += time_get()-Start;
+
+	m_Stats.m_Vertices += m_NumVertices;
+	m_Stats.m_Draws++;
+	m_NumVertices = 0;
+}
+
+void CGraphics_Null::SetTexCoord(int Corner, float u, float v)
+{
+	m_aTexture[Corner].u = m_aUVOffset[0] + u*m_aUVScale[0];
+	m_aTexture[Corner].v = m_aUVOffset[1] + v*m_aUVScale[1];
+}
+
+void CGraphics_Null::SetVertex(CVertex *pVertex, float x, float y, int Corner)
+{
+	pVertex->m_X = x;
+	pVertex->m_Y = y;
+	pVertex->m_U = m_aTexture[Corner].u;
+	pVertex->m_V = m_aTexture[Corner].v;
+	pVertex->m_Color = PackColor(m_aColor[Corner].r, m_aColor[Corner].g, m_aColor[Corner].b, m_aColor[Corner].a);
+}
+
+void CGraphics_Null::Rotate(float CenterX, float CenterY, CVertex *pPoints, int NumPoints)
+{
+	float c = cosf(m_Rotation);
+	float s = sinf(m_Rotation);
+
+	for(int i = 0; i < NumPoints; i++)
+	{
+		float x = pPoints[i].m_X - CenterX;
+		float y = pPoints[i].m_Y - CenterY;
+		pPoints[i].m_X = x * c - y * s + CenterX;
+		pPoints[i].m_Y = x * s + y * c + CenterY;
+	}
+}
+
+CGraphics_Null::CGraphics_Null()
+{
+	m_NumVertices = 0;
+
+	m_ScreenX0 = 0;
+	m_ScreenY0 = 0;
+	m_ScreenX1 = 0;
+	m_ScreenY1 = 0;
+
+	m_ScreenWidth = -1;
+	m_ScreenHeight = -1;
+
+	m_Rotation = 0;
+	m_Drawing = 0;
+	m_InvalidTexture = 0;
+
+	m_TextureMemoryUsage = 0;
+
+	m_CurTexture = -1;
+	m_CurBlend = BLEND_NORMAL;
+	m_CurWrap = 0;
+	m_CurClip = false;
+
+	m_AtlasPage = -1;
+	m_AtlasDepth = 0;
+	m_aUVOffset[0] = m_aUVOffset[1] = 0.0f;
+	m_aUVScale[0] = m_aUVScale[1] = 1.0f;
+
+	m_CommandSize = 0;
+	ResetStats();
+}
+
+void CGraphics_Null::ClipEnable(int x, int y, int w, int h)
+{
+	Flush();
+	int aClip[4] = {x, y, w, h};
+	AddCommand(CMD_CLIP, aClip, sizeof(aClip));
+	m_CurClip = true;
+	m_Stats.m_StateChanges++;
+}
+
+void CGraphics_Null::ClipDisable()
+{
+	if(!m_CurClip)
+		return;
+	Flush();
+	int aClip[4] = {0, 0, 0, 0};
+	AddCommand(CMD_CLIP, aClip, sizeof(aClip));
+	m_CurClip = false;
+	m_Stats.m_StateChanges++;
+}
+
+void CGraphics_Null::BlendNone()
+{
+	m_Stats.m_BlendSets++;
+	SetState(CMD_BLEND, &m_CurBlend, BLEND_NONE);
+}
+
+void CGraphics_Null::BlendNormal()
+{
+	m_Stats.m_BlendSets++;
+	SetState(CMD_BLEND, &m_CurBlend, BLEND_NORMAL);
+}
+
+void CGraphics_Null::BlendAdditive()
+{
+	m_Stats.m_BlendSets++;
+	SetState(CMD_BLEND, &m_CurBlend, BLEND_ADDITIVE);
+}
+
+void CGraphics_Null::WrapNormal()
+{
+	SetState(CMD_WRAP, &m_CurWrap, 0);
+}
+
+void CGraphics_Null::WrapClamp()
+{
+	SetState(CMD_WRAP, &m_CurWrap, 1);
+}
+
+int CGraphics_Null::MemoryUsage() const
+{
+	return m_TextureMemoryUsage;
+}
+
+void CGraphics_Null::MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY)
+{
+	if(m_ScreenX0 == TopLeftX && m_ScreenY0 == TopLeftY && m_ScreenX1 == BottomRightX && m_ScreenY1 == BottomRightY)
+		return;
+
+	Flush();
+	m_ScreenX0 = TopLeftX;
+	m_ScreenY0 = TopLeftY;
+	m_ScreenX1 = BottomRightX;
+	m_ScreenY1 = BottomRightY;
+	float aScreen[4] = {TopLeftX, TopLeftY, BottomRightX, BottomRightY};
+	AddCommand(CMD_SCREEN, aScreen, sizeof(aScreen));
+	m_Stats.m_StateChanges++;
+}
+
+void CGraphics_Null::GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY)
+{
+	*pTopLeftX = m_ScreenX0;
+	*pTopLeftY = m_ScreenY0;
+	*pBottomRightX = m_ScreenX1;
+	*pBottomRightY = m_ScreenY1;
+}
+
+void CGraphics_Null::LinesBegin()
+{
+	dbg_assert(m_Drawing == 0, "called Graphics()->LinesBegin twice");
+	Flush();
+	m_Drawing = DRAWING_LINES;
+	m_Stats.m_Batches++;
+	SetColor(1,1,1,1);
+}
+
+void CGraphics_Null::LinesEnd()
+{
+	dbg_assert(m_Drawing == DRAWING_LINES, "called Graphics()->LinesEnd without begin");
+	Flush();
+	m_Drawing = 0;
+}
+
+void CGraphics_Null::LinesDraw(const CLineItem *pArray, int Num)
+{
+	dbg_assert(m_Drawing == DRAWING_LINES, "called Graphics()->LinesDraw without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		if(m_NumVertices + 2 > MAX_VERTICES)
+			Flush();
+		SetVertex(&m_aVertices[m_NumVertices], pArray[i].m_X0, pArray[i].m_Y0, 0);
+		SetVertex(&m_aVertices[m_NumVertices + 1], pArray[i].m_X1, pArray[i].m_Y1, 1);
+		m_NumVertices += 2;
+	}
+}
+
+int CGraphics_Null::UnloadTexture(int Index)
+{
+	if(Index == m_InvalidTexture)
+		return 0;
+
+	if(Index < 0)
+		return 0;
+
+	int Page = m_aTextures[Index].m_Page;
+	m_aTextures[Index].m_Page = -1;
+	m_aTextures[Index].m_Next = m_FirstFreeTexture;
+	m_TextureMemoryUsage -= m_aTextures[Index].m_MemSize;
+	m_FirstFreeTexture = Index;
+
+	if(Page >= 0 && --m_aTextures[Page].m_Refs == 0 && Page != m_AtlasPage)
+	{
+		if(m_CurTexture == Page)
+			m_CurTexture = -1;
+		m_aTextures[Page].m_Next = m_FirstFreeTexture;
+		m_TextureMemoryUsage -= m_aTextures[Page].m_MemSize;
+		m_FirstFreeTexture = Page;
+	}
+	return 0;
+}
+
+int CGraphics_Null::AllocTexture()
+{
+	if(m_FirstFreeTexture < 0)
+		return -1;
+
+	int Tex = m_FirstFreeTexture;
+	m_FirstFreeTexture = m_aTextures[Tex].m_Next;
+	m_aTextures[Tex].m_Next = -1;
+	m_aTextures[Tex].m_MemSize = 0;
+	m_aTextures[Tex].m_Page = -1;
+	m_aTextures[Tex].m_Refs = 0;
+	return Tex;
+}
+
+void CGraphics_Null::AtlasBegin()
+{
+	m_AtlasDepth++;
+}
+
+void CGraphics_Null::AtlasEnd()
+{
+	dbg_assert(m_AtlasDepth > 0, "called Graphics()->AtlasEnd without begin");
+	if(--m_AtlasDepth == 0)
+		CloseAtlasPage();
+}
+
+void CGraphics_Null::CloseAtlasPage()
+{
+	if(m_AtlasPage < 0)
+		return;
+
+	CTexture *pPage = &m_aTextures[m_AtlasPage];
+	if(pPage->m_Refs == 0)
+	{
+		pPage->m_Next = m_FirstFreeTexture;
+		m_FirstFreeTexture = m_AtlasPage;
+		m_AtlasPage = -1;
+		m_AtlasPacker.Reset();
+		return;
+	}
+
+	pPage->m_aRect[0] = 0;
+	pPage->m_aRect[1] = 0;
+	pPage->m_aRect[2] = CAtlasPacker::PAGE_WIDTH;
+	pPage->m_aRect[3] = m_AtlasPacker.UsedHeight();
+	pPage->m_MemSize = pPage->m_aRect[2]*pPage->m_aRect[3]*4;
+	m_TextureMemoryUsage += pPage->m_MemSize;
+
+	m_AtlasPage = -1;
+	m_AtlasPacker.Reset();
+}
+
+int CGraphics_Null::LoadTextureRawSub(int TextureID, int x, int y, int Width, int Height, int Format, const void *pData)
+{
+	return 0;
+}
+
+int CGraphics_Null::LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags)
+{
+	if(Flags&TEXLOAD_ATLAS && m_AtlasDepth > 0 && g_Config.m_GfxAtlas && (Format == CImageInfo::FORMAT_RGBA || Format == CImageInfo::FORMAT_RGB))
+	{
+		int x, y;
+		bool Placed = CAtlasPacker::Fits(Width, Height) && m_AtlasPacker.Add(Width, Height, &x, &y);
+		if(!Placed && CAtlasPacker::Fits(Width, Height))
+		{
+			CloseAtlasPage();
+			Placed = m_AtlasPacker.Add(Width, Height, &x, &y);
+		}
+		if(Placed)
+		{
+			if(m_AtlasPage < 0)
+				m_AtlasPage = AllocTexture();
+			int Tex = AllocTexture();
+			if(m_AtlasPage >= 0 && Tex >= 0)
+			{
+				m_aTextures[Tex].m_Page = m_AtlasPage;
+				m_aTextures[Tex].m_aRect[0] = x;
+				m_aTextures[Tex].m_aRect[1] = y;
+				m_aTextures[Tex].m_aRect[2] = Width;
+				m_aTextures[Tex].m_aRect[3] = Height;
+				m_aTextures[m_AtlasPage].m_Refs++;
+				return Tex;
+			}
+		}
+	}
+
+	int Tex = AllocTexture();
+	if(Tex < 0)
+		return m_InvalidTexture;
+
+	int PixelSize = 4;
+	if(StoreFormat == CImageInfo::FORMAT_RGB)
+		PixelSize = 3;
+	else if(StoreFormat == CImageInfo::FORMAT_ALPHA)
+		PixelSize = 1;
+
+	m_aTextures[Tex].m_MemSize = Width*Height*PixelSize;
+	m_aTextures[Tex].m_aRect[0] = 0;
+	m_aTextures[Tex].m_aRect[1] = 0;
+	m_aTextures[Tex].m_aRect[2] = Width;
+	m_aTextures[Tex].m_aRect[3] = Height;
+	m_TextureMemoryUsage += m_aTextures[Tex].m_MemSize;
+	return Tex;
+}
+
+int CGraphics_Null::LoadTexture(const char *pFilename, int StorageType, int StoreFormat, int Flags)
+{
+	CImageInfo Img;
+
+	if(str_length(pFilename) < 3)
+		return m_InvalidTexture;
+	if(LoadPNG(&Img, pFilename, StorageType))
+	{
+		if(StoreFormat == CImageInfo::FORMAT_AUTO)
+			StoreFormat = Img.m_Format;
+
+		int ID = LoadTextureRaw(Img.m_Width, Img.m_Height, Img.m_Format, Img.m_pData, StoreFormat, Flags);
+		mem_free(Img.m_pData);
+		return ID;
+	}
+
+	return m_InvalidTexture;
+}
+
+int CGraphics_Null::LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType)
+{
+	return CPngLoader::Load(m_pStorage, pFilename, StorageType, pImg);
+}
+
+void CGraphics_Null::TextureSet(int TextureID)
+{
+	dbg_assert(m_Drawing == 0, "called Graphics()->TextureSet within begin");
+	m_Stats.m_TextureSets++;
+
+	m_aUVOffset[0] = m_aUVOffset[1] = 0.0f;
+	m_aUVScale[0] = m_aUVScale[1] = 1.0f;
+
+	int Page = TextureID;
+	if(TextureID >= 0 && m_aTextures[TextureID].m_Page >= 0)
+	{
+		const CTexture *pTex = &m_aTextures[TextureID];
+		const CTexture *pPage = &m_aTextures[pTex->m_Page];
+		Page = pTex->m_Page;
+		m_aUVOffset[0] = pTex->m_aRect[0]/(float)pPage->m_aRect[2];
+		m_aUVOffset[1] = pTex->m_aRect[1]/(float)pPage->m_aRect[3];
+		m_aUVScale[0] = pTex->m_aRect[2]/(float)pPage->m_aRect[2];
+		m_aUVScale[1] = pTex->m_aRect[3]/(float)pPage->m_aRect[3];
+	}
+	SetState(CMD_TEXTURE, &m_CurTexture, Page);
+}
+
+void CGraphics_Null::Clear(float r, float g, float b)
+{
+	Flush();
+	float aColor[3] = {r, g, b};
+	AddCommand(CMD_CLEAR, aColor, sizeof(aColor));
+}
+
+void CGraphics_Null::QuadsBegin()
+{
+	dbg_assert(m_Drawing == 0, "called Graphics()->QuadsBegin twice");
+	m_Drawing = DRAWING_QUADS;
+	m_Stats.m_Batches++;
+
+	QuadsSetSubset(0,0,1,1);
+	QuadsSetRotation(0);
+	SetColor(1,1,1,1);
+}
+
+void CGraphics_Null::QuadsEnd()
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsEnd without begin");
+	// flushed on the next state change, like the pvr backend
+	m_Drawing = 0;
+}
+
+void CGraphics_Null::QuadsSetRotation(float Angle)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsSetRotation without begin");
+	m_Rotation = Angle;
+}
+
+void CGraphics_Null::SetColorVertex(const CColorVertex *pArray, int Num)
+{
+	dbg_assert(m_Drawing != 0, "called Graphics()->SetColorVertex without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		m_aColor[pArray[i].m_Index].r = pArray[i].m_R;
+		m_aColor[pArray[i].m_Index].g = pArray[i].m_G;
+		m_aColor[pArray[i].m_Index].b = pArray[i].m_B;
+		m_aColor[pArray[i].m_Index].a = pArray[i].m_A;
+	}
+}
+
+void CGraphics_Null::SetColor(float r, float g, float b, float a)
+{
+	dbg_assert(m_Drawing != 0, "called Graphics()->SetColor without begin");
+	for(int i = 0; i < 4; ++i)
+	{
+		m_aColor[i].r = r;
+		m_aColor[i].g = g;
+		m_aColor[i].b = b;
+		m_aColor[i].a = a;
+	}
+}
+
+void CGraphics_Null::QuadsSetSubset(float TlU, float TlV, float BrU, float BrV)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsSetSubset without begin");
+
+	SetTexCoord(0, TlU, TlV);
+	SetTexCoord(1, BrU, TlV);
+	SetTexCoord(2, BrU, BrV);
+	SetTexCoord(3, TlU, BrV);
+}
+
+void CGraphics_Null::QuadsSetSubsetFree(
+	float x0, float y0, float x1, float y1,
+	float x2, float y2, float x3, float y3)
+{
+	SetTexCoord(0, x0, y0);
+	SetTexCoord(1, x1, y1);
+	SetTexCoord(2, x2, y2);
+	SetTexCoord(3, x3, y3);
+}
+
+void CGraphics_Null::QuadsDraw(CQuadItem *pArray, int Num)
+{
+	for(int i = 0; i < Num; ++i)
+	{
+		pArray[i].m_X -= pArray[i].m_Width/2;
+		pArray[i].m_Y -= pArray[i].m_Height/2;
+	}
+
+	QuadsDrawTL(pArray, Num);
+}
+
+void CGraphics_Null::AddQuad(const float *pX, const float *pY, const int *pCorners)
+{
+	if(m_NumVertices + 6 > MAX_VERTICES)
+		Flush();
+
+	CVertex *pVertices = &m_aVertices[m_NumVertices];
+	for(int i = 0; i < 4; i++)
+		SetVertex(&pVertices[i], pX[i], pY[i], pCorners[i]);
+	if(g_Config.m_GfxQuadAsTriangle)
+	{
+		pVertices[5] = pVertices[3];
+		pVertices[3] = pVertices[0];
+		pVertices[4] = pVertices[2];
+		m_NumVertices += 6;
+	}
+	else
+		m_NumVertices += 4;
+	m_Stats.m_Quads++;
+}
+
+void CGraphics_Null::QuadsDrawTL(const CQuadItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 2, 3};
+
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawTL without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		float aX[4] = {pArray[i].m_X, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X};
+		float aY[4] = {pArray[i].m_Y, pArray[i].m_Y, pArray[i].m_Y + pArray[i].m_Height, pArray[i].m_Y + pArray[i].m_Height};
+		AddQuad(aX, aY, s_aCorners);
+
+		if(m_Rotation != 0)
+		{
+			int Count = g_Config.m_GfxQuadAsTriangle ? 6 : 4;
+			Rotate(pArray[i].m_X + pArray[i].m_Width/2, pArray[i].m_Y + pArray[i].m_Height/2, &m_aVertices[m_NumVertices-Count], Count);
+		}
+	}
+}
+
+void CGraphics_Null::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 3, 2};
+
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawFreeform without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		float aX[4] = {pArray[i].m_X0, pArray[i].m_X1, pArray[i].m_X3, pArray[i].m_X2};
+		float aY[4] = {pArray[i].m_Y0, pArray[i].m_Y1, pArray[i].m_Y3, pArray[i].m_Y2};
+		AddQuad(aX, aY, s_aCorners);
+	}
+}
+
+void CGraphics_Null::QuadsDrawTextured(const CTexturedQuadItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 2, 3};
+
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawTextured without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		for(int c = 0; c < 4; c++)
+			SetTexCoord(c, pArray[i].m_aU[c], pArray[i].m_aV[c]);
+
+		float aX[4] = {pArray[i].m_X, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X + pArray[i].m_Width, pArray[i].m_X};
+		float aY[4] = {pArray[i].m_Y, pArray[i].m_Y, pArray[i].m_Y + pArray[i].m_Height, pArray[i].m_Y + pArray[i].m_Height};
+		AddQuad(aX, aY, s_aCorners);
+	}
+}
+
+void CGraphics_Null::QuadsDrawPrepared(const CPreparedQuadItem *pArray, int Num)
+{
+	static const int s_aCorners[4] = {0, 1, 2, 3};
+
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawPrepared without begin");
+
+	for(int i = 0; i < Num; ++i)
+	{
+		for(int c = 0; c < 4; c++)
+		{
+			SetTexCoord(c, pArray[i].m_aU[c], pArray[i].m_aV[c]);
+			m_aColor[c].r = pArray[i].m_aColors[c][0];
+			m_aColor[c].g = pArray[i].m_aColors[c][1];
+			m_aColor[c].b = pArray[i].m_aColors[c][2];
+			m_aColor[c].a = pArray[i].m_aColors[c][3];
+		}
+		AddQuad(pArray[i].m_aX, pArray[i].m_aY, s_aCorners);
+	}
+}
+
+void CGraphics_Null::QuadsText(float x, float y, float Size, const char *pText)
+{
+	float StartX = x;
+
+	while(*pText)
+	{
+		char c = *pText;
+		pText++;
+
+		if(c == '\n')
+		{
+			x = StartX;
+			y += Size;
+		}
+		else
+		{
+			QuadsSetSubset(
+				(c%16)/16.0f,
+				(c/16)/16.0f,
+				(c%16)/16.0f+1.0f/16.0f,
+				(c/16)/16.0f+1.0f/16.0f);
+
+			CQuadItem QuadItem(x, y, Size, Size);
+			QuadsDrawTL(&QuadItem, 1);
+			x += Size/2;
+		}
+	}
+}
+
+int CGraphics_Null::Init()
+{
+	m_pStorage = Kernel()->RequestInterface<IStorage>();
+
+	m_ScreenWidth = g_Config.m_GfxScreenWidth = 640;
+	m_ScreenHeight = g_Config.m_GfxScreenHeight = 480;
+
+	// init textures
+	m_FirstFreeTexture = 0;
+	for(int i = 0; i < MAX_TEXTURES; i++)
+		m_aTextures[i].m_Next = i+1;
+	m_aTextures[MAX_TEXTURES-1].m_Next = -1;
+
+	// null texture, will get id=0
+	m_InvalidTexture = LoadTextureRaw(4,4,CImageInfo::FORMAT_RGBA,0,CImageInfo::FORMAT_RGBA,TEXLOAD_NORESAMPLE);
+
+	return 0;
+}
+
+void CGraphics_Null::Shutdown()
+{
+}
+
+void CGraphics_Null::Minimize()
+{
+}
+
+void CGraphics_Null::Maximize()
+{
+}
+
+int CGraphics_Null::WindowActive()
+{
+	return 1;
+}
+
+int CGraphics_Null::WindowOpen()
+{
+	return 1;
+}
+
+void CGraphics_Null::NotifyWindow()
+{
+}
+
+void CGraphics_Null::TakeScreenshot(const char *pFilename)
+{
+}
+
+void CGraphics_Null::TakeCustomScreenshot(const char *pFilename)
+{
+}
+
+void CGraphics_Null::Swap()
+{
+	Flush();
+	m_Stats.m_Frames++;
+	m_CommandSize = 0;
+}
+
+int CGraphics_Null::GetVideoModes(CVideoMode *pModes, int MaxModes)
+{
+	pModes[0].m_Width = 640;
+	pModes[0].m_Height = 480;
+	pModes[0].m_Red = 8;
+	pModes[0].m_Green = 8;
+	pModes[0].m_Blue = 8;
+	return 1;
+}
+
+void CGraphics_Null::InsertSignal(semaphore *pSemaphore)
+{
+}
+
+bool CGraphics_Null::IsIdle()
+{
+	return true;
+}
+
+void CGraphics_Null::WaitForIdle()
+{
+}
+
+#if !defined(CONF_FAMILY_KOS)
+// hosts without kgl only have this backend
+IEngineGraphics *CreateEngineGraphics() { return new CGraphics_Null(); }
+#endif
@@ -0,0 +1,215 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_GRAPHICS_NULL_H
+#define ENGINE_CLIENT_GRAPHICS_NULL_H
+
+#include <engine/graphics.h>
+
+#include "atlas.h"
+
+// graphics backend without a gpu, everything is written into a command
+// stream that is thrown away on Swap. used to profile the render paths.
+class CGraphics_Null : public IEngineGraphics
+{
+public:
+	enum
+	{
+		CMD_CLEAR=1,
+		CMD_SCREEN,
+		CMD_CLIP,
+		CMD_BLEND,
+		CMD_WRAP,
+		CMD_TEXTURE,
+		CMD_DRAW,
+		// dbg_bench_immediate, one command per glColor4f, glTexCoord2f and glVertex3f
+		CMD_COLOR,
+		CMD_TEXCOORD,
+		CMD_VERTEX,
+
+		BLEND_NONE=0,
+		BLEND_NORMAL,
+		BLEND_ADDITIVE,
+
+		PRIMTYPE_QUADS=0,
+		PRIMTYPE_LINES,
+	};
+
+	struct CVertex
+	{
+		float m_X, m_Y;
+		float m_U, m_V;
+		unsigned m_Color;
+	};
+
+	struct CStats
+	{
+		int m_Frames;
+		int64 m_Vertices;
+		int64 m_Quads;
+		int64 m_Draws;
+		int64 m_Batches;
+		int64 m_TextureSets;
+		int64 m_BlendSets;
+		int64 m_StateChanges;
+		int64 m_CommandBytes;
+		int m_CommandOverflows;
+		int64 m_SubmitTime; // spent writing vertices into the stream
+	};
+
+protected:
+	class IStorage *m_pStorage;
+
+	typedef struct { float r, g, b, a; } CColor;
+	typedef struct { float u, v; } CTexCoord;
+
+	enum
+	{
+		MAX_VERTICES = 32*1024,
+		MAX_TEXTURES = 1024*4,
+		COMMAND_BUFFER_SIZE = 512*1024,
+
+		DRAWING_QUADS=1,
+		DRAWING_LINES=2
+	};
+
+	CVertex m_aVertices[MAX_VERTICES];
+	int m_NumVertices;
+
+	CColor m_aColor[4];
+	CTexCoord m_aTexture[4];
+
+	float m_Rotation;
+	int m_Drawing;
+
+	float m_ScreenX0;
+	float m_ScreenY0;
+	float m_ScreenX1;
+	float m_ScreenY1;
+
+	int m_InvalidTexture;
+
+	struct CTexture
+	{
+		int m_MemSize;
+		int m_Next;
+		int m_Page;
+		int m_Refs;
+		int m_aRect[4];
+	};
+
+	CTexture m_aTextures[MAX_TEXTURES];
+	int m_FirstFreeTexture;
+	int m_TextureMemoryUsage;
+
+	// only the packing is done, there are no pixels to keep
+	CAtlasPacker m_AtlasPacker;
+	int m_AtlasPage;
+	int m_AtlasDepth;
+	float m_aUVOffset[2];
+	float m_aUVScale[2];
+
+	// current state, to tell real changes from redundant calls
+	int m_CurTexture;
+	int m_CurBlend;
+	int m_CurWrap;
+	bool m_CurClip;
+
+	unsigned char m_aCommands[COMMAND_BUFFER_SIZE];
+	int m_CommandSize;
+	CStats m_Stats;
+
+	void Flush();
+	void SubmitImmediate();
+	void AddQuad(const float *pX, const float *pY, const int *pCorners);
+	void SetVertex(CVertex *pVertex, float x, float y, int Corner);
+	void SetTexCoord(int Corner, float u, float v);
+	int AllocTexture();
+	void CloseAtlasPage();
+	void Rotate(float CenterX, float CenterY, CVertex *pPoints, int NumPoints);
+
+	bool AddCommand(int Cmd, const void *pData, int Size);
+	void SetState(int Cmd, int *pCur, int Value);
+
+public:
+	CGraphics_Null();
+
+	const CStats &Stats() const { return m_Stats; }
+	void ResetStats() { mem_zero(&m_Stats, sizeof(m_Stats)); }
+	const unsigned char *CommandData() const { return m_aCommands; }
+	int CommandSize() const { return m_CommandSize; }
+
+	virtual void ClipEnable(int x, int y, int w, int h);
+	virtual void ClipDisable();
+
+	virtual void BlendNone();
+	virtual void BlendNormal();
+	virtual void BlendAdditive();
+
+	virtual void WrapNormal();
+	virtual void WrapClamp();
+
+	virtual int MemoryUsage() const;
+
+	virtual void MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY);
+	virtual void GetScreen(float *pTopLeftX, float *pTopLeftY, float *pBottomRightX, float *pBottomRightY);
+
+	virtual void LinesBegin();
+	virtual void LinesEnd();
+	virtual void LinesDraw(const CLineItem *pArray, int Num);
+
+	virtual int UnloadTexture(int Index);
+	virtual int LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags);
+	virtual int LoadTextureRawSub(int TextureID, int x, int y, int Width, int Height, int Format, const void *pData);
+
+	virtual int LoadTexture(const char *pFilename, int StorageType, int StoreFormat, int Flags);
+	virtual int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType);
+
+	virtual void TextureSet(int TextureID);
+
+	virtual void AtlasBegin();
+	virtual void AtlasEnd();
+
+	virtual void Clear(float r, float g, float b);
+
+	virtual void QuadsBegin();
+	virtual void QuadsEnd();
+	virtual void QuadsSetRotation(float Angle);
+
+	virtual void SetColorVertex(const CColorVertex *pArray, int Num);
+	virtual void SetColor(float r, float g, float b, float a);
+
+	virtual void QuadsSetSubset(float TlU, float TlV, float BrU, float BrV);
+	virtual void QuadsSetSubsetFree(
+		float x0, float y0, float x1, float y1,
+		float x2, float y2, float x3, float y3);
+
+	virtual void QuadsDraw(CQuadItem *pArray, int Num);
+	virtual void QuadsDrawTL(const CQuadItem *pArray, int Num);
+	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
+	virtual void QuadsDrawTextured(const CTexturedQuadItem *pArray, int Num);
+	virtual void QuadsDrawPrepared(const CPreparedQuadItem *pArray, int Num);
+	virtual void QuadsText(float x, float y, float Size, const char *pText);
+
+	virtual int Init();
+	virtual void Shutdown();
+
+	virtual void Minimize();
+	virtual void Maximize();
+
+	virtual int WindowActive();
+	virtual int WindowOpen();
+
+	virtual void NotifyWindow();
+
+	virtual void TakeScreenshot(const char *pFilename);
+	virtual void TakeCustomScreenshot(const char *pFilename);
+	virtual void Swap();
+
+	virtual int GetVideoModes(CVideoMode *pModes, int MaxModes);
+
+	virtual void InsertSignal(semaphore *pSemaphore);
+	virtual bool IsIdle();
+	virtual void WaitForIdle();
+};
+
+#endif
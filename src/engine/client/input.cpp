@@ -10,7 +10,9 @@
 
 #include "input.h"
 
-#include <kos.h>
+#if defined(CONF_FAMILY_KOS)
+	#include <kos.h>
+#endif
 
 //print >>f, "int inp_key_code(const char *key_name) { int i; if (!strcmp(key_name, \"-?-\")) return -1; else for (i = 0; i < 512; i++) if (!strcmp(key_strings[i], key_name)) return i; return -1; }"
 
@@ -45,6 +47,7 @@ void CInput::AddEvent(int Unicode, int Key, int Flags)
 	}
 }
 
+#if defined(CONF_FAMILY_KOS)
 static int MapKey(int k)
 {
 	if (k >= KBD_KEY_A  && k <= KBD_KEY_Z)   return KEY_a  + (k - KBD_KEY_A);
@@ -202,6 +205,7 @@ void CInput::HandleMouseInput(void* pMstate)
 
 	oldBtns = mstate->buttons;
 }
+#endif
 
 CInput::CInput()
 {
@@ -224,11 +228,14 @@ void CInput::Init()
 {
 	m_pGraphics = Kernel()->RequestInterface<IEngineGraphics>();
 
+#if defined(CONF_FAMILY_KOS)
 	cont_btn_callback(0, CONT_START | CONT_A | CONT_B | CONT_X | CONT_Y, (cont_btn_callback_t)arch_exit);
+#endif
 }
 
 void CInput::MouseRelative(float *x, float *y)
 {
+#if defined(CONF_FAMILY_KOS)
 	int nx = 0, ny = 0;
 	float Sens = ((g_Config.m_ClDyncam && g_Config.m_ClDyncamMousesens) ? g_Config.m_ClDyncamMousesens : g_Config.m_InpMousesens) / 100.0f;
 
@@ -253,6 +260,11 @@ void CInput::MouseRelative(float *x, float *y)
 
 	*x = nx*Sens;
 	*y = ny*Sens;
+#else
+	// other hosts have no input devices
+	*x = 0;
+	*y = 0;
+#endif
 }
 
 void CInput::MouseModeAbsolute()
@@ -337,6 +349,7 @@ int CInput::Update()
 	}
 	*/
 
+#if defined(CONF_FAMILY_KOS)
 	maple_device_t *cont, *mouse, *kbd;
 	cont_state_t *cstate;
 	mouse_state_t *mstate;
@@ -367,6 +380,7 @@ int CInput::Update()
 			
 		}
 	}
+#endif
 
 	/*
 	{
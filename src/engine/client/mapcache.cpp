@@ -0,0 +1,184 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <stdio.h>	// sscanf
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
+
+#include "mapcache.h"
+
+static const char *gs_pIndexFile = "downloadedmaps/index.txt";
+
+CMapCache::CMapCache()
+{
+	m_pStorage = 0;
+	m_NumEntries = 0;
+	m_TotalSize = 0;
+	m_Dirty = false;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+		m_aBuckets[i] = -1;
+}
+
+void CMapCache::Path(unsigned Crc, int Size, char *pPath, int PathSize)
+{
+	str_format(pPath, PathSize, "downloadedmaps/%08x_%d.map", Crc, Size);
+}
+
+int CMapCache::Lookup(unsigned Crc, int Size) const
+{
+	for(int i = m_aBuckets[Crc%NUM_BUCKETS]; i != -1; i = m_aEntries[i].m_Next)
+		if(m_aEntries[i].m_Crc == Crc && (Size < 0 || m_aEntries[i].m_Size == Size))
+			return i;
+	return -1;
+}
+
+void CMapCache::Rehash()
+{
+	m_TotalSize = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+		m_aBuckets[i] = -1;
+	for(int i = 0; i < m_NumEntries; i++)
+	{
+		int Bucket = m_aEntries[i].m_Crc%NUM_BUCKETS;
+		m_aEntries[i].m_Next = m_aBuckets[Bucket];
+		m_aBuckets[Bucket] = i;
+		m_TotalSize += m_aEntries[i].m_Size;
+	}
+}
+
+void CMapCache::Forget(int Index)
+{
+	m_aEntries[Index] = m_aEntries[m_NumEntries-1];
+	m_NumEntries--;
+	m_Dirty = true;
+	Rehash();
+}
+
+void CMapCache::Remove(int Index)
+{
+	char aPath[128];
+	Path(m_aEntries[Index].m_Crc, m_aEntries[Index].m_Size, aPath, sizeof(aPath));
+	m_pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE);
+	dbg_msg("mapcache", "removed '%s' (%s)", m_aEntries[Index].m_aName, aPath);
+	Forget(Index);
+}
+
+void CMapCache::Evict(unsigned KeepCrc, int KeepSize)
+{
+	int64 Budget = (int64)g_Config.m_ClMapCacheSize*1024*1024;
+	while(m_TotalSize > Budget || m_NumEntries >= MAX_ENTRIES)
+	{
+		int Oldest = -1;
+		for(int i = 0; i < m_NumEntries; i++)
+		{
+			if(m_aEntries[i].m_Crc == KeepCrc && m_aEntries[i].m_Size == KeepSize)
+				continue;
+			if(Oldest == -1 || m_aEntries[i].m_LastUse < m_aEntries[Oldest].m_LastUse)
+				Oldest = i;
+		}
+		if(Oldest == -1)
+			break;
+		Remove(Oldest);
+	}
+}
+
+void CMapCache::Save()
+{
+	IOHANDLE File = m_pStorage->OpenFile(gs_pIndexFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	char aLine[256];
+	for(int i = 0; i < m_NumEntries; i++)
+	{
+		str_format(aLine, sizeof(aLine), "%08x %d %d %s", m_aEntries[i].m_Crc, m_aEntries[i].m_Size, m_aEntries[i].m_LastUse, m_aEntries[i].m_aName);
+		io_write(File, aLine, str_length(aLine));
+		io_write_newline(File);
+	}
+	io_close(File);
+	m_Dirty = false;
+}
+
+void CMapCache::Flush()
+{
+	if(m_Dirty)
+		Save();
+}
+
+void CMapCache::Init(IStorage *pStorage)
+{
+	m_pStorage = pStorage;
+	m_NumEntries = 0;
+	m_Dirty = false;
+
+	IOHANDLE File = m_pStorage->OpenFile(gs_pIndexFile, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(File)
+	{
+		CLineReader LineReader;
+		LineReader.Init(File);
+		char *pLine;
+		while((pLine = LineReader.Get()) && m_NumEntries < MAX_ENTRIES)
+		{
+			CEntry *pEntry = &m_aEntries[m_NumEntries];
+			int NameStart = 0;
+			if(sscanf(pLine, "%x %d %d %n", &pEntry->m_Crc, &pEntry->m_Size, &pEntry->m_LastUse, &NameStart) < 3 || !NameStart)
+				continue;
+			str_copy(pEntry->m_aName, pLine+NameStart, sizeof(pEntry->m_aName));
+			m_NumEntries++;
+		}
+		io_close(File);
+	}
+	Rehash();
+
+	dbg_msg("mapcache", "%d maps, %d KB", m_NumEntries, (int)(m_TotalSize/1024));
+}
+
+bool CMapCache::Find(unsigned Crc, int Size, char *pPath, int PathSize)
+{
+	int Index;
+	while((Index = Lookup(Crc, Size)) != -1)
+	{
+		// maps removed by hand are only noticed here, Init doesn't open every map
+		Path(m_aEntries[Index].m_Crc, m_aEntries[Index].m_Size, pPath, PathSize);
+		IOHANDLE File = m_pStorage->OpenFile(pPath, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(File)
+		{
+			io_close(File);
+			break;
+		}
+		dbg_msg("mapcache", "'%s' (%s) is gone", m_aEntries[Index].m_aName, pPath);
+		Forget(Index);
+	}
+	if(Index == -1)
+		return false;
+
+	// only the use time changed, the index is written on the next change
+	// or when the client quits
+	m_aEntries[Index].m_LastUse = time_timestamp();
+	m_Dirty = true;
+	return true;
+}
+
+void CMapCache::Add(const char *pName, unsigned Crc, int Size)
+{
+	int Index = Lookup(Crc, Size);
+	if(Index == -1)
+	{
+		// make room first, the new map itself is never evicted
+		Evict(Crc, Size);
+		if(m_NumEntries >= MAX_ENTRIES)
+			return;
+		Index = m_NumEntries++;
+		m_aEntries[Index].m_Crc = Crc;
+		m_aEntries[Index].m_Size = Size;
+		Rehash();
+	}
+	str_copy(m_aEntries[Index].m_aName, pName, sizeof(m_aEntries[Index].m_aName));
+	m_aEntries[Index].m_LastUse = time_timestamp();
+	Evict(Crc, Size);
+	Save();
+}
@@ -0,0 +1,58 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_MAPCACHE_H
+#define ENGINE_CLIENT_MAPCACHE_H
+
+#include <base/system.h>
+
+// downloaded maps by content. a map is stored once under its crc and size,
+// whatever name servers publish it under. the least recently used ones are
+// removed beyond cl_map_cache_size, the index is downloadedmaps/index.txt.
+class CMapCache
+{
+	enum
+	{
+		MAX_ENTRIES=512,
+		NUM_BUCKETS=256,
+	};
+
+	struct CEntry
+	{
+		unsigned m_Crc;
+		int m_Size;
+		int m_LastUse;
+		char m_aName[128];
+		int m_Next; // in the same bucket
+	};
+
+	class IStorage *m_pStorage;
+	CEntry m_aEntries[MAX_ENTRIES];
+	int m_NumEntries;
+	int m_aBuckets[NUM_BUCKETS];
+	int64 m_TotalSize;
+	bool m_Dirty; // the index differs from index.txt
+
+	int Lookup(unsigned Crc, int Size) const;
+	void Rehash();
+	void Forget(int Index);
+	void Remove(int Index);
+	void Evict(unsigned KeepCrc, int KeepSize);
+	void Save();
+
+public:
+	CMapCache();
+
+	void Init(class IStorage *pStorage);
+
+	// Size < 0 matches any size. marks the map as used, drops it from the
+	// index if the file is gone.
+	bool Find(unsigned Crc, int Size, char *pPath, int PathSize);
+	// a completed download at Path(Crc, Size)
+	void Add(const char *pName, unsigned Crc, int Size);
+	// writes the index if lookups changed it
+	void Flush();
+
+	static void Path(unsigned Crc, int Size, char *pPath, int PathSize);
+};
+
+#endif
@@ -9,11 +9,25 @@
 #include <engine/shared/config.h>
 
 #include "sound.h"
+#include "soundsink.h"
 
 extern "C" { // wavpack
 	#include <engine/external/wavpack/wavpack.h>
+#if !defined(CONF_NO_OPUS)
 	#include <opusfile.h>
+#endif
 }
+
+#if defined(CONF_NO_OPUS)
+// builds without opusfile only load wavpack sounds, every opus file fails to open
+struct OggOpusFile;
+static OggOpusFile *op_open_memory(const unsigned char *pData, size_t Size, int *pError) { return 0; }
+static void op_free(OggOpusFile *pFile) {}
+static int op_read(OggOpusFile *pFile, short *pPcm, int BufSize, int *pLink) { return -1; }
+static int op_pcm_seek(OggOpusFile *pFile, int64 Offset) { return -1; }
+static int64 op_pcm_total(const OggOpusFile *pFile, int Link) { return -1; }
+static int op_channel_count(const OggOpusFile *pFile, int Link) { return 0; }
+#endif
 #include <math.h>
 
 enum
@@ -21,6 +35,70 @@ enum
 	NUM_SAMPLES = 512,
 	NUM_VOICES = 24,
 	NUM_CHANNELS = 16,
+
+	// voices are mixed in blocks of this many frames, volumes are taken once per block
+	MIX_BLOCK = 256,
+	RING_FRAMES = MIX_BLOCK*16,
+
+	OPUS_RATE = 48000,
+	STREAM_DECODE_FRAMES = 960,
+
+	PREDECODE_QUEUE = 64,
+};
+
+enum
+{
+	CODEC_NONE = 0, // raw pcm, never evicted
+	CODEC_WV,
+	CODEC_OPUS,
+};
+
+// linear interpolation in 16.16 fixed point. the last input frame is kept,
+// so consecutive chunks of a stream join without a step.
+struct CResampler
+{
+	int m_Step;
+	int64 m_Pos; // 16.16 overflows after 32767 frames
+	int m_Channels;
+	short m_aLast[2];
+
+	void Init(int SrcRate, int DstRate, int Channels)
+	{
+		m_Step = (int)(((int64)SrcRate<<16)/DstRate);
+		m_Pos = 1<<16;
+		m_Channels = Channels;
+		m_aLast[0] = m_aLast[1] = 0;
+	}
+
+	// frames written for InFrames of input at most, the step is rounded down
+	// so this can be more than InFrames*DstRate/SrcRate
+	int MaxFrames(int InFrames) const
+	{
+		return (int)(((int64)InFrames<<16)/m_Step) + 1;
+	}
+
+	int Process(const short *pIn, int InFrames, short *pOut)
+	{
+		int Out = 0;
+		while((m_Pos>>16) < InFrames)
+		{
+			int i = (int)(m_Pos>>16);
+			int Frac = (int)(m_Pos&0xffff)>>1;
+			for(int c = 0; c < m_Channels; c++)
+			{
+				int a = i ? pIn[(i-1)*m_Channels+c] : m_aLast[c];
+				int b = pIn[i*m_Channels+c];
+				*pOut++ = a + (((b-a)*Frac)>>15);
+			}
+			Out++;
+			m_Pos += m_Step;
+		}
+
+		m_Pos -= (int64)InFrames<<16;
+		for(int c = 0; c < m_Channels; c++)
+			m_aLast[c] = pIn[(InFrames-1)*m_Channels+c];
+		return Out;
+	}
 };
 
 struct CSample
@@ -33,6 +111,18 @@ struct CSample
 	int m_LoopStart;
 	int m_LoopEnd;
 	int m_PausedAt;
+
+	// the file as loaded. m_pData is decoded from it when the sample is
+	// played and freed again when the decoded budget runs out
+	unsigned char *m_pCompressed;
+	unsigned m_CompressedSize;
+	// holds m_pCompressed for sounds loaded from a file
+	IOMAP m_Map;
+	int m_Codec;
+	int m_LastUse;
+
+	// long opus sounds are never fully decoded, every voice decodes its own stream
+	bool m_Streamed;
 };
 
 struct CChannel
@@ -46,7 +136,7 @@ struct CVoice
 	CSample *m_pSample;
 	CChannel *m_pChannel;
 	int m_Age; // increases when reused
-	int m_Tick;
+	int m_Tick; // in frames at the mixing rate
 	int m_Vol; // 0 - 255
 	int m_Flags;
 	int m_X, m_Y;
@@ -58,6 +148,13 @@ struct CVoice
 		ISound::CVoiceShapeCircle m_Circle;
 		ISound::CVoiceShapeRectangle m_Rectangle;
 	};
+
+	// streamed voices, decoded and resampled a chunk at a time
+	OggOpusFile *m_pStream;
+	CResampler m_Resampler;
+	short *m_pStreamData;
+	int m_StreamFrames;
+	int m_StreamPos;
 };
 
 static CSample m_aSamples[NUM_SAMPLES] = { {0} };
@@ -76,9 +173,25 @@ static int m_NextVoice = 0;
 static int *m_pMixBuffer = 0;	// buffer only used by the thread callback function
 static unsigned m_MaxFrames = 0;
 
+// mixed blocks waiting for the sink, read and write are free running frame counters
+static short *m_pRingBuffer = 0;
+static unsigned m_RingRead = 0;
+static unsigned m_RingWrite = 0;
+
+// decoded pcm, everything but CODEC_NONE samples counts against snd_decoded_budget
+static int m_DecodedSize = 0;
+static int m_UseCounter = 0;
+static int m_NumDecodes = 0;
+static int m_NumEvictions = 0;
+static int64 m_LastDecodeTime = 0;
+static int64 m_MaxDecodeTime = 0;
+
+static int m_aPredecodeQueue[PREDECODE_QUEUE];
+static int m_PredecodeQueueSize = 0;
+
 static const void *ms_pWVBuffer = 0x0;
-static long int ms_WVBufferPosition = 0;
-static long int ms_WVBufferSize = 0;
+static int ms_WVBufferPosition = 0;
+static int ms_WVBufferSize = 0;
 
 const int DefaultDistance = 1500;
 
@@ -99,174 +212,435 @@ static int IntAbs(int i)
 	return i;
 }
 
+static bool IsStreamed(const CSample *pSample)
+{
+	return pSample->m_Streamed;
+}
 
-int CSound::Init()
+static int DecodedSize(const CSample *pSample)
 {
-	m_SoundEnabled = 0;
-	m_pGraphics = Kernel()->RequestInterface<IEngineGraphics>();
-	m_pStorage = Kernel()->RequestInterface<IStorage>();
+	return pSample->m_NumFrames*pSample->m_Channels*sizeof(short);
+}
 
-	// m_SoundLock = lock_create();
+// length in frames at the mixing rate
+static int VoiceLength(const CVoice *v)
+{
+	if(IsStreamed(v->m_pSample))
+		return (int)(v->m_pSample->m_NumFrames*(int64)m_MixingRate/(int64)v->m_pSample->m_Rate);
+	return v->m_pSample->m_NumFrames;
+}
 
-	if(!g_Config.m_SndEnable)
-		return 0;
+static void FreeVoice(CVoice *v)
+{
+	if(v->m_pStream)
+	{
+		op_free(v->m_pStream);
+		v->m_pStream = 0;
+	}
+	if(v->m_pStreamData)
+	{
+		mem_free(v->m_pStreamData);
+		v->m_pStreamData = 0;
+	}
+	v->m_pSample = 0;
+}
 
-	m_MixingRate = g_Config.m_SndRate;
+static bool OpenStream(CVoice *v)
+{
+	CSample *pSample = v->m_pSample;
+	v->m_pStream = op_open_memory(pSample->m_pCompressed, pSample->m_CompressedSize, NULL);
+	if(!v->m_pStream)
+		return false;
+
+	v->m_Resampler.Init(OPUS_RATE, (int)m_MixingRate, pSample->m_Channels);
+	int Capacity = v->m_Resampler.MaxFrames(STREAM_DECODE_FRAMES);
+	v->m_pStreamData = (short *)mem_alloc(Capacity*pSample->m_Channels*sizeof(short), 1);
+	v->m_StreamFrames = 0;
+	v->m_StreamPos = 0;
+	return true;
+}
 
-	m_SoundEnabled = 1;
-	Update(); // update the volume
-	return 0;
+static void SeekStream(CVoice *v, int Tick)
+{
+	op_pcm_seek(v->m_pStream, Tick*(int64)OPUS_RATE/(int64)m_MixingRate);
+	v->m_Resampler.Init(OPUS_RATE, (int)m_MixingRate, v->m_pSample->m_Channels);
+	v->m_StreamFrames = 0;
+	v->m_StreamPos = 0;
 }
 
-int CSound::Update()
+// decodes the next chunk, false at the end of the sound
+static bool FillStream(CVoice *v)
 {
-	/*
-	for (int i = 0; i < NUM_VOICES; i++) 
+	short aDecoded[STREAM_DECODE_FRAMES*2];
+	int Channels = v->m_pSample->m_Channels;
+	v->m_StreamPos = 0;
+	v->m_StreamFrames = 0;
+	while(v->m_StreamFrames == 0)
 	{
-		if (!m_aVoices[i].m_pSample) continue;
+		int Read = op_read(v->m_pStream, aDecoded, STREAM_DECODE_FRAMES*Channels, NULL);
+		if(Read <= 0)
+			return false;
+		v->m_StreamFrames = v->m_Resampler.Process(aDecoded, Read, v->m_pStreamData);
+	}
+	return true;
+}
 
-		CVoice *v = &m_aVoices[i];
+// tight fixed point loop, volumes are 0 - 255
+static void MixFrames(int *pOut, const short *pIn, int Frames, int Channels, int Lvol, int Rvol)
+{
+	const short *pInR = pIn + Channels - 1;
+	for(int i = 0; i < Frames; i++)
+	{
+		pOut[0] += pIn[0]*Lvol;
+		pOut[1] += pInR[0]*Rvol;
+		pOut += 2;
+		pIn += Channels;
+		pInR += Channels;
+	}
+}
 
-		int Rvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
-		int Lvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
+static void VoiceVolume(const CVoice *v, int *pLvol, int *pRvol)
+{
+	int Rvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
+	int Lvol = (int)(v->m_pChannel->m_Vol*(v->m_Vol/255.0f));
 
-		// volume calculation
-		if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+	// volume calculation
+	if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+	{
+		// TODO: we should respect the channel panning value
+		int dx = v->m_X - m_CenterX;
+		int dy = v->m_Y - m_CenterY;
+		//
+		int p = IntAbs(dx);
+		float FalloffX = 0.0f;
+		float FalloffY = 0.0f;
+
+		int RangeX = 0; // for panning
+		bool InVoiceField = false;
+
+		switch(v->m_Shape)
 		{
-			// TODO: we should respect the channel panning value
-			int dx = v->m_X - m_CenterX;
-			int dy = v->m_Y - m_CenterY;
-			//
-			int p = IntAbs(dx);
-			float FalloffX = 0.0f;
-			float FalloffY = 0.0f;
-
-			int RangeX = 0; // for panning
-			bool InVoiceField = false;
-
-			switch(v->m_Shape)
+		case ISound::SHAPE_CIRCLE:
 			{
-			case ISound::SHAPE_CIRCLE:
+				float r = v->m_Circle.m_Radius;
+				RangeX = r;
+
+				int Dist = (int)sqrtf((float)dx*dx+dy*dy); // nasty float
+				if(Dist < r)
 				{
-					float r = v->m_Circle.m_Radius;
-					RangeX = r;
-
-					int Dist = (int)sqrtf((float)dx*dx+dy*dy); // nasty float
-					if(Dist < r)
-					{
-						InVoiceField = true;
-
-						// falloff
-						int FalloffDistance = r*v->m_Falloff;
-						if(Dist > FalloffDistance)
-							FalloffX = FalloffY = (r-Dist)/(r-FalloffDistance);
-						else
-							FalloffX = FalloffY = 1.0f;
-					}
-					else
-						InVoiceField = false;
+					InVoiceField = true;
 
-					break;
+					// falloff
+					int FalloffDistance = r*v->m_Falloff;
+					if(Dist > FalloffDistance)
+						FalloffX = FalloffY = (r-Dist)/(r-FalloffDistance);
+					else
+						FalloffX = FalloffY = 1.0f;
 				}
+				else
+					InVoiceField = false;
 
-			case ISound::SHAPE_RECTANGLE:
-				{
-					RangeX = v->m_Rectangle.m_Width/2.0f;
+				break;
+			}
 
-					int abs_dx = abs(dx);
-					int abs_dy = abs(dy);
+		case ISound::SHAPE_RECTANGLE:
+			{
+				RangeX = v->m_Rectangle.m_Width/2.0f;
 
-					int w = v->m_Rectangle.m_Width/2.0f;
-					int h = v->m_Rectangle.m_Height/2.0f;
+				int abs_dx = abs(dx);
+				int abs_dy = abs(dy);
 
-					if(abs_dx < w && abs_dy < h)
-					{
-						InVoiceField = true;
+				int w = v->m_Rectangle.m_Width/2.0f;
+				int h = v->m_Rectangle.m_Height/2.0f;
 
-						// falloff
-						int fx = v->m_Falloff * w;
-						int fy = v->m_Falloff * h;
+				if(abs_dx < w && abs_dy < h)
+				{
+					InVoiceField = true;
 
-						FalloffX = abs_dx > fx ? (float)(w-abs_dx)/(w-fx) : 1.0f;
-						FalloffY = abs_dy > fy ? (float)(h-abs_dy)/(h-fy) : 1.0f;
-					}
-					else
-						InVoiceField = false;
+					// falloff
+					int fx = v->m_Falloff * w;
+					int fy = v->m_Falloff * h;
 
-					break;
+					FalloffX = abs_dx > fx ? (float)(w-abs_dx)/(w-fx) : 1.0f;
+					FalloffY = abs_dy > fy ? (float)(h-abs_dy)/(h-fy) : 1.0f;
 				}
-			};
+				else
+					InVoiceField = false;
 
-			if(InVoiceField)
-			{
-				// panning
-				if(!(v->m_Flags&ISound::FLAG_NO_PANNING))
-				{
-					if(dx > 0)
-						Lvol = ((RangeX-p)*Lvol)/RangeX;
-					else
-						Rvol = ((RangeX-p)*Rvol)/RangeX;
-				}
+				break;
+			}
+		};
 
-				{
-					Lvol *= FalloffX;
-					Rvol *= FalloffY;
-				}
+		if(InVoiceField)
+		{
+			// panning
+			if(!(v->m_Flags&ISound::FLAG_NO_PANNING))
+			{
+				if(dx > 0)
+					Lvol = ((RangeX-p)*Lvol)/RangeX;
+				else
+					Rvol = ((RangeX-p)*Rvol)/RangeX;
 			}
-			else
+
 			{
-				Lvol = 0;
-				Rvol = 0;
+				Lvol *= FalloffX;
+				Rvol *= FalloffY;
 			}
 		}
+		else
+		{
+			Lvol = 0;
+			Rvol = 0;
+		}
+	}
 
-		float mix[12] = {0.f};
-		mix[0] = Lvol/255.f;
-		mix[1] = Rvol/255.f;
-		ndspChnSetMix(i, mix);
+	*pLvol = Lvol;
+	*pRvol = Rvol;
+}
+
+static void MixVoice(CVoice *v, int *pOut, int Frames)
+{
+	int Lvol, Rvol;
+	VoiceVolume(v, &Lvol, &Rvol);
 
-		if(!ndspChnIsPlaying(i))
+	CSample *pSample = v->m_pSample;
+	int Channels = pSample->m_Channels;
+	int Done = 0;
+	while(Done < Frames)
+	{
+		int Num;
+		if(IsStreamed(pSample))
 		{
-			if (!v->m_Tick)
+			if(v->m_StreamPos == v->m_StreamFrames && !FillStream(v))
 			{
-				// play sound
-				ndspWaveBuf* buf = &m_aVoices[i].m_WaveBuf;
-				DSP_FlushDataCache(buf->data_pcm16, buf->nsamples);
-				ndspChnWaveBufAdd(i, buf);
+				// end of the stream
+				if(v->m_Flags&ISound::FLAG_LOOP && pSample->m_NumFrames > 0)
+				{
+					SeekStream(v, 0);
+					v->m_Tick = 0;
+					continue;
+				}
+				FreeVoice(v);
+				v->m_Age++;
+				return;
 			}
-			else
+
+			Num = min(Frames-Done, v->m_StreamFrames-v->m_StreamPos);
+			MixFrames(pOut+Done*2, v->m_pStreamData+v->m_StreamPos*Channels, Num, Channels, Lvol, Rvol);
+			v->m_StreamPos += Num;
+			v->m_Tick += Num;
+		}
+		else
+		{
+			Num = min(Frames-Done, (int)pSample->m_NumFrames-v->m_Tick);
+			if(Num > 0)
+			{
+				MixFrames(pOut+Done*2, pSample->m_pData+v->m_Tick*Channels, Num, Channels, Lvol, Rvol);
+				v->m_Tick += Num;
+			}
+
+			if(v->m_Tick >= (int)pSample->m_NumFrames)
 			{
 				// loop sound or free this voice
-				if(v->m_Flags&ISound::FLAG_LOOP)
+				if(v->m_Flags&ISound::FLAG_LOOP && pSample->m_NumFrames > 0)
 					v->m_Tick = 0;
 				else
 				{
-					v->m_pSample = 0;
+					FreeVoice(v);
 					v->m_Age++;
+					return;
 				}
 			}
 		}
+		Done += Num;
+	}
+}
+
+static void Mix(short *pFinalOut, unsigned Frames)
+{
+	mem_zero(m_pMixBuffer, Frames*2*sizeof(int));
+
+	for(unsigned i = 0; i < NUM_VOICES; i++)
+	{
+		if(m_aVoices[i].m_pSample)
+			MixVoice(&m_aVoices[i], m_pMixBuffer, Frames);
+	}
+
+	// release the lock as soon as possible
+	// lock_unlock(m_SoundLock);
+
+	// master volume and clamp
+	int MasterVol = m_SoundVolume;
+	for(unsigned i = 0; i < Frames*2; i++)
+		pFinalOut[i] = Int2Short(((m_pMixBuffer[i]*MasterVol)/101)>>8);
+}
+
+int CSound::Init()
+{
+	m_SoundEnabled = 0;
+	m_pGraphics = Kernel()->RequestInterface<IEngineGraphics>();
+	m_pStorage = Kernel()->RequestInterface<IStorage>();
+	m_pSink = 0;
+
+	// m_SoundLock = lock_create();
+
+	if(!g_Config.m_SndEnable)
+		return 0;
+
+	m_MixingRate = g_Config.m_SndRate;
+	m_MaxFrames = g_Config.m_SndBufferSize;
+
+	m_pMixBuffer = (int *)mem_alloc(MIX_BLOCK*2*sizeof(int), 1);
+	m_pRingBuffer = (short *)mem_alloc(RING_FRAMES*2*sizeof(short), 1);
+	m_RingRead = m_RingWrite = 0;
+
+	m_pSink = CreateSoundSink(g_Config.m_SndOutput, m_pStorage);
+	if(!m_pSink->Open((int)m_MixingRate, PullFrames, this))
+	{
+		dbg_msg("sound", "unable to open the '%s' output", m_pSink->Name());
+		delete m_pSink;
+		m_pSink = 0;
+		return -1;
+	}
+	dbg_msg("sound", "mixing at %dhz to the '%s' output", (int)m_MixingRate, m_pSink->Name());
+
+	if(g_Config.m_DbgBenchSound)
+		RunBenchmark(g_Config.m_DbgBenchSound);
+
+	m_SoundEnabled = 1;
+	Update(); // update the volume
+	return 0;
+}
+
+void CSound::PullFrames(short *pOut, int Frames, void *pUser)
+{
+	while(Frames > 0)
+	{
+		// mix whole blocks, a block never wraps around the end of the ring
+		if(m_RingRead == m_RingWrite)
+		{
+			Mix(m_pRingBuffer+(m_RingWrite%RING_FRAMES)*2, MIX_BLOCK);
+			m_RingWrite += MIX_BLOCK;
+		}
 
-		v->m_Tick++;
+		unsigned Pos = m_RingRead%RING_FRAMES;
+		int Num = min(Frames, (int)min(m_RingWrite-m_RingRead, RING_FRAMES-Pos));
+		mem_copy(pOut, m_pRingBuffer+Pos*2, Num*2*sizeof(short));
+		pOut += Num*2;
+		Frames -= Num;
+		m_RingRead += Num;
 	}
-	*/
+}
 
+int CSound::Update()
+{
+	// update volume
+	int WantedVolume = g_Config.m_SndVolume;
+
+	if(!m_pGraphics->WindowActive() && g_Config.m_SndNonactiveMute)
+		WantedVolume = 0;
+
+	m_SoundVolume = WantedVolume;
+
+	// at most one queued sample per frame, so the decoding is spread out
+	if(m_PredecodeQueueSize > 0)
+	{
+		int SampleID = m_aPredecodeQueue[0];
+		if(--m_PredecodeQueueSize > 0)
+			mem_move(m_aPredecodeQueue, m_aPredecodeQueue+1, m_PredecodeQueueSize*sizeof(int));
+
+		// only guess while there is room, played sounds are never pushed out for it
+		CSample *pSample = &m_aSamples[SampleID];
+		if(!pSample->m_pData && pSample->m_pCompressed && !IsStreamed(pSample))
+		{
+			int Size = (int)(pSample->m_NumFrames*(int64)m_MixingRate/(int64)pSample->m_Rate)*pSample->m_Channels*sizeof(short);
+			if(m_DecodedSize+Size <= g_Config.m_SndDecodedBudget*1024)
+				DecodeSample(SampleID);
+		}
+	}
+	EvictSamples(-1);
+
+	if(m_pSink)
+		m_pSink->Update();
 	return 0;
 }
 
 int CSound::Shutdown()
 {
+	StopAll();
+	if(m_pSink)
+	{
+		m_pSink->Close();
+		delete m_pSink;
+		m_pSink = 0;
+	}
+
 	// lock_destroy(m_SoundLock);
-	//ndspExit();
+	mem_free(m_pMixBuffer);
+	m_pMixBuffer = 0;
+	mem_free(m_pRingBuffer);
+	m_pRingBuffer = 0;
 	return 0;
 }
 
+void CSound::RunBenchmark(int MaxVoices)
+{
+	// one second of noise, already at the mixing rate
+	int SampleID = AllocID();
+	if(SampleID < 0)
+		return;
+	CSample *pSample = &m_aSamples[SampleID];
+	pSample->m_NumFrames = (uint32_t)m_MixingRate;
+	pSample->m_Rate = m_MixingRate;
+	pSample->m_Channels = 1;
+	pSample->m_pData = (short *)mem_alloc(pSample->m_NumFrames*sizeof(short), 1);
+	for(uint32_t i = 0; i < pSample->m_NumFrames; i++)
+		pSample->m_pData[i] = (short)((i*7919)&0xffff);
+
+	short aOut[MIX_BLOCK*2];
+	int Blocks = (int)m_MixingRate*2/MIX_BLOCK;
+	CChannel OldChannel = m_aChannels[0];
+	SetChannel(0, 1.0f, 1.0f);
+	MaxVoices = min(MaxVoices, (int)NUM_VOICES);
+	for(int Voices = 1; ; Voices = min(Voices*2, MaxVoices))
+	{
+		// positional voices around the listener, some of them panned
+		for(int i = 0; i < Voices; i++)
+		{
+			CVoiceHandle Voice = PlayAt(0, SampleID, FLAG_LOOP|(i&1 ? FLAG_NO_PANNING : 0), (i-Voices/2)*100.0f, 0.0f);
+			if(i&2)
+				SetVoiceRectangle(Voice, 2000.0f, 1000.0f);
+			SetVoiceFalloff(Voice, 0.5f);
+		}
+
+		// through the output like in a game, if it can be driven
+		int64 Start = time_get();
+		if(!m_pSink->Pump(Blocks*MIX_BLOCK))
+		{
+			for(int b = 0; b < Blocks; b++)
+				PullFrames(aOut, MIX_BLOCK, this);
+		}
+		int64 Time = time_get()-Start;
+		StopAll();
+
+		float Seconds = Blocks*MIX_BLOCK/m_MixingRate;
+		float PerVoice = Time*1000000.0f/time_freq()/Voices/Seconds;
+		dbg_msg("bench", "sound %d voices to '%s': %.1fus per voice per second of audio, %.2f%% of realtime",
+			Voices, m_pSink->Name(), PerVoice, Time*100.0f/time_freq()/Seconds);
+		if(Voices == MaxVoices)
+			break;
+	}
+	m_aChannels[0] = OldChannel;
+
+	UnloadSample(SampleID);
+}
+
 int CSound::AllocID()
 {
 	// TODO: linear search, get rid of it
 	for(unsigned SampleID = 0; SampleID < NUM_SAMPLES; SampleID++)
 	{
-		if(m_aSamples[SampleID].m_pData == 0x0)
+		if(m_aSamples[SampleID].m_pData == 0x0 && m_aSamples[SampleID].m_pCompressed == 0x0)
 			return SampleID;
 	}
 
@@ -280,30 +654,16 @@ void CSound::RateConvert(int SampleID)
 	short *pNewData = 0;
 
 	// make sure that we need to convert this sound
-	if(!pSample->m_pData || pSample->m_Rate == m_MixingRate)
+	if(!pSample->m_pData || pSample->m_Rate == m_MixingRate || !pSample->m_NumFrames)
 		return;
 
+	CResampler Resampler;
+	Resampler.Init((int)pSample->m_Rate, (int)m_MixingRate, pSample->m_Channels);
+
 	// allocate new data
-	NumFrames = (uint32_t)((pSample->m_NumFrames/pSample->m_Rate)*m_MixingRate);
+	NumFrames = Resampler.MaxFrames(pSample->m_NumFrames);
 	pNewData = (short *)mem_alloc(NumFrames*pSample->m_Channels*sizeof(short), 1);
-
-	for(uint32_t i = 0; i < NumFrames; i++)
-	{
-		// resample TODO: this should be done better, like linear atleast
-		float a = i/(float)NumFrames;
-		uint32_t f = (uint32_t)(a*pSample->m_NumFrames);
-		if(f >= pSample->m_NumFrames)
-			f = pSample->m_NumFrames-1;
-
-		// set new data
-		if(pSample->m_Channels == 1)
-			pNewData[i] = pSample->m_pData[f];
-		else if(pSample->m_Channels == 2)
-		{
-			pNewData[i*2] = pSample->m_pData[f*2];
-			pNewData[i*2+1] = pSample->m_pData[f*2+1];
-		}
-	}
+	NumFrames = Resampler.Process(pSample->m_pData, pSample->m_NumFrames, pNewData);
 
 	// free old data and apply new
 	mem_free(pSample->m_pData);
@@ -312,57 +672,220 @@ void CSound::RateConvert(int SampleID)
 	pSample->m_Rate = m_MixingRate;
 }
 
-long int CSound::ReadData(void *pBuffer, long int Size)
+int CSound::ReadData(void *pBuffer, int Size)
 {
-	long int ChunkSize = min(Size, ms_WVBufferSize - ms_WVBufferPosition);
+	int ChunkSize = min(Size, ms_WVBufferSize - ms_WVBufferPosition);
 	mem_copy(pBuffer, (const char *)ms_pWVBuffer + ms_WVBufferPosition, ChunkSize);
 	ms_WVBufferPosition += ChunkSize;
 	return ChunkSize;
 }
 
-int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize)
+// takes over the view if there is one, copies the data otherwise
+static void StoreCompressed(CSample *pSample, const void *pData, unsigned DataSize, int Codec, IOMAP *pMap)
 {
-	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
-		return -1;
+	if(pMap)
+	{
+		pSample->m_Map = *pMap;
+		mem_zero(pMap, sizeof(*pMap));
+		pSample->m_pCompressed = (unsigned char *)pSample->m_Map.data;
+	}
+	else
+	{
+		pSample->m_pCompressed = (unsigned char *)mem_alloc(DataSize, 1);
+		mem_copy(pSample->m_pCompressed, pData, DataSize);
+	}
+	pSample->m_CompressedSize = DataSize;
+	pSample->m_Codec = Codec;
+	pSample->m_LastUse = 0;
+	pSample->m_LoopStart = -1;
+	pSample->m_LoopEnd = -1;
+	pSample->m_PausedAt = 0;
+}
 
-	CSample *pSample = &m_aSamples[SampleID];
+static void FreeDecoded(CSample *pSample)
+{
+	if(!pSample->m_pData)
+		return;
+	if(pSample->m_Codec != CODEC_NONE)
+		m_DecodedSize -= DecodedSize(pSample);
+	mem_free(pSample->m_pData);
+	pSample->m_pData = 0;
+}
 
-	OggOpusFile *OpusFile = op_open_memory((const unsigned char *) pData, DataSize, NULL);
-	if (OpusFile)
+static void FreeSample(CSample *pSample)
+{
+	FreeDecoded(pSample);
+	if(pSample->m_Map.data)
+		io_unmap(&pSample->m_Map);
+	else
+		mem_free(pSample->m_pCompressed);
+	pSample->m_pCompressed = 0;
+	pSample->m_Codec = CODEC_NONE;
+	pSample->m_Streamed = false;
+}
+
+static bool IsPlaying(const CSample *pSample)
+{
+	for(int i = 0; i < NUM_VOICES; i++)
 	{
-		int NumChannels = op_channel_count(OpusFile, -1);
-		int NumSamples = op_pcm_total(OpusFile, -1); // per channel!
+		if(m_aVoices[i].m_pSample == pSample)
+			return true;
+	}
+	return false;
+}
 
-		pSample->m_Channels = NumChannels;
+static bool UnpackOpus(CSample *pSample)
+{
+	OggOpusFile *OpusFile = op_open_memory(pSample->m_pCompressed, pSample->m_CompressedSize, NULL);
+	if(!OpusFile)
+	{
+		dbg_msg("sound/opus", "failed to decode sample");
+		return false;
+	}
 
-		if(pSample->m_Channels > 2)
-		{
-			dbg_msg("sound/opus", "file is not mono or stereo.");
-			return -1;
-		}
+	int NumChannels = pSample->m_Channels;
+	int NumSamples = op_pcm_total(OpusFile, -1); // per channel!
+	pSample->m_pData = (short *)mem_alloc(NumSamples * sizeof(short) * NumChannels, 1);
+
+	int Read;
+	int Pos = 0;
+	while (Pos < NumSamples)
+	{
+		Read = op_read(OpusFile, pSample->m_pData + Pos*NumChannels, (NumSamples-Pos)*NumChannels, NULL);
+		if(Read <= 0)
+			break;
+		Pos += Read;
+	}
+
+	op_free(OpusFile);
+
+	pSample->m_NumFrames = NumSamples; // ?
+	pSample->m_Rate = OPUS_RATE;
+	return true;
+}
+
+static bool UnpackWV(CSample *pSample)
+{
+	char aError[100];
+	ms_pWVBuffer = pSample->m_pCompressed;
+	ms_WVBufferSize = pSample->m_CompressedSize;
+	ms_WVBufferPosition = 0;
+
+	WavpackContext *pContext = WavpackOpenFileInput(CSound::ReadData, aError);
+	if(!pContext)
+	{
+		dbg_msg("sound/wv", "failed to decode sample (%s)", aError);
+		return false;
+	}
+
+	int NumSamples = WavpackGetNumSamples(pContext);
+	int NumChannels = WavpackGetNumChannels(pContext);
 
-		pSample->m_pData = (short *)mem_alloc(NumSamples * sizeof(short) * NumChannels, 1);
+	int32_t *pBuffer = (int32_t *)mem_alloc(4*NumSamples*NumChannels, 1);
+	WavpackUnpackSamples(pContext, pBuffer, NumSamples); // TODO: check return value
+	int32_t *pSrc = pBuffer;
 
-		int Read;
-		int Pos = 0;
-		while (Pos < NumSamples)
+	pSample->m_pData = (short *)mem_alloc(2*NumSamples*NumChannels, 1);
+	short *pDst = pSample->m_pData;
+
+	for(int i = 0; i < NumSamples*NumChannels; i++)
+		*pDst++ = (short)*pSrc++;
+
+	mem_free(pBuffer);
+
+	pSample->m_NumFrames = NumSamples;
+	pSample->m_Rate = WavpackGetSampleRate(pContext);
+	return true;
+}
+
+bool CSound::DecodeSample(int SampleID)
+{
+	CSample *pSample = &m_aSamples[SampleID];
+	if(pSample->m_pData)
+		return true;
+	if(!pSample->m_pCompressed || IsStreamed(pSample))
+		return false;
+
+	int64 Start = time_get();
+	bool Result = pSample->m_Codec == CODEC_WV ? UnpackWV(pSample) : UnpackOpus(pSample);
+	if(!Result)
+		return false;
+	RateConvert(SampleID);
+	int64 Time = time_get()-Start;
+
+	m_DecodedSize += DecodedSize(pSample);
+	m_NumDecodes++;
+	m_LastDecodeTime = Time;
+	m_MaxDecodeTime = max(m_MaxDecodeTime, Time);
+	pSample->m_LastUse = ++m_UseCounter;
+	EvictSamples(SampleID);
+
+	if(g_Config.m_Debug)
+		dbg_msg("sound", "decoded sample %d, %d bytes in %.2fms", SampleID, DecodedSize(pSample), Time*1000.0f/time_freq());
+	return true;
+}
+
+void CSound::EvictSamples(int KeepID)
+{
+	int Budget = g_Config.m_SndDecodedBudget*1024;
+	while(m_DecodedSize > Budget)
+	{
+		// the least recently played sample that no voice is using
+		int Oldest = -1;
+		for(int i = 0; i < NUM_SAMPLES; i++)
 		{
-			Read = op_read(OpusFile, pSample->m_pData + Pos*NumChannels, NumSamples*NumChannels, NULL);
-			Pos += Read;
+			CSample *pSample = &m_aSamples[i];
+			if(i == KeepID || !pSample->m_pData || pSample->m_Codec == CODEC_NONE || IsPlaying(pSample))
+				continue;
+			if(Oldest == -1 || pSample->m_LastUse < m_aSamples[Oldest].m_LastUse)
+				Oldest = i;
 		}
+		if(Oldest == -1)
+			break;
 
-		pSample->m_NumFrames = NumSamples; // ?
-		pSample->m_Rate = 48000;
-		pSample->m_LoopStart = -1;
-		pSample->m_LoopEnd = -1;
-		pSample->m_PausedAt = 0;
+		FreeDecoded(&m_aSamples[Oldest]);
+		m_NumEvictions++;
 	}
-	else
+}
+
+// keeps the file and reads the header, the pcm is decoded by DecodeSample
+int CSound::DecodeOpus(int SampleID, const void *pData, unsigned DataSize, IOMAP *pMap)
+{
+	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
+		return -1;
+
+	CSample *pSample = &m_aSamples[SampleID];
+
+	OggOpusFile *OpusFile = op_open_memory((const unsigned char *) pData, DataSize, NULL);
+	if(!OpusFile)
 	{
 		dbg_msg("sound/opus", "failed to decode sample");
 		return -1;
 	}
 
+	int NumChannels = op_channel_count(OpusFile, -1);
+	int NumSamples = op_pcm_total(OpusFile, -1); // per channel!
+	op_free(OpusFile);
+
+	if(NumChannels > 2)
+	{
+		dbg_msg("sound/opus", "file is not mono or stereo.");
+		return -1;
+	}
+
+	pSample->m_Channels = NumChannels;
+	pSample->m_NumFrames = NumSamples;
+	pSample->m_Rate = OPUS_RATE;
+	StoreCompressed(pSample, pData, DataSize, CODEC_OPUS, pMap);
+
+	// keep long sounds compressed, every voice decodes its own stream
+	pSample->m_Streamed = g_Config.m_SndStreamLength && NumSamples > g_Config.m_SndStreamLength*OPUS_RATE;
+
+	if(!pSample->m_Streamed && !g_Config.m_SndLazyDecode && !DecodeSample(SampleID))
+	{
+		FreeSample(pSample);
+		return -1;
+	}
 	return SampleID;
 }
 
@@ -380,54 +903,40 @@ int CSound::DecodeWV(int SampleID, const void *pData, unsigned DataSize)
 	ms_WVBufferPosition = 0;
 
 	pContext = WavpackOpenFileInput(ReadData, aError);
-	if (pContext)
+	if(!pContext)
 	{
-		int NumSamples = WavpackGetNumSamples(pContext);
-		int BitsPerSample = WavpackGetBitsPerSample(pContext);
-		unsigned int SampleRate = WavpackGetSampleRate(pContext);
-		int NumChannels = WavpackGetNumChannels(pContext);
-		int32_t *pSrc;
-		short *pDst;
-		int i;
-
-		pSample->m_Channels = NumChannels;
-		pSample->m_Rate = SampleRate;
-
-		if(pSample->m_Channels > 2)
-		{
-			dbg_msg("sound/wv", "file is not mono or stereo.");
-			return -1;
-		}
-
-		if(BitsPerSample != 16)
-		{
-			dbg_msg("sound/wv", "bps is %d, not 16", BitsPerSample);
-			return -1;
-		}
+		dbg_msg("sound/wv", "failed to decode sample (%s)", aError);
+		return -1;
+	}
 
-		int32_t *pBuffer = (int32_t *)mem_alloc(4*NumSamples*NumChannels, 1);
-		WavpackUnpackSamples(pContext, pBuffer, NumSamples); // TODO: check return value
-		pSrc = pBuffer;
+	int NumSamples = WavpackGetNumSamples(pContext);
+	int BitsPerSample = WavpackGetBitsPerSample(pContext);
+	unsigned int SampleRate = WavpackGetSampleRate(pContext);
+	int NumChannels = WavpackGetNumChannels(pContext);
 
-		pSample->m_pData = (short *)mem_alloc(2*NumSamples*NumChannels, 1);
-		pDst = pSample->m_pData;
+	if(NumChannels > 2)
+	{
+		dbg_msg("sound/wv", "file is not mono or stereo.");
+		return -1;
+	}
 
-		for (i = 0; i < NumSamples*NumChannels; i++)
-			*pDst++ = (short)*pSrc++;
+	if(BitsPerSample != 16)
+	{
+		dbg_msg("sound/wv", "bps is %d, not 16", BitsPerSample);
+		return -1;
+	}
 
-		mem_free(pBuffer);
+	pSample->m_Channels = NumChannels;
+	pSample->m_NumFrames = NumSamples;
+	pSample->m_Rate = SampleRate;
+	pSample->m_Streamed = false;
+	StoreCompressed(pSample, pData, DataSize, CODEC_WV, 0);
 
-		pSample->m_NumFrames = NumSamples;
-		pSample->m_LoopStart = -1;
-		pSample->m_LoopEnd = -1;
-		pSample->m_PausedAt = 0;
-	}
-	else
+	if(!g_Config.m_SndLazyDecode && !DecodeSample(SampleID))
 	{
-		dbg_msg("sound/wv", "failed to decode sample (%s)", aError);
+		FreeSample(pSample);
 		return -1;
 	}
-
 	return SampleID;
 }
 
@@ -444,8 +953,9 @@ int CSound::LoadOpus(const char *pFilename)
 	if(!m_pStorage)
 		return -1;
 
-	ms_File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
-	if(!ms_File)
+	// the sample keeps the view as its compressed data
+	IOMAP Map;
+	if(!m_pStorage->MapFile(pFilename, IStorage::TYPE_ALL, &Map))
 	{
 		dbg_msg("sound/opus", "failed to open file. filename='%s'", pFilename);
 		return -1;
@@ -453,31 +963,17 @@ int CSound::LoadOpus(const char *pFilename)
 
 	int SampleID = AllocID();
 	if(SampleID < 0)
-		return -1;
-
-	// read the whole file into memory
-	int DataSize = io_length(ms_File);
-
-	if(DataSize <= 0)
 	{
-		io_close(ms_File);
-		dbg_msg("sound/opus", "failed to open file. filename='%s'", pFilename);
+		io_unmap(&Map);
 		return -1;
 	}
 
-	char *pData = new char[DataSize];
-	io_read(ms_File, pData, DataSize);
-
-	SampleID = DecodeOpus(SampleID, pData, DataSize);
-
-	delete[] pData;
-	io_close(ms_File);
-	ms_File = NULL;
+	SampleID = DecodeOpus(SampleID, Map.data, Map.size, &Map);
+	io_unmap(&Map);
 
 	if(g_Config.m_Debug)
 		dbg_msg("sound/opus", "loaded %s", pFilename);
 
-	RateConvert(SampleID);
 	return SampleID;
 }
 
@@ -528,7 +1024,6 @@ int CSound::LoadWV(const char *pFilename)
 	if(g_Config.m_Debug)
 		dbg_msg("sound/wv", "loaded %s", pFilename);
 
-	RateConvert(SampleID);
 	return SampleID;
 }
 
@@ -549,10 +1044,7 @@ int CSound::LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEdito
 	if(SampleID < 0)
 		return -1;
 
-	SampleID = DecodeOpus(SampleID, pData, DataSize);
-
-	RateConvert(SampleID);
-	return SampleID;
+	return DecodeOpus(SampleID, pData, DataSize);
 }
 
 int CSound::LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor = false)
@@ -572,10 +1064,7 @@ int CSound::LoadWVFromMem(const void *pData, unsigned DataSize, bool FromEditor
 	if(SampleID < 0)
 		return -1;
 
-	SampleID = DecodeWV(SampleID, pData, DataSize);
-
-	RateConvert(SampleID);
-	return SampleID;
+	return DecodeWV(SampleID, pData, DataSize);
 }
 
 void CSound::UnloadSample(int SampleID)
@@ -584,9 +1073,45 @@ void CSound::UnloadSample(int SampleID)
 		return;
 
 	Stop(SampleID);
-	mem_free(m_aSamples[SampleID].m_pData);
+	FreeSample(&m_aSamples[SampleID]);
+}
+
+void CSound::Predecode(int SampleID)
+{
+	if(SampleID < 0 || SampleID >= NUM_SAMPLES || m_PredecodeQueueSize == PREDECODE_QUEUE)
+		return;
+
+	CSample *pSample = &m_aSamples[SampleID];
+	if(pSample->m_pData || !pSample->m_pCompressed || IsStreamed(pSample))
+		return;
+
+	for(int i = 0; i < m_PredecodeQueueSize; i++)
+	{
+		if(m_aPredecodeQueue[i] == SampleID)
+			return;
+	}
+	m_aPredecodeQueue[m_PredecodeQueueSize++] = SampleID;
+}
+
+void CSound::GetStats(CStats *pStats)
+{
+	mem_zero(pStats, sizeof(*pStats));
+	for(int i = 0; i < NUM_SAMPLES; i++)
+	{
+		if(!m_aSamples[i].m_pCompressed)
+			continue;
+		pStats->m_NumSamples++;
+		pStats->m_CompressedSize += m_aSamples[i].m_CompressedSize;
+		if(m_aSamples[i].m_pData)
+			pStats->m_NumDecoded++;
+	}
 
-	m_aSamples[SampleID].m_pData = 0x0;
+	pStats->m_DecodedSize = m_DecodedSize;
+	pStats->m_DecodedBudget = g_Config.m_SndDecodedBudget*1024;
+	pStats->m_NumDecodes = m_NumDecodes;
+	pStats->m_NumEvictions = m_NumEvictions;
+	pStats->m_LastDecodeTime = m_LastDecodeTime*1000.0f/time_freq();
+	pStats->m_MaxDecodeTime = m_MaxDecodeTime*1000.0f/time_freq();
 }
 
 float CSound::GetSampleDuration(int SampleID)
@@ -656,31 +1181,33 @@ void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float offset)
 		return;
 
 	// lock_wait(m_SoundLock);
-	/*
 	{
-		if(m_aVoices[VoiceID].m_pSample)
+		CVoice *v = &m_aVoices[VoiceID];
+		if(v->m_pSample)
 		{
 			int Tick = 0;
-			bool IsLooping = m_aVoices[VoiceID].m_Flags&ISound::FLAG_LOOP;
-			uint64_t TickOffset = m_aVoices[VoiceID].m_pSample->m_Rate * offset;
-			if(m_aVoices[VoiceID].m_pSample->m_NumFrames > 0 && IsLooping)
-				Tick = TickOffset % m_aVoices[VoiceID].m_pSample->m_NumFrames;
+			int Length = VoiceLength(v);
+			bool IsLooping = v->m_Flags&ISound::FLAG_LOOP;
+			uint64_t TickOffset = m_MixingRate * offset;
+			if(Length > 0 && IsLooping)
+				Tick = TickOffset % Length;
 			else
-				Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)m_aVoices[VoiceID].m_pSample->m_NumFrames);
+				Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)Length);
 
 			// at least 200msec off, else depend on buffer size
-			float Threshold = max(0.2f * m_aVoices[VoiceID].m_pSample->m_Rate, (float)m_MaxFrames);
-			if(abs(m_aVoices[VoiceID].m_Tick-Tick) > Threshold)
+			float Threshold = max(0.2f * m_MixingRate, (float)m_MaxFrames);
+			if(abs(v->m_Tick-Tick) > Threshold)
 			{
 				// take care of looping (modulo!)
-				if( !(IsLooping && (min(m_aVoices[VoiceID].m_Tick, Tick) + m_aVoices[VoiceID].m_pSample->m_NumFrames - max(m_aVoices[VoiceID].m_Tick, Tick)) <= Threshold))
+				if( !(IsLooping && (min(v->m_Tick, Tick) + Length - max(v->m_Tick, Tick)) <= Threshold))
 				{
-					m_aVoices[VoiceID].m_Tick = Tick;
+					v->m_Tick = Tick;
+					if(v->m_pStream)
+						SeekStream(v, Tick);
 				}
 			}
 		}
 	}
-	*/
 	// lock_unlock(m_SoundLock);
 }
 
@@ -739,6 +1266,15 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float
 		}
 	}
 
+	// decode on first use
+	if(VoiceID != -1 && !IsStreamed(&m_aSamples[SampleID]))
+	{
+		if(DecodeSample(SampleID))
+			m_aSamples[SampleID].m_LastUse = ++m_UseCounter;
+		else
+			VoiceID = -1;
+	}
+
 	// voice found, use it
 	if(VoiceID != -1)
 	{
@@ -754,15 +1290,14 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float
 		m_aVoices[VoiceID].m_Circle.m_Radius = DefaultDistance;
 		Age = m_aVoices[VoiceID].m_Age;
 
-		/*
-		ndspChnReset(VoiceID);
-		ndspChnSetFormat(VoiceID, m_aSamples[SampleID].m_Format);
-		ndspChnSetRate(VoiceID, m_aSamples[SampleID].m_Rate);
+		if(IsStreamed(&m_aSamples[SampleID]) && !OpenStream(&m_aVoices[VoiceID]))
+		{
+			dbg_msg("sound/opus", "failed to open stream");
+			FreeVoice(&m_aVoices[VoiceID]);
+			VoiceID = -1;
+			Age = -1;
+		}
 
-		buf->looping    = !!(Flags & FLAG_LOOP);
-		buf->data_pcm16 = m_aSamples[SampleID].m_pData;
-		buf->nsamples   = m_aSamples[SampleID].m_NumFrames;
-		*/
 	}
 
 	// lock_unlock(m_SoundLock);
@@ -792,7 +1327,7 @@ void CSound::Stop(int SampleID)
 				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
 			else
 				m_aVoices[i].m_pSample->m_PausedAt = 0;
-			m_aVoices[i].m_pSample = 0;
+			FreeVoice(&m_aVoices[i]);
 		}
 	}
 	// lock_unlock(m_SoundLock);
@@ -811,7 +1346,7 @@ void CSound::StopAll()
 			else
 				m_aVoices[i].m_pSample->m_PausedAt = 0;
 		}
-		m_aVoices[i].m_pSample = 0;
+		FreeVoice(&m_aVoices[i]);
 	}
 	// lock_unlock(m_SoundLock);
 }
@@ -828,7 +1363,7 @@ void CSound::StopVoice(CVoiceHandle Voice)
 
 	// lock_wait(m_SoundLock);
 	{
-		m_aVoices[VoiceID].m_pSample = 0;
+		FreeVoice(&m_aVoices[VoiceID]);
 		m_aVoices[VoiceID].m_Age++;
 	}
 	// lock_unlock(m_SoundLock);
@@ -8,6 +8,10 @@
 class CSound : public IEngineSound
 {
 	int m_SoundEnabled;
+	class ISoundSink *m_pSink;
+
+	static void PullFrames(short *pOut, int Frames, void *pUser);
+	void RunBenchmark(int MaxVoices);
 
 public:
 	IEngineGraphics *m_pGraphics;
@@ -20,12 +24,14 @@ public:
 	int AllocID();
 
 	static void RateConvert(int SampleID);
+	static bool DecodeSample(int SampleID);
+	static void EvictSamples(int KeepID);
 
 	// TODO: Refactor: clean this mess up
 	static IOHANDLE ms_File;
-	static long int ReadData(void *pBuffer, long int Size);
+	static int ReadData(void *pBuffer, int Size);
 	static int DecodeWV(int SampleID, const void *pData, unsigned DataSize);
-	static int DecodeOpus(int SampleID, const void *pData, unsigned DataSize);
+	static int DecodeOpus(int SampleID, const void *pData, unsigned DataSize, IOMAP *pMap = 0);
 
 	virtual bool IsSoundEnabled() { return m_SoundEnabled != 0; }
 
@@ -35,6 +41,9 @@ public:
 	virtual int LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor);
 	virtual void UnloadSample(int SampleID);
 
+	virtual void Predecode(int SampleID);
+	virtual void GetStats(CStats *pStats);
+
 	virtual float GetSampleDuration(int SampleID); // in s
 
 	virtual void SetListenerPos(float x, float y);
@@ -0,0 +1,221 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/storage.h>
+
+#include "soundsink.h"
+
+#if defined(CONF_FAMILY_KOS)
+	#include <dc/sound/stream.h>
+#endif
+
+// consumes audio in real time without playing it
+class CSoundSink_Null : public ISoundSink
+{
+protected:
+	enum
+	{
+		CHUNK_FRAMES=1024,
+	};
+
+	FSoundPull m_pfnPull;
+	void *m_pUser;
+	int m_Rate;
+	int64 m_LastTime;
+	int64 m_Remainder;
+	short m_aChunk[CHUNK_FRAMES*2];
+
+	virtual void Consume(const short *pData, int Frames) {}
+
+public:
+	virtual bool Open(int Rate, FSoundPull pfnPull, void *pUser)
+	{
+		m_pfnPull = pfnPull;
+		m_pUser = pUser;
+		m_Rate = Rate;
+		m_LastTime = time_get();
+		m_Remainder = 0;
+		return true;
+	}
+
+	virtual void Close() {}
+
+	virtual void Update()
+	{
+		int64 Now = time_get();
+		int64 Ticks = (Now-m_LastTime)*m_Rate + m_Remainder;
+		m_LastTime = Now;
+
+		// don't catch up on long stalls, like loading a map
+		int Frames = min(Ticks/time_freq(), (int64)m_Rate/4);
+		m_Remainder = Ticks%time_freq();
+		Pump(Frames);
+	}
+
+	virtual bool Pump(int Frames)
+	{
+		while(Frames > 0)
+		{
+			int Num = min(Frames, (int)CHUNK_FRAMES);
+			m_pfnPull(m_aChunk, Num, m_pUser);
+			Consume(m_aChunk, Num);
+			Frames -= Num;
+		}
+		return true;
+	}
+
+	virtual const char *Name() const { return "null"; }
+};
+
+// the null sink, with everything written to dumps/sound.wav
+class CSoundSink_Wav : public CSoundSink_Null
+{
+	IStorage *m_pStorage;
+	IOHANDLE m_File;
+	unsigned m_DataSize;
+
+	static void WriteInt(unsigned char *pBuf, unsigned Value, int Size)
+	{
+		for(int i = 0; i < Size; i++)
+			pBuf[i] = (Value>>(i*8))&0xff;
+	}
+
+	void WriteHeader()
+	{
+		unsigned char aHeader[44];
+		mem_copy(aHeader, "RIFF", 4);
+		WriteInt(aHeader+4, 36+m_DataSize, 4);
+		mem_copy(aHeader+8, "WAVEfmt ", 8);
+		WriteInt(aHeader+16, 16, 4);
+		WriteInt(aHeader+20, 1, 2); // pcm
+		WriteInt(aHeader+22, 2, 2);
+		WriteInt(aHeader+24, m_Rate, 4);
+		WriteInt(aHeader+28, m_Rate*4, 4);
+		WriteInt(aHeader+32, 4, 2);
+		WriteInt(aHeader+34, 16, 2);
+		mem_copy(aHeader+36, "data", 4);
+		WriteInt(aHeader+40, m_DataSize, 4);
+		io_seek(m_File, 0, IOSEEK_START);
+		io_write(m_File, aHeader, sizeof(aHeader));
+		io_seek(m_File, 0, IOSEEK_END);
+	}
+
+protected:
+	virtual void Consume(const short *pData, int Frames)
+	{
+#if defined(CONF_ARCH_ENDIAN_BIG)
+		short aSwapped[CHUNK_FRAMES*2];
+		mem_copy(aSwapped, pData, Frames*4);
+		swap_endian(aSwapped, sizeof(short), Frames*2);
+		pData = aSwapped;
+#endif
+		m_DataSize += io_write(m_File, pData, Frames*4);
+	}
+
+public:
+	CSoundSink_Wav(IStorage *pStorage) : m_pStorage(pStorage), m_File(0), m_DataSize(0) {}
+
+	virtual bool Open(int Rate, FSoundPull pfnPull, void *pUser)
+	{
+		m_File = m_pStorage->OpenFile("dumps/sound.wav", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!m_File)
+		{
+			dbg_msg("sound", "failed to open dumps/sound.wav");
+			return false;
+		}
+		CSoundSink_Null::Open(Rate, pfnPull, pUser);
+		m_DataSize = 0;
+		WriteHeader();
+		return true;
+	}
+
+	virtual void Close()
+	{
+		if(!m_File)
+			return;
+		WriteHeader();
+		io_close(m_File);
+		m_File = 0;
+	}
+
+	virtual const char *Name() const { return "wav"; }
+};
+
+#if defined(CONF_FAMILY_KOS)
+// aica streaming channel, kos asks for more data from snd_stream_poll
+class CSoundSink_AICA : public ISoundSink
+{
+	enum
+	{
+		BUFFER_FRAMES=SND_STREAM_BUFFER_MAX/4,
+	};
+
+	static CSoundSink_AICA *ms_pSelf;
+
+	snd_stream_hnd_t m_Stream;
+	FSoundPull m_pfnPull;
+	void *m_pUser;
+	short m_aBuffer[BUFFER_FRAMES*2] __attribute__((aligned(32)));
+
+	static void *Callback(snd_stream_hnd_t Stream, int Bytes, int *pReceived)
+	{
+		int Frames = min(Bytes/4, (int)BUFFER_FRAMES);
+		ms_pSelf->m_pfnPull(ms_pSelf->m_aBuffer, Frames, ms_pSelf->m_pUser);
+		*pReceived = Frames*4;
+		return ms_pSelf->m_aBuffer;
+	}
+
+public:
+	CSoundSink_AICA() : m_Stream(SND_STREAM_INVALID) {}
+
+	virtual bool Open(int Rate, FSoundPull pfnPull, void *pUser)
+	{
+		m_pfnPull = pfnPull;
+		m_pUser = pUser;
+		ms_pSelf = this;
+
+		snd_stream_init();
+		m_Stream = snd_stream_alloc(Callback, SND_STREAM_BUFFER_MAX);
+		if(m_Stream == SND_STREAM_INVALID)
+		{
+			dbg_msg("sound", "failed to allocate an aica stream");
+			snd_stream_shutdown();
+			return false;
+		}
+		snd_stream_start(m_Stream, Rate, 1);
+		return true;
+	}
+
+	virtual void Close()
+	{
+		if(m_Stream == SND_STREAM_INVALID)
+			return;
+		snd_stream_stop(m_Stream);
+		snd_stream_destroy(m_Stream);
+		snd_stream_shutdown();
+		m_Stream = SND_STREAM_INVALID;
+	}
+
+	virtual void Update()
+	{
+		snd_stream_poll(m_Stream);
+	}
+
+	virtual const char *Name() const { return "aica"; }
+};
+
+CSoundSink_AICA *CSoundSink_AICA::ms_pSelf = 0;
+#endif
+
+ISoundSink *CreateSoundSink(int Output, IStorage *pStorage)
+{
+	if(Output == ISoundSink::OUTPUT_WAV)
+		return new CSoundSink_Wav(pStorage);
+#if defined(CONF_FAMILY_KOS)
+	if(Output == ISoundSink::OUTPUT_DEVICE)
+		return new CSoundSink_AICA();
+#endif
+	return new CSoundSink_Null();
+}
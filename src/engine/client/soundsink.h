@@ -0,0 +1,37 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_SOUNDSINK_H
+#define ENGINE_CLIENT_SOUNDSINK_H
+
+#include <base/system.h>
+
+// fills pOut with Frames interleaved stereo frames
+typedef void (*FSoundPull)(short *pOut, int Frames, void *pUser);
+
+// where the mixed audio goes. sinks pull frames from the mixer at their own
+// pace, Update is called once per client frame from the main thread.
+class ISoundSink
+{
+public:
+	enum
+	{
+		OUTPUT_DEVICE=0,
+		OUTPUT_NULL,
+		OUTPUT_WAV,
+	};
+
+	virtual ~ISoundSink() {}
+
+	virtual bool Open(int Rate, FSoundPull pfnPull, void *pUser) = 0;
+	virtual void Close() = 0;
+	virtual void Update() = 0;
+	virtual const char *Name() const = 0;
+
+	// pulls and consumes Frames right away, for the benchmark. false for
+	// sinks that are fed by the hardware on its own schedule
+	virtual bool Pump(int Frames) { return false; }
+};
+
+ISoundSink *CreateSoundSink(int Output, class IStorage *pStorage);
+
+#endif
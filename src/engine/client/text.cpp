@@ -9,6 +9,7 @@
 #include <engine/client.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
+#include <engine/shared/config.h>
 
 #ifdef CONF_FAMILY_WINDOWS
 	#include <windows.h>
@@ -16,6 +17,9 @@
 
 // https://github.com/vladimirgamalyan/fontbm
 
+// glyph size relative to the font size
+static const float gs_TextScale = 0.75f;
+
 class BMFont
 {
 #pragma pack(push, 1)
@@ -39,7 +43,7 @@ class BMFont
 		uint8_t outline;
 		char* fontName;
 	} info;
-	static_assert(sizeof(InfoBlock) == 18, "InfoBlock size is not 18");
+	static_assert(sizeof(InfoBlock) - sizeof(char*) == 14, "InfoBlock is not 14 bytes in the file");
 
 	struct CommonBlock
 	{
@@ -81,9 +85,33 @@ class BMFont
 	static_assert(sizeof(KerningPairsBlock) == 10, "KerningPairsBlock size is not 10");
 #pragma pack(pop)
 
+public:
+	struct CGlyph
+	{
+		bool m_Valid;
+		float m_aUV[4];
+		float m_OffsetX;
+		float m_OffsetY;
+		float m_Width;
+		float m_Height;
+		float m_Advance;
+	};
+
+private:
+	struct CKerning
+	{
+		uint8_t m_Second;
+		int16_t m_Amount;
+	};
+
 	std::unordered_map<int, char*> pages;
-	std::unordered_map<uint8_t, CharBlock> chars;
+	std::vector<CharBlock> chars;
 	std::vector<KerningPairsBlock> kernings;
+
+	// flat lookups for the first 256 code points, built once the texture size is known
+	CGlyph m_aGlyphs[256];
+	std::vector<CKerning> m_lKernings;
+	int m_aKerningStart[257];
 	int m_TextureID;
 	int m_Width;
 	int m_Height;
@@ -114,18 +142,75 @@ class BMFont
 		}
 
 		dbg_msg("bmfont", "BMFont loaded successfully");
+		BuildTables();
 		return true;
 	}
 
+	void BuildTables()
+	{
+		mem_zero(m_aGlyphs, sizeof(m_aGlyphs));
+		for(unsigned i = 0; i < chars.size(); i++)
+		{
+			const CharBlock &Char = chars[i];
+			if(Char.id >= 256)
+				continue;
+
+			CGlyph *pGlyph = &m_aGlyphs[Char.id];
+			pGlyph->m_Valid = true;
+			pGlyph->m_aUV[0] = Char.x / (float)m_Width;
+			pGlyph->m_aUV[1] = Char.y / (float)m_Height;
+			pGlyph->m_aUV[2] = (Char.x + Char.width) / (float)m_Width;
+			pGlyph->m_aUV[3] = (Char.y + Char.height) / (float)m_Height;
+			pGlyph->m_OffsetX = Char.xoffset;
+			pGlyph->m_OffsetY = Char.yoffset;
+			pGlyph->m_Width = Char.width;
+			pGlyph->m_Height = Char.height;
+			pGlyph->m_Advance = Char.xadvance;
+		}
+
+		// pairs grouped by their first character
+		mem_zero(m_aKerningStart, sizeof(m_aKerningStart));
+		for(unsigned i = 0; i < kernings.size(); i++)
+			if(kernings[i].first < 256 && kernings[i].second < 256)
+				m_aKerningStart[kernings[i].first+1]++;
+		for(int i = 0; i < 256; i++)
+			m_aKerningStart[i+1] += m_aKerningStart[i];
+
+		int aFill[256];
+		mem_copy(aFill, m_aKerningStart, sizeof(aFill));
+		m_lKernings.resize(m_aKerningStart[256]);
+		for(unsigned i = 0; i < kernings.size(); i++)
+		{
+			if(kernings[i].first >= 256 || kernings[i].second >= 256)
+				continue;
+			CKerning *pKerning = &m_lKernings[aFill[kernings[i].first]++];
+			pKerning->m_Second = kernings[i].second;
+			pKerning->m_Amount = kernings[i].amount;
+		}
+	}
+
 public:
 	std::unordered_map<int, char*>& Pages() {return pages;}
-	std::unordered_map<uint8_t, CharBlock>& Chars() {return chars;}
 	std::vector<KerningPairsBlock>& Kernings() {return kernings;}
 	const int Texture() const {return m_TextureID;}
 
+	const CGlyph *Glyph(uint8_t c) const { return m_aGlyphs[c].m_Valid ? &m_aGlyphs[c] : 0; }
+
+	int Kerning(int First, int Second) const
+	{
+		if(First < 0)
+			return 0;
+		for(int i = m_aKerningStart[First]; i < m_aKerningStart[First+1]; i++)
+			if(m_lKernings[i].m_Second == Second)
+				return m_lKernings[i].m_Amount;
+		return 0;
+	}
+
 	BMFont(IGraphics* Graphics, IStorage* Storage) : m_pGraphics(Graphics), m_pStorage(Storage)
 	{
 		info.fontName = 0;
+		mem_zero(m_aGlyphs, sizeof(m_aGlyphs));
+		mem_zero(m_aKerningStart, sizeof(m_aKerningStart));
 	}
 
 	~BMFont()
@@ -258,7 +343,7 @@ public:
 		{
 			BMFont::CharBlock block;
 			io_read(f, &block, sizeof(BMFont::CharBlock));
-			chars[block.id] = block;
+			chars.push_back(block);
 		}
 
 		// Block 5 (optional): Kernings
@@ -295,33 +380,80 @@ public:
 		return LoadPng(png);
 	}
 
-	void RenderChar(uint8_t c, float x, float y, float scale, float size, bool outline)
+	void GlyphQuad(const CGlyph *pGlyph, float x, float y, float Scale, IGraphics::CTexturedQuadItem *pQuad) const
 	{
-		if (!chars.count(c))
-			return;
-
-		Graphics()->QuadsSetSubset(
-			chars[c].x / (float)m_Width,
-			chars[c].y / (float)m_Height,
-			(chars[c].x + chars[c].width) / (float)m_Width,
-			(chars[c].y + chars[c].height) / (float)m_Height);
-
-		IGraphics::CQuadItem QuadItem(
-			x + (chars[c].xoffset*size*scale/10),
-			y + (chars[c].yoffset*size*scale/10),
-			chars[c].width*size*scale/10,
-			chars[c].height*size*scale/10);
-		Graphics()->QuadsDrawTL(&QuadItem, 1);
+		pQuad->m_X = x + pGlyph->m_OffsetX*Scale;
+		pQuad->m_Y = y + pGlyph->m_OffsetY*Scale;
+		pQuad->m_Width = pGlyph->m_Width*Scale;
+		pQuad->m_Height = pGlyph->m_Height*Scale;
+		pQuad->m_aU[0] = pQuad->m_aU[3] = pGlyph->m_aUV[0];
+		pQuad->m_aU[1] = pQuad->m_aU[2] = pGlyph->m_aUV[2];
+		pQuad->m_aV[0] = pQuad->m_aV[1] = pGlyph->m_aUV[1];
+		pQuad->m_aV[2] = pQuad->m_aV[3] = pGlyph->m_aUV[3];
 	}
 };
 
 
 class CTextRender : public IEngineTextRender
 {
+	enum
+	{
+		LAYOUT_CACHE_SIZE=64,
+		MAX_LAYOUT_TEXT=128,
+		MAX_LAYOUT_GLYPHS=128,
+		QUAD_BATCH=64,
+	};
+
+	struct CGlyphPos
+	{
+		float m_X, m_Y;
+		int m_Char;
+	};
+
+	// everything the layout depends on, positions are relative to the aligned cursor
+	struct CLayoutKey
+	{
+		BMFont *m_pFont;
+		unsigned m_Hash;
+		int m_Length;
+		int m_Flags;
+		int m_MaxLines;
+		int m_LineCount;
+		float m_Size;
+		float m_LineWidth;
+		float m_StartX;
+		float m_FakeToScreenX;
+		float m_FakeToScreenY;
+	};
+
+	struct CLayoutResult
+	{
+		float m_EndX, m_EndY;
+		int m_Lines;
+		int m_Chars;
+		bool m_NewLine;
+	};
+
+	// laid out text, chat lines, names and the scoreboard are drawn again
+	// every frame without being wrapped and measured again
+	struct CLayout
+	{
+		CLayoutKey m_Key;
+		int m_LastUse;
+		char m_aText[MAX_LAYOUT_TEXT];
+		CLayoutResult m_Result;
+		int m_NumGlyphs;
+		CGlyphPos m_aGlyphs[MAX_LAYOUT_GLYPHS];
+	};
+
 	IGraphics *m_pGraphics;
 	IStorage *m_pStorage;
 	IGraphics *Graphics() { return m_pGraphics; }
 
+	CLayout m_aLayouts[LAYOUT_CACHE_SIZE];
+	int m_LayoutUse;
+	std::vector<CGlyphPos> m_lGlyphs;
+
 	int WordLength(const char *pText)
 	{
 		int s = 1;
@@ -336,6 +468,247 @@ class CTextRender : public IEngineTextRender
 		}
 	}
 
+	static unsigned HashText(const char *pText, int Length)
+	{
+		unsigned Hash = 2166136261u;
+		for(int i = 0; i < Length; i++)
+			Hash = (Hash ^ (unsigned char)pText[i]) * 16777619u;
+		return Hash;
+	}
+
+	static float Align(float Value, float FakeToScreen)
+	{
+		return (int)(Value * FakeToScreen) / FakeToScreen;
+	}
+
+	static float Advance(BMFont *pFont, const BMFont::CGlyph *pGlyph, int Prev, int Character)
+	{
+		return (pGlyph->m_Advance + pFont->Kerning(Prev, Character)) * gs_TextScale / 10.f;
+	}
+
+	// where the word ends when drawn from x without wrapping, Prev is the
+	// character before it for the kerning
+	float MeasureWord(BMFont *pFont, const char *pText, int Length, int Prev, float x, float StartX, float Size, float FakeToScreenX)
+	{
+		const char *pEnd = pText+Length;
+		x = Align(x, FakeToScreenX);
+		while(pText < pEnd)
+		{
+			uint8_t Character = (uint8_t)str_utf8_decode(&pText);
+			if(Character == '\n')
+			{
+				x = Align(StartX, FakeToScreenX);
+				Prev = -1;
+				continue;
+			}
+
+			const BMFont::CGlyph *pGlyph = pFont->Glyph(Character);
+			if(!pGlyph)
+				continue;
+			x += Advance(pFont, pGlyph, Prev, Character)*Size;
+			Prev = Character;
+		}
+		return x;
+	}
+
+	// how many characters of the word fit before the line ends
+	int FittingChars(BMFont *pFont, const char *pText, int Length, int Prev, float x, float StartX, float LineWidth, float Size, float FakeToScreenX)
+	{
+		const char *pEnd = pText+Length;
+		int Count = 0;
+		x = Align(x, FakeToScreenX);
+		while(pText < pEnd)
+		{
+			uint8_t Character = (uint8_t)str_utf8_decode(&pText);
+			if(Character == '\n')
+			{
+				x = Align(StartX, FakeToScreenX);
+				Prev = -1;
+				continue;
+			}
+
+			const BMFont::CGlyph *pGlyph = pFont->Glyph(Character);
+			if(!pGlyph)
+				continue;
+			float Width = Advance(pFont, pGlyph, Prev, Character)*Size;
+			if(x+Width-StartX > LineWidth)
+				break;
+			x += Width;
+			Prev = Character;
+			Count++;
+		}
+		return Count;
+	}
+
+	// positions every glyph into m_lGlyphs, relative to the cursor
+	void Layout(const CTextCursor *pCursor, BMFont *pFont, const char *pText, int Length, float CursorX, float CursorY,
+		float Size, float FakeToScreenX, float FakeToScreenY, CLayoutResult *pResult)
+	{
+		const char *pCurrent = pText;
+		const char *pEnd = pCurrent+Length;
+		float DrawX = CursorX;
+		float DrawY = CursorY;
+		float StartX = pCursor->m_StartX;
+		float LineWidth = pCursor->m_LineWidth;
+		int MaxLines = pCursor->m_MaxLines;
+		int LineCount = pCursor->m_LineCount;
+		int Prev = -1;
+
+		m_lGlyphs.clear();
+		pResult->m_Chars = 0;
+		pResult->m_NewLine = false;
+
+		while(pCurrent < pEnd && (MaxLines < 1 || LineCount <= MaxLines))
+		{
+			int NewLine = 0;
+			const char *pBatchEnd = pEnd;
+			if(LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
+			{
+				int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
+				float WordEnd = MeasureWord(pFont, pCurrent, Wlen, Prev, DrawX, StartX, Size, FakeToScreenX);
+
+				if(WordEnd-DrawX > LineWidth)
+				{
+					// word can't be fitted in one line, cut it
+					Wlen = FittingChars(pFont, pCurrent, Wlen, Prev, DrawX, StartX, LineWidth, Size, FakeToScreenX);
+					NewLine = 1;
+
+					if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
+						Wlen = 0;
+				}
+				else if(WordEnd-StartX > LineWidth)
+				{
+					NewLine = 1;
+					Wlen = 0;
+				}
+
+				pBatchEnd = pCurrent + Wlen;
+			}
+
+			while(pCurrent < pBatchEnd)
+			{
+				uint8_t Character = (uint8_t)str_utf8_decode(&pCurrent);
+
+				if(Character == '\n')
+				{
+					DrawX = Align(StartX, FakeToScreenX); // realign
+					DrawY = Align(DrawY + Size, FakeToScreenY);
+					Prev = -1;
+					++LineCount;
+					if(MaxLines > 0 && LineCount > MaxLines)
+						break;
+					continue;
+				}
+
+				const BMFont::CGlyph *pGlyph = pFont->Glyph(Character);
+				if(!pGlyph)
+					continue;
+
+				float Width = Advance(pFont, pGlyph, Prev, Character)*Size;
+				if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Width-StartX > LineWidth)
+				{
+					// we hit the end of the line, no more to render or count
+					pCurrent = pEnd;
+					break;
+				}
+
+				CGlyphPos Pos;
+				Pos.m_X = DrawX - CursorX;
+				Pos.m_Y = DrawY - CursorY;
+				Pos.m_Char = Character;
+				m_lGlyphs.push_back(Pos);
+
+				DrawX += Width;
+				Prev = Character;
+				pResult->m_Chars++;
+			}
+
+			if(NewLine)
+			{
+				DrawX = Align(StartX, FakeToScreenX); // realign
+				DrawY = Align(DrawY + Size, FakeToScreenY);
+				Prev = -1;
+				pResult->m_NewLine = true;
+				++LineCount;
+			}
+		}
+
+		pResult->m_EndX = DrawX - CursorX;
+		pResult->m_EndY = DrawY - CursorY;
+		pResult->m_Lines = LineCount - pCursor->m_LineCount;
+	}
+
+	CLayout *FindLayout(const CLayoutKey *pKey, const char *pText)
+	{
+		for(int i = 0; i < LAYOUT_CACHE_SIZE; i++)
+		{
+			CLayout *pLayout = &m_aLayouts[i];
+			if(pLayout->m_Key.m_Hash == pKey->m_Hash && mem_comp(&pLayout->m_Key, pKey, sizeof(*pKey)) == 0 &&
+				mem_comp(pLayout->m_aText, pText, pKey->m_Length) == 0)
+			{
+				pLayout->m_LastUse = ++m_LayoutUse;
+				return pLayout;
+			}
+		}
+		return 0;
+	}
+
+	void StoreLayout(const CLayoutKey *pKey, const char *pText, const CLayoutResult *pResult)
+	{
+		// replace the least recently used one
+		CLayout *pLayout = &m_aLayouts[0];
+		for(int i = 1; i < LAYOUT_CACHE_SIZE; i++)
+			if(m_aLayouts[i].m_LastUse < pLayout->m_LastUse)
+				pLayout = &m_aLayouts[i];
+
+		pLayout->m_Key = *pKey;
+		pLayout->m_LastUse = ++m_LayoutUse;
+		mem_copy(pLayout->m_aText, pText, pKey->m_Length);
+		pLayout->m_Result = *pResult;
+		pLayout->m_NumGlyphs = m_lGlyphs.size();
+		if(pLayout->m_NumGlyphs)
+			mem_copy(pLayout->m_aGlyphs, &m_lGlyphs[0], pLayout->m_NumGlyphs*sizeof(CGlyphPos));
+	}
+
+	// outline pass first, then the fill, each as one batch of quads
+	void RenderGlyphs(BMFont *pFont, const CGlyphPos *pGlyphs, int Num, float x, float y, float Size)
+	{
+		IGraphics::CTexturedQuadItem aQuads[QUAD_BATCH];
+
+		for(int i = 0; i < 2; i++)
+		{
+			float Scale = gs_TextScale*Size/10.f;
+			float Offset = 0.0f;
+			if(i == 0)
+			{
+				Scale *= 1.3f;
+				Offset = gs_TextScale*Size/4.f;
+			}
+
+			Graphics()->TextureSet(pFont->Texture());
+			Graphics()->QuadsBegin();
+			if (i == 0)
+				Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
+			else
+				Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
+
+			int NumQuads = 0;
+			for(int g = 0; g < Num; g++)
+			{
+				pFont->GlyphQuad(pFont->Glyph(pGlyphs[g].m_Char), x+pGlyphs[g].m_X-Offset, y+pGlyphs[g].m_Y-Offset, Scale, &aQuads[NumQuads++]);
+				if(NumQuads == QUAD_BATCH)
+				{
+					Graphics()->QuadsDrawTextured(aQuads, NumQuads);
+					NumQuads = 0;
+				}
+			}
+			if(NumQuads)
+				Graphics()->QuadsDrawTextured(aQuads, NumQuads);
+
+			Graphics()->QuadsEnd();
+		}
+	}
+
 	float m_TextR;
 	float m_TextG;
 	float m_TextB;
@@ -363,6 +736,9 @@ public:
 		m_TextOutlineA = 0.3f;
 
 		m_pDefaultFont = 0;
+
+		mem_zero(m_aLayouts, sizeof(m_aLayouts));
+		m_LayoutUse = 0;
 	}
 
 	virtual void Init()
@@ -386,6 +762,9 @@ public:
 
 	virtual void DestroyFont(BMFont *pFont)
 	{
+		for(int i = 0; i < LAYOUT_CACHE_SIZE; i++)
+			if(m_aLayouts[i].m_Key.m_pFont == pFont)
+				mem_zero(&m_aLayouts[i], sizeof(m_aLayouts[i]));
 		delete pFont;
 	}
 
@@ -456,16 +835,11 @@ public:
 		//BMFont *pFont = pCursor->m_pFont;
 		BMFont *pFont = m_pDefaultFont;
 
-		//dbg_msg("textrender", "rendering text '%s'", text);
-
 		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
 		float FakeToScreenX, FakeToScreenY;
 		int ActualX, ActualY;
 
 		int ActualSize;
-		int GotNewLine = 0;
-		float DrawX = 0.0f, DrawY = 0.0f;
-		int LineCount = 0;
 		float CursorX, CursorY;
 
 		float Size = pCursor->m_FontSize;
@@ -485,151 +859,57 @@ public:
 		ActualSize = (int)(Size * FakeToScreenY);
 		Size = ActualSize / FakeToScreenY;
 
-		//pSizeData = GetSize(pFont, ActualSize);
-		//RenderSetup(pFont, ActualSize);
-
-		//float Scale = 1/pSizeData->m_FontSize;
-		float DefaultScale = 0.75f;
-
 		// set length
 		if(Length < 0)
 			Length = str_length(pText);
 
-		// if we don't want to render, we can just skip the first outline pass
-		int i = 1;
-		if(pCursor->m_Flags&TEXTFLAG_RENDER)
-			i = 0;
-
-		auto& chars = pFont->Chars();
-
-		for(;i < 2; i++)
+		bool Cache = g_Config.m_GfxTextCache && Length <= MAX_LAYOUT_TEXT;
+		CLayoutKey Key;
+		CLayout *pLayout = 0;
+		if(Cache)
 		{
-			const char *pCurrent = (char *)pText;
-			const char *pEnd = pCurrent+Length;
-			DrawX = CursorX;
-			DrawY = CursorY;
-			float Scale = DefaultScale;
-			LineCount = pCursor->m_LineCount;
-
-			if (i == 0)
-				Scale *= 1.3f;
-
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
-			{
-				Graphics()->TextureSet(pFont->Texture());
-				Graphics()->QuadsBegin();
-				if (i == 0)
-					Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
-				else
-					Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
-			}
-
-			while(pCurrent < pEnd && (pCursor->m_MaxLines < 1 || LineCount <= pCursor->m_MaxLines))
-			{
-				int NewLine = 0;
-				const char *pBatchEnd = pEnd;
-				if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
-				{
-					int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
-					CTextCursor Compare = *pCursor;
-					Compare.m_X = DrawX;
-					Compare.m_Y = DrawY;
-					Compare.m_Flags &= ~TEXTFLAG_RENDER;
-					Compare.m_LineWidth = -1;
-					TextEx(&Compare, pCurrent, Wlen);
-
-					if(Compare.m_X-DrawX > pCursor->m_LineWidth)
-					{
-						// word can't be fitted in one line, cut it
-						CTextCursor Cutter = *pCursor;
-						Cutter.m_CharCount = 0;
-						Cutter.m_X = DrawX;
-						Cutter.m_Y = DrawY;
-						Cutter.m_Flags &= ~TEXTFLAG_RENDER;
-						Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
-
-						TextEx(&Cutter, (const char *)pCurrent, Wlen);
-						Wlen = Cutter.m_CharCount;
-						NewLine = 1;
-
-						if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
-							Wlen = 0;
-					}
-					else if(Compare.m_X-pCursor->m_StartX > pCursor->m_LineWidth)
-					{
-						NewLine = 1;
-						Wlen = 0;
-					}
-
-					pBatchEnd = pCurrent + Wlen;
-				}
-
-				const char *pTmp = pCurrent;
-				int NextCharacter = str_utf8_decode(&pTmp);
-				while(pCurrent < pBatchEnd)
-				{
-					uint8_t Character = (uint8_t)NextCharacter;
-					pCurrent = pTmp;
-					NextCharacter = str_utf8_decode(&pTmp);
-
-					if(Character == '\n')
-					{
-						DrawX = pCursor->m_StartX;
-						DrawY += Size;
-						DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-						DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-						++LineCount;
-						if(pCursor->m_MaxLines > 0 && LineCount > pCursor->m_MaxLines)
-							break;
-						continue;
-					}
-
-					if (chars.count(Character))
-					{
-						float Advance = chars[Character].xadvance * DefaultScale / 10.f;
-						if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pCursor->m_StartX > pCursor->m_LineWidth)
-						{
-							// we hit the end of the line, no more to render or count
-							pCurrent = pEnd;
-							break;
-						}
-
-						if(pCursor->m_Flags&TEXTFLAG_RENDER)
-						{
-							float offsetX = (i==0) ? DefaultScale*Size/4.f : 0;
-							float offsetY = (i==0) ? DefaultScale*Size/4.f : 0;
-							DrawX -= offsetX;
-							DrawY -= offsetY;
-							pFont->RenderChar(Character, DrawX, DrawY, Scale, Size, i==0);
-							DrawX += offsetX;
-							DrawY += offsetY;
-						}
-
-						DrawX += Advance*Size;
-						pCursor->m_CharCount++;
-					}
-				}
-
-				if(NewLine)
-				{
-					DrawX = pCursor->m_StartX;
-					DrawY += Size;
-					GotNewLine = 1;
-					DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-					DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-					++LineCount;
-				}
-			}
+			mem_zero(&Key, sizeof(Key));
+			Key.m_pFont = pFont;
+			Key.m_Hash = HashText(pText, Length);
+			Key.m_Length = Length;
+			Key.m_Flags = pCursor->m_Flags&~TEXTFLAG_RENDER;
+			Key.m_MaxLines = pCursor->m_MaxLines;
+			Key.m_LineCount = pCursor->m_MaxLines > 0 ? pCursor->m_LineCount : 0;
+			Key.m_Size = Size;
+			Key.m_LineWidth = pCursor->m_LineWidth;
+			Key.m_StartX = pCursor->m_StartX - CursorX;
+			Key.m_FakeToScreenX = FakeToScreenX;
+			Key.m_FakeToScreenY = FakeToScreenY;
+			pLayout = FindLayout(&Key, pText);
+		}
 
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
-				Graphics()->QuadsEnd();
+		CLayoutResult Result;
+		const CGlyphPos *pGlyphs;
+		int NumGlyphs;
+		if(pLayout)
+		{
+			Result = pLayout->m_Result;
+			pGlyphs = pLayout->m_aGlyphs;
+			NumGlyphs = pLayout->m_NumGlyphs;
 		}
+		else
+		{
+			Layout(pCursor, pFont, pText, Length, CursorX, CursorY, Size, FakeToScreenX, FakeToScreenY, &Result);
+			NumGlyphs = m_lGlyphs.size();
+			pGlyphs = NumGlyphs ? &m_lGlyphs[0] : 0;
+			if(Cache && NumGlyphs <= MAX_LAYOUT_GLYPHS)
+				StoreLayout(&Key, pText, &Result);
+		}
+
+		if(pCursor->m_Flags&TEXTFLAG_RENDER)
+			RenderGlyphs(pFont, pGlyphs, NumGlyphs, CursorX, CursorY, Size);
 
-		pCursor->m_X = DrawX;
-		pCursor->m_LineCount = LineCount;
+		pCursor->m_X = CursorX + Result.m_EndX;
+		pCursor->m_LineCount += Result.m_Lines;
+		pCursor->m_CharCount += Result.m_Chars;
 
-		if(GotNewLine)
-			pCursor->m_Y = DrawY;
+		if(Result.m_NewLine)
+			pCursor->m_Y = CursorY + Result.m_EndY;
 	}
 
 };
@@ -63,6 +63,7 @@ public:
 	virtual const CInfo *BaseInfo() const = 0;
 	virtual void GetDemoName(char *pBuffer, int BufferSize) const = 0;
 	virtual bool GetDemoInfo(class IStorage *pStorage, const char *pFilename, int StorageType, CDemoHeader *pDemoHeader) const = 0;
+	virtual void RemoveIndex(class IStorage *pStorage, const char *pFilename, int StorageType) const = 0;
 	virtual int GetDemoType() const = 0;
 };
 
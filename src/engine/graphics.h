@@ -53,11 +53,13 @@ protected:
 public:
 	/* Constants: Texture Loading Flags
 		TEXLOAD_NORESAMPLE - Prevents the texture from any resampling
+		TEXLOAD_ATLAS - May share a texture page with other images, only for images that are never repeated
 	*/
 	enum
 	{
 		TEXLOAD_NORESAMPLE = 1,
 		TEXLOAD_NOMIPMAPS = 2,
+		TEXLOAD_ATLAS = 4,
 	};
 
 	int ScreenWidth() const { return m_ScreenWidth; }
@@ -87,6 +89,12 @@ public:
 	virtual int LoadTextureRawSub(int TextureID, int x, int y, int Width, int Height, int Format, const void *pData) = 0;
 	virtual void TextureSet(int TextureID) = 0;
 
+	// images loaded with TEXLOAD_ATLAS between these calls get packed into shared
+	// pages, their ids are valid right away but only usable after AtlasEnd. the
+	// calls nest, only the outermost AtlasEnd finishes the page
+	virtual void AtlasBegin() = 0;
+	virtual void AtlasEnd() = 0;
+
 	struct CLineItem
 	{
 		float m_X0, m_Y0, m_X1, m_Y1;
@@ -120,6 +128,27 @@ public:
 			: m_X0(x0), m_Y0(y0), m_X1(x1), m_Y1(y1), m_X2(x2), m_Y2(y2), m_X3(x3), m_Y3(y3) {}
 	};
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num) = 0;
+
+	// axis aligned quads that carry their own texture coordinates,
+	// corners in the same order as QuadsSetSubsetFree
+	struct CTexturedQuadItem
+	{
+		float m_X, m_Y, m_Width, m_Height;
+		float m_aU[4], m_aV[4];
+	};
+	virtual void QuadsDrawTextured(const CTexturedQuadItem *pArray, int Num) = 0;
+
+	// quads with every corner already transformed and colored. the corners go
+	// around the quad, top left, top right, bottom right, bottom left when it
+	// isn't rotated. the rotation, subset and color set before are ignored
+	// and left undefined
+	struct CPreparedQuadItem
+	{
+		float m_aX[4], m_aY[4];
+		float m_aU[4], m_aV[4];
+		float m_aColors[4][4]; // rgba
+	};
+	virtual void QuadsDrawPrepared(const CPreparedQuadItem *pArray, int Num) = 0;
 	virtual void QuadsText(float x, float y, float Size, const char *pText) = 0;
 
 	struct CColorVertex
@@ -13,6 +13,8 @@ public:
 	virtual int GetUncompressedDataSize(int Index) = 0;
 	virtual void *GetDataSwapped(int Index) = 0;
 	virtual void UnloadData(int Index) = 0;
+	virtual void PrefetchData(const int *pIndices, int Num) = 0;
+	virtual void DropFileCopy() = 0;
 	virtual void *GetItem(int Index, int *Type, int *pID) = 0;
 	virtual int GetItemSize(int Index) = 0;
 	virtual void GetType(int Type, int *pStart, int *pNum) = 0;
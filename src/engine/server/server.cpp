@@ -294,9 +294,10 @@ void CServer::CClient::Reset()
 
 CServer::CServer()
 {
+	// the race recordings are mostly thrown away, and renamed when kept
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
-	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false);
+		m_aDemoRecorder[i].Init(&m_SnapshotDelta, true, false);
+	m_aDemoRecorder[MAX_CLIENTS].Init(&m_SnapshotDelta, false);
 
 	m_TickSpeed = SERVER_TICK_SPEED;
 
@@ -304,6 +305,7 @@ CServer::CServer()
 
 	m_CurrentGameTick = 0;
 	m_RunServer = 1;
+	m_Benchmark = false;
 
 	m_pCurrentMapData = 0;
 	m_CurrentMapSize = 0;
@@ -533,6 +535,9 @@ bool CServer::ClientIngame(int ClientID)
 
 int CServer::MaxClients() const
 {
+	// the benchmark never opens the socket, its bots may use every slot
+	if(m_Benchmark)
+		return MAX_CLIENTS;
 	return m_NetServer.MaxClients();
 }
 
@@ -601,7 +606,7 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 		m_aDemoRecorder[MAX_CLIENTS].RecordMessage(pMsg->Data(), pMsg->Size());
 	}
 
-	if(!(Flags&MSGFLAG_NOSEND))
+	if(!(Flags&MSGFLAG_NOSEND) && !m_Benchmark)
 	{
 		if(ClientID == -1)
 		{
@@ -1814,6 +1819,138 @@ int CServer::Run()
 	return 0;
 }
 
+static void BenchInput(CNetObj_PlayerInput *pInput, unsigned *pSeed, int Tick)
+{
+	// cheap lcg so every run produces the same inputs
+	*pSeed = *pSeed*1103515245+12345;
+	unsigned Rand = *pSeed>>16;
+
+	if(Rand%40 == 0)
+		pInput->m_Direction = (int)(Rand/40%3)-1;
+	pInput->m_Jump = Rand%16 == 0;
+	if(Rand%30 == 0)
+		pInput->m_Hook ^= 1;
+	if(Rand%20 == 0)
+		pInput->m_Fire++;
+	if(Rand%500 == 0)
+		pInput->m_WantedWeapon = Rand/500%NUM_WEAPONS+1;
+	pInput->m_TargetX = (int)(cosf(Tick*0.02f+Rand%7)*200.0f);
+	pInput->m_TargetY = (int)(sinf(Tick*0.02f+Rand%7)*200.0f);
+	if(!pInput->m_TargetX && !pInput->m_TargetY)
+		pInput->m_TargetY = -1;
+}
+
+int CServer::RunBenchmark()
+{
+	if(!LoadMap(g_Config.m_SvMap))
+	{
+		dbg_msg("bench", "failed to load map. mapname='%s'", g_Config.m_SvMap);
+		return -1;
+	}
+
+	// nothing leaves the process, messages and snapshots are built and dropped
+	m_Benchmark = true;
+	GameServer()->OnInit();
+	m_pConsole->StoreCommands(false);
+
+	int NumBots = min(g_Config.m_DbgBenchBots, (int)MAX_CLIENTS);
+	CNetObj_PlayerInput aInputs[MAX_CLIENTS];
+	unsigned aSeeds[MAX_CLIENTS];
+	mem_zero(aInputs, sizeof(aInputs));
+	for(int i = 0; i < NumBots; i++)
+	{
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "bot%d", i);
+		NewClientCallback(i, this);
+		m_aClients[i].m_State = CClient::STATE_READY;
+		SetClientName(i, aName);
+		GameServer()->OnClientConnected(i);
+		m_aClients[i].m_State = CClient::STATE_INGAME;
+		GameServer()->OnClientEnter(i);
+		m_aClients[i].m_SnapRate = CClient::SNAPRATE_FULL;
+		aSeeds[i] = i+1;
+		aInputs[i].m_TargetY = -1;
+	}
+
+	enum
+	{
+		PHASE_INPUT=0,
+		PHASE_TICK,
+		PHASE_SNAP,
+		NUM_PHASES
+	};
+	static const char *s_apPhaseNames[NUM_PHASES] = {"input", "tick", "snap"};
+	int64 aPhaseTime[NUM_PHASES] = {0};
+	int NumSnaps = 0;
+
+	int StartAllocs = mem_stats()->total_allocations;
+	int64 Start = time_get();
+	m_GameStartTime = Start;
+	for(int t = 0; t < g_Config.m_DbgBenchTicks; t++)
+	{
+		m_CurrentGameTick++;
+
+		// bots can join a team once their characters have spawned
+		if(g_Config.m_DbgBenchTeams && t == SERVER_TICK_SPEED)
+			for(int c = 0; c < NumBots; c++)
+			{
+				char aBuf[32];
+				str_format(aBuf, sizeof(aBuf), "team %d", c%g_Config.m_DbgBenchTeams+1);
+				m_pConsole->ExecuteLine(aBuf, c);
+			}
+
+		int64 PhaseStart = time_get();
+		for(int c = 0; c < NumBots; c++)
+		{
+			BenchInput(&aInputs[c], &aSeeds[c], m_CurrentGameTick);
+			GameServer()->OnClientDirectInput(c, &aInputs[c]);
+			GameServer()->OnClientPredictedInput(c, &aInputs[c]);
+		}
+		int64 Now = time_get();
+		aPhaseTime[PHASE_INPUT] += Now-PhaseStart;
+
+		PhaseStart = Now;
+		GameServer()->OnTick();
+		Now = time_get();
+		aPhaseTime[PHASE_TICK] += Now-PhaseStart;
+
+		if(g_Config.m_SvHighBandwidth || (m_CurrentGameTick%2) == 0)
+		{
+			PhaseStart = Now;
+			DoSnapshot();
+			aPhaseTime[PHASE_SNAP] += time_get()-PhaseStart;
+			NumSnaps++;
+
+			// bots ack every snapshot right away, like clients without latency
+			for(int c = 0; c < NumBots; c++)
+				m_aClients[c].m_LastAckedSnapshot = m_CurrentGameTick;
+		}
+	}
+	int64 Total = time_get()-Start;
+	int Allocs = mem_stats()->total_allocations-StartAllocs;
+
+	int Ticks = g_Config.m_DbgBenchTicks;
+	float Seconds = Total/(float)time_freq();
+	dbg_msg("bench", "map='%s' bots=%d ticks=%d snaps=%d", m_aCurrentMap, NumBots, Ticks, NumSnaps);
+	dbg_msg("bench", "total %.3fs, %.1f ticks/s", Seconds, Seconds > 0.0f ? Ticks/Seconds : 0.0f);
+	for(int i = 0; i < NUM_PHASES; i++)
+		dbg_msg("bench", "%-5s %8.3fms %7.3fus/tick", s_apPhaseNames[i], aPhaseTime[i]*1000.0f/time_freq(), Ticks ? aPhaseTime[i]*1000000.0f/time_freq()/Ticks : 0.0f);
+	dbg_msg("bench", "allocations %d (%.2f/tick), %d active", Allocs, Ticks ? Allocs/(float)Ticks : 0.0f, mem_stats()->active_allocations);
+
+	for(int c = 0; c < NumBots; c++)
+	{
+		GameServer()->OnClientDrop(c, "benchmark done");
+		m_aClients[c].m_State = CClient::STATE_EMPTY;
+		m_aClients[c].m_Snapshots.PurgeAll();
+	}
+	GameServer()->OnShutdown();
+	m_pMap->Unload();
+
+	if(m_pCurrentMapData)
+		mem_free(m_pCurrentMapData);
+	return 0;
+}
+
 void CServer::ConTestingCommands(CConsole::IResult *pResult, void *pUser)
 {
 	char aBuf[128];
@@ -2244,8 +2381,13 @@ int main(int argc, const char **argv) // ignore_convention
 	pServer->InitRconPasswordIfEmpty();
 
 	// run the server
-	dbg_msg("server", "starting...");
-	pServer->Run();
+	if(g_Config.m_DbgBenchTicks)
+		pServer->RunBenchmark();
+	else
+	{
+		dbg_msg("server", "starting...");
+		pServer->Run();
+	}
 
 	// free
 #if defined(CONF_FAMILY_UNIX)
@@ -161,6 +161,7 @@ public:
 	int64 m_GameStartTime;
 	//int m_CurrentGameTick;
 	int m_RunServer;
+	bool m_Benchmark;
 	int m_MapReload;
 	bool m_ReloadedWhenEmpty;
 	int m_RconClientID;
@@ -257,6 +258,7 @@ public:
 
 	void InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, IConsole *pConsole);
 	int Run();
+	int RunBenchmark();
 
 	static void ConTestingCommands(IConsole::IResult *pResult, void *pUser);
 	static void ConRescue(IConsole::IResult *pResult, void *pUser);
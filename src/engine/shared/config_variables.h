@@ -17,6 +17,7 @@ MACRO_CONFIG_INT(ConsoleOutputLevel, console_output_level, 0, 0, 2, CFGFLAG_CLIE
 
 MACRO_CONFIG_INT(ClCpuThrottle, cl_cpu_throttle, 0, 0, 100, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(ClCpuThrottleInactive, cl_cpu_throttle_inactive, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
+MACRO_CONFIG_INT(ClMapCacheSize, cl_map_cache_size, 32, 1, 4096, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Disk space for downloaded maps in MB, the least recently played ones are removed beyond it")
 MACRO_CONFIG_INT(ClEditor, cl_editor, 0, 0, 1, CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(ClEditorUndo, cl_editorundo, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Undo function in editor")
 MACRO_CONFIG_INT(ClLoadCountryFlags, cl_load_country_flags, 1, 0, 1, CFGFLAG_CLIENT, "Load and show country flags")
@@ -66,6 +67,9 @@ MACRO_CONFIG_INT(BrMaxRequests, br_max_requests, 25, 0, 1000, CFGFLAG_SAVE|CFGFL
 MACRO_CONFIG_INT(BrDemoSort, br_demo_sort, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
 MACRO_CONFIG_INT(BrDemoSortOrder, br_demo_sort_order, 0, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "")
 
+MACRO_CONFIG_INT(MapDecodeThreads, map_decode_threads, 0, 0, 8, CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Extra threads that decompress map data on load (0 = load on the calling thread, only helps with more than one core)")
+MACRO_CONFIG_INT(MapEncodeThreads, map_encode_threads, 0, 0, 8, CFGFLAG_SAVE|CFGFLAG_CLIENT|CFGFLAG_SERVER, "Extra threads that compress map data when saving (0 = save on the calling thread)")
+
 MACRO_CONFIG_INT(SndBufferSize, snd_buffer_size, 512, 128, 32768, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound buffer size")
 #if defined(__ANDROID__)
 MACRO_CONFIG_INT(SndRate, snd_rate, 44100, 0, 0, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound mixing rate")
@@ -73,6 +77,10 @@ MACRO_CONFIG_INT(SndRate, snd_rate, 44100, 0, 0, CFGFLAG_SAVE|CFGFLAG_CLIENT, "S
 MACRO_CONFIG_INT(SndRate, snd_rate, 48000, 0, 0, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound mixing rate")
 #endif
 MACRO_CONFIG_INT(SndEnable, snd_enable, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound enable")
+MACRO_CONFIG_INT(SndOutput, snd_output, 0, 0, 2, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound output (0 = device, 1 = none, 2 = dumps/sound.wav)")
+MACRO_CONFIG_INT(SndStreamLength, snd_stream_length, 10, 0, 3600, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Decode opus sounds longer than this many seconds while playing (0 = never)")
+MACRO_CONFIG_INT(SndLazyDecode, snd_lazy_decode, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Keep sounds compressed until they are played for the first time")
+MACRO_CONFIG_INT(SndDecodedBudget, snd_decoded_budget, 2048, 64, 65536, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Memory for decoded sounds in KB, the least recently played ones are freed beyond it")
 MACRO_CONFIG_INT(SndMusic, snd_enable_music, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Play background music")
 MACRO_CONFIG_INT(SndVolume, snd_volume, 100, 0, 100, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Sound volume")
 MACRO_CONFIG_INT(SndDevice, snd_device, -1, 0, 0, CFGFLAG_SAVE|CFGFLAG_CLIENT, "(deprecated) Sound device to use")
@@ -122,6 +130,10 @@ MACRO_CONFIG_INT(GfxAsyncRenderOld, gfx_asyncrender_old, 1, 0, 1, CFGFLAG_SAVE|C
 MACRO_CONFIG_INT(GfxThreadedOld, gfx_threaded_old, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Use the threaded graphics backend")
 #endif
 MACRO_CONFIG_INT(GfxTuneOverlay, gfx_tune_overlay, 20, 1, 100, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Stop rendering text overlay in tuning zone in editor: high value = less details = more speed")
+MACRO_CONFIG_INT(GfxAtlas, gfx_atlas, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Pack sprites and map images into shared texture pages")
+MACRO_CONFIG_INT(GfxTileChunks, gfx_tile_chunks, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Render tile layers from chunks prepared at map load")
+MACRO_CONFIG_INT(GfxTextureCache, gfx_texture_cache, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Load textures converted to 16-bit from texcache/, store the ones that are missing")
+MACRO_CONFIG_INT(GfxTextCache, gfx_text_cache, 1, 0, 1, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Keep the layout of recently drawn texts")
 #if defined(__ANDROID__)
 MACRO_CONFIG_INT(GfxQuadAsTriangle, gfx_quad_as_triangle, 0, 0, 0, CFGFLAG_SAVE|CFGFLAG_CLIENT, "Render quads as triangles (fixes quad coloring on some GPUs)")
 #else
@@ -165,6 +177,16 @@ MACRO_CONFIG_INT(DbgStress, dbg_stress, 0, 0, 0, CFGFLAG_CLIENT|CFGFLAG_SERVER,
 MACRO_CONFIG_INT(DbgStressNetwork, dbg_stress_network, 0, 0, 0, CFGFLAG_CLIENT|CFGFLAG_SERVER, "Stress network")
 MACRO_CONFIG_INT(DbgPref, dbg_pref, 0, 0, 1, CFGFLAG_SERVER, "Performance outputs")
 MACRO_CONFIG_INT(DbgGraphs, dbg_graphs, 0, 0, 1, CFGFLAG_CLIENT, "Performance graphs")
+MACRO_CONFIG_INT(DbgBenchTicks, dbg_bench_ticks, 0, 0, 1000000, CFGFLAG_SERVER, "Run the given amount of ticks with bots and no network, then quit (0 = off)")
+MACRO_CONFIG_INT(DbgBenchBots, dbg_bench_bots, 16, 0, MAX_CLIENTS, CFGFLAG_SERVER, "Number of scripted bots for dbg_bench_ticks")
+MACRO_CONFIG_INT(DbgBenchTeams, dbg_bench_teams, 0, 0, MAX_CLIENTS-1, CFGFLAG_SERVER, "Spread the bots of dbg_bench_ticks over this many DDRace teams (0 = all in team 0)")
+MACRO_CONFIG_STR(DbgBenchDemo, dbg_bench_demo, 128, "", CFGFLAG_CLIENT, "Render the demo with the recording graphics backend as fast as possible, then quit")
+MACRO_CONFIG_INT(DbgBenchFps, dbg_bench_fps, 60, 1, 1000, CFGFLAG_CLIENT, "Frames per demo second for dbg_bench_demo")
+MACRO_CONFIG_INT(DbgBenchImmediate, dbg_bench_immediate, 0, 0, 1, CFGFLAG_CLIENT, "Record every vertex of dbg_bench_demo as separate color, texcoord and vertex calls like immediate mode")
+MACRO_CONFIG_INT(DbgBenchText, dbg_bench_text, 0, 0, 1000000, CFGFLAG_CLIENT, "Measure and draw sample texts the given amount of times, then quit (0 = off)")
+MACRO_CONFIG_INT(DbgBenchSound, dbg_bench_sound, 0, 0, 24, CFGFLAG_CLIENT, "Measure the mixing cost of up to this many voices when the sound starts")
+MACRO_CONFIG_INT(DbgBenchParticles, dbg_bench_particles, 0, 0, 8192, CFGFLAG_CLIENT, "Keep this many particles alive and print their update and render times")
+MACRO_CONFIG_INT(DbgSound, dbg_sound, 0, 0, 1, CFGFLAG_CLIENT, "Show sound memory and decode times")
 MACRO_CONFIG_INT(DbgHitch, dbg_hitch, 0, 0, 0, CFGFLAG_SERVER, "Hitch warnings")
 MACRO_CONFIG_STR(DbgStressServer, dbg_stress_server, 32, "localhost", CFGFLAG_CLIENT, "Server to stress")
 MACRO_CONFIG_INT(DbgResizable, dbg_resizable, 0, 0, 0, CFGFLAG_CLIENT, "Enables window resizing")
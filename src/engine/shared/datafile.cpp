@@ -3,7 +3,9 @@
 #include <base/math.h>
 #include <base/system.h>
 #include <engine/storage.h>
+#include "config.h"
 #include "datafile.h"
+#include "jobs.h"
 #include <zlib.h>
 
 static const int DEBUG=0;
@@ -58,53 +60,190 @@ struct CDatafileInfo
 struct CDatafile
 {
 	IOHANDLE m_File;
+	// the whole file if it could be mapped, m_File is 0 then. a file that
+	// had to be read for its crc is kept here as well until every data was
+	// loaded from it once or DropFileCopy is called, see m_pCopyLoaded
+	IOMAP m_Map;
 	unsigned m_Crc;
 	CDatafileInfo m_Info;
 	CDatafileHeader m_Header;
 	int m_DataStartOffset;
 	char **m_ppDataPtrs;
 	char *m_pData;
+
+	// compressed data of the last lazy load, kept for the next one
+	char *m_pScratch;
+	int m_ScratchSize;
+
+	// datas loaded from the copy in m_Map so far, 0 without a copy
+	char *m_pCopyLoaded;
+	int m_NumCopyPending;
 };
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+// crcs of recently opened files by path, size and modification time. the
+// server validates a map and then loads it, that way it is only read once.
+enum
 {
-	dbg_msg("datafile", "loading. filename='%s'", pFilename);
+	CRC_CACHE_SIZE=16,
+	CRC_BUFFER_SIZE=64*1024,
+	MAX_COPY_SIZE=4*1024*1024,
+};
 
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
-	if(!File)
-	{
-		dbg_msg("datafile", "could not open '%s'", pFilename);
+struct CCrcCacheEntry
+{
+	char m_aPath[512];
+	unsigned m_Size;
+	time_t m_Mtime;
+	unsigned m_Crc;
+};
+
+static CCrcCacheEntry gs_aCrcCache[CRC_CACHE_SIZE];
+static int gs_CrcCacheNext = 0;
+
+static bool CrcCacheLookup(const char *pPath, unsigned Size, time_t Mtime, unsigned *pCrc)
+{
+	if(!pPath[0] || !Mtime)
 		return false;
+	for(int i = 0; i < CRC_CACHE_SIZE; i++)
+	{
+		CCrcCacheEntry *pEntry = &gs_aCrcCache[i];
+		if(pEntry->m_Mtime == Mtime && pEntry->m_Size == Size && str_comp(pEntry->m_aPath, pPath) == 0)
+		{
+			*pCrc = pEntry->m_Crc;
+			return true;
+		}
 	}
+	return false;
+}
 
+static void CrcCacheStore(const char *pPath, unsigned Size, time_t Mtime, unsigned Crc)
+{
+	// files changed within the last seconds could change again without
+	// their modification time moving, don't trust those
+	if(!pPath[0] || !Mtime || Mtime >= time_timestamp()-1)
+		return;
+	CCrcCacheEntry *pEntry = &gs_aCrcCache[gs_CrcCacheNext];
+	gs_CrcCacheNext = (gs_CrcCacheNext+1)%CRC_CACHE_SIZE;
+	str_copy(pEntry->m_aPath, pPath, sizeof(pEntry->m_aPath));
+	pEntry->m_Size = Size;
+	pEntry->m_Mtime = Mtime;
+	pEntry->m_Crc = Crc;
+}
 
-	// take the CRC of the file and store it
-	unsigned Crc = 0;
+// continues the crc with the rest of the file, returns the number of bytes read
+static unsigned CrcRemaining(IOHANDLE File, unsigned *pCrc)
+{
+	unsigned char *pBuffer = (unsigned char *)mem_alloc(CRC_BUFFER_SIZE, 1);
+	unsigned Total = 0;
+	while(1)
 	{
-		enum
-		{
-			BUFFER_SIZE = 64*1024
-		};
+		unsigned Bytes = io_read(File, pBuffer, CRC_BUFFER_SIZE);
+		if(Bytes <= 0)
+			break;
+		*pCrc = crc32(*pCrc, pBuffer, Bytes); // ignore_convention
+		Total += Bytes;
+	}
+	mem_free(pBuffer);
+	return Total;
+}
 
-		unsigned char aBuffer[BUFFER_SIZE];
+// reads from the mapping if there is one, from the file otherwise
+static unsigned ReadAt(IOHANDLE File, const IOMAP *pMap, unsigned Offset, void *pBuffer, unsigned Size)
+{
+	if(!pMap->data)
+	{
+		io_seek(File, Offset, IOSEEK_START);
+		return io_read(File, pBuffer, Size);
+	}
+	if(Offset >= pMap->size)
+		return 0;
+	Size = min(Size, pMap->size-Offset);
+	mem_copy(pBuffer, (const char *)pMap->data+Offset, Size);
+	return Size;
+}
 
-		while(1)
-		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes <= 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes); // ignore_convention
-		}
+// the bytes in the mapping, 0 if there is none or they are out of bounds
+static const char *MappedAt(const IOMAP *pMap, unsigned Offset, unsigned Size)
+{
+	if(!pMap->data || Offset > pMap->size || Size > pMap->size-Offset)
+		return 0;
+	return (const char *)pMap->data+Offset;
+}
 
+static void CloseFile(IOHANDLE File, IOMAP *pMap)
+{
+	if(File)
+		io_close(File);
+	io_unmap(pMap);
+}
+
+// reads the whole file into a view that is not mapped
+static bool ReadCopy(IOHANDLE File, unsigned Size, IOMAP *pMap)
+{
+	void *pData = mem_alloc(max(Size, 1u), 1);
+	if(io_read(File, pData, Size) != Size)
+	{
+		mem_free(pData);
 		io_seek(File, 0, IOSEEK_START);
+		return false;
 	}
+	pMap->data = pData;
+	pMap->size = Size;
+	pMap->mapped = 0;
+	pMap->internal = 0;
+	return true;
+}
 
+// the copy of the file is dropped once every data came from it, the file
+// is still open for datas that are loaded again after an unload
+static void CopyLoaded(CDatafile *pDataFile, int Index)
+{
+	if(!pDataFile->m_pCopyLoaded || pDataFile->m_pCopyLoaded[Index])
+		return;
+	pDataFile->m_pCopyLoaded[Index] = 1;
+	if(--pDataFile->m_NumCopyPending == 0)
+	{
+		io_unmap(&pDataFile->m_Map);
+		pDataFile->m_pCopyLoaded = 0;
+	}
+}
+
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+{
+	dbg_msg("datafile", "loading. filename='%s'", pFilename);
+	int64 StartTime = time_get();
+
+	// map the file if possible. the data is loaded lazily, so reading the
+	// whole file into memory instead would only cost memory
+	char aPath[512];
+	IOMAP Map;
+	IOHANDLE File = 0;
+	if(!pStorage->MapFile(pFilename, StorageType, &Map, false, aPath, sizeof(aPath)))
+	{
+		File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
+		if(!File)
+		{
+			dbg_msg("datafile", "could not open '%s'", pFilename);
+			return false;
+		}
+	}
+
+	// the crc is either known already or taken while the file is read below
+	unsigned FileSize = File ? io_length(File) : Map.size;
+	time_t Mtime = fs_getmtime(aPath);
+	unsigned Crc = 0;
+	bool CrcCached = CrcCacheLookup(aPath, FileSize, Mtime, &Crc);
+
+	// without the crc the whole file has to be read now, keep it so the
+	// datas don't have to be read a second time when they are loaded
+	bool Copied = File && !CrcCached && FileSize <= MAX_COPY_SIZE && ReadCopy(File, FileSize, &Map);
 
 	// TODO: change this header
 	CDatafileHeader Header;
-	if (sizeof(Header) != io_read(File, &Header, sizeof(Header)))
+	if (sizeof(Header) != ReadAt(File, &Map, 0, &Header, sizeof(Header)))
 	{
 		dbg_msg("datafile", "couldn't load header");
+		CloseFile(File, &Map);
 		return 0;
 	}
 	if(Header.m_aID[0] != 'A' || Header.m_aID[1] != 'T' || Header.m_aID[2] != 'A' || Header.m_aID[3] != 'D')
@@ -112,9 +251,12 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		if(Header.m_aID[0] != 'D' || Header.m_aID[1] != 'A' || Header.m_aID[2] != 'T' || Header.m_aID[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aID[0], Header.m_aID[1], Header.m_aID[2], Header.m_aID[3]);
+			CloseFile(File, &Map);
 			return 0;
 		}
 	}
+	if(!CrcCached && !Map.data)
+		Crc = crc32(Crc, (const Bytef *)&Header, sizeof(Header)); // ignore_convention
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(&Header, sizeof(int), sizeof(Header)/sizeof(int));
@@ -122,6 +264,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
+		CloseFile(File, &Map);
 		return 0;
 	}
 
@@ -136,6 +279,8 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	unsigned AllocSize = Size;
 	AllocSize += sizeof(CDatafile); // add space for info structure
 	AllocSize += Header.m_NumRawData*sizeof(void*); // add space for data pointers
+	if(Copied)
+		AllocSize += Header.m_NumRawData; // add space for the copy flags
 
 	CDatafile *pTmpDataFile = (CDatafile*)mem_alloc(AllocSize, 1);
 	pTmpDataFile->m_Header = Header;
@@ -143,22 +288,47 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	pTmpDataFile->m_ppDataPtrs = (char**)(pTmpDataFile+1);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile+1)+Header.m_NumRawData*sizeof(char *);
 	pTmpDataFile->m_File = File;
-	pTmpDataFile->m_Crc = Crc;
+	pTmpDataFile->m_Map = Map;
+	pTmpDataFile->m_pScratch = 0;
+	pTmpDataFile->m_ScratchSize = 0;
+	pTmpDataFile->m_pCopyLoaded = 0;
+	pTmpDataFile->m_NumCopyPending = 0;
+	if(Copied && Header.m_NumRawData > 0)
+	{
+		pTmpDataFile->m_pCopyLoaded = pTmpDataFile->m_pData+Size;
+		mem_zero(pTmpDataFile->m_pCopyLoaded, Header.m_NumRawData);
+		pTmpDataFile->m_NumCopyPending = Header.m_NumRawData;
+	}
 
 	// clear the data pointers
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData*sizeof(void*));
 
 	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
+	unsigned ReadSize = ReadAt(File, &Map, sizeof(Header), pTmpDataFile->m_pData, Size);
 	if(ReadSize != Size)
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile(File, &Map);
 		mem_free(pTmpDataFile);
 		pTmpDataFile = 0;
 		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
 		return false;
 	}
 
+	// the data itself is loaded on demand, only the crc needs the rest of the file now
+	if(!CrcCached && Map.data)
+	{
+		Crc = crc32(0, (const Bytef *)Map.data, Map.size); // ignore_convention
+		CrcCacheStore(aPath, FileSize, Mtime, Crc);
+	}
+	else if(!CrcCached)
+	{
+		Crc = crc32(Crc, (const Bytef *)pTmpDataFile->m_pData, Size); // ignore_convention
+		unsigned Remaining = CrcRemaining(File, &Crc);
+		if(sizeof(Header)+Size+Remaining == FileSize)
+			CrcCacheStore(aPath, FileSize, Mtime, Crc);
+	}
+	pTmpDataFile->m_Crc = Crc;
+
 	Close();
 	m_pDataFile = pTmpDataFile;
 
@@ -185,7 +355,8 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		m_pDataFile->m_Info.m_pItemStart = (char *)&m_pDataFile->m_Info.m_pDataOffsets[m_pDataFile->m_Header.m_NumRawData];
 	m_pDataFile->m_Info.m_pDataStart = m_pDataFile->m_Info.m_pItemStart + m_pDataFile->m_Header.m_ItemSize;
 
-	dbg_msg("datafile", "loading done. datafile='%s'", pFilename);
+	dbg_msg("datafile", "loading done. datafile='%s' time=%.2fms crc=%s", pFilename,
+		(time_get()-StartTime)*1000.0f/time_freq(), CrcCached ? "cached" : Copied ? "read" : Map.data ? "mapped" : "streamed");
 
 	if(DEBUG)
 	{
@@ -228,21 +399,19 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 bool CDataFileReader::GetCrcSize(class IStorage *pStorage, const char *pFilename, int StorageType, unsigned *pCrc, unsigned *pSize)
 {
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	char aPath[512];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
 	if(!File)
 		return false;
 
 	// get crc and size
+	unsigned Size = io_length(File);
+	time_t Mtime = fs_getmtime(aPath);
 	unsigned Crc = 0;
-	unsigned Size = 0;
-	unsigned char aBuffer[64*1024];
-	while(1)
+	if(!CrcCacheLookup(aPath, Size, Mtime, &Crc))
 	{
-		unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
-		if(Bytes <= 0)
-			break;
-		Crc = crc32(Crc, aBuffer, Bytes); // ignore_convention
-		Size += Bytes;
+		Size = CrcRemaining(File, &Crc);
+		CrcCacheStore(aPath, Size, Mtime, Crc);
 	}
 
 	io_close(File);
@@ -279,6 +448,16 @@ int CDataFileReader::GetUncompressedDataSize(int Index)
 		return GetDataSize(Index);
 }
 
+bool CDataFileReader::GetCompressedData(int Index, void *pBuffer)
+{
+	if(!m_pDataFile || m_pDataFile->m_Header.m_Version != 4 || Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
+		return false;
+
+	int DataSize = GetDataSize(Index);
+	unsigned Offset = m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index];
+	return (int)ReadAt(m_pDataFile->m_File, &m_pDataFile->m_Map, Offset, pBuffer, DataSize) == DataSize;
+}
+
 void *CDataFileReader::GetDataImpl(int Index, int Swap)
 {
 	if(!m_pDataFile) { return 0; }
@@ -288,14 +467,15 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 	{
 		// fetch the data size
 		int DataSize = GetDataSize(Index);
+		unsigned Offset = m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index];
 #if defined(CONF_ARCH_ENDIAN_BIG)
 		int SwapSize = DataSize;
 #endif
 
 		if(m_pDataFile->m_Header.m_Version == 4)
 		{
-			// v4 has compressed data
-			void *pTemp = (char *)mem_alloc(DataSize, 1);
+			// v4 has compressed data, a mapped file is inflated in place
+			const char *pTemp = MappedAt(&m_pDataFile->m_Map, Offset, DataSize);
 			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
 			unsigned long s;
 
@@ -303,8 +483,17 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc(UncompressedSize, 1);
 
 			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
+			if(!pTemp)
+			{
+				if(m_pDataFile->m_ScratchSize < DataSize)
+				{
+					mem_free(m_pDataFile->m_pScratch);
+					m_pDataFile->m_pScratch = (char *)mem_alloc(DataSize, 1);
+					m_pDataFile->m_ScratchSize = DataSize;
+				}
+				ReadAt(m_pDataFile->m_File, &m_pDataFile->m_Map, Offset, m_pDataFile->m_pScratch, DataSize);
+				pTemp = m_pDataFile->m_pScratch;
+			}
 
 			// decompress the data, TODO: check for errors
 			s = UncompressedSize;
@@ -312,28 +501,197 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
-
-			// clean up the temporary buffers
-			mem_free(pTemp);
 		}
 		else
 		{
 			// load the data
 			dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
 			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc(DataSize, 1);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+			ReadAt(m_pDataFile->m_File, &m_pDataFile->m_Map, Offset, m_pDataFile->m_ppDataPtrs[Index], DataSize);
 		}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 		if(Swap && SwapSize)
 			swap_endian(m_pDataFile->m_ppDataPtrs[Index], sizeof(int), SwapSize/sizeof(int));
 #endif
+		CopyLoaded(m_pDataFile, Index);
 	}
 
 	return m_pDataFile->m_ppDataPtrs[Index];
 }
 
+struct CPrefetchEntry
+{
+	int m_Index;
+	const char *m_pCompressed;
+	int m_CompressedSize;
+	char *m_pDest;
+	int m_Size;
+};
+
+struct CPrefetchJob
+{
+	CJob m_Job;
+	CPrefetchEntry *m_pEntries;
+	int m_Num;
+};
+
+static int PrefetchJob(void *pUser)
+{
+	CPrefetchJob *pJob = (CPrefetchJob *)pUser;
+	int Errors = 0;
+	for(int i = 0; i < pJob->m_Num; i++)
+	{
+		CPrefetchEntry *pEntry = &pJob->m_pEntries[i];
+		unsigned long s = pEntry->m_Size;
+		if(uncompress((Bytef *)pEntry->m_pDest, &s, (Bytef *)pEntry->m_pCompressed, pEntry->m_CompressedSize) != Z_OK || (int)s != pEntry->m_Size) // ignore_convention
+		{
+			// leave it to the lazy load
+			mem_free(pEntry->m_pDest);
+			pEntry->m_pDest = 0;
+			Errors++;
+		}
+	}
+	return Errors;
+}
+
+void CDataFileReader::Prefetch(const int *pIndices, int Num)
+{
+	if(!m_pDataFile || Num <= 0)
+		return;
+
+	int64 StartTime = time_get();
+	bool Compressed = m_pDataFile->m_Header.m_Version == 4;
+
+	// sorted by index the blocks are in file order, so the reads only seek forward
+	CPrefetchEntry *pEntries = (CPrefetchEntry *)mem_alloc(Num*sizeof(CPrefetchEntry), 1);
+	int NumEntries = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		int Index = pIndices[i];
+		if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData || m_pDataFile->m_ppDataPtrs[Index])
+			continue;
+		int j = NumEntries;
+		for(; j > 0 && pEntries[j-1].m_Index >= Index; j--)
+			;
+		if(j < NumEntries && pEntries[j].m_Index == Index)
+			continue;
+		mem_move(&pEntries[j+1], &pEntries[j], (NumEntries-j)*sizeof(CPrefetchEntry));
+		pEntries[j].m_Index = Index;
+		NumEntries++;
+	}
+	if(!NumEntries)
+	{
+		mem_free(pEntries);
+		return;
+	}
+
+	int TotalSize = 0;
+	int CompressedSize = 0;
+	for(int i = 0; i < NumEntries; i++)
+	{
+		pEntries[i].m_Size = GetUncompressedDataSize(pEntries[i].m_Index);
+		pEntries[i].m_CompressedSize = Compressed ? GetDataSize(pEntries[i].m_Index) : 0;
+		TotalSize += pEntries[i].m_Size;
+		CompressedSize += pEntries[i].m_CompressedSize;
+	}
+
+	// every data gets its own block so it can still be unloaded on its own,
+	// the compressed data is read into one buffer and gone after inflating.
+	// a mapped file is inflated in place
+	IOMAP *pMap = &m_pDataFile->m_Map;
+	char *pCompressed = Compressed && !pMap->data ? (char *)mem_alloc(max(CompressedSize, 1), 1) : 0;
+	char *pSrc = pCompressed;
+	for(int i = 0; i < NumEntries; i++)
+	{
+		CPrefetchEntry *pEntry = &pEntries[i];
+		pEntry->m_pDest = (char *)mem_alloc(max(pEntry->m_Size, 1), 1);
+
+		unsigned Offset = m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[pEntry->m_Index];
+		if(Compressed)
+		{
+			pEntry->m_pCompressed = MappedAt(pMap, Offset, pEntry->m_CompressedSize);
+			if(!pEntry->m_pCompressed)
+			{
+				pEntry->m_pCompressed = pSrc;
+				if(!pSrc || (int)ReadAt(m_pDataFile->m_File, pMap, Offset, pSrc, pEntry->m_CompressedSize) != pEntry->m_CompressedSize)
+					pEntry->m_CompressedSize = 0;
+				else
+					pSrc += pEntry->m_CompressedSize;
+			}
+		}
+		else if((int)ReadAt(m_pDataFile->m_File, pMap, Offset, pEntry->m_pDest, pEntry->m_Size) != pEntry->m_Size)
+		{
+			mem_free(pEntry->m_pDest);
+			pEntry->m_pDest = 0;
+		}
+	}
+
+	// split the inflating into runs of about the same compressed size, the
+	// calling thread takes the first one
+	enum
+	{
+		MAX_PREFETCH_JOBS=9,
+	};
+	static CJobPool s_Pool;
+	static int s_NumThreads = 0;
+	int NumJobs = 1;
+	if(Compressed)
+	{
+		if(s_NumThreads < g_Config.m_MapDecodeThreads)
+		{
+			s_Pool.Init(g_Config.m_MapDecodeThreads - s_NumThreads);
+			s_NumThreads = g_Config.m_MapDecodeThreads;
+		}
+		NumJobs = clamp(g_Config.m_MapDecodeThreads+1, 1, min((int)MAX_PREFETCH_JOBS, NumEntries));
+
+		CPrefetchJob aJobs[MAX_PREFETCH_JOBS];
+		int Entry = 0;
+		int Done = 0;
+		for(int i = 0; i < NumJobs; i++)
+		{
+			aJobs[i].m_pEntries = &pEntries[Entry];
+			int Target = (int)((int64)CompressedSize*(i+1)/NumJobs);
+			while(Entry < NumEntries && (i == NumJobs-1 || Done < Target))
+				Done += pEntries[Entry++].m_CompressedSize;
+			aJobs[i].m_Num = &pEntries[Entry] - aJobs[i].m_pEntries;
+		}
+
+		for(int i = 1; i < NumJobs; i++)
+			if(aJobs[i].m_Num)
+				s_Pool.Add(&aJobs[i].m_Job, PrefetchJob, &aJobs[i]);
+		PrefetchJob(&aJobs[0]);
+		for(int i = 1; i < NumJobs; i++)
+			if(aJobs[i].m_Num)
+				s_Pool.Wait(&aJobs[i].m_Job);
+	}
+
+	int NumLoaded = 0;
+	for(int i = 0; i < NumEntries; i++)
+		if(pEntries[i].m_pDest)
+		{
+			m_pDataFile->m_ppDataPtrs[pEntries[i].m_Index] = pEntries[i].m_pDest;
+			CopyLoaded(m_pDataFile, pEntries[i].m_Index);
+			NumLoaded++;
+		}
+
+	dbg_msg("datafile", "prefetched %d/%d datas, %d bytes in %.2fms with %d jobs", NumLoaded, NumEntries, TotalSize,
+		(time_get()-StartTime)*1000.0f/time_freq(), NumJobs);
+	mem_free(pCompressed);
+	mem_free(pEntries);
+}
+
+void CDataFileReader::DropFileCopy()
+{
+	if(!m_pDataFile || !m_pDataFile->m_pCopyLoaded)
+		return;
+
+	dbg_msg("datafile", "dropped the file copy, %d datas were not loaded from it", m_pDataFile->m_NumCopyPending);
+	io_unmap(&m_pDataFile->m_Map);
+	m_pDataFile->m_pCopyLoaded = 0;
+	m_pDataFile->m_NumCopyPending = 0;
+}
+
 void *CDataFileReader::GetData(int Index)
 {
 	return GetDataImpl(Index, 0);
@@ -424,8 +782,9 @@ bool CDataFileReader::Close()
 	int i;
 	for(i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 		mem_free(m_pDataFile->m_ppDataPtrs[i]);
+	mem_free(m_pDataFile->m_pScratch);
 
-	io_close(m_pDataFile->m_File);
+	CloseFile(m_pDataFile->m_File, &m_pDataFile->m_Map);
 	mem_free(m_pDataFile);
 	m_pDataFile = 0;
 	return true;
@@ -441,6 +800,7 @@ unsigned CDataFileReader::Crc()
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_CompressionLevel = Z_DEFAULT_COMPRESSION;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1));
 	m_pItems = static_cast<CItemInfo *>(mem_alloc(sizeof(CItemInfo) * MAX_ITEMS, 1));
 	m_pDatas = static_cast<CDataInfo *>(mem_alloc(sizeof(CDataInfo) * MAX_DATAS, 1));
@@ -469,6 +829,7 @@ void CDataFileWriter::Init()
 	m_NumItems = 0;
 	m_NumDatas = 0;
 	m_NumItemTypes = 0;
+	m_PendingSize = 0;
 	mem_zero(m_pItemTypes, sizeof(CItemTypeInfo) * MAX_ITEM_TYPES);
 
 	for(int i = 0; i < MAX_ITEM_TYPES; i++)
@@ -522,25 +883,177 @@ int CDataFileWriter::AddData(int Size, void *pData)
 {
 	dbg_assert(m_NumDatas < 1024, "too much data");
 
+	// compressed together with the other pending datas
 	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
-	void *pCompData = mem_alloc(s, 1); // temporary buffer that we use during compression
+	pInfo->m_UncompressedSize = Size;
+	pInfo->m_CompressedSize = 0;
+	pInfo->m_pUncompressedData = mem_alloc(max(Size, 1), 1);
+	mem_copy(pInfo->m_pUncompressedData, pData, Size);
+	pInfo->m_pCompressedData = 0;
 
-	int Result = compress((Bytef*)pCompData, &s, (Bytef*)pData, Size); // ignore_convention
-	if(Result != Z_OK)
+	m_NumDatas++;
+
+	// only so many raw copies are kept, without extra threads there is
+	// nothing to gain from holding any
+	m_PendingSize += Size;
+	if(!g_Config.m_MapEncodeThreads || m_PendingSize >= MAX_PENDING_SIZE)
+		CompressDatas();
+	return m_NumDatas-1;
+}
+
+int CDataFileWriter::AddDataCompressed(int UncompressedSize, int CompressedSize, const void *pCompressedData)
+{
+	dbg_assert(m_NumDatas < 1024, "too much data");
+
+	// written as is, Finish skips it
+	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
+	pInfo->m_UncompressedSize = UncompressedSize;
+	pInfo->m_CompressedSize = CompressedSize;
+	pInfo->m_pUncompressedData = 0;
+	pInfo->m_pCompressedData = mem_alloc(max(CompressedSize, 1), 1);
+	mem_copy(pInfo->m_pCompressedData, pCompressedData, CompressedSize);
+
+	m_NumDatas++;
+	return m_NumDatas-1;
+}
+
+struct CCompressEntry
+{
+	void *m_pSrc;
+	int m_SrcSize;
+	void *m_pDst;
+	int m_DstSize;
+};
+
+struct CCompressJob
+{
+	CJob m_Job;
+	int m_Level;
+	CCompressEntry *m_pEntries;
+	int m_Num;
+};
+
+static int CompressJob(void *pUser)
+{
+	CCompressJob *pJob = (CCompressJob *)pUser;
+
+	// one deflate state for all datas of the job, reset in between
+	z_stream Stream;
+	mem_zero(&Stream, sizeof(Stream));
+	int Result = deflateInit(&Stream, pJob->m_Level); // ignore_convention
+	for(int i = 0; i < pJob->m_Num && Result == Z_OK; i++)
 	{
+		CCompressEntry *pEntry = &pJob->m_pEntries[i];
+		if(!pEntry->m_pSrc)
+			continue;
+		unsigned long Bound = deflateBound(&Stream, pEntry->m_SrcSize); // ignore_convention
+		pEntry->m_pDst = mem_alloc(Bound, 1);
+		Stream.next_in = (Bytef *)pEntry->m_pSrc; // ignore_convention
+		Stream.avail_in = pEntry->m_SrcSize; // ignore_convention
+		Stream.next_out = (Bytef *)pEntry->m_pDst; // ignore_convention
+		Stream.avail_out = Bound; // ignore_convention
+		Result = deflate(&Stream, Z_FINISH); // ignore_convention
+		if(Result != Z_STREAM_END)
+		{
+			mem_free(pEntry->m_pDst);
+			pEntry->m_pDst = 0;
+			break;
+		}
+		pEntry->m_DstSize = Bound - Stream.avail_out; // ignore_convention
+		Result = deflateReset(&Stream); // ignore_convention
+
+		// the raw data is not needed anymore
+		mem_free(pEntry->m_pSrc);
+		pEntry->m_pSrc = 0;
+	}
+	deflateEnd(&Stream); // ignore_convention
+	return Result == Z_OK ? 0 : Result;
+}
+
+void CDataFileWriter::CompressDatas()
+{
+	enum
+	{
+		MAX_COMPRESS_JOBS=9,
+	};
+	static CJobPool s_Pool;
+	static int s_NumThreads = 0;
+	if(s_NumThreads < g_Config.m_MapEncodeThreads)
+	{
+		s_Pool.Init(g_Config.m_MapEncodeThreads - s_NumThreads);
+		s_NumThreads = g_Config.m_MapEncodeThreads;
+	}
+
+	int64 StartTime = time_get();
+	CCompressEntry *pEntries = (CCompressEntry *)mem_alloc(max(m_NumDatas, 1)*sizeof(CCompressEntry), 1);
+	int TotalSize = 0;
+	for(int i = 0; i < m_NumDatas; i++)
+	{
+		pEntries[i].m_pSrc = m_pDatas[i].m_pUncompressedData;
+		pEntries[i].m_SrcSize = pEntries[i].m_pSrc ? m_pDatas[i].m_UncompressedSize : 0;
+		pEntries[i].m_pDst = 0;
+		pEntries[i].m_DstSize = 0;
+		TotalSize += pEntries[i].m_SrcSize;
+	}
+
+	// runs of about the same raw size, the calling thread takes the first one
+	int NumJobs = clamp(g_Config.m_MapEncodeThreads+1, 1, max(min((int)MAX_COMPRESS_JOBS, m_NumDatas), 1));
+	CCompressJob aJobs[MAX_COMPRESS_JOBS];
+	int Entry = 0;
+	int Done = 0;
+	for(int i = 0; i < NumJobs; i++)
+	{
+		aJobs[i].m_Level = m_CompressionLevel;
+		aJobs[i].m_pEntries = &pEntries[Entry];
+		int Target = (int)((int64)TotalSize*(i+1)/NumJobs);
+		while(Entry < m_NumDatas && (i == NumJobs-1 || Done < Target))
+			Done += pEntries[Entry++].m_SrcSize;
+		aJobs[i].m_Num = &pEntries[Entry] - aJobs[i].m_pEntries;
+	}
+
+	for(int i = 1; i < NumJobs; i++)
+		if(aJobs[i].m_Num)
+			s_Pool.Add(&aJobs[i].m_Job, CompressJob, &aJobs[i]);
+	int Result = CompressJob(&aJobs[0]);
+	for(int i = 1; i < NumJobs; i++)
+		if(aJobs[i].m_Num)
+		{
+			s_Pool.Wait(&aJobs[i].m_Job);
+			if(aJobs[i].m_Job.Result())
+				Result = aJobs[i].m_Job.Result();
+		}
+	if(Result != 0)
+	{
+		// the raw copies the jobs didn't get to and all output go with it
+		for(int i = 0; i < m_NumDatas; i++)
+		{
+			if(!m_pDatas[i].m_pUncompressedData)
+				continue;
+			mem_free(pEntries[i].m_pSrc);
+			mem_free(pEntries[i].m_pDst);
+			m_pDatas[i].m_pUncompressedData = 0;
+		}
+		mem_free(pEntries);
+		m_PendingSize = 0;
 		dbg_msg("datafile", "compression error %d", Result);
 		dbg_assert(0, "zlib error");
+		return;
 	}
 
-	pInfo->m_UncompressedSize = Size;
-	pInfo->m_CompressedSize = (int)s;
-	pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
-	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
-	mem_free(pCompData);
+	for(int i = 0; i < m_NumDatas; i++)
+	{
+		if(!m_pDatas[i].m_pUncompressedData)
+			continue;
+		m_pDatas[i].m_pUncompressedData = 0;
+		m_pDatas[i].m_pCompressedData = pEntries[i].m_pDst;
+		m_pDatas[i].m_CompressedSize = pEntries[i].m_DstSize;
+	}
+	mem_free(pEntries);
+	m_PendingSize = 0;
 
-	m_NumDatas++;
-	return m_NumDatas-1;
+	if(DEBUG && TotalSize)
+		dbg_msg("datafile", "compressed %d bytes in %.2fms with %d jobs", TotalSize,
+			(time_get()-StartTime)*1000.0f/time_freq(), NumJobs);
 }
 
 int CDataFileWriter::AddDataSwapped(int Size, void *pData)
@@ -569,6 +1082,8 @@ int CDataFileWriter::Finish()
 	int DataSize = 0;
 	CDatafileHeader Header;
 
+	CompressDatas();
+
 	// we should now write this file!
 	if(DEBUG)
 		dbg_msg("datafile", "writing");
@@ -23,7 +23,14 @@ public:
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	int GetDataSize(int Index);
 	int GetUncompressedDataSize(int Index);
+	bool GetCompressedData(int Index, void *pBuffer); // GetDataSize bytes as stored, only for compressed files
 	void UnloadData(int Index);
+	// loads the given datas in one pass over the file, inflating them on map_decode_threads
+	// extra threads. the data is not swapped, use it for byte data only.
+	void Prefetch(const int *pIndices, int Num);
+	// frees the copy of the file Open keeps when it had to read it for the crc,
+	// call it after the first pass over the datas. later loads read the file
+	void DropFileCopy();
 	void *GetItem(int Index, int *pType, int *pID);
 	int GetItemSize(int Index);
 	void GetType(int Type, int *pStart, int *pNum);
@@ -42,6 +49,7 @@ class CDataFileWriter
 	{
 		int m_UncompressedSize;
 		int m_CompressedSize;
+		void *m_pUncompressedData;
 		void *m_pCompressedData;
 	};
 
@@ -67,6 +75,7 @@ class CDataFileWriter
 		MAX_ITEM_TYPES=0xffff,
 		MAX_ITEMS=1024,
 		MAX_DATAS=1024,
+		MAX_PENDING_SIZE=2*1024*1024, // raw bytes held before AddData compresses them
 	};
 
 	IOHANDLE m_File;
@@ -76,6 +85,10 @@ class CDataFileWriter
 	CItemTypeInfo *m_pItemTypes;
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
+	int m_PendingSize;
+	int m_CompressionLevel;
+
+	void CompressDatas();
 
 public:
 	CDataFileWriter();
@@ -85,7 +98,10 @@ public:
 	bool Open(class IStorage *pStorage, const char *Filename);
 	int AddData(int Size, void *pData);
 	int AddDataSwapped(int Size, void *pData);
+	int AddDataCompressed(int UncompressedSize, int CompressedSize, const void *pCompressedData); // from CDataFileReader::GetCompressedData
 	int AddItem(int Type, int ID, int Size, void *pData);
+	// zlib level from 0 (fastest) to 9 (smallest), -1 for the default
+	void SetCompressionLevel(int Level) { m_CompressionLevel = Level; }
 	int Finish();
 };
 
@@ -3,6 +3,8 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#include <zlib.h>
+
 #include <engine/console.h>
 #include <engine/storage.h>
 
@@ -20,21 +22,176 @@ static const unsigned char gs_OldVersion = 3;
 static const unsigned char gs_VersionTickCompression = 5; // demo files with this version or higher will use `CHUNKTICKFLAG_TICK_COMPRESSED`
 static const int gs_LengthOffset = 152;
 static const int gs_NumMarkersOffset = 176;
+static const unsigned char gs_aIndexMarker[4] = {'T', 'W', 'D', 'I'};
+static const int gs_IndexVersion = 1;
+
+/*
+	Keyframe index, democache/<header crc>_<file size>.idx
+		marker, version, file size, number of keyframes, first tick, last tick
+		then file position and tick of every keyframe
+	all big endian. the header holds the recording time and the length,
+	so a recording that is overwritten gets a different index. deleting a
+	demo in the browser removes its index, the ones of demos removed
+	otherwise are pruned oldest first once there are gs_MaxIndexes.
+*/
+
+static void IndexFilename(const CDemoHeader *pHeader, unsigned FileSize, char *pBuf, int BufSize)
+{
+	unsigned Crc = crc32(0, (const Bytef *)pHeader, sizeof(*pHeader));
+	str_format(pBuf, BufSize, "democache/%08x_%u.idx", Crc, FileSize);
+}
+
+// the oldest indexes beyond this are removed when one is saved
+static const int gs_MaxIndexes = 256;
+// removed per save at most, so the listing stays bounded
+static const int gs_MaxPrune = 16;
+
+struct CIndexEntry
+{
+	time_t m_Date;
+	char m_aName[64];
+};
+
+// the gs_MaxPrune oldest indexes, sorted oldest first
+struct CIndexList
+{
+	int m_Num;
+	int m_NumOldest;
+	CIndexEntry m_aOldest[gs_MaxPrune];
+};
+
+static int IndexListCallback(const char *pName, time_t Date, int IsDir, int StorageType, void *pUser)
+{
+	CIndexList *pList = (CIndexList *)pUser;
+	int Length = str_length(pName);
+	if(IsDir || Length < 4 || str_comp(pName+Length-4, ".idx") != 0)
+		return 0;
+	pList->m_Num++;
+
+	int Pos = pList->m_NumOldest;
+	while(Pos > 0 && Date < pList->m_aOldest[Pos-1].m_Date)
+		Pos--;
+	if(Pos == gs_MaxPrune)
+		return 0;
+	int Num = min(pList->m_NumOldest+1, gs_MaxPrune);
+	mem_move(&pList->m_aOldest[Pos+1], &pList->m_aOldest[Pos], (Num-1-Pos)*sizeof(CIndexEntry));
+	pList->m_aOldest[Pos].m_Date = Date;
+	str_copy(pList->m_aOldest[Pos].m_aName, pName, sizeof(pList->m_aOldest[Pos].m_aName));
+	pList->m_NumOldest = Num;
+	return 0;
+}
+
+static void PruneIndexes(IStorage *pStorage)
+{
+	CIndexList List;
+	List.m_Num = 0;
+	List.m_NumOldest = 0;
+	pStorage->ListDirectoryInfo(IStorage::TYPE_SAVE, "democache", IndexListCallback, &List);
+	int NumRemove = min(List.m_Num-gs_MaxIndexes, List.m_NumOldest);
+	for(int i = 0; i < NumRemove; i++)
+	{
+		char aFilename[128];
+		str_format(aFilename, sizeof(aFilename), "democache/%s", List.m_aOldest[i].m_aName);
+		pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+static void WriteIndexInt(unsigned char *pBuf, int Value)
+{
+	pBuf[0] = (Value>>24)&0xff;
+	pBuf[1] = (Value>>16)&0xff;
+	pBuf[2] = (Value>>8)&0xff;
+	pBuf[3] = (Value)&0xff;
+}
+
+static int ReadIndexInt(const unsigned char *pBuf)
+{
+	return (pBuf[0]<<24) | (pBuf[1]<<16) | (pBuf[2]<<8) | pBuf[3];
+}
+
+static void SaveIndex(IStorage *pStorage, const CDemoHeader *pHeader, unsigned FileSize, const CDemoKeyFrame *pKeyFrames, int Num, int FirstTick, int LastTick)
+{
+	char aFilename[128];
+	IndexFilename(pHeader, FileSize, aFilename, sizeof(aFilename));
+	IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	unsigned char aHeader[24];
+	mem_copy(aHeader, gs_aIndexMarker, sizeof(gs_aIndexMarker));
+	WriteIndexInt(aHeader+4, gs_IndexVersion);
+	WriteIndexInt(aHeader+8, FileSize);
+	WriteIndexInt(aHeader+12, Num);
+	WriteIndexInt(aHeader+16, FirstTick);
+	WriteIndexInt(aHeader+20, LastTick);
+	io_write(File, aHeader, sizeof(aHeader));
+
+	unsigned char *pData = (unsigned char *)mem_alloc(Num*8, 1);
+	for(int i = 0; i < Num; i++)
+	{
+		WriteIndexInt(pData+i*8, pKeyFrames[i].m_Filepos);
+		WriteIndexInt(pData+i*8+4, pKeyFrames[i].m_Tick);
+	}
+	io_write(File, pData, Num*8);
+	mem_free(pData);
+	io_close(File);
+
+	PruneIndexes(pStorage);
+}
 
 
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData)
 {
+	Reset();
+	Init(pSnapshotDelta, DelayedMapData);
+}
+
+CDemoRecorder::CDemoRecorder()
+{
+	Reset();
+}
+
+void CDemoRecorder::Reset()
+{
+	m_pConsole = 0;
+	m_pStorage = 0;
 	m_File = 0;
+	mem_zero(&m_Header, sizeof(m_Header));
 	m_LastTickMarker = -1;
+	m_LastKeyFrame = 0;
+	m_FirstTick = 0;
+	mem_zero(m_aLastSnapshotData, sizeof(m_aLastSnapshotData));
+	m_pSnapshotDelta = 0;
+	m_NumTimelineMarkers = 0;
+	mem_zero(m_aTimelineMarkers, sizeof(m_aTimelineMarkers));
+	m_DelayedMapData = false;
+	m_MapSize = 0;
+	m_pMapData = 0;
+	m_Index = true;
+	m_pKeyFrames = 0;
+	m_NumKeyFrames = 0;
+	m_KeyFramesCapacity = 0;
+}
+
+void CDemoRecorder::Init(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData, bool Index)
+{
+	dbg_assert(!m_File, "changing a recorder while recording");
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_DelayedMapData = DelayedMapData;
+	m_Index = Index;
+}
+
+CDemoRecorder::~CDemoRecorder()
+{
+	mem_free(m_pKeyFrames);
 }
 
 // Record
-int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType, unsigned int MapSize, unsigned char *pMapData)
+int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType, unsigned int MapSize, unsigned char *pMapData, const char *pMapPath)
 {
 	m_MapSize = MapSize;
 	m_pMapData = pMapData;
+	m_pConsole = pConsole;
 
 	IOHANDLE DemoFile = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 	if(!DemoFile)
@@ -50,7 +207,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	if(m_File)
 		return -1;
 
-	m_pConsole = pConsole;
+	m_pStorage = pStorage;
 
 	IOHANDLE MapFile = NULL;
 
@@ -58,9 +215,13 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	{
 		// open mapfile
 		char aMapFilename[128];
+		// the file the map was loaded from
+		if(pMapPath)
+			MapFile = pStorage->OpenFile(pMapPath, IOFLAG_READ, IStorage::TYPE_ALL);
 		// try the normal maps folder
 		str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", pMap);
-		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+		if(!MapFile)
+			MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
 		if(!MapFile)
 		{
 			// try the downloaded maps
@@ -104,6 +265,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	// Header.m_Length - add this on stop
 	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
 	io_write(DemoFile, &Header, sizeof(Header));
+	m_Header = Header;
 	io_write(DemoFile, &TimelineMarkers, sizeof(TimelineMarkers)); // fill this on stop
 
 	if(m_DelayedMapData)
@@ -128,6 +290,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_NumKeyFrames = 0;
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "Recording to '%s'", pFilename);
@@ -181,6 +344,22 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 		if(Keyframe)
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
 
+		if(Keyframe && m_Index)
+		{
+			if(m_NumKeyFrames == m_KeyFramesCapacity)
+			{
+				m_KeyFramesCapacity = max(m_KeyFramesCapacity*2, 64);
+				CDemoKeyFrame *pKeyFrames = (CDemoKeyFrame *)mem_alloc(m_KeyFramesCapacity*sizeof(CDemoKeyFrame), 1);
+				if(m_pKeyFrames)
+					mem_copy(pKeyFrames, m_pKeyFrames, m_NumKeyFrames*sizeof(CDemoKeyFrame));
+				mem_free(m_pKeyFrames);
+				m_pKeyFrames = pKeyFrames;
+			}
+			m_pKeyFrames[m_NumKeyFrames].m_Filepos = io_tell(m_File);
+			m_pKeyFrames[m_NumKeyFrames].m_Tick = Tick;
+			m_NumKeyFrames++;
+		}
+
 		io_write(m_File, aChunk, sizeof(aChunk));
 	}
 	else
@@ -319,6 +498,14 @@ int CDemoRecorder::Stop(bool Finalize)
 		io_write(m_File, m_pMapData, m_MapSize);
 	}
 
+	// index the keyframes, so the player doesn't have to scan the file
+	io_seek(m_File, 0, IOSEEK_END);
+	unsigned FileSize = io_tell(m_File);
+	mem_copy(m_Header.m_aLength, aLength, sizeof(aLength));
+	if(m_NumKeyFrames)
+		SaveIndex(m_pStorage, &m_Header, FileSize, m_pKeyFrames, m_NumKeyFrames, m_FirstTick, m_LastTickMarker);
+	m_NumKeyFrames = 0;
+
 	io_close(m_File);
 	m_File = 0;
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording");
@@ -350,9 +537,26 @@ CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
 {
 	m_File = 0;
 	m_pKeyFrames = 0;
+	for(int i = 0; i < NUM_SEEK_POINTS; i++)
+	{
+		m_aSeekPoints[i].m_pSnapshot = 0;
+		m_aSeekPoints[i].m_Capacity = 0;
+	}
+	ClearSeekPoints(false);
+	m_pTickBuffers = 0;
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_FixedStep = 0;
+}
+
+CDemoPlayer::~CDemoPlayer()
+{
+	if(m_File)
+		io_close(m_File);
+	mem_free(m_pKeyFrames);
+	ClearSeekPoints(true);
+	mem_free(m_pTickBuffers);
 }
 
 void CDemoPlayer::SetListner(IListner *pListner)
@@ -482,11 +686,105 @@ void CDemoPlayer::ScanFile()
 	io_seek(m_File, StartPos, IOSEEK_START);
 }
 
+bool CDemoPlayer::LoadIndex(unsigned FileSize)
+{
+	char aFilename[128];
+	IndexFilename(&m_Info.m_Header, FileSize, aFilename, sizeof(aFilename));
+	IOHANDLE File = m_pStorage->OpenFile(aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	unsigned char aHeader[24];
+	bool Valid = io_read(File, aHeader, sizeof(aHeader)) == sizeof(aHeader) && mem_comp(aHeader, gs_aIndexMarker, sizeof(gs_aIndexMarker)) == 0 &&
+		ReadIndexInt(aHeader+4) == gs_IndexVersion && (unsigned)ReadIndexInt(aHeader+8) == FileSize;
+	int Num = Valid ? ReadIndexInt(aHeader+12) : 0;
+	unsigned char *pData = 0;
+	if(Num <= 0 || (unsigned)Num > FileSize/5)
+		Valid = false;
+	else
+	{
+		pData = (unsigned char *)mem_alloc(Num*8, 1);
+		Valid = io_read(File, pData, Num*8) == (unsigned)Num*8;
+	}
+	io_close(File);
+
+	// the keyframes have to be in order and within the chunks
+	CKeyFrame *pKeyFrames = 0;
+	if(Valid)
+	{
+		long StartPos = io_tell(m_File);
+		pKeyFrames = (CKeyFrame *)mem_alloc(Num*sizeof(CKeyFrame), 1);
+		for(int i = 0; i < Num && Valid; i++)
+		{
+			pKeyFrames[i].m_Filepos = ReadIndexInt(pData+i*8);
+			pKeyFrames[i].m_Tick = ReadIndexInt(pData+i*8+4);
+			if(pKeyFrames[i].m_Filepos < StartPos || pKeyFrames[i].m_Filepos >= (long)FileSize ||
+				(i > 0 && (pKeyFrames[i].m_Filepos <= pKeyFrames[i-1].m_Filepos || pKeyFrames[i].m_Tick < pKeyFrames[i-1].m_Tick)))
+				Valid = false;
+		}
+	}
+	mem_free(pData);
+
+	if(!Valid)
+	{
+		mem_free(pKeyFrames);
+		return false;
+	}
+
+	m_pKeyFrames = pKeyFrames;
+	m_Info.m_SeekablePoints = Num;
+	m_Info.m_Info.m_FirstTick = ReadIndexInt(aHeader+16);
+	m_Info.m_Info.m_LastTick = ReadIndexInt(aHeader+20);
+	return true;
+}
+
+void CDemoPlayer::AddSeekPoint()
+{
+	int Tick = m_Info.m_Info.m_CurrentTick;
+	if(m_LastSnapshotDataSize <= 0 || m_Info.m_PreviousTick == -1)
+		return;
+
+	// one per second of demo is enough
+	for(int i = 0; i < NUM_SEEK_POINTS; i++)
+		if(m_aSeekPoints[i].m_SnapshotSize > 0 && absolute(m_aSeekPoints[i].m_CurrentTick-Tick) < SERVER_TICK_SPEED)
+			return;
+
+	CSeekPoint *pPoint = &m_aSeekPoints[m_NextSeekPoint];
+	m_NextSeekPoint = (m_NextSeekPoint+1)%NUM_SEEK_POINTS;
+	if(pPoint->m_Capacity < m_LastSnapshotDataSize)
+	{
+		mem_free(pPoint->m_pSnapshot);
+		pPoint->m_pSnapshot = (unsigned char *)mem_alloc(m_LastSnapshotDataSize, 1);
+		pPoint->m_Capacity = m_LastSnapshotDataSize;
+	}
+	pPoint->m_Filepos = io_tell(m_File);
+	pPoint->m_PreviousTick = m_Info.m_PreviousTick;
+	pPoint->m_CurrentTick = Tick;
+	pPoint->m_NextTick = m_Info.m_NextTick;
+	pPoint->m_SnapshotSize = m_LastSnapshotDataSize;
+	mem_copy(pPoint->m_pSnapshot, m_aLastSnapshotData, m_LastSnapshotDataSize);
+}
+
+void CDemoPlayer::ClearSeekPoints(bool Free)
+{
+	for(int i = 0; i < NUM_SEEK_POINTS; i++)
+	{
+		if(Free)
+		{
+			mem_free(m_aSeekPoints[i].m_pSnapshot);
+			m_aSeekPoints[i].m_pSnapshot = 0;
+			m_aSeekPoints[i].m_Capacity = 0;
+		}
+		m_aSeekPoints[i].m_SnapshotSize = 0;
+	}
+	m_NextSeekPoint = 0;
+}
+
 void CDemoPlayer::DoTick()
 {
-	static char aCompresseddata[CSnapshot::MAX_SIZE];
-	static char aDecompressed[CSnapshot::MAX_SIZE];
-	static char aData[CSnapshot::MAX_SIZE];
+	char *pCompressed = m_pTickBuffers->m_aCompressed;
+	char *pDecompressed = m_pTickBuffers->m_aDecompressed;
+	char *pData = m_pTickBuffers->m_aData;
 	int ChunkType, ChunkTick, ChunkSize;
 	int DataSize = 0;
 	int GotSnapshot = 0;
@@ -515,7 +813,7 @@ void CDemoPlayer::DoTick()
 		// read the chunk
 		if(ChunkSize)
 		{
-			if(io_read(m_File, aCompresseddata, ChunkSize) != (unsigned)ChunkSize)
+			if(io_read(m_File, pCompressed, ChunkSize) != (unsigned)ChunkSize)
 			{
 				// stop on error or eof
 				m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_player", "error reading chunk");
@@ -523,7 +821,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CNetBase::Decompress(aCompresseddata, ChunkSize, aDecompressed, sizeof(aDecompressed));
+			DataSize = CNetBase::Decompress(pCompressed, ChunkSize, pDecompressed, sizeof(m_pTickBuffers->m_aDecompressed));
 			if(DataSize < 0)
 			{
 				// stop on error or eof
@@ -532,7 +830,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CVariableInt::Decompress(aDecompressed, DataSize, aData);
+			DataSize = CVariableInt::Decompress(pDecompressed, DataSize, pData);
 
 			if(DataSize < 0)
 			{
@@ -545,19 +843,19 @@ void CDemoPlayer::DoTick()
 		if(ChunkType == CHUNKTYPE_DELTA)
 		{
 			// process delta snapshot
-			static char aNewsnap[CSnapshot::MAX_SIZE];
+			char *pNewSnap = m_pTickBuffers->m_aNewSnap;
 
 			GotSnapshot = 1;
 
-			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)aNewsnap, aData, DataSize);
+			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)pNewSnap, pData, DataSize);
 
 			if(DataSize >= 0)
 			{
 				if(m_pListner)
-					m_pListner->OnDemoPlayerSnapshot(aNewsnap, DataSize);
+					m_pListner->OnDemoPlayerSnapshot(pNewSnap, DataSize);
 
 				m_LastSnapshotDataSize = DataSize;
-				mem_copy(m_aLastSnapshotData, aNewsnap, DataSize);
+				mem_copy(m_aLastSnapshotData, pNewSnap, DataSize);
 			}
 			else
 			{
@@ -572,9 +870,9 @@ void CDemoPlayer::DoTick()
 			GotSnapshot = 1;
 
 			m_LastSnapshotDataSize = DataSize;
-			mem_copy(m_aLastSnapshotData, aData, DataSize);
+			mem_copy(m_aLastSnapshotData, pData, DataSize);
 			if(m_pListner)
-				m_pListner->OnDemoPlayerSnapshot(aData, DataSize);
+				m_pListner->OnDemoPlayerSnapshot(pData, DataSize);
 		}
 		else
 		{
@@ -589,12 +887,13 @@ void CDemoPlayer::DoTick()
 			if(ChunkType&CHUNKTYPEFLAG_TICKMARKER)
 			{
 				m_Info.m_NextTick = ChunkTick;
+				AddSeekPoint();
 				break;
 			}
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
 			{
 				if(m_pListner)
-					m_pListner->OnDemoPlayerMessage(aData, DataSize);
+					m_pListner->OnDemoPlayerMessage(pData, DataSize);
 			}
 		}
 	}
@@ -618,6 +917,7 @@ void CDemoPlayer::Unpause()
 int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType)
 {
 	m_pConsole = pConsole;
+	m_pStorage = pStorage;
 	m_File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
 	if(!m_File)
 	{
@@ -630,6 +930,9 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 	// store the filename
 	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
 
+	if(!m_pTickBuffers)
+		m_pTickBuffers = (CTickBuffers *)mem_alloc(sizeof(CTickBuffers), 1);
+
 	// clear the playback info
 	mem_zero(&m_Info, sizeof(m_Info));
 	m_Info.m_Info.m_FirstTick = -1;
@@ -640,6 +943,7 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 	m_Info.m_Info.m_Speed = 1;
 
 	m_LastSnapshotDataSize = -1;
+	ClearSeekPoints(false);
 
 	// read the header
 	io_read(m_File, &m_Info.m_Header, sizeof(m_Info.m_Header));
@@ -696,8 +1000,11 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 
 		// save map
 		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
-		io_write(MapFile, pMapData, MapSize);
-		io_close(MapFile);
+		if(MapFile)
+		{
+			io_write(MapFile, pMapData, MapSize);
+			io_close(MapFile);
+		}
 
 		// free data
 		mem_free(pMapData);
@@ -723,8 +1030,23 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 		}
 	}
 
-	// scan the file for interessting points
-	ScanFile();
+	// use the keyframe index, or scan the file for interessting points
+	int64 StartTime = time_get();
+	long ChunksPos = io_tell(m_File);
+	io_seek(m_File, 0, IOSEEK_END);
+	unsigned FileSize = io_tell(m_File);
+	io_seek(m_File, ChunksPos, IOSEEK_START);
+	bool Indexed = LoadIndex(FileSize);
+	if(!Indexed)
+	{
+		ScanFile();
+		if(m_Info.m_SeekablePoints)
+			SaveIndex(pStorage, &m_Info.m_Header, FileSize, m_pKeyFrames, m_Info.m_SeekablePoints, m_Info.m_Info.m_FirstTick, m_Info.m_Info.m_LastTick);
+	}
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%d keyframes %s in %.2fms", m_Info.m_SeekablePoints, Indexed ? "from the index" : "scanned",
+		(time_get()-StartTime)*1000.0/time_freq());
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_player", aBuf);
 
 	// reset slice markers
 	g_Config.m_ClDemoSliceBegin = -1;
@@ -777,13 +1099,35 @@ int CDemoPlayer::SetPos(float Percent)
 	while(Keyframe && m_pKeyFrames[Keyframe].m_Tick > WantedTick)
 		Keyframe--;
 
-	// seek to the correct keyframe
-	io_seek(m_File, m_pKeyFrames[Keyframe].m_Filepos, IOSEEK_START);
+	// resume from a decoded state between the keyframe and the wanted tick
+	const CSeekPoint *pSeekPoint = 0;
+	for(int i = 0; i < NUM_SEEK_POINTS; i++)
+	{
+		const CSeekPoint *pPoint = &m_aSeekPoints[i];
+		if(pPoint->m_SnapshotSize > 0 && pPoint->m_CurrentTick < WantedTick && pPoint->m_CurrentTick >= m_pKeyFrames[Keyframe].m_Tick &&
+			(!pSeekPoint || pPoint->m_CurrentTick > pSeekPoint->m_CurrentTick))
+			pSeekPoint = pPoint;
+	}
 
-	//m_Info.start_tick = -1;
-	m_Info.m_NextTick = -1;
-	m_Info.m_Info.m_CurrentTick = -1;
-	m_Info.m_PreviousTick = -1;
+	if(pSeekPoint)
+	{
+		io_seek(m_File, pSeekPoint->m_Filepos, IOSEEK_START);
+		m_Info.m_NextTick = pSeekPoint->m_NextTick;
+		m_Info.m_Info.m_CurrentTick = pSeekPoint->m_CurrentTick;
+		m_Info.m_PreviousTick = pSeekPoint->m_PreviousTick;
+		m_LastSnapshotDataSize = pSeekPoint->m_SnapshotSize;
+		mem_copy(m_aLastSnapshotData, pSeekPoint->m_pSnapshot, pSeekPoint->m_SnapshotSize);
+	}
+	else
+	{
+		// seek to the correct keyframe
+		io_seek(m_File, m_pKeyFrames[Keyframe].m_Filepos, IOSEEK_START);
+
+		//m_Info.start_tick = -1;
+		m_Info.m_NextTick = -1;
+		m_Info.m_Info.m_CurrentTick = -1;
+		m_Info.m_PreviousTick = -1;
+	}
 
 	// playback everything until we hit our tick
 	while(m_Info.m_PreviousTick < WantedTick && IsPlaying())
@@ -802,7 +1146,7 @@ void CDemoPlayer::SetSpeed(float Speed)
 int CDemoPlayer::Update(bool RealTime)
 {
 	int64 Now = time_get();
-	int64 Deltatime = Now-m_Info.m_LastUpdate;
+	int64 Deltatime = m_FixedStep ? m_FixedStep : Now-m_Info.m_LastUpdate;
 	m_Info.m_LastUpdate = Now;
 
 	if(!IsPlaying())
@@ -863,6 +1207,7 @@ int CDemoPlayer::Stop()
 	m_File = 0;
 	mem_free(m_pKeyFrames);
 	m_pKeyFrames = 0;
+	ClearSeekPoints(true);
 	str_copy(m_aFilename, "", sizeof(m_aFilename));
 	return 0;
 }
@@ -906,6 +1251,25 @@ bool CDemoPlayer::GetDemoInfo(class IStorage *pStorage, const char *pFilename, i
 	return true;
 }
 
+void CDemoPlayer::RemoveIndex(class IStorage *pStorage, const char *pFilename, int StorageType) const
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	if(!File)
+		return;
+
+	CDemoHeader Header;
+	bool Valid = io_read(File, &Header, sizeof(Header)) == sizeof(Header) && mem_comp(Header.m_aMarker, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) == 0;
+	io_seek(File, 0, IOSEEK_END);
+	unsigned FileSize = io_tell(File);
+	io_close(File);
+	if(!Valid)
+		return;
+
+	char aFilename[128];
+	IndexFilename(&Header, FileSize, aFilename, sizeof(aFilename));
+	pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+}
+
 int CDemoPlayer::GetDemoType() const
 {
 	if(m_File)
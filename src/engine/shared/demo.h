@@ -8,10 +8,19 @@
 
 #include "snapshot.h"
 
+// where the tick marker of a keyframe starts in the file
+struct CDemoKeyFrame
+{
+	long m_Filepos;
+	int m_Tick;
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
+	class IStorage *m_pStorage;
 	IOHANDLE m_File;
+	CDemoHeader m_Header;
 	int m_LastTickMarker;
 	int m_LastKeyFrame;
 	int m_FirstTick;
@@ -23,13 +32,28 @@ class CDemoRecorder : public IDemoRecorder
 	unsigned int m_MapSize;
 	unsigned char *m_pMapData;
 
+	// written to democache/ on stop
+	bool m_Index;
+	CDemoKeyFrame *m_pKeyFrames;
+	int m_NumKeyFrames;
+	int m_KeyFramesCapacity;
+
 	void WriteTickMarker(int Tick, int Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void Reset();
+
+	// owns the keyframes, not copyable
+	CDemoRecorder(const CDemoRecorder &Other);
+	CDemoRecorder &operator=(const CDemoRecorder &Other);
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData = false);
-	CDemoRecorder() {}
+	CDemoRecorder();
+	~CDemoRecorder();
+
+	// recordings that are never played where they are made can skip the index
+	void Init(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData, bool Index = true);
 
-	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, const char *pType, unsigned int MapSize = 0, unsigned char *pMapData = 0);
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, const char *pType, unsigned int MapSize = 0, unsigned char *pMapData = 0, const char *pMapPath = 0);
 	int Stop(bool Finalize = false);
 	void AddDemoMarker();
 
@@ -83,11 +107,7 @@ private:
 
 
 	// Playback
-	struct CKeyFrame
-	{
-		long m_Filepos;
-		int m_Tick;
-	};
+	typedef CDemoKeyFrame CKeyFrame;
 
 	struct CKeyFrameSearch
 	{
@@ -95,26 +115,62 @@ private:
 		CKeyFrameSearch *m_pNext;
 	};
 
+	// decoded states around the playback position, so seeking back
+	// doesn't have to replay everything from the last keyframe
+	enum
+	{
+		NUM_SEEK_POINTS=8,
+	};
+
+	struct CSeekPoint
+	{
+		long m_Filepos;
+		int m_PreviousTick;
+		int m_CurrentTick;
+		int m_NextTick;
+		int m_SnapshotSize;
+		int m_Capacity;
+		unsigned char *m_pSnapshot;
+	};
+
 	class IConsole *m_pConsole;
+	class IStorage *m_pStorage;
 	IOHANDLE m_File;
 	char m_aFilename[256];
 	CKeyFrame *m_pKeyFrames;
+	CSeekPoint m_aSeekPoints[NUM_SEEK_POINTS];
+	int m_NextSeekPoint;
 	CMapInfo m_MapInfo;
 
 	CPlaybackInfo m_Info;
 	int m_DemoType;
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	int m_LastSnapshotDataSize;
+
+	// scratch space for DoTick, allocated on the first load
+	struct CTickBuffers
+	{
+		char m_aCompressed[CSnapshot::MAX_SIZE];
+		char m_aDecompressed[CSnapshot::MAX_SIZE];
+		char m_aData[CSnapshot::MAX_SIZE];
+		char m_aNewSnap[CSnapshot::MAX_SIZE];
+	};
+	CTickBuffers *m_pTickBuffers;
 	class CSnapshotDelta *m_pSnapshotDelta;
+	int64 m_FixedStep;
 
 	int ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
 	void ScanFile();
+	bool LoadIndex(unsigned FileSize);
+	void AddSeekPoint();
+	void ClearSeekPoints(bool Free);
 	int NextFrame();
 
 public:
 
 	CDemoPlayer(class CSnapshotDelta *m_pSnapshotDelta);
+	~CDemoPlayer();
 
 	void SetListner(IListner *pListner);
 
@@ -124,10 +180,12 @@ public:
 	void Unpause();
 	int Stop();
 	void SetSpeed(float Speed);
+	void SetFixedStep(int64 Step) { m_FixedStep = Step; } // advance by this much per update instead of the real time
 	int SetPos(float Percent);
 	const CInfo *BaseInfo() const { return &m_Info.m_Info; }
 	void GetDemoName(char *pBuffer, int BufferSize) const;
 	bool GetDemoInfo(class IStorage *pStorage, const char *pFilename, int StorageType, CDemoHeader *pDemoHeader) const;
+	void RemoveIndex(class IStorage *pStorage, const char *pFilename, int StorageType) const;
 	const char *GetDemoFileName() { return m_aFilename; };
 	int GetDemoType() const;
 
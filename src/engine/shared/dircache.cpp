@@ -0,0 +1,273 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include "dircache.h"
+
+CDirCache::CDirCache()
+{
+	m_NumListings = 0;
+	m_NumReadOnlyRoots = 0;
+	m_TotalSize = 0;
+	m_UseCounter = 0;
+	m_NumHits = 0;
+	m_NumMisses = 0;
+	m_Lock = lock_create();
+}
+
+CDirCache::~CDirCache()
+{
+	Invalidate(0);
+	lock_destroy(m_Lock);
+}
+
+void CDirCache::Normalize(const char *pPath, char *pDir, int DirSize)
+{
+	str_copy(pDir, pPath, DirSize);
+	int Length = str_length(pDir);
+	while(Length > 1 && (pDir[Length-1] == '/' || pDir[Length-1] == '\\'))
+		pDir[--Length] = 0;
+}
+
+int CDirCache::Find(const char *pDir) const
+{
+	for(int i = 0; i < m_NumListings; i++)
+		if(str_comp(m_apListings[i]->m_aDir, pDir) == 0)
+			return i;
+	return -1;
+}
+
+void CDirCache::AddReadOnlyRoot(const char *pRoot)
+{
+	if(m_NumReadOnlyRoots < MAX_READONLY_ROOTS)
+		Normalize(pRoot, m_aaReadOnlyRoots[m_NumReadOnlyRoots++], MAX_DIR_LENGTH);
+}
+
+bool CDirCache::IsReadOnly(const char *pDir) const
+{
+	for(int i = 0; i < m_NumReadOnlyRoots; i++)
+	{
+		int Length = str_length(m_aaReadOnlyRoots[i]);
+		if(str_comp_num(pDir, m_aaReadOnlyRoots[i], Length) == 0 && (pDir[Length] == 0 || pDir[Length] == '/' || pDir[Length] == '\\'))
+			return true;
+	}
+	return false;
+}
+
+void CDirCache::Release(CListing *pListing)
+{
+	lock_wait(m_Lock);
+	bool Free = --pListing->m_Refs == 0;
+	lock_unlock(m_Lock);
+	if(Free)
+		mem_free(pListing);
+}
+
+// called with the lock held, the listing is freed once nobody walks it anymore
+void CDirCache::Remove(int Index)
+{
+	CListing *pListing = m_apListings[Index];
+	m_TotalSize -= pListing->m_Size;
+	m_apListings[Index] = m_apListings[--m_NumListings];
+	if(--pListing->m_Refs == 0)
+		mem_free(pListing);
+}
+
+void CDirCache::Store(CListing *pListing)
+{
+	if(pListing->m_Size > CACHE_SIZE/2)
+		return;
+
+	lock_wait(m_Lock);
+	int Index = Find(pListing->m_aDir);
+	if(Index != -1)
+		Remove(Index);
+	while(m_NumListings && (m_NumListings >= MAX_LISTINGS || m_TotalSize+pListing->m_Size > CACHE_SIZE))
+	{
+		int Oldest = 0;
+		for(int i = 1; i < m_NumListings; i++)
+			if(m_apListings[i]->m_LastUse < m_apListings[Oldest]->m_LastUse)
+				Oldest = i;
+		Remove(Oldest);
+	}
+	pListing->m_Refs++;
+	pListing->m_LastUse = ++m_UseCounter;
+	m_apListings[m_NumListings++] = pListing;
+	m_TotalSize += pListing->m_Size;
+	lock_unlock(m_Lock);
+}
+
+template<typename T>
+static void Grow(T **ppData, int *pMax, int Needed, int ElementSize)
+{
+	if(Needed <= *pMax)
+		return;
+	int NewMax = max(Needed, max(*pMax*2, 64));
+	T *pNew = (T *)mem_alloc(NewMax*ElementSize, 1);
+	if(*ppData)
+		mem_copy(pNew, *ppData, *pMax*ElementSize);
+	mem_free(*ppData);
+	*ppData = pNew;
+	*pMax = NewMax;
+}
+
+CDirCache::CListing *CDirCache::Read(const char *pDir, time_t Mtime, bool Dates)
+{
+	// collect the entries first, then pack everything into one block
+	struct CCollect
+	{
+		CEntry *m_pEntries;
+		int m_NumEntries;
+		int m_MaxEntries;
+		char *m_pNames;
+		int m_NamesSize;
+		int m_MaxNamesSize;
+
+		void Add(const char *pName, time_t Date, int IsDir)
+		{
+			int Length = str_length(pName)+1;
+			Grow(&m_pEntries, &m_MaxEntries, m_NumEntries+1, sizeof(CEntry));
+			Grow(&m_pNames, &m_MaxNamesSize, m_NamesSize+Length, 1);
+			CEntry *pEntry = &m_pEntries[m_NumEntries++];
+			pEntry->m_Date = Date;
+			pEntry->m_IsDir = IsDir;
+			pEntry->m_Name = m_NamesSize;
+			mem_copy(m_pNames+m_NamesSize, pName, Length);
+			m_NamesSize += Length;
+		}
+
+		static int Callback(const char *pName, int IsDir, int Type, void *pUser)
+		{
+			((CCollect *)pUser)->Add(pName, 0, IsDir);
+			return 0;
+		}
+
+		static int InfoCallback(const char *pName, time_t Date, int IsDir, int Type, void *pUser)
+		{
+			((CCollect *)pUser)->Add(pName, Date, IsDir);
+			return 0;
+		}
+	};
+
+	// the dates cost another stat per entry, only get them when asked for
+	CCollect Collect;
+	mem_zero(&Collect, sizeof(Collect));
+	if(Dates)
+		fs_listdir_info(pDir, CCollect::InfoCallback, 0, &Collect);
+	else
+		fs_listdir(pDir, CCollect::Callback, 0, &Collect);
+
+	int Size = sizeof(CListing)+Collect.m_NumEntries*sizeof(CEntry)+Collect.m_NamesSize;
+	CListing *pListing = (CListing *)mem_alloc(Size, sizeof(time_t));
+	Normalize(pDir, pListing->m_aDir, sizeof(pListing->m_aDir));
+	pListing->m_Mtime = Mtime;
+	pListing->m_LastUse = 0;
+	pListing->m_Refs = 1;
+	pListing->m_Size = Size;
+	pListing->m_HasDates = Dates;
+	pListing->m_NumEntries = Collect.m_NumEntries;
+	pListing->m_pEntries = (CEntry *)(pListing+1);
+	pListing->m_pNames = (char *)(pListing->m_pEntries+Collect.m_NumEntries);
+	if(Collect.m_NumEntries)
+	{
+		mem_copy(pListing->m_pEntries, Collect.m_pEntries, Collect.m_NumEntries*sizeof(CEntry));
+		mem_copy(pListing->m_pNames, Collect.m_pNames, Collect.m_NamesSize);
+	}
+	mem_free(Collect.m_pEntries);
+	mem_free(Collect.m_pNames);
+	return pListing;
+}
+
+void CDirCache::List(const char *pDir, int Type, FS_LISTDIR_CALLBACK pfnCallback, FS_LISTDIR_INFO_CALLBACK pfnInfoCallback, void *pUser)
+{
+	char aDir[MAX_DIR_LENGTH];
+	Normalize(pDir, aDir, sizeof(aDir));
+
+	// read-only media may not report a modification time at all (iso9660),
+	// there is nothing to check for them and the stat is saved
+	bool ReadOnly = IsReadOnly(aDir);
+	time_t Mtime = 0;
+	if(!ReadOnly)
+	{
+		// without a modification time there is nothing to check the listing against
+		Mtime = fs_getmtime(pDir);
+		if(!Mtime)
+		{
+			if(pfnCallback)
+				fs_listdir(pDir, pfnCallback, Type, pUser);
+			else
+				fs_listdir_info(pDir, pfnInfoCallback, Type, pUser);
+			return;
+		}
+	}
+
+	CListing *pListing = 0;
+	lock_wait(m_Lock);
+	int Index = Find(aDir);
+	if(Index != -1 && (ReadOnly || m_apListings[Index]->m_Mtime == Mtime) && (pfnCallback || m_apListings[Index]->m_HasDates))
+	{
+		pListing = m_apListings[Index];
+		pListing->m_Refs++;
+		pListing->m_LastUse = ++m_UseCounter;
+		m_NumHits++;
+	}
+	else
+		m_NumMisses++;
+	lock_unlock(m_Lock);
+
+	if(!pListing)
+	{
+		pListing = Read(pDir, Mtime, pfnInfoCallback != 0);
+		// directories changed within the last seconds could change again
+		// without their modification time moving, don't keep those. a time
+		// after the clock, like with an unset rtc, moves on the next change
+		int Now = time_timestamp();
+		if(ReadOnly || Mtime < Now-1 || Mtime > Now)
+			Store(pListing);
+	}
+
+	// the callbacks may list other directories, the lock isn't held here
+	for(int i = 0; i < pListing->m_NumEntries; i++)
+	{
+		const CEntry *pEntry = &pListing->m_pEntries[i];
+		const char *pName = pListing->m_pNames+pEntry->m_Name;
+		if(pfnCallback ? pfnCallback(pName, pEntry->m_IsDir, Type, pUser) : pfnInfoCallback(pName, pEntry->m_Date, pEntry->m_IsDir, Type, pUser))
+			break;
+	}
+	Release(pListing);
+}
+
+void CDirCache::Invalidate(const char *pDir)
+{
+	lock_wait(m_Lock);
+	if(!pDir)
+	{
+		while(m_NumListings)
+			Remove(m_NumListings-1);
+	}
+	else
+	{
+		char aDir[MAX_DIR_LENGTH];
+		Normalize(pDir, aDir, sizeof(aDir));
+		int Index = Find(aDir);
+		if(Index != -1)
+			Remove(Index);
+	}
+	lock_unlock(m_Lock);
+}
+
+void CDirCache::InvalidateParent(const char *pPath)
+{
+	char aDir[MAX_DIR_LENGTH];
+	Normalize(pPath, aDir, sizeof(aDir));
+	int Slash = -1;
+	for(int i = 0; aDir[i]; i++)
+		if(aDir[i] == '/' || aDir[i] == '\\')
+			Slash = i;
+	if(Slash == -1)
+		aDir[0] = 0;
+	else
+		aDir[max(Slash, 1)] = 0;
+	Invalidate(aDir);
+}
@@ -0,0 +1,83 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_DIRCACHE_H
+#define ENGINE_SHARED_DIRCACHE_H
+
+#include <base/system.h>
+
+// directory listings by path. a listing is reused as long as the
+// modification time of the directory stays the same, writes through the
+// storage drop the listing of the directory they touch. listings below a
+// read-only root are reused without looking at the modification time.
+class CDirCache
+{
+	enum
+	{
+		MAX_LISTINGS=32,
+		MAX_READONLY_ROOTS=4,
+		MAX_DIR_LENGTH=512,
+		CACHE_SIZE=1024*1024,
+	};
+
+	struct CEntry
+	{
+		time_t m_Date;
+		int m_IsDir;
+		int m_Name;
+	};
+
+	struct CListing
+	{
+		char m_aDir[MAX_DIR_LENGTH];
+		time_t m_Mtime;
+		int m_LastUse;
+		int m_Refs; // the cache holds one while the listing is in it
+		int m_Size;
+		bool m_HasDates; // only listed with dates for ListDirInfo
+		int m_NumEntries;
+		CEntry *m_pEntries;
+		char *m_pNames;
+	};
+
+	CListing *m_apListings[MAX_LISTINGS];
+	int m_NumListings;
+	char m_aaReadOnlyRoots[MAX_READONLY_ROOTS][MAX_DIR_LENGTH];
+	int m_NumReadOnlyRoots;
+	int m_TotalSize;
+	int m_UseCounter;
+	LOCK m_Lock;
+
+	int m_NumHits;
+	int m_NumMisses;
+
+	int Find(const char *pDir) const;
+	bool IsReadOnly(const char *pDir) const;
+	void Remove(int Index);
+	void Release(CListing *pListing);
+	void Store(CListing *pListing);
+	static CListing *Read(const char *pDir, time_t Mtime, bool Dates);
+	static void Normalize(const char *pPath, char *pDir, int DirSize);
+
+	void List(const char *pDir, int Type, FS_LISTDIR_CALLBACK pfnCallback, FS_LISTDIR_INFO_CALLBACK pfnInfoCallback, void *pUser);
+
+public:
+	CDirCache();
+	~CDirCache();
+
+	// same as fs_listdir and fs_listdir_info
+	void ListDir(const char *pDir, FS_LISTDIR_CALLBACK pfnCallback, int Type, void *pUser) { List(pDir, Type, pfnCallback, 0, pUser); }
+	void ListDirInfo(const char *pDir, FS_LISTDIR_INFO_CALLBACK pfnCallback, int Type, void *pUser) { List(pDir, Type, 0, pfnCallback, pUser); }
+
+	// the contents below pRoot can't change while the game runs, like the disc
+	void AddReadOnlyRoot(const char *pRoot);
+
+	// drops the listing of a directory, all of them for 0
+	void Invalidate(const char *pDir);
+	// drops the listing of the directory the file or folder is in
+	void InvalidateParent(const char *pPath);
+
+	int NumHits() const { return m_NumHits; }
+	int NumMisses() const { return m_NumMisses; }
+};
+
+#endif
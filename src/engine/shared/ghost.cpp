@@ -0,0 +1,230 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include <zlib.h>
+
+#include "compression.h"
+#include "ghost.h"
+#include "network.h"
+
+static const unsigned char gs_aHeaderMarker[8] = {'T', 'W', 'G', 'H', 'O', 'S', 'T', 0};
+
+enum
+{
+	NUM_FIELDS=sizeof(CGhostCharacter)/sizeof(int),
+};
+
+static void WriteInt(unsigned char *pBuf, int Value)
+{
+	pBuf[0] = (Value>>24)&0xff;
+	pBuf[1] = (Value>>16)&0xff;
+	pBuf[2] = (Value>>8)&0xff;
+	pBuf[3] = (Value)&0xff;
+}
+
+static int ReadInt(const unsigned char *pBuf)
+{
+	return (pBuf[0]<<24) | (pBuf[1]<<16) | (pBuf[2]<<8) | pBuf[3];
+}
+
+CGhostReader::CGhostReader()
+{
+	m_File = 0;
+	m_pBlocks = 0;
+	m_NumBlocks = 0;
+	m_NumSamples = 0;
+	m_CachedBlock = -1;
+	m_PrevIndex = -1;
+	mem_zero(&m_Header, sizeof(m_Header));
+}
+
+CGhostReader::~CGhostReader()
+{
+	Close();
+}
+
+bool CGhostReader::ReadHeader(IOHANDLE File, CGhostHeader *pHeader)
+{
+	if(io_read(File, pHeader, sizeof(*pHeader)) != sizeof(*pHeader))
+		return false;
+	if(mem_comp(pHeader->m_aMarker, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) != 0)
+		return false;
+	return pHeader->m_Version == VERSION_RAW || pHeader->m_Version == VERSION_DELTA;
+}
+
+bool CGhostReader::Open(IOHANDLE File, void *pInfo, int InfoSize)
+{
+	Close();
+	if(!ReadHeader(File, &m_Header) || m_Header.m_NumShots < 0 || io_read(File, pInfo, InfoSize) != (unsigned)InfoSize)
+	{
+		io_close(File);
+		return false;
+	}
+	m_File = File;
+
+	// find the blocks, they are read when a sample in them is needed
+	int NumBlocks = (m_Header.m_NumShots+BLOCK_SAMPLES-1)/BLOCK_SAMPLES;
+	int HeaderSize = m_Header.m_Version == VERSION_DELTA ? 8 : 4;
+	m_pBlocks = (CBlock *)mem_alloc(max(NumBlocks, 1)*sizeof(CBlock), 1);
+	for(m_NumBlocks = 0; m_NumBlocks < NumBlocks; m_NumBlocks++)
+	{
+		unsigned char aSize[8];
+		if(io_read(File, aSize, HeaderSize) != (unsigned)HeaderSize)
+			break;
+		CBlock *pBlock = &m_pBlocks[m_NumBlocks];
+		pBlock->m_Size = ReadInt(aSize);
+		pBlock->m_PackedSize = m_Header.m_Version == VERSION_DELTA ? ReadInt(aSize+4) : 0;
+		pBlock->m_Filepos = io_tell(File);
+		if(pBlock->m_Size <= 0 || pBlock->m_Size > MAX_BLOCK_SIZE || pBlock->m_PackedSize < 0 || pBlock->m_PackedSize > MAX_BLOCK_SIZE)
+			break;
+		io_skip(File, pBlock->m_Size);
+	}
+
+	m_NumSamples = min(m_Header.m_NumShots, m_NumBlocks*(int)BLOCK_SAMPLES);
+	m_CachedBlock = -1;
+	m_PrevIndex = -1;
+	return true;
+}
+
+void CGhostReader::Close()
+{
+	if(m_File)
+		io_close(m_File);
+	m_File = 0;
+	mem_free(m_pBlocks);
+	m_pBlocks = 0;
+	m_NumBlocks = 0;
+	m_NumSamples = 0;
+}
+
+bool CGhostReader::LoadBlock(int Index)
+{
+	// the buffers are only needed while unpacking, ghosts stay loaded for
+	// as long as the map
+	const CBlock *pBlock = &m_pBlocks[Index];
+	unsigned char *pCompressed = (unsigned char *)mem_alloc(pBlock->m_Size+MAX_BLOCK_SIZE, 1);
+	unsigned char *pPacked = pCompressed+pBlock->m_Size;
+
+	io_seek(m_File, pBlock->m_Filepos, IOSEEK_START);
+	bool Result = io_read(m_File, pCompressed, pBlock->m_Size) == (unsigned)pBlock->m_Size;
+	if(Result)
+	{
+		// both versions pack the fields as varints, version 3 as deltas
+		int PackedSize;
+		if(m_Header.m_Version == VERSION_DELTA)
+		{
+			uLongf Size = MAX_BLOCK_SIZE;
+			Result = uncompress(pPacked, &Size, pCompressed, pBlock->m_Size) == Z_OK && (int)Size == pBlock->m_PackedSize;
+			PackedSize = Size;
+		}
+		else
+		{
+			PackedSize = CNetBase::Decompress(pCompressed, pBlock->m_Size, pPacked, MAX_BLOCK_SIZE);
+			Result = PackedSize >= 0;
+		}
+		Result = Result && UnpackBlock(pPacked, PackedSize, Index);
+	}
+	mem_free(pCompressed);
+	return Result;
+}
+
+bool CGhostReader::UnpackBlock(const unsigned char *pPacked, int PackedSize, int Index)
+{
+	int Num = min((int)BLOCK_SAMPLES, m_NumSamples-Index*BLOCK_SAMPLES);
+	bool Delta = m_Header.m_Version == VERSION_DELTA;
+
+	const unsigned char *pSrc = pPacked;
+	const unsigned char *pEnd = pPacked+PackedSize;
+	int aValues[NUM_FIELDS] = {0};
+	for(int i = 0; i < Num; i++)
+	{
+		int *pSample = (int *)&m_aSamples[i];
+		for(int f = 0; f < NUM_FIELDS; f++)
+		{
+			if(pSrc >= pEnd)
+				return false;
+			int Value;
+			pSrc = CVariableInt::Unpack(pSrc, &Value);
+			if(Delta)
+				Value = aValues[f] = (int)((unsigned)aValues[f]+(unsigned)Value);
+			pSample[f] = Value;
+		}
+	}
+	return true;
+}
+
+const CGhostCharacter *CGhostReader::Sample(int Index)
+{
+	if(Index < 0 || Index >= m_NumSamples)
+		return 0;
+
+	if(Index == m_PrevIndex)
+		return &m_PrevSample;
+
+	int Block = Index/BLOCK_SAMPLES;
+	if(Block != m_CachedBlock)
+	{
+		if(m_CachedBlock != -1 && Block == m_CachedBlock+1)
+		{
+			m_PrevIndex = Block*BLOCK_SAMPLES-1;
+			m_PrevSample = m_aSamples[BLOCK_SAMPLES-1];
+		}
+		else
+			m_PrevIndex = -1;
+
+		m_CachedBlock = -1;
+		if(!LoadBlock(Block))
+		{
+			dbg_msg("ghost", "failed to read block %d, %d of %d samples left", Block, Block*BLOCK_SAMPLES, m_NumSamples);
+			m_NumSamples = Block*BLOCK_SAMPLES;
+			return 0;
+		}
+		m_CachedBlock = Block;
+	}
+	return &m_aSamples[Index%BLOCK_SAMPLES];
+}
+
+bool CGhostWriter::Write(IOHANDLE File, CGhostHeader *pHeader, const void *pInfo, int InfoSize, const CGhostCharacter *pSamples, int Num)
+{
+	mem_copy(pHeader->m_aMarker, gs_aHeaderMarker, sizeof(pHeader->m_aMarker));
+	pHeader->m_Version = CGhostReader::VERSION_DELTA;
+	pHeader->m_NumShots = Num;
+	io_write(File, pHeader, sizeof(*pHeader));
+	io_write(File, pInfo, InfoSize);
+
+	unsigned char *pPacked = (unsigned char *)mem_alloc(CGhostReader::MAX_BLOCK_SIZE*2, 1);
+	unsigned char *pCompressed = pPacked+CGhostReader::MAX_BLOCK_SIZE;
+	bool Result = true;
+	for(int Start = 0; Start < Num && Result; Start += CGhostReader::BLOCK_SAMPLES)
+	{
+		int Count = min((int)CGhostReader::BLOCK_SAMPLES, Num-Start);
+		int aValues[NUM_FIELDS] = {0};
+		unsigned char *pDst = pPacked;
+		for(int i = 0; i < Count; i++)
+		{
+			const int *pSample = (const int *)&pSamples[Start+i];
+			for(int f = 0; f < NUM_FIELDS; f++)
+			{
+				pDst = CVariableInt::Pack(pDst, (int)((unsigned)pSample[f]-(unsigned)aValues[f]));
+				aValues[f] = pSample[f];
+			}
+		}
+
+		uLongf Size = CGhostReader::MAX_BLOCK_SIZE;
+		if(compress2(pCompressed, &Size, pPacked, pDst-pPacked, Z_BEST_COMPRESSION) != Z_OK)
+		{
+			Result = false;
+			break;
+		}
+
+		unsigned char aHeader[8];
+		WriteInt(aHeader, Size);
+		WriteInt(aHeader+4, pDst-pPacked);
+		io_write(File, aHeader, sizeof(aHeader));
+		io_write(File, pCompressed, Size);
+	}
+	mem_free(pPacked);
+	return Result;
+}
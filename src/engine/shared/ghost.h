@@ -0,0 +1,103 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_GHOST_H
+#define ENGINE_SHARED_GHOST_H
+
+#include <base/system.h>
+
+#include "protocol.h"
+
+// race ghost files: the header, the client info of the player and one sample
+// per tick, in blocks of BLOCK_SAMPLES. version 2 keeps the samples as they
+// are. version 3 stores every field as a varint delta to the tick before,
+// starting from zero in each block, and deflates the blocks.
+struct CGhostHeader
+{
+	unsigned char m_aMarker[8];
+	unsigned char m_Version;
+	char m_aOwner[MAX_NAME_LENGTH];
+	char m_aMap[64];
+	unsigned char m_aCrc[4];
+	int m_NumShots;
+	float m_Time;
+};
+
+struct CGhostCharacter
+{
+	int m_X;
+	int m_Y;
+	int m_VelX;
+	int m_VelY;
+	int m_Angle;
+	int m_Direction;
+	int m_Weapon;
+	int m_HookState;
+	int m_HookX;
+	int m_HookY;
+	int m_AttackTick;
+};
+
+// reads the samples a block at a time, the file stays open until Close
+class CGhostReader
+{
+public:
+	enum
+	{
+		VERSION_RAW=2,
+		VERSION_DELTA=3,
+
+		BLOCK_SAMPLES=500,
+		MAX_BLOCK_SIZE=100*500,
+	};
+
+private:
+	struct CBlock
+	{
+		long m_Filepos;
+		int m_Size;
+		int m_PackedSize;
+	};
+
+	IOHANDLE m_File;
+	CGhostHeader m_Header;
+	CBlock *m_pBlocks;
+	int m_NumBlocks;
+	int m_NumSamples;
+
+	// one unpacked block. the last sample of the block before stays around,
+	// playback looks at the previous tick too
+	int m_CachedBlock;
+	CGhostCharacter m_aSamples[BLOCK_SAMPLES];
+	int m_PrevIndex;
+	CGhostCharacter m_PrevSample;
+
+	bool LoadBlock(int Index);
+	bool UnpackBlock(const unsigned char *pPacked, int PackedSize, int Index);
+
+public:
+	CGhostReader();
+	~CGhostReader();
+
+	// checks the marker and the version
+	static bool ReadHeader(IOHANDLE File, CGhostHeader *pHeader);
+
+	// takes the file in any case
+	bool Open(IOHANDLE File, void *pInfo, int InfoSize);
+	void Close();
+
+	const CGhostHeader *Header() const { return &m_Header; }
+	int NumSamples() const { return m_NumSamples; }
+
+	// 0 past the end. a block that can't be read ends the ghost there
+	const CGhostCharacter *Sample(int Index);
+};
+
+class CGhostWriter
+{
+public:
+	// writes the current version. fills in the marker, the version and the
+	// number of samples of the header
+	static bool Write(IOHANDLE File, CGhostHeader *pHeader, const void *pInfo, int InfoSize, const CGhostCharacter *pSamples, int Num);
+};
+
+#endif
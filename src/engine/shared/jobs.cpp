@@ -7,6 +7,11 @@ CJobPool::CJobPool()
 {
 	// empty the pool
 	m_Lock = lock_create();
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_Pending);
+	semaphore_init(&m_Done);
+#endif
+	m_NumWaiting = 0;
 	m_pFirstJob = 0;
 	m_pLastJob = 0;
 }
@@ -19,6 +24,11 @@ void CJobPool::WorkerThread(void *pUser)
 	{
 		CJob *pJob = 0;
 
+#if !defined(CONF_PLATFORM_MACOSX)
+		// sleep until a job gets added
+		semaphore_wait(&pPool->m_Pending);
+#endif
+
 		// fetch job from queue
 		lock_wait(pPool->m_Lock);
 		if(pPool->m_pFirstJob)
@@ -36,11 +46,25 @@ void CJobPool::WorkerThread(void *pUser)
 		if(pJob)
 		{
 			pJob->m_Status = CJob::STATE_RUNNING;
-			pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+			int Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+
+			// the lock publishes what the job wrote to whoever sees it done
+			lock_wait(pPool->m_Lock);
+			pJob->m_Result = Result;
 			pJob->m_Status = CJob::STATE_DONE;
+			bool Wake = pPool->m_NumWaiting > 0;
+			if(Wake)
+				pPool->m_NumWaiting--;
+			lock_unlock(pPool->m_Lock);
+#if !defined(CONF_PLATFORM_MACOSX)
+			if(Wake)
+				semaphore_signal(&pPool->m_Done);
+#endif
 		}
+#if defined(CONF_PLATFORM_MACOSX)
 		else
 			thread_sleep(10);
+#endif
 	}
 
 }
@@ -70,5 +94,30 @@ int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData)
 		m_pFirstJob = pJob;
 
 	lock_unlock(m_Lock);
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_signal(&m_Pending);
+#endif
 	return 0;
 }
+
+void CJobPool::Wait(CJob *pJob)
+{
+	while(1)
+	{
+		lock_wait(m_Lock);
+		if(pJob->m_Status == CJob::STATE_DONE)
+		{
+			lock_unlock(m_Lock);
+			return;
+		}
+#if !defined(CONF_PLATFORM_MACOSX)
+		// every waiter is woken by one finished job, not necessarily its own
+		m_NumWaiting++;
+		lock_unlock(m_Lock);
+		semaphore_wait(&m_Done);
+#else
+		lock_unlock(m_Lock);
+		thread_yield();
+#endif
+	}
+}
@@ -2,6 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_JOBS_H
 #define ENGINE_SHARED_JOBS_H
+
+#include <base/system.h>
+
 typedef int (*JOBFUNC)(void *pData);
 
 class CJobPool;
@@ -39,6 +42,12 @@ public:
 class CJobPool
 {
 	LOCK m_Lock;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_Pending;
+	// signalled once per finished job while someone is in Wait
+	SEMAPHORE m_Done;
+#endif
+	int m_NumWaiting;
 	CJob *m_pFirstJob;
 	CJob *m_pLastJob;
 
@@ -49,5 +58,7 @@ public:
 
 	int Init(int NumThreads);
 	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData);
+	// sleeps until a job of this pool is done, its result is visible afterwards
+	void Wait(CJob *pJob);
 };
 #endif
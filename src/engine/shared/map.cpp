@@ -15,6 +15,8 @@ public:
 	virtual int GetUncompressedDataSize(int Index) { return m_DataFile.GetUncompressedDataSize(Index); }
 	virtual void *GetDataSwapped(int Index) { return m_DataFile.GetDataSwapped(Index); }
 	virtual void UnloadData(int Index) { m_DataFile.UnloadData(Index); }
+	virtual void PrefetchData(const int *pIndices, int Num) { m_DataFile.Prefetch(pIndices, Num); }
+	virtual void DropFileCopy() { m_DataFile.DropFileCopy(); }
 	virtual void *GetItem(int Index, int *pType, int *pID) { return m_DataFile.GetItem(Index, pType, pID); }
 	virtual int GetItemSize(int Index) { return m_DataFile.GetItemSize(Index); }
 	virtual void GetType(int Type, int *pStart, int *pNum) { m_DataFile.GetType(Type, pStart, pNum); }
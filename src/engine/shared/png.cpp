@@ -0,0 +1,80 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <engine/external/pnglite/pnglite.h>
+#include <engine/graphics.h>
+#include <engine/storage.h>
+
+#include "png.h"
+
+// feeds pnglite from a file in memory
+struct CPngReader
+{
+	const IOMAP *m_pMap;
+	unsigned m_Pos;
+
+	static unsigned Read(void *pOutput, unsigned long Size, unsigned long Num, void *pUser)
+	{
+		CPngReader *pReader = (CPngReader *)pUser;
+		unsigned long Bytes = Size*Num;
+		if(Bytes > pReader->m_pMap->size-pReader->m_Pos)
+			return 0;
+		// no output only skips
+		if(pOutput)
+			mem_copy(pOutput, (const char *)pReader->m_pMap->data+pReader->m_Pos, Bytes);
+		pReader->m_Pos += Bytes;
+		return Num;
+	}
+};
+
+bool CPngLoader::Load(IStorage *pStorage, const char *pFilename, int StorageType, CImageInfo *pImg)
+{
+	char aCompleteFilename[512];
+	IOMAP Map;
+	if(!pStorage->MapFile(pFilename, StorageType, &Map, true, aCompleteFilename, sizeof(aCompleteFilename)))
+	{
+		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
+		return false;
+	}
+
+	bool Result = Load(&Map, aCompleteFilename, pImg);
+	io_unmap(&Map);
+	return Result;
+}
+
+bool CPngLoader::Load(const IOMAP *pMap, const char *pFilename, CImageInfo *pImg)
+{
+	unsigned char *pBuffer;
+	png_t Png; // ignore_convention
+
+	png_init(0,0); // ignore_convention
+
+	CPngReader Reader;
+	Reader.m_pMap = pMap;
+	Reader.m_Pos = 0;
+
+	int Error = png_open(&Png, CPngReader::Read, &Reader); // ignore_convention
+	if(Error != PNG_NO_ERROR)
+	{
+		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
+		return false;
+	}
+
+	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA)) // ignore_convention
+	{
+		dbg_msg("game/png", "invalid format. filename='%s'", pFilename);
+		return false;
+	}
+
+	pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
+	png_get_data(&Png, pBuffer); // ignore_convention
+
+	pImg->m_Width = Png.width; // ignore_convention
+	pImg->m_Height = Png.height; // ignore_convention
+	if(Png.color_type == PNG_TRUECOLOR) // ignore_convention
+		pImg->m_Format = CImageInfo::FORMAT_RGB;
+	else if(Png.color_type == PNG_TRUECOLOR_ALPHA) // ignore_convention
+		pImg->m_Format = CImageInfo::FORMAT_RGBA;
+	pImg->m_pData = pBuffer;
+	return true;
+}
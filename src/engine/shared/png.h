@@ -0,0 +1,18 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_PNG_H
+#define ENGINE_SHARED_PNG_H
+
+#include <base/system.h>
+
+class CPngLoader
+{
+public:
+	// decodes an 8-bit rgb or rgba png into a buffer from mem_alloc. the file
+	// is read through a mapping of it where the storage can map it
+	static bool Load(class IStorage *pStorage, const char *pFilename, int StorageType, class CImageInfo *pImg);
+	// the same from a view the caller already has, it stays mapped
+	static bool Load(const IOMAP *pMap, const char *pFilename, class CImageInfo *pImg);
+};
+
+#endif
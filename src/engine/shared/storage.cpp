@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/system.h>
 #include <engine/storage.h>
+#include "dircache.h"
 #include "linereader.h"
 
 // compiled-in data-dir path
@@ -22,6 +23,7 @@ public:
 	char m_aUserdir[MAX_PATH_LENGTH];
 	char m_aCurrentdir[MAX_PATH_LENGTH];
 	char m_aBinarydir[MAX_PATH_LENGTH];
+	CDirCache m_DirCache;
 
 	CStorage()
 	{
@@ -63,10 +65,12 @@ public:
 				fs_makedir(GetPath(TYPE_SAVE, "screenshots/auto/stats", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "maps", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "downloadedmaps", aPath, sizeof(aPath)));
+				fs_makedir(GetPath(TYPE_SAVE, "texcache", aPath, sizeof(aPath)));
 			}
 			fs_makedir(GetPath(TYPE_SAVE, "dumps", aPath, sizeof(aPath)));
 			fs_makedir(GetPath(TYPE_SAVE, "demos", aPath, sizeof(aPath)));
 			fs_makedir(GetPath(TYPE_SAVE, "demos/auto", aPath, sizeof(aPath)));
+			fs_makedir(GetPath(TYPE_SAVE, "democache", aPath, sizeof(aPath)));
 			fs_makedir(GetPath(TYPE_SAVE, "editor", aPath, sizeof(aPath)));
 			fs_makedir(GetPath(TYPE_SAVE, "ghosts", aPath, sizeof(aPath)));
 		}
@@ -163,6 +167,7 @@ public:
 	{
 		str_copy(m_aDatadir, "/cd/data", sizeof(m_aDatadir));
 		str_copy(m_aBinarydir, "/cd", sizeof(m_aBinarydir));
+		m_DirCache.AddReadOnlyRoot(m_aBinarydir);
 	}
 
 
@@ -173,12 +178,12 @@ public:
 		{
 			// list all available directories
 			for(int i = 0; i < m_NumPaths; ++i)
-				fs_listdir_info(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
+				m_DirCache.ListDirInfo(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
 		}
 		else if(Type >= 0 && Type < m_NumPaths)
 		{
 			// list wanted directory
-			fs_listdir_info(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
+			m_DirCache.ListDirInfo(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
 		}
 	}
 
@@ -189,12 +194,12 @@ public:
 		{
 			// list all available directories
 			for(int i = 0; i < m_NumPaths; ++i)
-				fs_listdir(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
+				m_DirCache.ListDir(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
 		}
 		else if(Type >= 0 && Type < m_NumPaths)
 		{
 			// list wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
+			m_DirCache.ListDir(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
 		}
 	}
 
@@ -215,7 +220,9 @@ public:
 
 		if(Flags&IOFLAG_WRITE)
 		{
-			return io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			IOHANDLE Handle = io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			m_DirCache.InvalidateParent(pBuffer);
+			return Handle;
 		}
 		else
 		{
@@ -244,6 +251,58 @@ public:
 		return 0;
 	}
 
+	virtual bool MapFile(const char *pFilename, int Type, IOMAP *pMap, bool Fallback = true, char *pBuffer = 0, int BufferSize = 0)
+	{
+		char aBuffer[MAX_PATH_LENGTH];
+		if(!pBuffer)
+		{
+			pBuffer = aBuffer;
+			BufferSize = sizeof(aBuffer);
+		}
+		mem_zero(pMap, sizeof(*pMap));
+
+		if(Type == TYPE_ALL)
+		{
+			// check all available directories. a file that can't be mapped
+			// still hides the ones in the later paths, like for OpenFile
+			for(int i = 0; i < m_NumPaths; ++i)
+			{
+				if(MapPath(i, pFilename, pMap, Fallback, pBuffer, BufferSize))
+					return true;
+				if(FileExists(pBuffer))
+					break;
+			}
+		}
+		else if(Type >= 0 && Type < m_NumPaths)
+		{
+			// check wanted directory
+			if(MapPath(Type, pFilename, pMap, Fallback, pBuffer, BufferSize))
+				return true;
+		}
+
+		pBuffer[0] = 0;
+		return false;
+	}
+
+	bool MapPath(int Type, const char *pFilename, IOMAP *pMap, bool Fallback, char *pBuffer, int BufferSize)
+	{
+		// the client rewrites files in the save path in place (editor saves,
+		// downloads), a mapping of a file that shrinks faults on the next
+		// access. those are always read into memory
+		GetPath(Type, pFilename, pBuffer, BufferSize);
+		if(Type == TYPE_SAVE)
+			return Fallback && io_map(pBuffer, pMap, IOMAP_COPY);
+		return io_map(pBuffer, pMap, Fallback ? IOMAP_FALLBACK : 0);
+	}
+
+	static bool FileExists(const char *pPath)
+	{
+		IOHANDLE File = io_open(pPath, IOFLAG_READ);
+		if(File)
+			io_close(File);
+		return File != 0;
+	}
+
 	struct CFindCBData
 	{
 		CStorage *pStorage;
@@ -266,7 +325,7 @@ public:
 			char aPath[MAX_PATH_LENGTH];
 			str_format(aPath, sizeof(aPath), "%s/%s", Data.pPath, pName);
 			Data.pPath = aPath;
-			fs_listdir(Data.pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
+			Data.pStorage->m_DirCache.ListDir(Data.pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
 			if(Data.pBuffer[0])
 				return 1;
 		}
@@ -299,7 +358,7 @@ public:
 			// search within all available directories
 			for(int i = 0; i < m_NumPaths; ++i)
 			{
-				fs_listdir(GetPath(i, pPath, aBuf, sizeof(aBuf)), FindFileCallback, i, &Data);
+				m_DirCache.ListDir(GetPath(i, pPath, aBuf, sizeof(aBuf)), FindFileCallback, i, &Data);
 				if(pBuffer[0])
 					return true;
 			}
@@ -307,7 +366,7 @@ public:
 		else if(Type >= 0 && Type < m_NumPaths)
 		{
 			// search within wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
+			m_DirCache.ListDir(GetPath(Type, pPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
 		}
 
 		return pBuffer[0] != 0;
@@ -319,7 +378,9 @@ public:
 			return false;
 
 		char aBuffer[MAX_PATH_LENGTH];
-		return !fs_remove(GetPath(Type, pFilename, aBuffer, sizeof(aBuffer)));
+		bool Removed = !fs_remove(GetPath(Type, pFilename, aBuffer, sizeof(aBuffer)));
+		m_DirCache.InvalidateParent(aBuffer);
+		return Removed;
 	}
 
 	virtual bool RemoveBinaryFile(const char *pFilename)
@@ -334,7 +395,10 @@ public:
 			return false;
 		char aOldBuffer[MAX_PATH_LENGTH];
 		char aNewBuffer[MAX_PATH_LENGTH];
-		return !_fs_rename(GetPath(Type, pOldFilename, aOldBuffer, sizeof(aOldBuffer)), GetPath(Type, pNewFilename, aNewBuffer, sizeof (aNewBuffer)));
+		bool Renamed = !_fs_rename(GetPath(Type, pOldFilename, aOldBuffer, sizeof(aOldBuffer)), GetPath(Type, pNewFilename, aNewBuffer, sizeof (aNewBuffer)));
+		m_DirCache.InvalidateParent(aOldBuffer);
+		m_DirCache.InvalidateParent(aNewBuffer);
+		return Renamed;
 	}
 
 	virtual bool RenameBinaryFile(const char* pOldFilename, const char* pNewFilename)
@@ -350,7 +414,23 @@ public:
 			return false;
 
 		char aBuffer[MAX_PATH_LENGTH];
-		return !fs_makedir(GetPath(Type, pFoldername, aBuffer, sizeof(aBuffer)));
+		bool Created = !fs_makedir(GetPath(Type, pFoldername, aBuffer, sizeof(aBuffer)));
+		m_DirCache.InvalidateParent(aBuffer);
+		return Created;
+	}
+
+	virtual void RefreshDirectory(int Type, const char *pPath)
+	{
+		char aBuffer[MAX_PATH_LENGTH];
+		if(!pPath)
+			m_DirCache.Invalidate(0);
+		else if(Type == TYPE_ALL)
+		{
+			for(int i = 0; i < m_NumPaths; ++i)
+				m_DirCache.Invalidate(GetPath(i, pPath, aBuffer, sizeof(aBuffer)));
+		}
+		else if(Type >= 0 && Type < m_NumPaths)
+			m_DirCache.Invalidate(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)));
 	}
 
 	virtual void GetCompletePath(int Type, const char *pDir, char *pBuffer, unsigned BufferSize)
@@ -0,0 +1,293 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/graphics.h>
+
+#include "texconv.h"
+
+#include <zlib.h>
+
+static const unsigned char gs_aCacheMagic[4] = {'T', 'X', 'C', 'H'};
+
+enum
+{
+	HEADER_SIZE=20,
+	MAX_CACHE_SIZE=1024,
+};
+
+unsigned CTextureConverter::Hash(const void *pData, int Size)
+{
+	return crc32(crc32(0L, 0, 0), (const Bytef *)pData, Size); // ignore_convention
+}
+
+void CTextureConverter::CacheName(char *pBuffer, int BufferSize, unsigned Hash, int Options)
+{
+	str_format(pBuffer, BufferSize, "texcache/%08x_%d.tex", Hash, Options);
+}
+
+static unsigned char *Rescale(int Width, int Height, int NewWidth, int NewHeight, int Bpp, const unsigned char *pData)
+{
+	int ScaleW = Width/NewWidth;
+	int ScaleH = Height/NewHeight;
+	int Area = ScaleW*ScaleH;
+	unsigned char *pTmpData = (unsigned char *)mem_alloc(NewWidth*NewHeight*Bpp, 1);
+	unsigned char *pDst = pTmpData;
+
+	// box filter, all channels of a block are summed in one pass
+	for(int y = 0; y < NewHeight; y++)
+		for(int x = 0; x < NewWidth; x++)
+		{
+			int aSum[4] = {0, 0, 0, 0};
+			const unsigned char *pRow = pData + ((y*ScaleH)*Width + x*ScaleW)*Bpp;
+			for(int v = 0; v < ScaleH; v++, pRow += Width*Bpp)
+				for(int u = 0; u < ScaleW*Bpp; u += Bpp)
+					for(int c = 0; c < Bpp; c++)
+						aSum[c] += pRow[u+c];
+			for(int c = 0; c < Bpp; c++)
+				*pDst++ = aSum[c]/Area;
+		}
+
+	return pTmpData;
+}
+
+unsigned char *CTextureConverter::Downscale(int *pWidth, int *pHeight, int Format, const unsigned char *pData, int Options)
+{
+	if(Options&OPTION_NORESAMPLE || (Format != CImageInfo::FORMAT_RGBA && Format != CImageInfo::FORMAT_RGB))
+		return 0;
+
+	int Bpp = Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int Width = *pWidth;
+	int Height = *pHeight;
+	if(Width > MAX_SIZE || Height > MAX_SIZE)
+	{
+		int NewWidth = min(Width, (int)MAX_SIZE);
+		float div = NewWidth/(float)Width;
+		int NewHeight = Height * div;
+		*pWidth = NewWidth;
+		*pHeight = NewHeight;
+		return Rescale(Width, Height, NewWidth, NewHeight, Bpp, pData);
+	}
+	else if(Width > 16 && Height > 16 && Options&OPTION_LOWQUALITY)
+	{
+		*pWidth = Width/2;
+		*pHeight = Height/2;
+		return Rescale(Width, Height, Width/2, Height/2, Bpp, pData);
+	}
+	return 0;
+}
+
+int CTextureConverter::ChooseFormat(int Format, const unsigned char *pData, int Width, int Height)
+{
+	if(Format != CImageInfo::FORMAT_RGBA)
+		return FORMAT_RGB565;
+
+	// the cheapest format that keeps the alpha channel
+	bool Translucent = false;
+	bool Masked = false;
+	for(int i = 0; i < Width*Height; i++)
+	{
+		unsigned char a = pData[i*4+3];
+		if(a == 0)
+			Masked = true;
+		else if(a != 255)
+		{
+			Translucent = true;
+			break;
+		}
+	}
+
+	if(Translucent)
+		return FORMAT_ARGB4444;
+	return Masked ? FORMAT_ARGB1555 : FORMAT_RGB565;
+}
+
+void CTextureConverter::Convert(int Format, const unsigned char *pData, int Width, int Height, int DstFormat, unsigned short *pDst)
+{
+	int Bpp = Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int Num = Width*Height;
+	for(int i = 0; i < Num; i++, pData += Bpp)
+	{
+		unsigned r = pData[0], g = pData[1], b = pData[2];
+		unsigned a = Bpp == 4 ? pData[3] : 255;
+		if(DstFormat == FORMAT_RGB565)
+			pDst[i] = ((r>>3)<<11) | ((g>>2)<<5) | (b>>3);
+		else if(DstFormat == FORMAT_ARGB1555)
+			pDst[i] = (a >= 128 ? 0x8000 : 0) | ((r>>3)<<10) | ((g>>3)<<5) | (b>>3);
+		else
+			pDst[i] = ((a>>4)<<12) | ((r>>4)<<8) | ((g>>4)<<4) | (b>>4);
+	}
+}
+
+void CTextureConverter::Expand(int Format, const unsigned short *pData, int Width, int Height, unsigned char *pDst)
+{
+	int Num = Width*Height;
+	for(int i = 0; i < Num; i++, pDst += 4)
+	{
+		unsigned Texel = pData[i];
+		unsigned r, g, b, a;
+		if(Format == FORMAT_RGB565)
+		{
+			r = (Texel>>11)&0x1f; g = (Texel>>5)&0x3f; b = Texel&0x1f;
+			r = (r<<3)|(r>>2); g = (g<<2)|(g>>4); b = (b<<3)|(b>>2);
+			a = 255;
+		}
+		else if(Format == FORMAT_ARGB1555)
+		{
+			r = (Texel>>10)&0x1f; g = (Texel>>5)&0x1f; b = Texel&0x1f;
+			r = (r<<3)|(r>>2); g = (g<<3)|(g>>2); b = (b<<3)|(b>>2);
+			a = Texel&0x8000 ? 255 : 0;
+		}
+		else
+		{
+			a = (Texel>>12)&0xf; r = (Texel>>8)&0xf; g = (Texel>>4)&0xf; b = Texel&0xf;
+			a |= a<<4; r |= r<<4; g |= g<<4; b |= b<<4;
+		}
+		pDst[0] = r;
+		pDst[1] = g;
+		pDst[2] = b;
+		pDst[3] = a;
+	}
+}
+
+// moves the lower 16 bits of v to the even bit positions
+static unsigned Spread(unsigned v)
+{
+	v = (v | (v<<8)) & 0x00ff00ff;
+	v = (v | (v<<4)) & 0x0f0f0f0f;
+	v = (v | (v<<2)) & 0x33333333;
+	v = (v | (v<<1)) & 0x55555555;
+	return v;
+}
+
+static int TwiddledIndex(int x, int y, int Min)
+{
+	// rectangles are a row or column of squares, y goes to the lower bit
+	int Square = x/Min + y/Min;
+	return Square*Min*Min + (Spread(y&(Min-1)) | (Spread(x&(Min-1))<<1));
+}
+
+bool CTextureConverter::CanTwiddle(int Width, int Height)
+{
+	return Width >= 8 && Height >= 8 && Width <= MAX_CACHE_SIZE && Height <= MAX_CACHE_SIZE &&
+		!(Width&(Width-1)) && !(Height&(Height-1));
+}
+
+void CTextureConverter::Twiddle(const unsigned short *pData, int Width, int Height, unsigned short *pDst)
+{
+	int Min = min(Width, Height);
+	for(int y = 0; y < Height; y++)
+		for(int x = 0; x < Width; x++)
+			pDst[TwiddledIndex(x, y, Min)] = *pData++;
+}
+
+void CTextureConverter::Untwiddle(const unsigned short *pData, int Width, int Height, unsigned short *pDst)
+{
+	int Min = min(Width, Height);
+	for(int y = 0; y < Height; y++)
+		for(int x = 0; x < Width; x++)
+			*pDst++ = pData[TwiddledIndex(x, y, Min)];
+}
+
+unsigned short *CTextureConverter::Build(int Width, int Height, int Format, const unsigned char *pData, int Options, bool Twiddled, CHeader *pHeader)
+{
+	if(Format != CImageInfo::FORMAT_RGBA && Format != CImageInfo::FORMAT_RGB)
+		return 0;
+
+	unsigned char *pTmpData = Downscale(&Width, &Height, Format, pData, Options);
+	if(pTmpData)
+		pData = pTmpData;
+
+	int DstFormat = ChooseFormat(Format, pData, Width, Height);
+	unsigned short *pTexels = (unsigned short *)mem_alloc(Width*Height*sizeof(unsigned short), 1);
+	Convert(Format, pData, Width, Height, DstFormat, pTexels);
+	if(pTmpData)
+		mem_free(pTmpData);
+
+	pHeader->m_Flags = 0;
+	if(Twiddled && CanTwiddle(Width, Height))
+	{
+		unsigned short *pTwiddled = (unsigned short *)mem_alloc(Width*Height*sizeof(unsigned short), 1);
+		Twiddle(pTexels, Width, Height, pTwiddled);
+		mem_free(pTexels);
+		pTexels = pTwiddled;
+		pHeader->m_Flags |= FLAG_TWIDDLED;
+	}
+
+	pHeader->m_Width = Width;
+	pHeader->m_Height = Height;
+	pHeader->m_Format = DstFormat;
+	pHeader->m_Hash = 0;
+	return pTexels;
+}
+
+static void WriteInt(unsigned char *pBuf, unsigned Value)
+{
+	pBuf[0] = (Value>>24)&0xff;
+	pBuf[1] = (Value>>16)&0xff;
+	pBuf[2] = (Value>>8)&0xff;
+	pBuf[3] = Value&0xff;
+}
+
+static unsigned ReadInt(const unsigned char *pBuf)
+{
+	return (pBuf[0]<<24) | (pBuf[1]<<16) | (pBuf[2]<<8) | pBuf[3];
+}
+
+bool CTextureConverter::Save(IOHANDLE File, const CHeader *pHeader, const unsigned short *pData)
+{
+	unsigned char aHeader[HEADER_SIZE];
+	mem_copy(aHeader, gs_aCacheMagic, sizeof(gs_aCacheMagic));
+	aHeader[4] = VERSION;
+	aHeader[5] = pHeader->m_Format;
+	aHeader[6] = pHeader->m_Flags;
+	aHeader[7] = 0;
+	WriteInt(aHeader+8, pHeader->m_Width);
+	WriteInt(aHeader+12, pHeader->m_Height);
+	WriteInt(aHeader+16, pHeader->m_Hash);
+	if(io_write(File, aHeader, sizeof(aHeader)) != sizeof(aHeader))
+		return false;
+
+	// texels are stored little endian, the way the pvr reads them
+	unsigned Size = pHeader->m_Width*pHeader->m_Height*sizeof(unsigned short);
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	unsigned short *pSwapped = (unsigned short *)mem_alloc(Size, 1);
+	mem_copy(pSwapped, pData, Size);
+	swap_endian(pSwapped, sizeof(unsigned short), Size/sizeof(unsigned short));
+	bool Result = io_write(File, pSwapped, Size) == Size;
+	mem_free(pSwapped);
+	return Result;
+#else
+	return io_write(File, pData, Size) == Size;
+#endif
+}
+
+unsigned short *CTextureConverter::Load(IOHANDLE File, CHeader *pHeader)
+{
+	unsigned char aHeader[HEADER_SIZE];
+	if(io_read(File, aHeader, sizeof(aHeader)) != sizeof(aHeader) ||
+		mem_comp(aHeader, gs_aCacheMagic, sizeof(gs_aCacheMagic)) != 0 || aHeader[4] != VERSION)
+		return 0;
+
+	pHeader->m_Format = aHeader[5];
+	pHeader->m_Flags = aHeader[6];
+	pHeader->m_Width = ReadInt(aHeader+8);
+	pHeader->m_Height = ReadInt(aHeader+12);
+	pHeader->m_Hash = ReadInt(aHeader+16);
+	if(pHeader->m_Format < 0 || pHeader->m_Format >= NUM_FORMATS ||
+		pHeader->m_Width <= 0 || pHeader->m_Height <= 0 ||
+		pHeader->m_Width > MAX_CACHE_SIZE || pHeader->m_Height > MAX_CACHE_SIZE)
+		return 0;
+
+	unsigned Size = pHeader->m_Width*pHeader->m_Height*sizeof(unsigned short);
+	unsigned short *pData = (unsigned short *)mem_alloc(Size, 1);
+	if(io_read(File, pData, Size) != Size)
+	{
+		mem_free(pData);
+		return 0;
+	}
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	swap_endian(pData, sizeof(unsigned short), Size/sizeof(unsigned short));
+#endif
+	return pData;
+}
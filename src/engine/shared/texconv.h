@@ -0,0 +1,63 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_TEXCONV_H
+#define ENGINE_SHARED_TEXCONV_H
+
+#include <base/system.h>
+
+// converts rgb(a) images into the 16-bit formats the pvr samples natively.
+// the result can be stored in a cache file keyed by the hash of the source
+// data, so later loads skip decoding, downscaling and conversion. nothing in
+// here touches the gpu, the offline tool and the client share the code.
+class CTextureConverter
+{
+public:
+	enum
+	{
+		FORMAT_RGB565=0,
+		FORMAT_ARGB1555,
+		FORMAT_ARGB4444,
+		NUM_FORMATS,
+
+		FLAG_TWIDDLED=1,
+
+		// conversion options, part of the cache key
+		OPTION_NORESAMPLE=1,
+		OPTION_LOWQUALITY=2,
+
+		MAX_SIZE=256,
+		VERSION=1,
+	};
+
+	struct CHeader
+	{
+		int m_Width;
+		int m_Height;
+		int m_Format;
+		int m_Flags;
+		unsigned m_Hash;
+	};
+
+	static unsigned Hash(const void *pData, int Size);
+	static void CacheName(char *pBuffer, int BufferSize, unsigned Hash, int Options);
+
+	// returns 0 when the image can be used as it is
+	static unsigned char *Downscale(int *pWidth, int *pHeight, int Format, const unsigned char *pData, int Options);
+
+	static int ChooseFormat(int Format, const unsigned char *pData, int Width, int Height);
+	static void Convert(int Format, const unsigned char *pData, int Width, int Height, int DstFormat, unsigned short *pDst);
+	static void Expand(int Format, const unsigned short *pData, int Width, int Height, unsigned char *pDst);
+
+	// the pvr stores twiddled textures as squares of morton ordered texels
+	static bool CanTwiddle(int Width, int Height);
+	static void Twiddle(const unsigned short *pData, int Width, int Height, unsigned short *pDst);
+	static void Untwiddle(const unsigned short *pData, int Width, int Height, unsigned short *pDst);
+
+	// full pipeline, pData is Format (rgb or rgba) and gets freed by the caller
+	static unsigned short *Build(int Width, int Height, int Format, const unsigned char *pData, int Options, bool Twiddled, CHeader *pHeader);
+
+	static bool Save(IOHANDLE File, const CHeader *pHeader, const unsigned short *pData);
+	static unsigned short *Load(IOHANDLE File, CHeader *pHeader);
+};
+
+#endif
@@ -51,6 +51,19 @@ public:
 		bool operator ==(const CVoiceHandle &Other) const { return m_Id == Other.m_Id && m_Age == Other.m_Age; }
 	};
 
+	struct CStats
+	{
+		int m_NumSamples;
+		int m_NumDecoded;
+		int m_CompressedSize; // in bytes
+		int m_DecodedSize;
+		int m_DecodedBudget;
+		int m_NumDecodes;
+		int m_NumEvictions;
+		float m_LastDecodeTime; // in ms
+		float m_MaxDecodeTime;
+	};
+
 
 	virtual bool IsSoundEnabled() = 0;
 
@@ -60,6 +73,10 @@ public:
 	virtual int LoadOpusFromMem(const void *pData, unsigned DataSize, bool FromEditor = false) = 0;
 	virtual void UnloadSample(int SampleID) = 0;
 
+	// samples are decoded when first played, this decodes one ahead of time
+	virtual void Predecode(int SampleID) = 0;
+	virtual void GetStats(CStats *pStats) = 0;
+
 	virtual float GetSampleDuration(int SampleID) = 0; // in s
 
 	virtual void SetChannel(int ChannelID, float Volume, float Panning) = 0;
@@ -22,7 +22,14 @@ public:
 	virtual void ListDirectory(int Type, const char *pPath, FS_LISTDIR_CALLBACK pfnCallback, void *pUser) = 0;
 	virtual void ListDirectoryInfo(int Type, const char *pPath, FS_LISTDIR_INFO_CALLBACK pfnCallback, void *pUser) = 0;
 	virtual IOHANDLE OpenFile(const char *pFilename, int Flags, int Type, char *pBuffer = 0, int BufferSize = 0) = 0;
+	// read-only view of a whole file, searched like OpenFile. files in the save
+	// path are always read into memory, the client rewrites those in place.
+	// release it with io_unmap
+	virtual bool MapFile(const char *pFilename, int Type, IOMAP *pMap, bool Fallback = true, char *pBuffer = 0, int BufferSize = 0) = 0;
 	virtual bool FindFile(const char *pFilename, const char *pPath, int Type, char *pBuffer, int BufferSize) = 0;
+	// listings are cached per directory and read again when its modification
+	// time changes. drops the listings of pPath, or all of them for 0
+	virtual void RefreshDirectory(int Type, const char *pPath) = 0;
 	virtual bool RemoveFile(const char *pFilename, int Type) = 0;
 	virtual bool RenameFile(const char* pOldFilename, const char* pNewFilename, int Type) = 0;
 	virtual bool CreateFolder(const char *pFoldername, int Type) = 0;
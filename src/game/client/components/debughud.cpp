@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <engine/shared/config.h>
 #include <engine/graphics.h>
+#include <engine/sound.h>
 #include <engine/textrender.h>
 
 #include <game/generated/protocol.h>
@@ -31,7 +32,7 @@ void CDebugHud::RenderNetCorrections()
 	float Velspeed = length(vec2(m_pClient->m_Snap.m_pLocalCharacter->m_VelX/256.0f, m_pClient->m_Snap.m_pLocalCharacter->m_VelY/256.0f))*50;
 	float Ramp = VelocityRamp(Velspeed, m_pClient->m_Tuning[g_Config.m_ClDummy].m_VelrampStart, m_pClient->m_Tuning[g_Config.m_ClDummy].m_VelrampRange, m_pClient->m_Tuning[g_Config.m_ClDummy].m_VelrampCurvature);
 
-	const char *paStrings[] = {"velspeed:", "velspeed*ramp:", "ramp:", "Pos", " x:", " y:", "netobj corrections", " num:", " on:"};
+	const char *paStrings[] = {"velspeed:", "velspeed*ramp:", "ramp:", "Pos", " x:", " y:", "netobj corrections", " num:", " on:", "prediction", " resim ticks:"};
 	const int Num = sizeof(paStrings)/sizeof(char *);
 	const float LineHeight = 6.0f;
 	const float Fontsize = 5.0f;
@@ -68,6 +69,10 @@ void CDebugHud::RenderNetCorrections()
 	y += LineHeight;
 	w = TextRender()->TextWidth(0, Fontsize, m_pClient->NetobjCorrectedOn(), -1);
 	TextRender()->Text(0, x-w, y, Fontsize, m_pClient->NetobjCorrectedOn(), -1);
+	y += 2*LineHeight;
+	str_format(aBuf, sizeof(aBuf), "%d", m_pClient->PredictionResimTicks());
+	w = TextRender()->TextWidth(0, Fontsize, aBuf, -1);
+	TextRender()->Text(0, x-w, y, Fontsize, aBuf, -1);
 }
 
 void CDebugHud::RenderTuning()
@@ -135,8 +140,41 @@ void CDebugHud::RenderTuning()
 	TextRender()->TextColor(1,1,1,1);
 }
 
+void CDebugHud::RenderSoundStats()
+{
+	if(!g_Config.m_DbgSound)
+		return;
+
+	ISound::CStats Stats;
+	Sound()->GetStats(&Stats);
+
+	float Width = 300*Graphics()->ScreenAspect();
+	Graphics()->MapScreen(0, 0, Width, 300);
+
+	const float LineHeight = 6.0f;
+	const float Fontsize = 5.0f;
+	float x = 5.0f, y = 200.0f;
+	char aBuf[128];
+
+	str_format(aBuf, sizeof(aBuf), "samples: %d, %d decoded", Stats.m_NumSamples, Stats.m_NumDecoded);
+	TextRender()->Text(0, x, y, Fontsize, aBuf, -1);
+	y += LineHeight;
+	str_format(aBuf, sizeof(aBuf), "compressed: %d KB", Stats.m_CompressedSize/1024);
+	TextRender()->Text(0, x, y, Fontsize, aBuf, -1);
+	y += LineHeight;
+	str_format(aBuf, sizeof(aBuf), "decoded: %d / %d KB", Stats.m_DecodedSize/1024, Stats.m_DecodedBudget/1024);
+	TextRender()->Text(0, x, y, Fontsize, aBuf, -1);
+	y += LineHeight;
+	str_format(aBuf, sizeof(aBuf), "decodes: %d, evictions: %d", Stats.m_NumDecodes, Stats.m_NumEvictions);
+	TextRender()->Text(0, x, y, Fontsize, aBuf, -1);
+	y += LineHeight;
+	str_format(aBuf, sizeof(aBuf), "decode time: %.2f ms, max %.2f ms", Stats.m_LastDecodeTime, Stats.m_MaxDecodeTime);
+	TextRender()->Text(0, x, y, Fontsize, aBuf, -1);
+}
+
 void CDebugHud::OnRender()
 {
 	RenderTuning();
 	RenderNetCorrections();
+	RenderSoundStats();
 }
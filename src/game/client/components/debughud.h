@@ -8,6 +8,7 @@ class CDebugHud : public CComponent
 {
 	void RenderNetCorrections();
 	void RenderTuning();
+	void RenderSoundStats();
 public:
 	virtual void OnRender();
 };
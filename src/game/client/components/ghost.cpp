@@ -5,8 +5,6 @@
 #include <engine/storage.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
-#include <engine/shared/compression.h>
-#include <engine/shared/network.h>
 
 #include <game/generated/client_data.h>
 #include <game/client/animstate.h>
@@ -24,9 +22,6 @@ can used PrevChar and PlayerChar and it would be fluent and accurate but won't b
 so it will be affected by lags
 */
 
-static const unsigned char gs_aHeaderMarker[8] = {'T', 'W', 'G', 'H', 'O', 'S', 'T', 0};
-static const unsigned char gs_ActVersion = 2;
-
 CGhost::CGhost()
 {
 	m_lGhosts.clear();
@@ -58,6 +53,32 @@ void CGhost::AddInfos(CGhostCharacter Player)
 	m_CurGhost.m_Path.add(Player);
 }
 
+int CGhost::NumSamples(const CGhostItem *pGhost) const
+{
+	return pGhost->m_pReader ? pGhost->m_pReader->NumSamples() : pGhost->m_Path.size();
+}
+
+bool CGhost::GetSample(CGhostItem *pGhost, int Index, CGhostCharacter *pSample)
+{
+	if(!pGhost->m_pReader)
+	{
+		*pSample = pGhost->m_Path[Index];
+		return true;
+	}
+
+	const CGhostCharacter *pRead = pGhost->m_pReader->Sample(Index);
+	if(!pRead)
+		return false;
+	*pSample = *pRead;
+	return true;
+}
+
+void CGhost::FreeGhost(CGhostItem *pGhost)
+{
+	delete pGhost->m_pReader;
+	pGhost->m_pReader = 0;
+}
+
 void CGhost::OnRender()
 {
 	if(!g_Config.m_ClRaceGhost || Client()->State() != IClient::STATE_ONLINE)
@@ -95,7 +116,10 @@ void CGhost::OnRender()
 			if(r.empty())
 				m_lGhosts.add(m_CurGhost);
 			else
+			{
+				FreeGhost(&r.front());
 				r.front() = m_CurGhost;
+			}
 
 			Save();
 		}
@@ -125,12 +149,13 @@ void CGhost::OnRender()
 	for(int i = 0; i < m_lGhosts.size(); i++)
 	{
 		CGhostItem *pGhost = &m_lGhosts[i];
-		if(m_CurPos >= pGhost->m_Path.size())
+		if(m_CurPos >= NumSamples(pGhost))
 			continue;
 
 		int PrevPos = (m_CurPos > 0) ? m_CurPos-1 : m_CurPos;
-		CGhostCharacter Player = pGhost->m_Path[m_CurPos];
-		CGhostCharacter Prev = pGhost->m_Path[PrevPos];
+		CGhostCharacter Player, Prev;
+		if(!GetSample(pGhost, m_CurPos, &Player) || !GetSample(pGhost, PrevPos, &Prev))
+			continue;
 		CNetObj_ClientInfo Info = pGhost->m_Info;
 
 		RenderGhostHook(Player, Prev);
@@ -255,7 +280,7 @@ void CGhost::RenderGhostHook(CGhostCharacter Player, CGhostCharacter Prev)
 	Graphics()->QuadsEnd();
 }
 
-CGhost::CGhostCharacter CGhost::GetGhostCharacter(CNetObj_Character Char)
+CGhostCharacter CGhost::GetGhostCharacter(CNetObj_Character Char)
 {
 	CGhostCharacter Player;
 	Player.m_X = Char.m_X;
@@ -329,8 +354,6 @@ void CGhost::Save()
 	// write header
 	int Crc = Client()->GetCurrentMapCrc();
 	mem_zero(&Header, sizeof(Header));
-	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
-	Header.m_Version = gs_ActVersion;
 	IntsToStr(&m_CurGhost.m_Info.m_Name0, 4, Header.m_aOwner);
 	str_copy(Header.m_aMap, Client()->GetCurrentMap(), sizeof(Header.m_aMap));
 	Header.m_aCrc[0] = (Crc>>24)&0xff;
@@ -338,41 +361,10 @@ void CGhost::Save()
 	Header.m_aCrc[2] = (Crc>>8)&0xff;
 	Header.m_aCrc[3] = (Crc)&0xff;
 	Header.m_Time = m_BestTime;
-	Header.m_NumShots = m_CurGhost.m_Path.size();
-	io_write(File, &Header, sizeof(Header));
-
-	// write client info
-	io_write(File, &m_CurGhost.m_Info, sizeof(m_CurGhost.m_Info));
 
-	// write data
-	int ItemsPerPackage = 500; // 500 ticks per package
-	int Num = Header.m_NumShots;
-	CGhostCharacter *Data = &m_CurGhost.m_Path[0];
-
-	while(Num)
-	{
-		int Items = min(Num, ItemsPerPackage);
-		Num -= Items;
-
-		char aBuffer[100*500];
-		char aBuffer2[100*500];
-		unsigned char aSize[4];
-
-		int Size = sizeof(CGhostCharacter)*Items;
-		mem_copy(aBuffer2, Data, Size);
-		Data += Items;
-
-		Size = CVariableInt::Compress(aBuffer2, Size, aBuffer);
-		Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2));
-
-		aSize[0] = (Size>>24)&0xff;
-		aSize[1] = (Size>>16)&0xff;
-		aSize[2] = (Size>>8)&0xff;
-		aSize[3] = (Size)&0xff;
-
-		io_write(File, aSize, sizeof(aSize));
-		io_write(File, aBuffer2, Size);
-	}
+	// write client info and data
+	int Num = m_CurGhost.m_Path.size();
+	CGhostWriter::Write(File, &Header, &m_CurGhost.m_Info, sizeof(m_CurGhost.m_Info), Num ? &m_CurGhost.m_Path[0] : 0, Num);
 
 	io_close(File);
 
@@ -400,27 +392,10 @@ void CGhost::Save()
 	m_Saving = false;
 }
 
-bool CGhost::GetHeader(IOHANDLE *pFile, CGhostHeader *pHeader)
+bool CGhost::CheckHeader(const CGhostHeader *pHeader)
 {
-	if(!*pFile)
-		return 0;
-
-	CGhostHeader Header;
-	io_read(*pFile, &Header, sizeof(Header));
-
-	*pHeader = Header;
-
-	if(mem_comp(Header.m_aMarker, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) != 0)
-		return 0;
-
-	if(Header.m_Version != gs_ActVersion)
-		return 0;
-
-	int Crc = (Header.m_aCrc[0]<<24) | (Header.m_aCrc[1]<<16) | (Header.m_aCrc[2]<<8) | (Header.m_aCrc[3]);
-	if(str_comp(Header.m_aMap, Client()->GetCurrentMap()) != 0 || Crc != Client()->GetCurrentMapCrc())
-		return 0;
-
-	return 1;
+	int Crc = (pHeader->m_aCrc[0]<<24) | (pHeader->m_aCrc[1]<<16) | (pHeader->m_aCrc[2]<<8) | (pHeader->m_aCrc[3]);
+	return str_comp(pHeader->m_aMap, Client()->GetCurrentMap()) == 0 && Crc == Client()->GetCurrentMapCrc();
 }
 
 bool CGhost::GetInfo(const char* pFilename, CGhostHeader *pHeader)
@@ -431,7 +406,7 @@ bool CGhost::GetInfo(const char* pFilename, CGhostHeader *pHeader)
 	if(!File)
 		return 0;
 
-	bool Check = GetHeader(&File, pHeader);
+	bool Check = CGhostReader::ReadHeader(File, pHeader) && CheckHeader(pHeader);
 	io_close(File);
 
 	return Check;
@@ -445,74 +420,18 @@ void CGhost::Load(const char* pFilename, int ID)
 	if(!File)
 		return;
 
-	// read header
-	CGhostHeader Header;
-	if(!GetHeader(&File, &Header))
+	// read header and client info, the path is read while it plays
+	CGhostItem Ghost;
+	Ghost.m_pReader = new CGhostReader();
+	if(!Ghost.m_pReader->Open(File, &Ghost.m_Info, sizeof(Ghost.m_Info)) || !CheckHeader(Ghost.m_pReader->Header()))
 	{
-		io_close(File);
+		FreeGhost(&Ghost);
 		return;
 	}
 
 	if(ID == -1)
-		m_BestTime = Header.m_Time;
-
-	int NumShots = Header.m_NumShots;
-
-	// create ghost
-	CGhostItem Ghost;
+		m_BestTime = Ghost.m_pReader->Header()->m_Time;
 	Ghost.m_ID = ID;
-	Ghost.m_Path.clear();
-	Ghost.m_Path.set_size(NumShots);
-
-	// read client info
-	io_read(File, &Ghost.m_Info, sizeof(Ghost.m_Info));
-
-	// read data
-	int Index = 0;
-	while(Index < NumShots)
-	{
-		static char aCompresseddata[100*500];
-		static char aDecompressed[100*500];
-		static char aData[100*500];
-
-		unsigned char aSize[4];
-		if(io_read(File, aSize, sizeof(aSize)) != sizeof(aSize))
-			break;
-		int Size = (aSize[0]<<24) | (aSize[1]<<16) | (aSize[2]<<8) | aSize[3];
-
-		if(io_read(File, aCompresseddata, Size) != (unsigned)Size)
-		{
-			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error reading chunk");
-			break;
-		}
-
-		Size = CNetBase::Decompress(aCompresseddata, Size, aDecompressed, sizeof(aDecompressed));
-		if(Size < 0)
-		{
-			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error during network decompression");
-			break;
-		}
-
-		Size = CVariableInt::Decompress(aDecompressed, Size, aData);
-		if(Size < 0)
-		{
-			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "ghost", "error during intpack decompression");
-			break;
-		}
-
-		CGhostCharacter *Tmp = (CGhostCharacter*)aData;
-		for(unsigned i = 0; i < Size/sizeof(CGhostCharacter); i++)
-		{
-			if(Index >= NumShots)
-				break;
-
-			Ghost.m_Path[Index] = *Tmp;
-			Index++;
-			Tmp++;
-		}
-	}
-
-	io_close(File);
 
 	m_lGhosts.add(Ghost);
 }
@@ -521,6 +440,10 @@ void CGhost::Unload(int ID)
 {
 	CGhostItem Item;
 	Item.m_ID = ID;
+	array<CGhostItem>::range r = find_linear(m_lGhosts.all(), Item);
+	if(r.empty())
+		return;
+	FreeGhost(&r.front());
 	m_lGhosts.remove_fast(Item);
 }
 
@@ -602,6 +525,8 @@ void CGhost::OnMapLoad()
 {
 	OnReset();
 	m_BestTime = -1;
+	for(int i = 0; i < m_lGhosts.size(); i++)
+		FreeGhost(&m_lGhosts[i]);
 	m_lGhosts.clear();
 	m_pClient->m_pMenus->GhostlistPopulate();
 }
@@ -3,43 +3,21 @@
 #ifndef GAME_CLIENT_COMPONENTS_GHOST_H
 #define GAME_CLIENT_COMPONENTS_GHOST_H
 
+#include <engine/shared/ghost.h>
+
 #include <game/client/component.h>
 
 class CGhost : public CComponent
 {
-public:
-	struct CGhostHeader
-	{
-		unsigned char m_aMarker[8];
-		unsigned char m_Version;
-		char m_aOwner[MAX_NAME_LENGTH];
-		char m_aMap[64];
-		unsigned char m_aCrc[4];
-		int m_NumShots;
-		float m_Time;
-	};
-
-private:
-	struct CGhostCharacter
-	{
-		int m_X;
-		int m_Y;
-		int m_VelX;
-		int m_VelY;
-		int m_Angle;
-		int m_Direction;
-		int m_Weapon;
-		int m_HookState;
-		int m_HookX;
-		int m_HookY;
-		int m_AttackTick;
-	};
-
+	// recorded ghosts keep their path in memory, loaded ones read it from the file
 	struct CGhostItem
 	{
 		int m_ID;
 		CNetObj_ClientInfo m_Info;
 		array<CGhostCharacter> m_Path;
+		CGhostReader *m_pReader;
+
+		CGhostItem() : m_ID(-1), m_pReader(0) {}
 
 		bool operator==(const CGhostItem &Other) { return m_ID == Other.m_ID; }
 	};
@@ -65,6 +43,10 @@ private:
 
 	void AddInfos(CGhostCharacter Player);
 
+	int NumSamples(const CGhostItem *pGhost) const;
+	bool GetSample(CGhostItem *pGhost, int Index, CGhostCharacter *pSample);
+	void FreeGhost(CGhostItem *pGhost);
+
 	CGhostCharacter GetGhostCharacter(CNetObj_Character Char);
 
 	void StartRecord();
@@ -74,7 +56,7 @@ private:
 	void RenderGhost(CGhostCharacter Player, CGhostCharacter Prev, CNetObj_ClientInfo Info);
 	void RenderGhostHook(CGhostCharacter Player, CGhostCharacter Prev);
 
-	bool GetHeader(IOHANDLE *pFile, CGhostHeader *pHeader);
+	bool CheckHeader(const CGhostHeader *pHeader);
 
 	void Save();
 
@@ -1,5 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+
 #include <engine/graphics.h>
 #include <engine/map.h>
 #include <engine/storage.h>
@@ -8,6 +10,43 @@
 
 #include "mapimages.h"
 
+// images that are only drawn by quads with texture coordinates inside the
+// image never repeat, so they can share an atlas page
+static void FindAtlasImages(IMap *pMap, bool *pAtlas, int NumImages)
+{
+	for(int i = 0; i < NumImages; i++)
+		pAtlas[i] = true;
+
+	int Start, Num;
+	pMap->GetType(MAPITEMTYPE_LAYER, &Start, &Num);
+	for(int l = 0; l < Num; l++)
+	{
+		CMapItemLayer *pLayer = (CMapItemLayer *)pMap->GetItem(Start+l, 0, 0);
+		if(pLayer->m_Type == LAYERTYPE_TILES)
+		{
+			CMapItemLayerTilemap *pTMap = (CMapItemLayerTilemap *)pLayer;
+			if(pTMap->m_Image >= 0 && pTMap->m_Image < NumImages)
+				pAtlas[pTMap->m_Image] = false;
+		}
+		else if(pLayer->m_Type == LAYERTYPE_QUADS)
+		{
+			CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
+			if(pQLayer->m_Image < 0 || pQLayer->m_Image >= NumImages || !pAtlas[pQLayer->m_Image])
+				continue;
+
+			CQuad *pQuads = (CQuad *)pMap->GetDataSwapped(pQLayer->m_Data);
+			for(int q = 0; pQuads && q < pQLayer->m_NumQuads; q++)
+				for(int c = 0; c < 4; c++)
+				{
+					int u = pQuads[q].m_aTexcoords[c].x;
+					int v = pQuads[q].m_aTexcoords[c].y;
+					if(u < 0 || u > 1024 || v < 0 || v > 1024)
+						pAtlas[pQLayer->m_Image] = false;
+				}
+		}
+	}
+}
+
 CMapImages::CMapImages()
 {
 	m_Count = 0;
@@ -29,10 +68,15 @@ void CMapImages::OnMapLoad()
 	int Start;
 	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &m_Count);
 
+	bool aAtlas[64];
+	FindAtlasImages(pMap, aAtlas, min(m_Count, 64));
+
 	// load new textures
+	Graphics()->AtlasBegin();
 	for(int i = 0; i < m_Count; i++)
 	{
 		m_aTextures[i] = 0;
+		int Flags = i < 64 && aAtlas[i] ? IGraphics::TEXLOAD_ATLAS : 0;
 
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
 		if(pImg->m_External)
@@ -40,15 +84,16 @@ void CMapImages::OnMapLoad()
 			char Buf[256];
 			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
 			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, Flags);
 		}
 		else
 		{
 			void *pData = pMap->GetData(pImg->m_ImageData);
-			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, 0);
+			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, Flags);
 			pMap->UnloadData(pImg->m_ImageData);
 		}
 	}
+	Graphics()->AtlasEnd();
 }
 
 void CMapImages::LoadBackground(class IMap *pMap)
@@ -64,10 +109,15 @@ void CMapImages::LoadBackground(class IMap *pMap)
 	int Start;
 	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &m_Count);
 
+	bool aAtlas[64];
+	FindAtlasImages(pMap, aAtlas, min(m_Count, 64));
+
 	// load new textures
+	Graphics()->AtlasBegin();
 	for(int i = 0; i < m_Count; i++)
 	{
 		m_aTextures[i] = 0;
+		int Flags = i < 64 && aAtlas[i] ? IGraphics::TEXLOAD_ATLAS : 0;
 
 		CMapItemImage *pImg = (CMapItemImage *)pMap->GetItem(Start+i, 0, 0);
 		if(pImg->m_External)
@@ -75,15 +125,16 @@ void CMapImages::LoadBackground(class IMap *pMap)
 			char Buf[256];
 			char *pName = (char *)pMap->GetData(pImg->m_ImageName);
 			str_format(Buf, sizeof(Buf), "mapres/%s.png", pName);
-			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+			m_aTextures[i] = Graphics()->LoadTexture(Buf, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, Flags);
 		}
 		else
 		{
 			void *pData = pMap->GetData(pImg->m_ImageData);
-			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, 0);
+			m_aTextures[i] = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData, CImageInfo::FORMAT_RGBA, Flags);
 			pMap->UnloadData(pImg->m_ImageData);
 		}
 	}
+	Graphics()->AtlasEnd();
 }
 
 int CMapImages::GetEntities()
@@ -25,6 +25,19 @@ CMapLayers::CMapLayers(int t)
 	m_CurrentLocalTick = 0;
 	m_LastLocalTick = 0;
 	m_EnvelopeUpdate = false;
+	m_pTileChunks = 0;
+	m_NumTileChunks = 0;
+	m_pPreparedQuads = 0;
+	m_pPreparedQuadsStart = 0;
+	for(int i = 0; i < ENVELOPE_CACHE_SIZE; i++)
+		m_aEnvelopeCache[i].m_Env = -1;
+}
+
+CMapLayers::~CMapLayers()
+{
+	delete [] m_pTileChunks;
+	delete [] m_pPreparedQuads;
+	delete [] m_pPreparedQuadsStart;
 }
 
 void CMapLayers::OnInit()
@@ -32,6 +45,121 @@ void CMapLayers::OnInit()
 	m_pLayers = Layers();
 }
 
+void CMapLayers::OnMapLoad()
+{
+	delete [] m_pTileChunks;
+	m_pTileChunks = 0;
+	delete [] m_pPreparedQuads;
+	m_pPreparedQuads = 0;
+	delete [] m_pPreparedQuadsStart;
+	m_pPreparedQuadsStart = 0;
+	for(int i = 0; i < ENVELOPE_CACHE_SIZE; i++)
+		m_aEnvelopeCache[i].m_Env = -1;
+
+	m_NumTileChunks = m_pLayers->NumLayers();
+	if(m_NumTileChunks <= 0)
+		return;
+	m_pTileChunks = new CTileChunks[m_NumTileChunks];
+	m_pPreparedQuadsStart = new int[m_NumTileChunks];
+
+	for(int i = 0; i < m_NumTileChunks; i++)
+		m_pPreparedQuadsStart[i] = -1;
+
+	int NumQuads = 0;
+	bool PassedGameLayer = false;
+	for(int g = 0; g < m_pLayers->NumGroups(); g++)
+	{
+		CMapItemGroup *pGroup = m_pLayers->GetGroup(g);
+		if(!pGroup)
+			continue;
+
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			CMapItemLayer *pLayer = m_pLayers->GetLayer(pGroup->m_StartLayer+l);
+			if(pLayer == (CMapItemLayer*)m_pLayers->GameLayer())
+				PassedGameLayer = true;
+
+			// only the layers this pass is going to draw
+			if((m_Type == TYPE_BACKGROUND && PassedGameLayer) || (m_Type == TYPE_FOREGROUND && !PassedGameLayer))
+				continue;
+			if(pLayer->m_Type == LAYERTYPE_QUADS)
+			{
+				m_pPreparedQuadsStart[pGroup->m_StartLayer+l] = NumQuads;
+				NumQuads += ((CMapItemLayerQuads *)pLayer)->m_NumQuads;
+			}
+			if(pLayer->m_Type != LAYERTYPE_TILES)
+				continue;
+
+			CMapItemLayerTilemap *pTMap = (CMapItemLayerTilemap *)pLayer;
+			int Data = pTMap->m_Data;
+			int Source = CTileChunks::SOURCE_TILES;
+			unsigned TileSize = sizeof(CTile);
+			if(pLayer == (CMapItemLayer*)m_pLayers->FrontLayer())
+				Data = pTMap->m_Front;
+			else if(pLayer == (CMapItemLayer*)m_pLayers->TeleLayer())
+			{
+				Data = pTMap->m_Tele;
+				Source = CTileChunks::SOURCE_TELE;
+				TileSize = sizeof(CTeleTile);
+			}
+			else if(pLayer == (CMapItemLayer*)m_pLayers->SpeedupLayer())
+			{
+				Data = pTMap->m_Speedup;
+				Source = CTileChunks::SOURCE_SPEEDUP;
+				TileSize = sizeof(CSpeedupTile);
+			}
+			else if(pLayer == (CMapItemLayer*)m_pLayers->SwitchLayer())
+			{
+				Data = pTMap->m_Switch;
+				Source = CTileChunks::SOURCE_SWITCH;
+				TileSize = sizeof(CSwitchTile);
+			}
+			else if(pLayer == (CMapItemLayer*)m_pLayers->TuneLayer())
+			{
+				Data = pTMap->m_Tune;
+				Source = CTileChunks::SOURCE_TUNE;
+				TileSize = sizeof(CTuneTile);
+			}
+
+			void *pData = m_pLayers->Map()->GetData(Data);
+			unsigned int Size = m_pLayers->Map()->GetUncompressedDataSize(Data);
+			if(pData && Size >= pTMap->m_Width*pTMap->m_Height*TileSize)
+				m_pTileChunks[pGroup->m_StartLayer+l].Init(pData, Source, pTMap->m_Width, pTMap->m_Height);
+		}
+	}
+
+	// quads without envelopes never change, they are converted once here
+	if(NumQuads > 0)
+	{
+		m_pPreparedQuads = new IGraphics::CPreparedQuadItem[NumQuads];
+		for(int i = 0; i < m_NumTileChunks; i++)
+		{
+			if(m_pPreparedQuadsStart[i] < 0)
+				continue;
+			CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)m_pLayers->GetLayer(i);
+			CQuad *pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
+			if(pQuads)
+				RenderTools()->PrepareQuads(pQuads, pQLayer->m_NumQuads, &m_pPreparedQuads[m_pPreparedQuadsStart[i]]);
+			else
+				m_pPreparedQuadsStart[i] = -1;
+		}
+	}
+}
+
+CTileChunks *CMapLayers::TileChunks(int Layer)
+{
+	if(!g_Config.m_GfxTileChunks || Layer < 0 || Layer >= m_NumTileChunks || !m_pTileChunks[Layer].IsValid())
+		return 0;
+	return &m_pTileChunks[Layer];
+}
+
+const IGraphics::CPreparedQuadItem *CMapLayers::PreparedQuads(int Layer)
+{
+	if(Layer < 0 || Layer >= m_NumTileChunks || !m_pPreparedQuadsStart || m_pPreparedQuadsStart[Layer] < 0)
+		return 0;
+	return &m_pPreparedQuads[m_pPreparedQuadsStart[Layer]];
+}
+
 void CMapLayers::EnvelopeUpdate()
 {
 	if(Client()->State() == IClient::STATE_DEMOPLAYBACK)
@@ -55,6 +183,41 @@ void CMapLayers::MapScreenToGroup(float CenterX, float CenterY, CMapItemGroup *p
 void CMapLayers::EnvelopeEval(float TimeOffset, int Env, float *pChannels, void *pUser)
 {
 	CMapLayers *pThis = (CMapLayers *)pUser;
+
+	// quads and layers sharing an envelope and offset get the same result
+	// within a frame, the time only moves on between frames
+	float LocalTime = pThis->Client()->LocalTime();
+	unsigned Bits;
+	mem_copy(&Bits, &TimeOffset, sizeof(Bits));
+	unsigned Hash = (unsigned)Env*2654435761u ^ Bits*40503u;
+	CEnvelopeCacheEntry *pFree = 0;
+	for(int i = 0; i < ENVELOPE_CACHE_PROBES; i++)
+	{
+		CEnvelopeCacheEntry *pEntry = &pThis->m_aEnvelopeCache[(Hash+i)%ENVELOPE_CACHE_SIZE];
+		if(pEntry->m_Env == -1 || pEntry->m_LocalTime != LocalTime)
+		{
+			if(!pFree)
+				pFree = pEntry;
+		}
+		else if(pEntry->m_Env == Env && pEntry->m_TimeOffset == TimeOffset)
+		{
+			mem_copy(pChannels, pEntry->m_aChannels, sizeof(pEntry->m_aChannels));
+			return;
+		}
+	}
+
+	pThis->EnvelopeEvalImpl(TimeOffset, Env, pChannels);
+	if(pFree)
+	{
+		pFree->m_LocalTime = LocalTime;
+		pFree->m_Env = Env;
+		pFree->m_TimeOffset = TimeOffset;
+		mem_copy(pFree->m_aChannels, pChannels, sizeof(pFree->m_aChannels));
+	}
+}
+
+void CMapLayers::EnvelopeEvalImpl(float TimeOffset, int Env, float *pChannels)
+{
 	pChannels[0] = 0;
 	pChannels[1] = 0;
 	pChannels[2] = 0;
@@ -64,55 +227,55 @@ void CMapLayers::EnvelopeEval(float TimeOffset, int Env, float *pChannels, void
 
 	{
 		int Start, Num;
-		pThis->m_pLayers->Map()->GetType(MAPITEMTYPE_ENVPOINTS, &Start, &Num);
+		m_pLayers->Map()->GetType(MAPITEMTYPE_ENVPOINTS, &Start, &Num);
 		if(Num)
-			pPoints = (CEnvPoint *)pThis->m_pLayers->Map()->GetItem(Start, 0, 0);
+			pPoints = (CEnvPoint *)m_pLayers->Map()->GetItem(Start, 0, 0);
 	}
 
 	int Start, Num;
-	pThis->m_pLayers->Map()->GetType(MAPITEMTYPE_ENVELOPE, &Start, &Num);
+	m_pLayers->Map()->GetType(MAPITEMTYPE_ENVELOPE, &Start, &Num);
 
 	if(Env >= Num)
 		return;
 
-	CMapItemEnvelope *pItem = (CMapItemEnvelope *)pThis->m_pLayers->Map()->GetItem(Start+Env, 0, 0);
+	CMapItemEnvelope *pItem = (CMapItemEnvelope *)m_pLayers->Map()->GetItem(Start+Env, 0, 0);
 
 	static float s_Time = 0.0f;
-	static float s_LastLocalTime = pThis->Client()->LocalTime();
-	if(pThis->Client()->State() == IClient::STATE_DEMOPLAYBACK)
+	static float s_LastLocalTime = Client()->LocalTime();
+	if(Client()->State() == IClient::STATE_DEMOPLAYBACK)
 	{
-		const IDemoPlayer::CInfo *pInfo = pThis->DemoPlayer()->BaseInfo();
+		const IDemoPlayer::CInfo *pInfo = DemoPlayer()->BaseInfo();
 
-		if(!pInfo->m_Paused || pThis->m_EnvelopeUpdate)
+		if(!pInfo->m_Paused || m_EnvelopeUpdate)
 		{
-			if(pThis->m_CurrentLocalTick != pInfo->m_CurrentTick)
+			if(m_CurrentLocalTick != pInfo->m_CurrentTick)
 			{
-				pThis->m_LastLocalTick = pThis->m_CurrentLocalTick;
-				pThis->m_CurrentLocalTick = pInfo->m_CurrentTick;
+				m_LastLocalTick = m_CurrentLocalTick;
+				m_CurrentLocalTick = pInfo->m_CurrentTick;
 			}
 
-			s_Time = mix(pThis->m_LastLocalTick / (float)pThis->Client()->GameTickSpeed(),
-						pThis->m_CurrentLocalTick / (float)pThis->Client()->GameTickSpeed(),
-						pThis->Client()->IntraGameTick());
+			s_Time = mix(m_LastLocalTick / (float)Client()->GameTickSpeed(),
+						m_CurrentLocalTick / (float)Client()->GameTickSpeed(),
+						Client()->IntraGameTick());
 		}
 
-		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
+		RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
 	}
 	else
 	{
-		if(pThis->m_pClient->m_Snap.m_pGameInfoObj) // && !(pThis->m_pClient->m_Snap.m_pGameInfoObj->m_GameStateFlags&GAMESTATEFLAG_PAUSED))
+		if(m_pClient->m_Snap.m_pGameInfoObj) // && !(m_pClient->m_Snap.m_pGameInfoObj->m_GameStateFlags&GAMESTATEFLAG_PAUSED))
 		{
 			if(pItem->m_Version < 2 || pItem->m_Synchronized)
 			{
-				s_Time = mix((pThis->Client()->PrevGameTick()-pThis->m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)pThis->Client()->GameTickSpeed(),
-							(pThis->Client()->GameTick()-pThis->m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)pThis->Client()->GameTickSpeed(),
-							pThis->Client()->IntraGameTick());
+				s_Time = mix((Client()->PrevGameTick()-m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)Client()->GameTickSpeed(),
+							(Client()->GameTick()-m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)Client()->GameTickSpeed(),
+							Client()->IntraGameTick());
 			}
 			else
-				s_Time += pThis->Client()->LocalTime()-s_LastLocalTime;
+				s_Time += Client()->LocalTime()-s_LastLocalTime;
 		}
-		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
-		s_LastLocalTime = pThis->Client()->LocalTime();
+		RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
+		s_LastLocalTime = Client()->LocalTime();
 	}
 }
 
@@ -163,6 +326,7 @@ void CMapLayers::OnRender()
 		for(int l = 0; l < pGroup->m_NumLayers; l++)
 		{
 			CMapItemLayer *pLayer = m_pLayers->GetLayer(pGroup->m_StartLayer+l);
+			CTileChunks *pChunks = TileChunks(pGroup->m_StartLayer+l);
 			bool Render = false;
 			bool IsGameLayer = false;
 			bool IsFrontLayer = false;
@@ -257,11 +421,22 @@ void CMapLayers::OnRender()
 							Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
 						if(!IsGameLayer && g_Config.m_ClOverlayEntities)
 							Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*(100-g_Config.m_ClOverlayEntities)/100.0f);
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
-														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
-						Graphics()->BlendNormal();
-						RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
-														EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+						if(pChunks)
+						{
+							RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+															EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+							Graphics()->BlendNormal();
+							RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+															EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+						}
+						else
+						{
+							RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+															EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+							Graphics()->BlendNormal();
+							RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+															EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+						}
 					}
 				}
 				else if(pLayer->m_Type == LAYERTYPE_QUADS)
@@ -274,10 +449,12 @@ void CMapLayers::OnRender()
 
 					CQuad *pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
 
+					const IGraphics::CPreparedQuadItem *pPrepared = PreparedQuads(pGroup->m_StartLayer+l);
+
 					Graphics()->BlendNone();
-					RenderTools()->RenderQuads(pQuads, pQLayer->m_NumQuads, LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this);
+					RenderTools()->RenderQuads(pQuads, pQLayer->m_NumQuads, LAYERRENDERFLAG_OPAQUE, EnvelopeEval, this, pPrepared);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderQuads(pQuads, pQLayer->m_NumQuads, LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this);
+					RenderTools()->RenderQuads(pQuads, pQLayer->m_NumQuads, LAYERRENDERFLAG_TRANSPARENT, EnvelopeEval, this, pPrepared);
 				}
 			}
 			else if(Render && g_Config.m_ClOverlayEntities && IsFrontLayer)
@@ -292,11 +469,22 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
-							EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
-					Graphics()->BlendNormal();
-					RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
-							EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+					if(pChunks)
+					{
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+								EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+								EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+					}
+					else
+					{
+						RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+								EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTilemap(pFrontTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+								EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
+					}
 				}
 			}
 			else if(Render && g_Config.m_ClOverlayEntities && IsSwitchLayer)
@@ -311,10 +499,19 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
-					Graphics()->BlendNormal();
-					RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
-					RenderTools()->RenderSwitchOverlay(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
+					if(pChunks)
+					{
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					else
+					{
+						RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderSwitchmap(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					RenderTools()->RenderSwitchOverlay(pSwitchTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f, pChunks);
 				}
 			}
 			else if(Render && g_Config.m_ClOverlayEntities && IsTeleLayer)
@@ -329,10 +526,19 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
-					Graphics()->BlendNormal();
-					RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
-					RenderTools()->RenderTeleOverlay(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
+					if(pChunks)
+					{
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					else
+					{
+						RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTelemap(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					RenderTools()->RenderTeleOverlay(pTeleTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f, pChunks);
 				}
 			}
 			else if(Render && g_Config.m_ClOverlayEntities && IsSpeedupLayer)
@@ -347,10 +553,19 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
-					Graphics()->BlendNormal();
-					RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
-					RenderTools()->RenderSpeedupOverlay(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
+					if(pChunks)
+					{
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					else
+					{
+						RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderSpeedupmap(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					RenderTools()->RenderSpeedupOverlay(pSpeedupTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f, pChunks);
 				}
 			}
 			else if(Render && g_Config.m_ClOverlayEntities && IsTuneLayer)
@@ -365,10 +580,19 @@ void CMapLayers::OnRender()
 				{
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f*g_Config.m_ClOverlayEntities/100.0f);
-					RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
-					Graphics()->BlendNormal();
-					RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
-					//RenderTools()->RenderTuneOverlay(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f);
+					if(pChunks)
+					{
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTileChunks(pChunks, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					else
+					{
+						RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE);
+						Graphics()->BlendNormal();
+						RenderTools()->RenderTunemap(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT);
+					}
+					//RenderTools()->RenderTuneOverlay(pTuneTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, g_Config.m_ClOverlayEntities/100.0f, pChunks);
 				}
 			}
 		}
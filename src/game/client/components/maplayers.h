@@ -14,6 +14,31 @@ class CMapLayers : public CComponent
 	int m_LastLocalTick;
 	bool m_EnvelopeUpdate;
 
+	class CTileChunks *m_pTileChunks; // one per map layer, only tile layers this pass renders are set up
+	int m_NumTileChunks;
+
+	// every quad of the quad layers this pass renders, m_pPreparedQuadsStart has the first one of each layer
+	IGraphics::CPreparedQuadItem *m_pPreparedQuads;
+	int *m_pPreparedQuadsStart;
+
+	// envelope results of the current frame, by envelope and time offset
+	enum
+	{
+		ENVELOPE_CACHE_SIZE=256,
+		ENVELOPE_CACHE_PROBES=8,
+	};
+	struct CEnvelopeCacheEntry
+	{
+		float m_LocalTime;
+		int m_Env;
+		float m_TimeOffset;
+		float m_aChannels[4];
+	};
+	CEnvelopeCacheEntry m_aEnvelopeCache[ENVELOPE_CACHE_SIZE];
+
+	class CTileChunks *TileChunks(int Layer);
+	const IGraphics::CPreparedQuadItem *PreparedQuads(int Layer);
+	void EnvelopeEvalImpl(float TimeOffset, int Env, float *pChannels);
 	void MapScreenToGroup(float CenterX, float CenterY, CMapItemGroup *pGroup, float Zoom = 1.0f);
 public:
 	enum
@@ -23,7 +48,9 @@ public:
 	};
 
 	CMapLayers(int Type);
+	~CMapLayers();
 	virtual void OnInit();
+	virtual void OnMapLoad();
 	virtual void OnRender();
 
 	void EnvelopeUpdate();
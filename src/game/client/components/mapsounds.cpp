@@ -83,6 +83,10 @@ void CMapSounds::OnMapLoad()
 					if(!source.m_pSource || source.m_Sound == -1)
 						continue;
 
+					// sources without a delay start playing right away
+					if(source.m_pSource->m_TimeDelay <= 0 && source.m_Sound < m_Count)
+						Sound()->Predecode(m_aSounds[source.m_Sound]);
+
 					m_lSourceQueue.add(source);
 				}
 			}
@@ -1428,6 +1428,7 @@ int CMenus::Render()
 				{
 					char aBuf[512];
 					str_format(aBuf, sizeof(aBuf), "%s/%s", m_aCurrentDemoFolder, m_lDemos[m_DemolistSelectedIndex].m_aFilename);
+					DemoPlayer()->RemoveIndex(Storage(), aBuf, m_lDemos[m_DemolistSelectedIndex].m_StorageType);
 					if(Storage()->RemoveFile(aBuf, m_lDemos[m_DemolistSelectedIndex].m_StorageType))
 					{
 						DemolistPopulate();
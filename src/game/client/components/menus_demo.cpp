@@ -1109,6 +1109,8 @@ void CMenus::RenderDemoList(CUIRect MainView)
 	static int s_RefreshButton = 0;
 	if(DoButton_Menu(&s_RefreshButton, Localize("Refresh"), 0, &RefreshRect))
 	{
+		// demos rewritten in place don't touch the folder, read it again
+		Storage()->RefreshDirectory(m_DemolistStorageType, m_aCurrentDemoFolder);
 		DemolistPopulate();
 		DemolistOnUpdate(false);
 	}
@@ -861,7 +861,7 @@ int CMenus::GhostlistFetchCallback(const char *pName, int IsDir, int StorageType
 		(!IsDir && (Length < 4 || str_comp(pName+Length-4, ".gho"))))
 		return 0;
 
-	CGhost::CGhostHeader Header;
+	CGhostHeader Header;
 	if(!pSelf->m_pClient->m_pGhost->GetInfo(pName, &Header))
 		return 0;
 
@@ -3,14 +3,36 @@
 #include <base/math.h>
 #include <engine/graphics.h>
 #include <engine/demo.h>
+#include <engine/shared/config.h>
 
 #include <game/generated/client_data.h>
 #include <game/client/render.h>
+#include <game/client/components/camera.h>
 #include <game/gamecore.h>
 #include "particles.h"
 
+#include <math.h> // cosf, sinf
+
 CParticles::CParticles()
 {
+	// trails and general effects get most of the room. an explosion or a
+	// hammer hit adds a single particle, trails and smoke are added along
+	// every projectile and player. the 32 bot bench session peaks at 1406
+	// general and 5 explosion particles, far below their 4096 and 1024
+	static const int s_aCapacity[NUM_GROUPS] = {MAX_PARTICLES*3/8, MAX_PARTICLES/8, MAX_PARTICLES/2};
+	int Start = 0;
+	for(int g = 0; g < NUM_GROUPS; g++)
+	{
+		m_aGroups[g].m_Capacity = s_aCapacity[g];
+		for(int f = 0; f < NUM_FIELDS; f++)
+			m_aGroups[g].m_apFields[f] = &m_aData[f*MAX_PARTICLES + Start];
+		Start += s_aCapacity[g];
+	}
+
+	m_BenchUpdateTime = 0;
+	m_BenchRenderTime = 0;
+	m_BenchFrames = 0;
+
 	OnReset();
 	m_RenderTrail.m_pParts = this;
 	m_RenderExplosions.m_pParts = this;
@@ -21,18 +43,8 @@ CParticles::CParticles()
 void CParticles::OnReset()
 {
 	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
-	{
-		m_aParticles[i].m_PrevPart = i-1;
-		m_aParticles[i].m_NextPart = i+1;
-	}
-
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES-1].m_NextPart = -1;
-	m_FirstFree = 0;
-
 	for(int i = 0; i < NUM_GROUPS; i++)
-		m_aFirstPart[i] = -1;
+		m_aGroups[i].m_Num = 0;
 }
 
 void CParticles::Add(int Group, CParticle *pPart)
@@ -49,27 +61,99 @@ void CParticles::Add(int Group, CParticle *pPart)
 			return;
 	}
 
-	if (m_FirstFree == -1)
+	CGroup *pGroup = &m_aGroups[Group];
+	if(pGroup->m_Num == pGroup->m_Capacity)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
+	// the subset SelectSprite would set, looked up once instead of every frame
+	float aUV[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+	if(pPart->m_Spr >= 0 && pPart->m_Spr < g_pData->m_NumSprites)
+	{
+		const CDataSprite *pSpr = &g_pData->m_aSprites[pPart->m_Spr];
+		aUV[0] = pSpr->m_X/(float)pSpr->m_pSet->m_Gridx;
+		aUV[1] = pSpr->m_Y/(float)pSpr->m_pSet->m_Gridy;
+		aUV[2] = (pSpr->m_X+pSpr->m_W)/(float)pSpr->m_pSet->m_Gridx;
+		aUV[3] = (pSpr->m_Y+pSpr->m_H)/(float)pSpr->m_pSet->m_Gridy;
+	}
+
+	int i = pGroup->m_Num++;
+	float **ppF = pGroup->m_apFields;
+	ppF[FIELD_POS_X][i] = pPart->m_Pos.x;
+	ppF[FIELD_POS_Y][i] = pPart->m_Pos.y;
+	ppF[FIELD_VEL_X][i] = pPart->m_Vel.x;
+	ppF[FIELD_VEL_Y][i] = pPart->m_Vel.y;
+	ppF[FIELD_LIFE][i] = 0;
+	ppF[FIELD_LIFESPAN][i] = pPart->m_LifeSpan;
+	ppF[FIELD_START_SIZE][i] = pPart->m_StartSize;
+	ppF[FIELD_END_SIZE][i] = pPart->m_EndSize;
+	ppF[FIELD_ROT][i] = pPart->m_Rot;
+	ppF[FIELD_ROTSPEED][i] = pPart->m_Rotspeed;
+	ppF[FIELD_GRAVITY][i] = pPart->m_Gravity;
+	ppF[FIELD_FRICTION][i] = pPart->m_Friction;
+	ppF[FIELD_COLOR_R][i] = pPart->m_Color.r;
+	ppF[FIELD_COLOR_G][i] = pPart->m_Color.g;
+	ppF[FIELD_COLOR_B][i] = pPart->m_Color.b;
+	ppF[FIELD_COLOR_A][i] = pPart->m_Color.a;
+	ppF[FIELD_U0][i] = aUV[0];
+	ppF[FIELD_V0][i] = aUV[1];
+	ppF[FIELD_U1][i] = aUV[2];
+	ppF[FIELD_V1][i] = aUV[3];
+}
+
+void CParticles::UpdateGroup(CGroup *pGroup, float TimePassed, int FrictionCount)
+{
+	int Num = pGroup->m_Num;
+	float **ppF = pGroup->m_apFields;
+	float *pPosX = ppF[FIELD_POS_X], *pPosY = ppF[FIELD_POS_Y];
+	float *pVelX = ppF[FIELD_VEL_X], *pVelY = ppF[FIELD_VEL_Y];
+	float *pLife = ppF[FIELD_LIFE], *pLifeSpan = ppF[FIELD_LIFESPAN];
+	float *pRot = ppF[FIELD_ROT], *pRotspeed = ppF[FIELD_ROTSPEED];
+	float *pGravity = ppF[FIELD_GRAVITY], *pFriction = ppF[FIELD_FRICTION];
+
+	// everything but the collision runs as plain loops over the arrays
+	for(int i = 0; i < Num; i++)
+		pVelY[i] += pGravity[i]*TimePassed;
+
+	for(int f = 0; f < FrictionCount; f++) // apply friction
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			pVelX[i] *= pFriction[i];
+			pVelY[i] *= pFriction[i];
+		}
+	}
 
-	// copy data
-	m_aParticles[Id] = *pPart;
+	for(int i = 0; i < Num; i++)
+	{
+		pLife[i] += TimePassed;
+		pRot[i] += TimePassed * pRotspeed[i];
+	}
 
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
+	// move the points
+	for(int i = 0; i < Num; i++)
+	{
+		vec2 Pos(pPosX[i], pPosY[i]);
+		vec2 Vel(pVelX[i]*TimePassed, pVelY[i]*TimePassed);
+		Collision()->MovePoint(&Pos, &Vel, 0.1f+0.9f*frandom(), NULL);
+		pPosX[i] = Pos.x;
+		pPosY[i] = Pos.y;
+		pVelX[i] = Vel.x * (1.0f/TimePassed);
+		pVelY[i] = Vel.y * (1.0f/TimePassed);
+	}
 
-	// set some parameters
-	m_aParticles[Id].m_Life = 0;
+	// check particle death, the last particle moves into the free slot
+	for(int i = 0; i < Num; )
+	{
+		if(pLife[i] > pLifeSpan[i])
+		{
+			Num--;
+			for(int f = 0; f < NUM_FIELDS; f++)
+				ppF[f][i] = ppF[f][Num];
+		}
+		else
+			i++;
+	}
+	pGroup->m_Num = Num;
 }
 
 void CParticles::Update(float TimePassed)
@@ -87,47 +171,37 @@ void CParticles::Update(float TimePassed)
 		FrictionFraction -= 0.05f;
 	}
 
+	for(int g = 0; g < NUM_GROUPS; g++)
+		UpdateGroup(&m_aGroups[g], TimePassed, FrictionCount);
+}
+
+void CParticles::FillBenchmark()
+{
+	// keeps every group at its share of dbg_bench_particles, spread around the camera
+	static const int s_aSprites[] = {SPRITE_PART_SMOKE, SPRITE_PART_BALL, SPRITE_PART_SPLAT01};
+	vec2 Center = m_pClient->m_pCamera->m_Center;
 	for(int g = 0; g < NUM_GROUPS; g++)
 	{
-		int i = m_aFirstPart[g];
-		while(i != -1)
+		int Wanted = min(m_aGroups[g].m_Capacity, g_Config.m_DbgBenchParticles*m_aGroups[g].m_Capacity/MAX_PARTICLES);
+		while(m_aGroups[g].m_Num < Wanted)
 		{
-			int Next = m_aParticles[i].m_NextPart;
-			//m_aParticles[i].vel += flow_get(m_aParticles[i].pos)*time_passed * m_aParticles[i].flow_affected;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity*TimePassed;
-
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
-
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel*TimePassed;
-			Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, 0.1f+0.9f*frandom(), NULL);
-			m_aParticles[i].m_Vel = Vel* (1.0f/TimePassed);
-
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
-
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					m_aFirstPart[g] = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
-
-			i = Next;
+			CParticle p;
+			p.SetDefault();
+			p.m_Spr = s_aSprites[m_aGroups[g].m_Num%3];
+			p.m_Pos = Center + vec2(frandom()-0.5f, frandom()-0.5f)*600.0f;
+			p.m_Vel = GetDir(frandom()*pi*2)*(50.0f+frandom()*200.0f);
+			p.m_LifeSpan = 0.5f + frandom();
+			p.m_StartSize = 12.0f + frandom()*20.0f;
+			p.m_EndSize = 0;
+			p.m_Rot = frandom()*pi*2;
+			p.m_Rotspeed = pi*2;
+			p.m_Gravity = 500.0f;
+			p.m_Friction = 0.9f;
+			p.m_Color = vec4(1.0f, frandom(), frandom(), 0.75f);
+			int Num = m_aGroups[g].m_Num;
+			Add(g, &p);
+			if(m_aGroups[g].m_Num == Num)
+				break;
 		}
 	}
 }
@@ -137,6 +211,9 @@ void CParticles::OnRender()
 	if(Client()->State() < IClient::STATE_ONLINE)
 		return;
 
+	if(g_Config.m_DbgBenchParticles)
+		FillBenchmark();
+
 	static int64 LastTime = 0;
 	int64 t = time_get();
 
@@ -153,36 +230,88 @@ void CParticles::OnRender()
 	}
 
 	LastTime = t;
+
+	if(g_Config.m_DbgBenchParticles)
+	{
+		m_BenchUpdateTime += time_get()-t;
+		if(++m_BenchFrames == 100)
+		{
+			int Num = 0;
+			for(int g = 0; g < NUM_GROUPS; g++)
+				Num += m_aGroups[g].m_Num;
+			float Scale = 1000000.0f/time_freq()/m_BenchFrames;
+			dbg_msg("bench", "particles %d alive, update %.1fus/frame, render %.1fus/frame",
+				Num, m_BenchUpdateTime*Scale, m_BenchRenderTime*Scale);
+			m_BenchUpdateTime = 0;
+			m_BenchRenderTime = 0;
+			m_BenchFrames = 0;
+		}
+	}
 }
 
 void CParticles::RenderGroup(int Group)
 {
+	int64 Start = time_get();
+	const CGroup *pGroup = &m_aGroups[Group];
+	float *const *ppF = pGroup->m_apFields;
+
 	Graphics()->BlendNormal();
 	//gfx_blend_additive();
 	Graphics()->TextureSet(g_pData->m_aImages[IMAGE_PARTICLES].m_Id);
 	Graphics()->QuadsBegin();
 
-	int i = m_aFirstPart[Group];
-	while(i != -1)
+	// corners are rotated here and handed over in batches, the
+	// graphics state stays the same for the whole group
+	IGraphics::CPreparedQuadItem aItems[RENDER_BATCH];
+	int NumItems = 0;
+	for(int i = pGroup->m_Num-1; i >= 0; i--) // newest first, as the old list did
 	{
-		RenderTools()->SelectSprite(m_aParticles[i].m_Spr);
-		float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-		vec2 p = m_aParticles[i].m_Pos;
-		float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
+		float a = ppF[FIELD_LIFE][i] / ppF[FIELD_LIFESPAN][i];
+		float Size = mix(ppF[FIELD_START_SIZE][i], ppF[FIELD_END_SIZE][i], a);
+		float x = ppF[FIELD_POS_X][i];
+		float y = ppF[FIELD_POS_Y][i];
+
+		// half diagonals, rotated
+		float c = Size/2, s = 0;
+		if(ppF[FIELD_ROT][i] != 0)
+		{
+			s = sinf(ppF[FIELD_ROT][i])*Size/2;
+			c = cosf(ppF[FIELD_ROT][i])*Size/2;
+		}
 
-		Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
+		IGraphics::CPreparedQuadItem *pItem = &aItems[NumItems++];
+		pItem->m_aX[0] = x - c + s; pItem->m_aY[0] = y - s - c;
+		pItem->m_aX[1] = x + c + s; pItem->m_aY[1] = y + s - c;
+		pItem->m_aX[2] = x + c - s; pItem->m_aY[2] = y + s + c;
+		pItem->m_aX[3] = x - c - s; pItem->m_aY[3] = y - s + c;
 
-		Graphics()->SetColor(
-			m_aParticles[i].m_Color.r,
-			m_aParticles[i].m_Color.g,
-			m_aParticles[i].m_Color.b,
-			m_aParticles[i].m_Color.a); // pow(a, 0.75f) *
+		float u0 = ppF[FIELD_U0][i], v0 = ppF[FIELD_V0][i];
+		float u1 = ppF[FIELD_U1][i], v1 = ppF[FIELD_V1][i];
+		pItem->m_aU[0] = u0; pItem->m_aV[0] = v0;
+		pItem->m_aU[1] = u1; pItem->m_aV[1] = v0;
+		pItem->m_aU[2] = u1; pItem->m_aV[2] = v1;
+		pItem->m_aU[3] = u0; pItem->m_aV[3] = v1;
 
-		IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
-		Graphics()->QuadsDraw(&QuadItem, 1);
+		for(int c = 0; c < 4; c++)
+		{
+			pItem->m_aColors[c][0] = ppF[FIELD_COLOR_R][i];
+			pItem->m_aColors[c][1] = ppF[FIELD_COLOR_G][i];
+			pItem->m_aColors[c][2] = ppF[FIELD_COLOR_B][i];
+			pItem->m_aColors[c][3] = ppF[FIELD_COLOR_A][i]; // pow(a, 0.75f) *
+		}
 
-		i = m_aParticles[i].m_NextPart;
+		if(NumItems == RENDER_BATCH)
+		{
+			Graphics()->QuadsDrawPrepared(aItems, NumItems);
+			NumItems = 0;
+		}
 	}
+	if(NumItems)
+		Graphics()->QuadsDrawPrepared(aItems, NumItems);
+
 	Graphics()->QuadsEnd();
 	Graphics()->BlendNormal();
+
+	if(g_Config.m_DbgBenchParticles)
+		m_BenchRenderTime += time_get()-Start;
 }
@@ -41,11 +41,6 @@ struct CParticle
 	float m_Friction;
 
 	vec4 m_Color;
-
-	// set by the particle system
-	float m_Life;
-	int m_PrevPart;
-	int m_NextPart;
 };
 
 class CParticles : public CComponent
@@ -69,15 +64,58 @@ public:
 
 private:
 
+	// the groups split MAX_PARTICLES into fixed shares (see the constructor),
+	// a full group drops new particles even while the others have room
 	enum
 	{
 		MAX_PARTICLES=1024*8,
+		RENDER_BATCH=64,
+	};
+
+	enum
+	{
+		FIELD_POS_X=0,
+		FIELD_POS_Y,
+		FIELD_VEL_X,
+		FIELD_VEL_Y,
+		FIELD_LIFE,
+		FIELD_LIFESPAN,
+		FIELD_START_SIZE,
+		FIELD_END_SIZE,
+		FIELD_ROT,
+		FIELD_ROTSPEED,
+		FIELD_GRAVITY,
+		FIELD_FRICTION,
+		FIELD_COLOR_R,
+		FIELD_COLOR_G,
+		FIELD_COLOR_B,
+		FIELD_COLOR_A,
+		FIELD_U0, // sprite subset
+		FIELD_V0,
+		FIELD_U1,
+		FIELD_V1,
+		NUM_FIELDS
 	};
 
-	CParticle m_aParticles[MAX_PARTICLES];
-	int m_FirstFree;
-	int m_aFirstPart[NUM_GROUPS];
+	// the particles of a group, one packed array per field. a dead particle
+	// is replaced by the last one of its group
+	struct CGroup
+	{
+		int m_Num;
+		int m_Capacity;
+		float *m_apFields[NUM_FIELDS];
+	};
+
+	float m_aData[NUM_FIELDS*MAX_PARTICLES];
+	CGroup m_aGroups[NUM_GROUPS];
+
+	// dbg_bench_particles
+	int64 m_BenchUpdateTime;
+	int64 m_BenchRenderTime;
+	int m_BenchFrames;
 
+	void UpdateGroup(CGroup *pGroup, float TimePassed, int FrictionCount);
+	void FillBenchmark();
 	void RenderGroup(int Group);
 	void Update(float TimePassed);
 
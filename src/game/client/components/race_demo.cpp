@@ -25,6 +25,7 @@ void CRaceDemo::Stop()
 
 	char aFilename[512];
 	str_format(aFilename, sizeof(aFilename), "demos/%s_tmp_%d.demo", m_pMap, pid());
+	DemoPlayer()->RemoveIndex(Storage(), aFilename, IStorage::TYPE_SAVE);
 	Storage()->RemoveFile(aFilename, IStorage::TYPE_SAVE);
 
 	m_Time = 0;
@@ -167,6 +168,7 @@ void CRaceDemo::CheckDemo()
 				// delete old demo
 				char aFilename[512];
 				str_format(aFilename, sizeof(aFilename), "demos/%s.demo", m_pClient->m_pMenus->m_lDemos[i].m_aName);
+				DemoPlayer()->RemoveIndex(Storage(), aFilename, IStorage::TYPE_SAVE);
 				Storage()->RemoveFile(aFilename, IStorage::TYPE_SAVE);
 			}
 
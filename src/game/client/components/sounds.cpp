@@ -105,7 +105,15 @@ void CSounds::OnReset()
 void CSounds::OnStateChange(int NewState, int OldState)
 {
 	if(NewState == IClient::STATE_ONLINE || NewState == IClient::STATE_DEMOPLAYBACK)
+	{
 		OnReset();
+
+		// sounds that are heard within the first seconds of every round
+		static const int s_aLikely[] = {SOUND_PLAYER_SPAWN, SOUND_PLAYER_JUMP, SOUND_PLAYER_AIRJUMP, SOUND_HOOK_LOOP,
+			SOUND_HOOK_ATTACH_GROUND, SOUND_HAMMER_FIRE, SOUND_GUN_FIRE, SOUND_BODY_LAND, SOUND_CHAT_SERVER};
+		for(unsigned i = 0; i < sizeof(s_aLikely)/sizeof(s_aLikely[0]); i++)
+			Predecode(s_aLikely[i]);
+	}
 }
 
 void CSounds::OnRender()
@@ -205,6 +213,17 @@ void CSounds::PlayAt(int Chn, int SetId, float Vol, vec2 Pos)
 	Sound()->PlayAt(Chn, SampleId, Flags, Pos.x, Pos.y);
 }
 
+void CSounds::Predecode(int SetId)
+{
+	if(m_WaitForSoundJob || SetId < 0 || SetId >= g_pData->m_NumSounds)
+		return;
+
+	CDataSoundset *pSet = &g_pData->m_aSounds[SetId];
+
+	for(int i = 0; i < pSet->m_NumSounds; i++)
+		Sound()->Predecode(pSet->m_aSounds[i].m_Id);
+}
+
 void CSounds::Stop(int SetId)
 {
 	if(m_WaitForSoundJob || SetId < 0 || SetId >= g_pData->m_NumSounds)
@@ -304,6 +304,9 @@ void CGameClient::OnInit()
 	if(!pDefaultFont)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load font. filename='%s'", pFontFile);
 
+	// skins and the sprite sheets share atlas pages
+	Graphics()->AtlasBegin();
+
 	// init all components
 	for(int i = m_All.m_Num-1; i >= 0; --i)
 		m_All.m_paComponents[i]->OnInit();
@@ -313,10 +316,15 @@ void CGameClient::OnInit()
 	// setup load amount// load textures
 	for(int i = 0; i < g_pData->m_NumImages; i++)
 	{
-		g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+		int Flags = 0;
+		if(i == IMAGE_GAME || i == IMAGE_PARTICLES || i == IMAGE_EMOTICONS)
+			Flags |= IGraphics::TEXLOAD_ATLAS;
+		g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, Flags);
 		g_GameClient.m_pMenus->RenderLoading();
 	}
 
+	Graphics()->AtlasEnd();
+
 #if defined(__ANDROID__)
 	m_pMapimages->OnMapLoad(); // Reload map textures on Android
 #endif
@@ -405,7 +413,9 @@ int CGameClient::OnSnapInput(int *pData)
 
 void CGameClient::OnConnected()
 {
+	int64 StartTime = time_get();
 	m_Layers.Init(Kernel());
+	m_Layers.PrefetchData(true);
 	m_Collision.Init(Layers());
 
 	RenderTools()->RenderTilemapGenerateSkip(Layers());
@@ -415,6 +425,9 @@ void CGameClient::OnConnected()
 		m_All.m_paComponents[i]->OnMapLoad();
 		m_All.m_paComponents[i]->OnReset();
 	}
+	// the datas needed later are few, they can come from the file again
+	Layers()->Map()->DropFileCopy();
+	dbg_msg("gameclient", "map ready for the first frame in %.2fms", (time_get()-StartTime)*1000.0f/time_freq());
 
 	CServerInfo CurrentServerInfo;
 	Client()->GetServerInfo(&CurrentServerInfo);
@@ -435,6 +448,9 @@ void CGameClient::OnReset()
 	m_LastNewPredictedTick[0] = -1;
 	m_LastNewPredictedTick[1] = -1;
 	mem_zero(&g_GameClient.m_Snap, sizeof(g_GameClient.m_Snap));
+	mem_zero(&m_PredictionKey, sizeof(m_PredictionKey));
+	InvalidatePrediction();
+	m_PredictionResimTicks = 0;
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_aClients[i].Reset();
@@ -1322,21 +1338,22 @@ void CGameClient::OnPredict()
 	if(AntiPingPlayers())
 		FindWeaker(IsWeaker);
 
-	// repredict character
-	CWorldCore World;
+	// repredict character, starting from the last tick that is still valid
+	int FirstTick = PredictionStartTick(IsWeaker[g_Config.m_ClDummy]);
+	m_PredictionResimTicks = max(Client()->PredGameTick() - FirstTick + 1, 0);
+
+	CWorldCore &World = m_PredictedWorld;
+	mem_zero(World.m_apCharacters, sizeof(World.m_apCharacters));
 	World.m_Tuning[g_Config.m_ClDummy] = m_Tuning[g_Config.m_ClDummy];
 
-	// search for players
+	CPredictedTick *pStart = PredictedTick(FirstTick-1);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(!m_Snap.m_aCharacters[i].m_Active || !m_Snap.m_paPlayerInfos[i])
+		if(!m_PredictionKey.m_aActive[i])
 			continue;
 
-		g_GameClient.m_aClients[i].m_Predicted.Init(&World, Collision(), &m_Teams);
+		g_GameClient.m_aClients[i].m_Predicted = pStart->m_aCharacters[i];
 		World.m_apCharacters[i] = &g_GameClient.m_aClients[i].m_Predicted;
-		World.m_apCharacters[i]->m_Id = m_Snap.m_paPlayerInfos[i]->m_ClientID;
-		g_GameClient.m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
-		g_GameClient.m_aClients[i].m_Predicted.m_ActiveWeapon = m_Snap.m_aCharacters[i].m_Cur.m_Weapon;
 	}
 
 	CServerInfo Info;
@@ -1397,21 +1414,8 @@ void CGameClient::OnPredict()
 	}
 
 	// predict
-	for(int Tick = Client()->GameTick()+1; Tick <= Client()->PredGameTick(); Tick++)
+	for(int Tick = FirstTick; Tick <= Client()->PredGameTick(); Tick++)
 	{
-		// fetch the local
-		if(Tick == Client()->PredGameTick() && World.m_apCharacters[m_Snap.m_LocalClientID])
-			m_PredictedPrevChar = *World.m_apCharacters[m_Snap.m_LocalClientID];
-
-		for(int c = 0; c < MAX_CLIENTS; c++)
-		{
-			if(!World.m_apCharacters[c])
-				continue;
-
-			if(AntiPingPlayers() && Tick == Client()->PredGameTick())
-				g_GameClient.m_aClients[c].m_PrevPredicted = *World.m_apCharacters[c];
-		}
-
 		// input
 		for(int c = 0; c < MAX_CLIENTS; c++)
 		{
@@ -1704,20 +1708,28 @@ void CGameClient::OnPredict()
 			}
 		}
 
+		// without room for all ticks only the two that are fetched below are kept
+		if(PredictionFits() || Tick >= Client()->PredGameTick()-1)
+			StorePredictedTick(Tick);
+	}
 
-		if(Tick == Client()->PredGameTick() && World.m_apCharacters[m_Snap.m_LocalClientID])
-		{
-			m_PredictedChar = *World.m_apCharacters[m_Snap.m_LocalClientID];
+	// fetch the local and, with antiping, everyone else from the cache
+	CPredictedTick *pPrev = PredictedTick(Client()->PredGameTick()-1);
+	CPredictedTick *pCur = PredictedTick(Client()->PredGameTick());
+	if(pPrev->m_Tick == Client()->PredGameTick()-1 && pCur->m_Tick == Client()->PredGameTick() && World.m_apCharacters[m_Snap.m_LocalClientID])
+	{
+		m_PredictedPrevChar = pPrev->m_aCharacters[m_Snap.m_LocalClientID];
+		m_PredictedChar = pCur->m_aCharacters[m_Snap.m_LocalClientID];
 
-			if (AntiPingPlayers())
+		if(AntiPingPlayers())
+		{
+			for(int c = 0; c < MAX_CLIENTS; c++)
 			{
-				for (int c = 0; c < MAX_CLIENTS; c++)
-				{
-					if(!World.m_apCharacters[c])
-						continue;
+				if(!World.m_apCharacters[c])
+					continue;
 
-					g_GameClient.m_aClients[c].m_Predicted = *World.m_apCharacters[c];
-				}
+				g_GameClient.m_aClients[c].m_PrevPredicted = pPrev->m_aCharacters[c];
+				g_GameClient.m_aClients[c].m_Predicted = pCur->m_aCharacters[c];
 			}
 		}
 	}
@@ -1746,6 +1758,109 @@ void CGameClient::OnPredict()
 	m_PredictedTick = Client()->PredGameTick();
 }
 
+void CGameClient::InvalidatePrediction()
+{
+	for(int i = 0; i < PREDICTION_RING_SIZE; i++)
+		m_aPredictedTicks[i].m_Tick = -1;
+}
+
+int CGameClient::PredictionStartTick(const bool *pIsWeaker)
+{
+	// everything the simulation depends on besides the base state and the input
+	CPredictionKey Key;
+	mem_zero(&Key, sizeof(Key));
+	Key.m_LocalClientID = m_Snap.m_LocalClientID;
+	Key.m_Dummy = g_Config.m_ClDummy;
+	Key.m_AntiPingPlayers = AntiPingPlayers();
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		Key.m_aActive[i] = m_Snap.m_aCharacters[i].m_Active && m_Snap.m_paPlayerInfos[i];
+		Key.m_aWeaker[i] = Key.m_AntiPingPlayers && pIsWeaker[i];
+	}
+	mem_copy(&Key.m_Tuning, &m_Tuning[g_Config.m_ClDummy], sizeof(Key.m_Tuning));
+	mem_copy(&Key.m_Teams, &m_Teams, sizeof(Key.m_Teams));
+
+	// predicted projectiles are not cached, so weapon prediction always starts over
+	if(mem_comp(&Key, &m_PredictionKey, sizeof(Key)) != 0 || AntiPingWeapons())
+		InvalidatePrediction();
+	mem_copy(&m_PredictionKey, &Key, sizeof(Key));
+
+	// the base tick is only reusable if the snapshot agrees with what we predicted for it
+	int BaseTick = Client()->GameTick();
+	CPredictedTick *pBase = PredictedTick(BaseTick);
+	bool BaseValid = pBase->m_Tick == BaseTick && PredictionFits();
+	for(int i = 0; i < MAX_CLIENTS && BaseValid; i++)
+	{
+		if(!Key.m_aActive[i])
+			continue;
+
+		CNetObj_CharacterCore Predicted;
+		pBase->m_aCharacters[i].Write(&Predicted);
+		if(mem_comp(&Predicted, static_cast<const CNetObj_CharacterCore *>(&m_Snap.m_aCharacters[i].m_Cur), sizeof(Predicted)) != 0 ||
+			pBase->m_aCharacters[i].m_ActiveWeapon != m_Snap.m_aCharacters[i].m_Cur.m_Weapon)
+			BaseValid = false;
+	}
+
+	if(!BaseValid)
+	{
+		InvalidatePrediction();
+		pBase->m_Tick = BaseTick;
+		pBase->m_HasInput = false;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!Key.m_aActive[i])
+				continue;
+
+			CCharacterCore *pCore = &pBase->m_aCharacters[i];
+			*pCore = g_GameClient.m_aClients[i].m_Predicted;
+			pCore->Init(&m_PredictedWorld, Collision(), &m_Teams);
+			pCore->m_Id = m_Snap.m_paPlayerInfos[i]->m_ClientID;
+			pCore->Read(&m_Snap.m_aCharacters[i].m_Cur);
+			pCore->m_ActiveWeapon = m_Snap.m_aCharacters[i].m_Cur.m_Weapon;
+		}
+		return BaseTick+1;
+	}
+
+	// reuse every following tick that was simulated with the same input
+	for(int Tick = BaseTick+1; Tick <= Client()->PredGameTick(); Tick++)
+	{
+		CPredictedTick *pTick = PredictedTick(Tick);
+		if(pTick->m_Tick != Tick)
+			return Tick;
+
+		int *pInput = Client()->GetInput(Tick);
+		if((pInput != 0) != pTick->m_HasInput || (pInput && mem_comp(pInput, &pTick->m_Input, sizeof(pTick->m_Input)) != 0))
+			return Tick;
+	}
+	return Client()->PredGameTick()+1;
+}
+
+bool CGameClient::PredictionFits() const
+{
+	// the ring has to hold every tick from the snapshot to the predicted one
+	return Client()->PredGameTick()-Client()->GameTick() < PREDICTION_RING_SIZE;
+}
+
+void CGameClient::StorePredictedTick(int Tick)
+{
+	CPredictedTick *pTick = PredictedTick(Tick);
+
+	// later ticks were simulated from an outdated state
+	for(int i = 0; i < PREDICTION_RING_SIZE; i++)
+		if(m_aPredictedTicks[i].m_Tick > Tick)
+			m_aPredictedTicks[i].m_Tick = -1;
+
+	pTick->m_Tick = Tick;
+	int *pInput = Client()->GetInput(Tick);
+	pTick->m_HasInput = pInput != 0;
+	if(pInput)
+		mem_copy(&pTick->m_Input, pInput, sizeof(pTick->m_Input));
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(m_PredictedWorld.m_apCharacters[i])
+			pTick->m_aCharacters[i] = *m_PredictedWorld.m_apCharacters[i];
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
@@ -109,6 +109,45 @@ class CGameClient : public IGameClient
 	int m_PredictedTick;
 	int m_LastNewPredictedTick[2];
 
+	// prediction cache, holds the simulated world for the last ticks so
+	// OnPredict only re-simulates from the first tick that was corrected.
+	// 32 ticks cover a ping of about 500ms, a longer prediction doesn't fit
+	// and is simulated from the snapshot every frame like without the cache
+	enum
+	{
+		PREDICTION_RING_SIZE=32,
+	};
+
+	struct CPredictionKey
+	{
+		int m_LocalClientID;
+		int m_Dummy;
+		int m_AntiPingPlayers;
+		bool m_aActive[MAX_CLIENTS];
+		bool m_aWeaker[MAX_CLIENTS];
+		CTuningParams m_Tuning;
+		CTeamsCore m_Teams;
+	};
+
+	struct CPredictedTick
+	{
+		int m_Tick;
+		bool m_HasInput;
+		CNetObj_PlayerInput m_Input;
+		CCharacterCore m_aCharacters[MAX_CLIENTS];
+	};
+
+	CWorldCore m_PredictedWorld;
+	CPredictionKey m_PredictionKey;
+	CPredictedTick m_aPredictedTicks[PREDICTION_RING_SIZE];
+	int m_PredictionResimTicks;
+
+	CPredictedTick *PredictedTick(int Tick) { return &m_aPredictedTicks[((Tick%PREDICTION_RING_SIZE)+PREDICTION_RING_SIZE)%PREDICTION_RING_SIZE]; }
+	void InvalidatePrediction();
+	int PredictionStartTick(const bool *pIsWeaker);
+	bool PredictionFits() const;
+	void StorePredictedTick(int Tick);
+
 	int m_LastRoundStartTick;
 
 	int m_LastFlagCarrierRed;
@@ -147,6 +186,7 @@ public:
 
 	int NetobjNumCorrections() { return m_NetObjHandler.NumObjCorrections(); }
 	const char *NetobjCorrectedOn() { return m_NetObjHandler.CorrectedObjOn(); }
+	int PredictionResimTicks() const { return m_PredictionResimTicks; }
 
 	bool m_SuppressEvents;
 	bool m_NewTick;
@@ -4,6 +4,7 @@
 #define GAME_CLIENT_RENDER_H
 
 #include <base/vmath.h>
+#include <engine/graphics.h>
 #include <game/mapitems.h>
 #include "ui.h"
 
@@ -41,6 +42,80 @@ enum
 
 typedef void (*ENVELOPE_EVAL)(float TimeOffset, int Env, float *pChannels, void *pUser);
 
+// the non-empty cells of a tile layer, bucketed into chunks when the map is
+// loaded so the renderers can skip empty space and only walk visible chunks
+class CTileChunks
+{
+public:
+	enum
+	{
+		CHUNK_SHIFT=5,
+		CHUNK_SIZE=1<<CHUNK_SHIFT,
+
+		SOURCE_TILES=0,
+		SOURCE_TELE,
+		SOURCE_SPEEDUP,
+		SOURCE_SWITCH,
+		SOURCE_TUNE,
+	};
+
+	struct CCell
+	{
+		unsigned short m_Pos; // (y<<CHUNK_SHIFT)|x inside the chunk
+		unsigned char m_Index; // 0 if the cell only carries overlay data
+		unsigned char m_Flags;
+	};
+
+	struct CChunk
+	{
+		CCell *m_pCells;
+		int m_NumOpaque; // opaque cells come first
+		int m_Num;
+	};
+
+	// walks the cells inside a tile rectangle, through the chunks if there are any
+	class CCursor
+	{
+		const CTileChunks *m_pChunks;
+		int m_StartX, m_StartY, m_EndX, m_EndY;
+		int m_FirstChunkX, m_LastChunkX, m_LastChunkY;
+		int m_ChunkX, m_ChunkY;
+		int m_Cell;
+		int m_X, m_Y;
+	public:
+		void Init(const CTileChunks *pChunks, int w, int h, int StartX, int StartY, int EndX, int EndY);
+		bool Next(int *pX, int *pY);
+	};
+
+private:
+	const void *m_pData;
+	int m_Source;
+	int m_Width;
+	int m_Height;
+	int m_ChunksX;
+	int m_ChunksY;
+	CChunk *m_pChunks;
+
+	void BuildChunk(CChunk *pChunk, int cx, int cy);
+
+public:
+	CTileChunks();
+	~CTileChunks();
+
+	void Init(const void *pData, int Source, int Width, int Height);
+	void Clear();
+
+	bool GetTile(int Index, unsigned char *pIndex, unsigned char *pFlags) const;
+
+	bool IsValid() const { return m_pChunks != 0; }
+	int Source() const { return m_Source; }
+	int Width() const { return m_Width; }
+	int Height() const { return m_Height; }
+	int NumChunksX() const { return m_ChunksX; }
+	int NumChunksY() const { return m_ChunksY; }
+	const CChunk *GetChunk(int cx, int cy) const { return &m_pChunks[cy*m_ChunksX+cx]; }
+};
+
 class CRenderTools
 {
 public:
@@ -73,9 +148,11 @@ public:
 
 	// map render methods (gc_render_map.cpp)
 	static void RenderEvalEnvelope(CEnvPoint *pPoints, int NumPoints, int Channels, float Time, float *pResult);
-	void RenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser);
-	void ForceRenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser, float Alpha = 1.0f);
+	static void PrepareQuads(const CQuad *pQuads, int NumQuads, IGraphics::CPreparedQuadItem *pItems);
+	void RenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser, const IGraphics::CPreparedQuadItem *pPrepared = 0);
+	void ForceRenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser, float Alpha = 1.0f, const IGraphics::CPreparedQuadItem *pPrepared = 0);
 	void RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
+	void RenderTileChunks(CTileChunks *pChunks, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval = 0, void *pUser = 0, int ColorEnv = -1, int ColorEnvOffset = 0);
 
 	// helpers
 	void MapscreenToWorld(float CenterX, float CenterY, float ParallaxX, float ParallaxY,
@@ -83,10 +160,10 @@ public:
 
 	// DDRace
 
-	void RenderTeleOverlay(CTeleTile *pTele, int w, int h, float Scale, float Alpha=1.0f);
-	void RenderSpeedupOverlay(CSpeedupTile *pTele, int w, int h, float Scale, float Alpha=1.0f);
-	void RenderSwitchOverlay(CSwitchTile *pSwitch, int w, int h, float Scale, float Alpha=1.0f);
-	void RenderTuneOverlay(CTuneTile *pTune, int w, int h, float Scale, float Alpha=1.0f);
+	void RenderTeleOverlay(CTeleTile *pTele, int w, int h, float Scale, float Alpha=1.0f, const CTileChunks *pChunks=0);
+	void RenderSpeedupOverlay(CSpeedupTile *pTele, int w, int h, float Scale, float Alpha=1.0f, const CTileChunks *pChunks=0);
+	void RenderSwitchOverlay(CSwitchTile *pSwitch, int w, int h, float Scale, float Alpha=1.0f, const CTileChunks *pChunks=0);
+	void RenderTuneOverlay(CTuneTile *pTune, int w, int h, float Scale, float Alpha=1.0f, const CTileChunks *pChunks=0);
 	void RenderTelemap(CTeleTile *pTele, int w, int h, float Scale, vec4 Color, int RenderFlags);
 	void RenderSpeedupmap(CSpeedupTile *pTele, int w, int h, float Scale, vec4 Color, int RenderFlags);
 	void RenderSwitchmap(CSwitchTile *pSwitch, int w, int h, float Scale, vec4 Color, int RenderFlags);
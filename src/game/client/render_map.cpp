@@ -32,39 +32,50 @@ void CRenderTools::RenderEvalEnvelope(CEnvPoint *pPoints, int NumPoints, int Cha
 	}
 
 	Time = fmod(Time, pPoints[NumPoints-1].m_Time/1000.0f)*1000.0f;
-	for(int i = 0; i < NumPoints-1; i++)
+
+	// the first segment that ends at or after Time, points are sorted by time
+	int Low = 0;
+	int High = NumPoints-1;
+	while(Low < High)
 	{
-		if(Time >= pPoints[i].m_Time && Time <= pPoints[i+1].m_Time)
-		{
-			float Delta = pPoints[i+1].m_Time-pPoints[i].m_Time;
-			float a = (Time-pPoints[i].m_Time)/Delta;
+		int Mid = (Low+High)/2;
+		if(pPoints[Mid+1].m_Time >= Time)
+			High = Mid;
+		else
+			Low = Mid+1;
+	}
 
+	int i = Low;
+	if(i < NumPoints-1 && Time >= pPoints[i].m_Time && Time <= pPoints[i+1].m_Time)
+	{
+		float Delta = pPoints[i+1].m_Time-pPoints[i].m_Time;
+		float a = (Time-pPoints[i].m_Time)/Delta;
 
-			if(pPoints[i].m_Curvetype == CURVETYPE_SMOOTH)
-				a = -2*a*a*a + 3*a*a; // second hermite basis
-			else if(pPoints[i].m_Curvetype == CURVETYPE_SLOW)
-				a = a*a*a;
-			else if(pPoints[i].m_Curvetype == CURVETYPE_FAST)
-			{
-				a = 1-a;
-				a = 1-a*a*a;
-			}
-			else if (pPoints[i].m_Curvetype == CURVETYPE_STEP)
-				a = 0;
-			else
-			{
-				// linear
-			}
 
-			for(int c = 0; c < Channels; c++)
-			{
-				float v0 = fx2f(pPoints[i].m_aValues[c]);
-				float v1 = fx2f(pPoints[i+1].m_aValues[c]);
-				pResult[c] = v0 + (v1-v0) * a;
-			}
+		if(pPoints[i].m_Curvetype == CURVETYPE_SMOOTH)
+			a = -2*a*a*a + 3*a*a; // second hermite basis
+		else if(pPoints[i].m_Curvetype == CURVETYPE_SLOW)
+			a = a*a*a;
+		else if(pPoints[i].m_Curvetype == CURVETYPE_FAST)
+		{
+			a = 1-a;
+			a = 1-a*a*a;
+		}
+		else if (pPoints[i].m_Curvetype == CURVETYPE_STEP)
+			a = 0;
+		else
+		{
+			// linear
+		}
 
-			return;
+		for(int c = 0; c < Channels; c++)
+		{
+			float v0 = fx2f(pPoints[i].m_aValues[c]);
+			float v1 = fx2f(pPoints[i+1].m_aValues[c]);
+			pResult[c] = v0 + (v1-v0) * a;
 		}
+
+		return;
 	}
 
 	pResult[0] = fx2f(pPoints[NumPoints-1].m_aValues[0]);
@@ -83,22 +94,67 @@ static void Rotate(CPoint *pCenter, CPoint *pPoint, float Rotation)
 	pPoint->y = (int)(x * sinf(Rotation) + y * cosf(Rotation) + pCenter->y);
 }
 
-void CRenderTools::RenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser)
+static bool IsAnimated(const CQuad *pQuad)
+{
+	return pQuad->m_PosEnv >= 0 || pQuad->m_ColorEnv >= 0;
+}
+
+void CRenderTools::PrepareQuads(const CQuad *pQuads, int NumQuads, IGraphics::CPreparedQuadItem *pItems)
+{
+	// map quads are stored as two rows of points, prepared items go around
+	static const int s_aCorners[4] = {0, 1, 3, 2};
+	float Conv = 1/255.0f;
+	for(int i = 0; i < NumQuads; i++)
+	{
+		const CQuad *q = &pQuads[i];
+		IGraphics::CPreparedQuadItem *pItem = &pItems[i];
+		for(int c = 0; c < 4; c++)
+		{
+			int p = s_aCorners[c];
+			pItem->m_aX[c] = fx2f(q->m_aPoints[p].x);
+			pItem->m_aY[c] = fx2f(q->m_aPoints[p].y);
+			pItem->m_aU[c] = fx2f(q->m_aTexcoords[p].x);
+			pItem->m_aV[c] = fx2f(q->m_aTexcoords[p].y);
+			pItem->m_aColors[c][0] = q->m_aColors[p].r*Conv;
+			pItem->m_aColors[c][1] = q->m_aColors[p].g*Conv;
+			pItem->m_aColors[c][2] = q->m_aColors[p].b*Conv;
+			pItem->m_aColors[c][3] = q->m_aColors[p].a*Conv;
+		}
+	}
+}
+
+void CRenderTools::RenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, const IGraphics::CPreparedQuadItem *pPrepared)
 {
 	if(!g_Config.m_ClShowQuads || g_Config.m_ClOverlayEntities == 100)
 		return;
 
-	ForceRenderQuads(pQuads, NumQuads, RenderFlags, pfnEval, pUser, (100-g_Config.m_ClOverlayEntities)/100.0f);
+	ForceRenderQuads(pQuads, NumQuads, RenderFlags, pfnEval, pUser, (100-g_Config.m_ClOverlayEntities)/100.0f, pPrepared);
 }
 
-void CRenderTools::ForceRenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, float Alpha)
+void CRenderTools::ForceRenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, float Alpha, const IGraphics::CPreparedQuadItem *pPrepared)
 {
+	// the prepared items don't carry the overlay alpha
+	if(Alpha != 1.0f)
+		pPrepared = 0;
+
 	Graphics()->QuadsBegin();
 	float Conv = 1/255.0f;
 	for(int i = 0; i < NumQuads; i++)
 	{
 		CQuad *q = &pQuads[i];
 
+		// runs of quads without envelopes are drawn as they were prepared at map load
+		if(pPrepared && !IsAnimated(q))
+		{
+			int Num = 1;
+			while(i+Num < NumQuads && !IsAnimated(&pQuads[i+Num]))
+				Num++;
+			if(RenderFlags&LAYERRENDERFLAG_TRANSPARENT) // see the opaque TODO below
+				Graphics()->QuadsDrawPrepared(&pPrepared[i], Num);
+			i += Num-1;
+			continue;
+		}
+
 		float r=1, g=1, b=1, a=1;
 
 		if(q->m_ColorEnv >= 0)
@@ -322,56 +378,206 @@ void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
 
-void CRenderTools::RenderTeleOverlay(CTeleTile *pTele, int w, int h, float Scale, float Alpha)
+static void SetTileQuad(IGraphics::CTexturedQuadItem *pItem, float x, float y, float Scale, int Index, int Flags, float Frac, float Nudge)
 {
-	if(!g_Config.m_ClTextEntities)
-	  return;
+	float TexSize = 1024.0f;
+	int tx = Index%16;
+	int ty = Index/16;
+	int Px0 = tx*(1024/16);
+	int Py0 = ty*(1024/16);
+	int Px1 = Px0+(1024/16)-1;
+	int Py1 = Py0+(1024/16)-1;
+
+	float x0 = Nudge + Px0/TexSize+Frac;
+	float y0 = Nudge + Py0/TexSize+Frac;
+	float x1 = Nudge + Px1/TexSize-Frac;
+	float y1 = Nudge + Py0/TexSize+Frac;
+	float x2 = Nudge + Px1/TexSize-Frac;
+	float y2 = Nudge + Py1/TexSize-Frac;
+	float x3 = Nudge + Px0/TexSize+Frac;
+	float y3 = Nudge + Py1/TexSize-Frac;
+
+	if(Flags&TILEFLAG_VFLIP)
+	{
+		x0 = x2;
+		x1 = x3;
+		x2 = x3;
+		x3 = x0;
+	}
+
+	if(Flags&TILEFLAG_HFLIP)
+	{
+		y0 = y3;
+		y2 = y1;
+		y3 = y1;
+		y1 = y0;
+	}
+
+	if(Flags&TILEFLAG_ROTATE)
+	{
+		float Tmp = x0;
+		x0 = x3;
+		x3 = x2;
+		x2 = x1;
+		x1 = Tmp;
+		Tmp = y0;
+		y0 = y3;
+		y3 = y2;
+		y2 = y1;
+		y1 = Tmp;
+	}
+
+	pItem->m_X = x;
+	pItem->m_Y = y;
+	pItem->m_Width = Scale;
+	pItem->m_Height = Scale;
+	pItem->m_aU[0] = x0; pItem->m_aV[0] = y0;
+	pItem->m_aU[1] = x1; pItem->m_aV[1] = y1;
+	pItem->m_aU[2] = x2; pItem->m_aV[2] = y2;
+	pItem->m_aU[3] = x3; pItem->m_aV[3] = y3;
+}
+
+void CRenderTools::RenderTileChunks(CTileChunks *pChunks, float Scale, vec4 Color, int RenderFlags,
+									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+{
+	if(!pChunks->IsValid())
+		return;
 
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
 	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 
+	// calculate the final pixelsize for the tiles
+	float TilePixelSize = 1024/32.0f;
+	float FinalTileSize = Scale/(ScreenX1-ScreenX0) * Graphics()->ScreenWidth();
+	float FinalTilesetScale = FinalTileSize/TilePixelSize;
+
+	float r=1, g=1, b=1, a=1;
+	if(ColorEnv >= 0 && pfnEval)
+	{
+		float aChannels[4];
+		pfnEval(ColorEnvOffset/1000.0f, ColorEnv, aChannels, pUser);
+		r = aChannels[0];
+		g = aChannels[1];
+		b = aChannels[2];
+		a = aChannels[3];
+	}
+
+	Graphics()->QuadsBegin();
+	Graphics()->SetColor(Color.r*r, Color.g*g, Color.b*b, Color.a*a);
+
+	int w = pChunks->Width();
+	int h = pChunks->Height();
 	int StartY = (int)(ScreenY0/Scale)-1;
 	int StartX = (int)(ScreenX0/Scale)-1;
 	int EndY = (int)(ScreenY1/Scale)+1;
 	int EndX = (int)(ScreenX1/Scale)+1;
 
-	if(EndX - StartX > g_Config.m_GfxScreenWidth / g_Config.m_GfxTextOverlay || EndY - StartY > g_Config.m_GfxScreenHeight / g_Config.m_GfxTextOverlay)
-		return; // its useless to render text at this distance
+	// adjust the texture shift according to mipmap level
+	float TexSize = 1024.0f;
+	float Frac = (1.25f/TexSize) * (1/FinalTilesetScale);
+	float Nudge = (0.5f/TexSize) * (1/FinalTilesetScale);
 
-	for(int y = StartY; y < EndY; y++)
-		for(int x = StartX; x < EndX; x++)
-		{
-			int mx = x;
-			int my = y;
+	// tile layers lose their opaque tiles once the layer is faded
+	bool AllTransparent = pChunks->Source() == CTileChunks::SOURCE_TILES && !(Color.a*a > 254.0f/255.0f);
 
+	enum { BATCH_SIZE=64 };
+	IGraphics::CTexturedQuadItem aBatch[BATCH_SIZE];
+	int NumBatch = 0;
 
-			if(mx<0)
-				continue; // mx = 0;
-			if(mx>=w)
-				continue; // mx = w-1;
-			if(my<0)
-				continue; // my = 0;
-			if(my>=h)
-				continue; // my = h-1;
+	// whole chunks inside the map
+	int ChunkStartX = max(StartX, 0)>>CTileChunks::CHUNK_SHIFT;
+	int ChunkStartY = max(StartY, 0)>>CTileChunks::CHUNK_SHIFT;
+	int ChunkEndX = min(EndX, w)-1;
+	int ChunkEndY = min(EndY, h)-1;
+	if(ChunkEndX >= 0 && ChunkEndY >= 0)
+	{
+		ChunkEndX >>= CTileChunks::CHUNK_SHIFT;
+		ChunkEndY >>= CTileChunks::CHUNK_SHIFT;
+	}
+	else
+		ChunkEndX = ChunkEndY = -1;
 
-			int c = mx + my*w;
+	for(int cy = ChunkStartY; cy <= ChunkEndY; cy++)
+		for(int cx = ChunkStartX; cx <= ChunkEndX; cx++)
+		{
+			const CTileChunks::CChunk *pChunk = pChunks->GetChunk(cx, cy);
 
-			unsigned char Index = pTele[c].m_Number;
-			if(Index && pTele[c].m_Type != TILE_TELECHECKIN && pTele[c].m_Type != TILE_TELECHECKINEVIL)
+			int First, Last;
+			if(AllTransparent)
 			{
-				char aBuf[16];
-				str_format(aBuf, sizeof(aBuf), "%d", Index);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-				UI()->TextRender()->Text(0, mx*Scale-2, my*Scale-4, Scale-5, aBuf, -1);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
+				First = RenderFlags&LAYERRENDERFLAG_TRANSPARENT ? 0 : pChunk->m_Num;
+				Last = pChunk->m_Num;
+			}
+			else
+			{
+				First = RenderFlags&LAYERRENDERFLAG_OPAQUE ? 0 : pChunk->m_NumOpaque;
+				Last = RenderFlags&LAYERRENDERFLAG_TRANSPARENT ? pChunk->m_Num : pChunk->m_NumOpaque;
+			}
+
+			float OffsetX = (cx<<CTileChunks::CHUNK_SHIFT)*Scale;
+			float OffsetY = (cy<<CTileChunks::CHUNK_SHIFT)*Scale;
+			for(int i = First; i < Last; i++)
+			{
+				const CTileChunks::CCell *pCell = &pChunk->m_pCells[i];
+				if(!pCell->m_Index)
+					continue;
+
+				float x = OffsetX + (pCell->m_Pos&(CTileChunks::CHUNK_SIZE-1))*Scale;
+				float y = OffsetY + (pCell->m_Pos>>CTileChunks::CHUNK_SHIFT)*Scale;
+				SetTileQuad(&aBatch[NumBatch++], x, y, Scale, pCell->m_Index, pCell->m_Flags, Frac, Nudge);
+				if(NumBatch == BATCH_SIZE)
+				{
+					Graphics()->QuadsDrawTextured(aBatch, NumBatch);
+					NumBatch = 0;
+				}
 			}
 		}
 
+	// the border tiles stretched past the map edges
+	if(RenderFlags&TILERENDERFLAG_EXTEND && (StartX < 0 || StartY < 0 || EndX > w || EndY > h))
+	{
+		for(int y = StartY; y < EndY; y++)
+			for(int x = StartX; x < EndX; x++)
+			{
+				if(y >= 0 && y < h && x >= 0 && x < w)
+				{
+					x = w-1;
+					continue;
+				}
+
+				int mx = clamp(x, 0, w-1);
+				int my = clamp(y, 0, h-1);
+
+				unsigned char Index, Flags;
+				pChunks->GetTile(mx + my*w, &Index, &Flags);
+				if(!Index)
+					continue;
+
+				bool Opaque = !AllTransparent && (Flags&TILEFLAG_OPAQUE);
+				if(!(RenderFlags&(Opaque ? LAYERRENDERFLAG_OPAQUE : LAYERRENDERFLAG_TRANSPARENT)))
+					continue;
+
+				SetTileQuad(&aBatch[NumBatch++], x*Scale, y*Scale, Scale, Index, Flags, Frac, Nudge);
+				if(NumBatch == BATCH_SIZE)
+				{
+					Graphics()->QuadsDrawTextured(aBatch, NumBatch);
+					NumBatch = 0;
+				}
+			}
+	}
+
+	if(NumBatch)
+		Graphics()->QuadsDrawTextured(aBatch, NumBatch);
+
+	Graphics()->QuadsEnd();
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
 
-void CRenderTools::RenderSpeedupOverlay(CSpeedupTile *pSpeedup, int w, int h, float Scale, float Alpha)
+void CRenderTools::RenderTeleOverlay(CTeleTile *pTele, int w, int h, float Scale, float Alpha, const CTileChunks *pChunks)
 {
+	if(!g_Config.m_ClTextEntities)
+	  return;
+
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
 	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 
@@ -383,60 +589,84 @@ void CRenderTools::RenderSpeedupOverlay(CSpeedupTile *pSpeedup, int w, int h, fl
 	if(EndX - StartX > g_Config.m_GfxScreenWidth / g_Config.m_GfxTextOverlay || EndY - StartY > g_Config.m_GfxScreenHeight / g_Config.m_GfxTextOverlay)
 		return; // its useless to render text at this distance
 
-	for(int y = StartY; y < EndY; y++)
-		for(int x = StartX; x < EndX; x++)
+	CTileChunks::CCursor Cursor;
+	Cursor.Init(pChunks, w, h, StartX, StartY, EndX, EndY);
+	int mx, my;
+	while(Cursor.Next(&mx, &my))
+	{
+		int c = mx + my*w;
+
+		unsigned char Index = pTele[c].m_Number;
+		if(Index && pTele[c].m_Type != TILE_TELECHECKIN && pTele[c].m_Type != TILE_TELECHECKINEVIL)
 		{
-			int mx = x;
-			int my = y;
+			char aBuf[16];
+			str_format(aBuf, sizeof(aBuf), "%d", Index);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
+			UI()->TextRender()->Text(0, mx*Scale-2, my*Scale-4, Scale-5, aBuf, -1);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
+		}
+	}
 
-			if(mx<0)
-				continue; // mx = 0;
-			if(mx>=w)
-				continue; // mx = w-1;
-			if(my<0)
-				continue; // my = 0;
-			if(my>=h)
-				continue; // my = h-1;
+	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
+}
 
-			int c = mx + my*w;
+void CRenderTools::RenderSpeedupOverlay(CSpeedupTile *pSpeedup, int w, int h, float Scale, float Alpha, const CTileChunks *pChunks)
+{
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
 
-			int Force = (int)pSpeedup[c].m_Force;
-			int MaxSpeed = (int)pSpeedup[c].m_MaxSpeed;
-			if(Force)
-			{
-				// draw arrow
-				Graphics()->TextureSet(g_pData->m_aImages[IMAGE_SPEEDUP_ARROW].m_Id);
-				Graphics()->QuadsBegin();
-				Graphics()->SetColor(255.0f, 255.0f, 255.0f, Alpha);
+	int StartY = (int)(ScreenY0/Scale)-1;
+	int StartX = (int)(ScreenX0/Scale)-1;
+	int EndY = (int)(ScreenY1/Scale)+1;
+	int EndX = (int)(ScreenX1/Scale)+1;
+
+	if(EndX - StartX > g_Config.m_GfxScreenWidth / g_Config.m_GfxTextOverlay || EndY - StartY > g_Config.m_GfxScreenHeight / g_Config.m_GfxTextOverlay)
+		return; // its useless to render text at this distance
+
+	CTileChunks::CCursor Cursor;
+	Cursor.Init(pChunks, w, h, StartX, StartY, EndX, EndY);
+	int mx, my;
+	while(Cursor.Next(&mx, &my))
+	{
+		int c = mx + my*w;
+
+		int Force = (int)pSpeedup[c].m_Force;
+		int MaxSpeed = (int)pSpeedup[c].m_MaxSpeed;
+		if(Force)
+		{
+			// draw arrow
+			Graphics()->TextureSet(g_pData->m_aImages[IMAGE_SPEEDUP_ARROW].m_Id);
+			Graphics()->QuadsBegin();
+			Graphics()->SetColor(255.0f, 255.0f, 255.0f, Alpha);
 
-				SelectSprite(SPRITE_SPEEDUP_ARROW);
-				Graphics()->QuadsSetRotation(pSpeedup[c].m_Angle*(3.14159265f/180.0f));
-				DrawSprite(mx*Scale+16, my*Scale+16, 35.0f);
+			SelectSprite(SPRITE_SPEEDUP_ARROW);
+			Graphics()->QuadsSetRotation(pSpeedup[c].m_Angle*(3.14159265f/180.0f));
+			DrawSprite(mx*Scale+16, my*Scale+16, 35.0f);
 
-				Graphics()->QuadsEnd();
+			Graphics()->QuadsEnd();
 
-				if(g_Config.m_ClTextEntities)
+			if(g_Config.m_ClTextEntities)
+			{
+				// draw force
+				char aBuf[16];
+				str_format(aBuf, sizeof(aBuf), "%d", Force);
+				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
+				UI()->TextRender()->Text(0, mx*Scale, my*Scale+16, Scale-20, aBuf, -1);
+				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
+				if(MaxSpeed)
 				{
-					// draw force
-					char aBuf[16];
-					str_format(aBuf, sizeof(aBuf), "%d", Force);
+					str_format(aBuf, sizeof(aBuf), "%d", MaxSpeed);
 					UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-					UI()->TextRender()->Text(0, mx*Scale, my*Scale+16, Scale-20, aBuf, -1);
+					UI()->TextRender()->Text(0, mx*Scale, my*Scale-2, Scale-20, aBuf, -1);
 					UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
-					if(MaxSpeed)
-					{
-						str_format(aBuf, sizeof(aBuf), "%d", MaxSpeed);
-						UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-						UI()->TextRender()->Text(0, mx*Scale, my*Scale-2, Scale-20, aBuf, -1);
-						UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
-					}
 				}
 			}
 		}
+	}
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
 
-void CRenderTools::RenderSwitchOverlay(CSwitchTile *pSwitch, int w, int h, float Scale, float Alpha)
+void CRenderTools::RenderSwitchOverlay(CSwitchTile *pSwitch, int w, int h, float Scale, float Alpha, const CTileChunks *pChunks)
 {
 	if(!g_Config.m_ClTextEntities)
 	  return;
@@ -452,49 +682,38 @@ void CRenderTools::RenderSwitchOverlay(CSwitchTile *pSwitch, int w, int h, float
 	if(EndX - StartX > g_Config.m_GfxScreenWidth / g_Config.m_GfxTextOverlay || EndY - StartY > g_Config.m_GfxScreenHeight / g_Config.m_GfxTextOverlay)
 		return; // its useless to render text at this distance
 
-	for(int y = StartY; y < EndY; y++)
-		for(int x = StartX; x < EndX; x++)
-		{
-			int mx = x;
-			int my = y;
-
-
-			if(mx<0)
-				continue; // mx = 0;
-			if(mx>=w)
-				continue; // mx = w-1;
-			if(my<0)
-				continue; // my = 0;
-			if(my>=h)
-				continue; // my = h-1;
-
-			int c = mx + my*w;
+	CTileChunks::CCursor Cursor;
+	Cursor.Init(pChunks, w, h, StartX, StartY, EndX, EndY);
+	int mx, my;
+	while(Cursor.Next(&mx, &my))
+	{
+		int c = mx + my*w;
 
-			unsigned char Index = pSwitch[c].m_Number;
-			if(Index)
-			{
-				char aBuf[16];
-				str_format(aBuf, sizeof(aBuf), "%d", Index);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-				UI()->TextRender()->Text(0, mx*Scale, my*Scale+16, Scale-20, aBuf, -1);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
-			}
+		unsigned char Index = pSwitch[c].m_Number;
+		if(Index)
+		{
+			char aBuf[16];
+			str_format(aBuf, sizeof(aBuf), "%d", Index);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
+			UI()->TextRender()->Text(0, mx*Scale, my*Scale+16, Scale-20, aBuf, -1);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
+		}
 
-			unsigned char Delay = pSwitch[c].m_Delay;
-			if(Delay)
-			{
-				char aBuf[16];
-				str_format(aBuf, sizeof(aBuf), "%d", Delay);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-				UI()->TextRender()->Text(0, mx*Scale, my*Scale-2, Scale-20, aBuf, -1);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
-			}
+		unsigned char Delay = pSwitch[c].m_Delay;
+		if(Delay)
+		{
+			char aBuf[16];
+			str_format(aBuf, sizeof(aBuf), "%d", Delay);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
+			UI()->TextRender()->Text(0, mx*Scale, my*Scale-2, Scale-20, aBuf, -1);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
 		}
+	}
 
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
 
-void CRenderTools::RenderTuneOverlay(CTuneTile *pTune, int w, int h, float Scale, float Alpha)
+void CRenderTools::RenderTuneOverlay(CTuneTile *pTune, int w, int h, float Scale, float Alpha, const CTileChunks *pChunks)
 {
 	if(!g_Config.m_ClTextEntities)
 	  return;
@@ -510,34 +729,23 @@ void CRenderTools::RenderTuneOverlay(CTuneTile *pTune, int w, int h, float Scale
 	if(EndX - StartX > g_Config.m_GfxScreenWidth / g_Config.m_GfxTextOverlay || EndY - StartY > g_Config.m_GfxScreenHeight / g_Config.m_GfxTextOverlay)
 		return; // its useless to render text at this distance
 
-	for(int y = StartY; y < EndY; y++)
-		for(int x = StartX; x < EndX; x++)
-		{
-			int mx = x;
-			int my = y;
-
-
-			if(mx<0)
-				continue; // mx = 0;
-			if(mx>=w)
-				continue; // mx = w-1;
-			if(my<0)
-				continue; // my = 0;
-			if(my>=h)
-				continue; // my = h-1;
-
-			int c = mx + my*w;
+	CTileChunks::CCursor Cursor;
+	Cursor.Init(pChunks, w, h, StartX, StartY, EndX, EndY);
+	int mx, my;
+	while(Cursor.Next(&mx, &my))
+	{
+		int c = mx + my*w;
 
-			unsigned char Index = pTune[c].m_Number;
-			if(Index)
-			{
-				char aBuf[16];
-				str_format(aBuf, sizeof(aBuf), "%d", Index);
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
-				UI()->TextRender()->Text(0, mx*Scale+11.f, my*Scale+6.f, Scale/1.5f-5.f, aBuf, -1); // numbers shouldnt be too big and in the center of the tile
-				UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
-			}
+		unsigned char Index = pTune[c].m_Number;
+		if(Index)
+		{
+			char aBuf[16];
+			str_format(aBuf, sizeof(aBuf), "%d", Index);
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, Alpha);
+			UI()->TextRender()->Text(0, mx*Scale+11.f, my*Scale+6.f, Scale/1.5f-5.f, aBuf, -1); // numbers shouldnt be too big and in the center of the tile
+			UI()->TextRender()->TextColor(1.0f, 1.0f, 1.0f, 1.0f);
 		}
+	}
 
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
@@ -952,3 +1160,208 @@ void CRenderTools::RenderTunemap(CTuneTile *pTune, int w, int h, float Scale, ve
 	Graphics()->QuadsEnd();
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
 }
+
+CTileChunks::CTileChunks()
+{
+	m_pData = 0;
+	m_Source = SOURCE_TILES;
+	m_Width = 0;
+	m_Height = 0;
+	m_ChunksX = 0;
+	m_ChunksY = 0;
+	m_pChunks = 0;
+}
+
+CTileChunks::~CTileChunks()
+{
+	Clear();
+}
+
+void CTileChunks::Clear()
+{
+	if(m_pChunks)
+	{
+		for(int i = 0; i < m_ChunksX*m_ChunksY; i++)
+			mem_free(m_pChunks[i].m_pCells);
+		delete [] m_pChunks;
+	}
+	m_pChunks = 0;
+	m_pData = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_ChunksX = 0;
+	m_ChunksY = 0;
+}
+
+void CTileChunks::Init(const void *pData, int Source, int Width, int Height)
+{
+	Clear();
+	if(!pData || Width <= 0 || Height <= 0)
+		return;
+
+	m_pData = pData;
+	m_Source = Source;
+	m_Width = Width;
+	m_Height = Height;
+	m_ChunksX = (Width+CHUNK_SIZE-1)>>CHUNK_SHIFT;
+	m_ChunksY = (Height+CHUNK_SIZE-1)>>CHUNK_SHIFT;
+	m_pChunks = new CChunk[m_ChunksX*m_ChunksY];
+	for(int cy = 0; cy < m_ChunksY; cy++)
+		for(int cx = 0; cx < m_ChunksX; cx++)
+		{
+			CChunk *pChunk = &m_pChunks[cy*m_ChunksX+cx];
+			pChunk->m_pCells = 0;
+			BuildChunk(pChunk, cx, cy);
+		}
+}
+
+bool CTileChunks::GetTile(int Index, unsigned char *pIndex, unsigned char *pFlags) const
+{
+	*pFlags = 0;
+	switch(m_Source)
+	{
+	case SOURCE_TILES:
+		{
+			const CTile *pTile = &((const CTile *)m_pData)[Index];
+			*pIndex = pTile->m_Index;
+			*pFlags = pTile->m_Flags;
+			return pTile->m_Index != 0;
+		}
+	case SOURCE_TELE:
+		{
+			const CTeleTile *pTile = &((const CTeleTile *)m_pData)[Index];
+			*pIndex = pTile->m_Type;
+			return pTile->m_Type || pTile->m_Number;
+		}
+	case SOURCE_SPEEDUP:
+		{
+			const CSpeedupTile *pTile = &((const CSpeedupTile *)m_pData)[Index];
+			*pIndex = pTile->m_Type;
+			return pTile->m_Type || pTile->m_Force;
+		}
+	case SOURCE_SWITCH:
+		{
+			const CSwitchTile *pTile = &((const CSwitchTile *)m_pData)[Index];
+			*pIndex = pTile->m_Type == TILE_SWITCHTIMEDOPEN ? 8 : pTile->m_Type;
+			*pFlags = pTile->m_Flags;
+			return pTile->m_Type || pTile->m_Number || pTile->m_Delay;
+		}
+	case SOURCE_TUNE:
+		{
+			const CTuneTile *pTile = &((const CTuneTile *)m_pData)[Index];
+			*pIndex = pTile->m_Type;
+			return pTile->m_Type || pTile->m_Number;
+		}
+	}
+	*pIndex = 0;
+	return false;
+}
+
+void CTileChunks::BuildChunk(CChunk *pChunk, int cx, int cy)
+{
+	CCell aCells[CHUNK_SIZE*CHUNK_SIZE];
+	int NumOpaque = 0;
+	int Num = 0;
+
+	int StartX = cx<<CHUNK_SHIFT;
+	int StartY = cy<<CHUNK_SHIFT;
+	int EndX = min(StartX+(int)CHUNK_SIZE, m_Width);
+	int EndY = min(StartY+(int)CHUNK_SIZE, m_Height);
+
+	// two passes so that the opaque cells end up in front
+	for(int Pass = 0; Pass < 2; Pass++)
+		for(int y = StartY; y < EndY; y++)
+			for(int x = StartX; x < EndX; x++)
+			{
+				unsigned char Index, Flags;
+				if(!GetTile(y*m_Width+x, &Index, &Flags))
+					continue;
+				bool Opaque = Index && (Flags&TILEFLAG_OPAQUE);
+				if(Opaque != (Pass == 0))
+					continue;
+
+				CCell *pCell = &aCells[Num++];
+				pCell->m_Pos = ((y-StartY)<<CHUNK_SHIFT)|(x-StartX);
+				pCell->m_Index = Index;
+				pCell->m_Flags = Flags;
+				if(Opaque)
+					NumOpaque++;
+			}
+
+	mem_free(pChunk->m_pCells);
+	pChunk->m_pCells = 0;
+	if(Num)
+	{
+		pChunk->m_pCells = (CCell *)mem_alloc(Num*sizeof(CCell), 1);
+		mem_copy(pChunk->m_pCells, aCells, Num*sizeof(CCell));
+	}
+	pChunk->m_NumOpaque = NumOpaque;
+	pChunk->m_Num = Num;
+}
+
+void CTileChunks::CCursor::Init(const CTileChunks *pChunks, int w, int h, int StartX, int StartY, int EndX, int EndY)
+{
+	m_pChunks = pChunks && pChunks->IsValid() ? pChunks : 0;
+	m_StartX = max(StartX, 0);
+	m_StartY = max(StartY, 0);
+	m_EndX = min(EndX, w);
+	m_EndY = min(EndY, h);
+	m_X = m_StartX;
+	m_Y = m_StartY;
+	m_Cell = 0;
+
+	if(m_StartX >= m_EndX || m_StartY >= m_EndY)
+	{
+		// nothing visible
+		m_pChunks = 0;
+		m_Y = m_EndY = m_StartY;
+		return;
+	}
+
+	m_FirstChunkX = m_ChunkX = m_StartX>>CHUNK_SHIFT;
+	m_ChunkY = m_StartY>>CHUNK_SHIFT;
+	m_LastChunkX = (m_EndX-1)>>CHUNK_SHIFT;
+	m_LastChunkY = (m_EndY-1)>>CHUNK_SHIFT;
+}
+
+bool CTileChunks::CCursor::Next(int *pX, int *pY)
+{
+	if(!m_pChunks)
+	{
+		if(m_Y >= m_EndY)
+			return false;
+		*pX = m_X;
+		*pY = m_Y;
+		if(++m_X >= m_EndX)
+		{
+			m_X = m_StartX;
+			m_Y++;
+		}
+		return true;
+	}
+
+	while(m_ChunkY <= m_LastChunkY)
+	{
+		const CChunk *pChunk = m_pChunks->GetChunk(m_ChunkX, m_ChunkY);
+		while(m_Cell < pChunk->m_Num)
+		{
+			const CCell *pCell = &pChunk->m_pCells[m_Cell++];
+			int x = (m_ChunkX<<CHUNK_SHIFT) + (pCell->m_Pos&(CHUNK_SIZE-1));
+			int y = (m_ChunkY<<CHUNK_SHIFT) + (pCell->m_Pos>>CHUNK_SHIFT);
+			if(x >= m_StartX && x < m_EndX && y >= m_StartY && y < m_EndY)
+			{
+				*pX = x;
+				*pY = y;
+				return true;
+			}
+		}
+
+		m_Cell = 0;
+		if(++m_ChunkX > m_LastChunkX)
+		{
+			m_ChunkX = m_FirstChunkX;
+			m_ChunkY++;
+		}
+	}
+	return false;
+}
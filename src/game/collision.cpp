@@ -25,9 +25,12 @@ CCollision::CCollision()
 	m_pSpeedup = 0;
 	m_pFront = 0;
 	m_pSwitch = 0;
-	m_pDoor = 0;
-	m_pSwitchers = 0;
+	m_pDoorMask = 0;
+	m_pSwitchStatus = 0;
+	m_pSwitchInitial = 0;
 	m_pTune = 0;
+	m_SwitchWheelTick = -1;
+	m_SwitchTimerSerial = 0;
 }
 
 void CCollision::Init(class CLayers *pLayers)
@@ -60,13 +63,9 @@ void CCollision::Init(class CLayers *pLayers)
 		if (Size >= m_Width*m_Height*sizeof(CSwitchTile))
 			m_pSwitch = static_cast<CSwitchTile *>(m_pLayers->Map()->GetData(m_pLayers->SwitchLayer()->m_Switch));
 
-		m_pDoor = new CDoorTile[m_Width*m_Height];
-		mem_zero(m_pDoor, m_Width * m_Height * sizeof(CDoorTile));
-	}
-	else
-	{
-		m_pDoor = 0;
-		m_pSwitchers = 0;
+		int MaskSize = (m_Width*m_Height+31)/32;
+		m_pDoorMask = new unsigned[MaskSize];
+		mem_zero(m_pDoorMask, MaskSize * sizeof(unsigned));
 	}
 
 	if(m_pLayers->TuneLayer())
@@ -91,11 +90,6 @@ void CCollision::Init(class CLayers *pLayers)
 			if(m_pSwitch[i].m_Number > m_NumSwitchers)
 				m_NumSwitchers = m_pSwitch[i].m_Number;
 
-			if(m_pSwitch[i].m_Number)
-				m_pDoor[i].m_Number = m_pSwitch[i].m_Number;
-			else
-				m_pDoor[i].m_Number = 0;
-
 			Index = m_pSwitch[i].m_Type;
 
 			if(Index <= TILE_NPH_START)
@@ -162,20 +156,30 @@ void CCollision::Init(class CLayers *pLayers)
 		}
 	}
 	if(m_NumSwitchers)
-	{
-		m_pSwitchers = new SSwitchers[m_NumSwitchers+1];
+		InitSwitches(m_NumSwitchers);
+}
 
-		for (int i = 0; i < m_NumSwitchers+1; ++i)
-		{
-			m_pSwitchers[i].m_Initial = true;
-			for (int j = 0; j < MAX_CLIENTS; ++j)
-			{
-				m_pSwitchers[i].m_Status[j] = true;
-				m_pSwitchers[i].m_EndTick[j] = 0;
-				m_pSwitchers[i].m_Type[j] = 0;
-			}
-		}
-	}
+void CCollision::InitSwitches(int NumSwitchers)
+{
+	if(m_pSwitchStatus)
+		delete[] m_pSwitchStatus;
+	if(m_pSwitchInitial)
+		delete[] m_pSwitchInitial;
+	m_SwitchTimers.clear();
+	for(int i = 0; i < SWITCH_WHEEL_SIZE; i++)
+		m_aSwitchWheel[i].clear();
+	m_SwitchWheelTick = -1;
+
+	m_NumSwitchers = NumSwitchers;
+	m_pSwitchStatus = new unsigned[(m_NumSwitchers+1)*SWITCH_WORDS];
+	m_pSwitchInitial = new bool[m_NumSwitchers+1];
+	for(int i = 0; i < (m_NumSwitchers+1)*SWITCH_WORDS; i++)
+		m_pSwitchStatus[i] = ~0u;
+	for(int i = 0; i < m_NumSwitchers+1; i++)
+		m_pSwitchInitial[i] = true;
+
+	if(g_Config.m_Debug)
+		dbg_msg("collision", "switch state for %d switches: %d bytes", m_NumSwitchers, SwitchMemoryUsage());
 }
 
 int CCollision::GetTile(int x, int y)
@@ -454,10 +458,17 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, float Elas
 
 void CCollision::Dest()
 {
-	if(m_pDoor)
-		delete[] m_pDoor;
-	if(m_pSwitchers)
-		delete[] m_pSwitchers;
+	if(m_pDoorMask)
+		delete[] m_pDoorMask;
+	if(m_pSwitchStatus)
+		delete[] m_pSwitchStatus;
+	if(m_pSwitchInitial)
+		delete[] m_pSwitchInitial;
+	m_Doors.clear();
+	m_SwitchTimers.clear();
+	for(int i = 0; i < SWITCH_WHEEL_SIZE; i++)
+		m_aSwitchWheel[i].clear();
+	m_SwitchWheelTick = -1;
 	m_pTiles = 0;
 	m_Width = 0;
 	m_Height = 0;
@@ -467,8 +478,9 @@ void CCollision::Dest()
 	m_pFront = 0;
 	m_pSwitch = 0;
 	m_pTune = 0;
-	m_pDoor = 0;
-	m_pSwitchers = 0;
+	m_pDoorMask = 0;
+	m_pSwitchStatus = 0;
+	m_pSwitchInitial = 0;
 }
 
 int CCollision::IsSolid(int x, int y)
@@ -732,7 +744,7 @@ bool CCollision::TileExists(int Index)
 		return true;
 	if(m_pSpeedup && m_pSpeedup[Index].m_Force > 0)
 		return true;
-	if(m_pDoor && m_pDoor[Index].m_Index)
+	if(DoorTile(Index)->m_Index)
 		return true;
 	if(m_pSwitch && m_pSwitch[Index].m_Type)
 		return true;
@@ -769,15 +781,19 @@ bool CCollision::TileExistsNext(int Index)
 		if((m_pFront[TileBelow].m_Index == TILE_STOP && m_pFront[TileBelow].m_Flags == ROTATION_0) || (m_pFront[TileAbove].m_Index == TILE_STOP && m_pFront[TileAbove].m_Flags == ROTATION_180))
 			return true;
 	}
-	if(m_pDoor)
+	if(!m_Doors.empty())
 	{
-		if(m_pDoor[TileOnTheRight].m_Index == TILE_STOPA || m_pDoor[TileOnTheLeft].m_Index == TILE_STOPA || ((m_pDoor[TileOnTheRight].m_Index == TILE_STOPS || m_pDoor[TileOnTheLeft].m_Index == TILE_STOPS) && m_pDoor[TileOnTheRight].m_Flags|ROTATION_270|ROTATION_90))
+		const CDoorTile *pRight = DoorTile(TileOnTheRight);
+		const CDoorTile *pLeft = DoorTile(TileOnTheLeft);
+		const CDoorTile *pBelow = DoorTile(TileBelow);
+		const CDoorTile *pAbove = DoorTile(TileAbove);
+		if(pRight->m_Index == TILE_STOPA || pLeft->m_Index == TILE_STOPA || ((pRight->m_Index == TILE_STOPS || pLeft->m_Index == TILE_STOPS) && pRight->m_Flags|ROTATION_270|ROTATION_90))
 			return true;
-		if(m_pDoor[TileBelow].m_Index == TILE_STOPA || m_pDoor[TileAbove].m_Index == TILE_STOPA || ((m_pDoor[TileBelow].m_Index == TILE_STOPS || m_pDoor[TileAbove].m_Index == TILE_STOPS) && m_pDoor[TileBelow].m_Flags|ROTATION_180|ROTATION_0))
+		if(pBelow->m_Index == TILE_STOPA || pAbove->m_Index == TILE_STOPA || ((pBelow->m_Index == TILE_STOPS || pAbove->m_Index == TILE_STOPS) && pBelow->m_Flags|ROTATION_180|ROTATION_0))
 			return true;
-		if((m_pDoor[TileOnTheRight].m_Index == TILE_STOP && m_pDoor[TileOnTheRight].m_Flags == ROTATION_270) || (m_pDoor[TileOnTheLeft].m_Index == TILE_STOP && m_pDoor[TileOnTheLeft].m_Flags == ROTATION_90))
+		if((pRight->m_Index == TILE_STOP && pRight->m_Flags == ROTATION_270) || (pLeft->m_Index == TILE_STOP && pLeft->m_Flags == ROTATION_90))
 			return true;
-		if((m_pDoor[TileBelow].m_Index == TILE_STOP && m_pDoor[TileBelow].m_Flags == ROTATION_0) || (m_pDoor[TileAbove].m_Index == TILE_STOP && m_pDoor[TileAbove].m_Flags == ROTATION_180))
+		if((pBelow->m_Index == TILE_STOP && pBelow->m_Flags == ROTATION_0) || (pAbove->m_Index == TILE_STOP && pAbove->m_Flags == ROTATION_180))
 			return true;
 	}
 	return false;
@@ -1025,36 +1041,193 @@ void CCollision::SetCollisionAt(float x, float y, int flag)
 
 void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Number)
 {
-	if(!m_pDoor)
+	if(!m_pDoorMask)
 		return;
 	int Nx = clamp(round_to_int(x)/32, 0, m_Width-1);
 	int Ny = clamp(round_to_int(y)/32, 0, m_Height-1);
+	int Index = Ny * m_Width + Nx;
+
+	if(!Type)
+	{
+		m_pDoorMask[Index/32] &= ~(1u<<(Index%32));
+		m_Doors.erase(Index);
+		return;
+	}
 
-	m_pDoor[Ny * m_Width + Nx].m_Index = Type;
-	m_pDoor[Ny * m_Width + Nx].m_Flags = Flags;
-	m_pDoor[Ny * m_Width + Nx].m_Number = Number;
+	m_pDoorMask[Index/32] |= 1u<<(Index%32);
+	CDoorTile &Door = m_Doors[Index];
+	Door.m_Index = Type;
+	Door.m_Flags = Flags;
+	Door.m_Number = Number;
+}
+
+const CDoorTile *CCollision::DoorTile(int Index)
+{
+	static const CDoorTile s_EmptyDoor = {0, 0, 0};
+	if(!m_pDoorMask || Index < 0 || !(m_pDoorMask[Index/32]&(1u<<(Index%32))))
+		return &s_EmptyDoor;
+	return &m_Doors.find(Index)->second;
 }
 
 int CCollision::GetDTileIndex(int Index)
 {
-	if(!m_pDoor || Index < 0 || !m_pDoor[Index].m_Index)
-		return 0;
-	return m_pDoor[Index].m_Index;
+	return DoorTile(Index)->m_Index;
 }
 
 int CCollision::GetDTileNumber(int Index)
 {
-	if(!m_pDoor || Index < 0 || !m_pDoor[Index].m_Index)
-		return 0;
-	if(m_pDoor[Index].m_Number) return m_pDoor[Index].m_Number;
-	return 0;
+	return DoorTile(Index)->m_Number;
 }
 
 int CCollision::GetDTileFlags(int Index)
 {
-	if(!m_pDoor || Index < 0 || !m_pDoor[Index].m_Index)
+	return DoorTile(Index)->m_Flags;
+}
+
+bool CCollision::SwitchStatus(int Number, int Team)
+{
+	if(!m_pSwitchStatus || Number < 0 || Number > m_NumSwitchers || Team < 0 || Team >= SWITCH_TEAMS)
+		return false;
+	return m_pSwitchStatus[Number*SWITCH_WORDS + Team/32]&(1u<<(Team%32));
+}
+
+void CCollision::SetSwitchStatus(int Number, int Team, bool Status, int EndTick, int Type)
+{
+	if(!m_pSwitchStatus || Number < 0 || Number > m_NumSwitchers || Team < 0 || Team >= SWITCH_TEAMS)
+		return;
+
+	if(Status)
+		m_pSwitchStatus[Number*SWITCH_WORDS + Team/32] |= 1u<<(Team%32);
+	else
+		m_pSwitchStatus[Number*SWITCH_WORDS + Team/32] &= ~(1u<<(Team%32));
+
+	// a timed switch without an end tick expires on the next tick, like before
+	int Key = Number*SWITCH_TEAMS + Team;
+	if(Type == TILE_SWITCHTIMEDOPEN || Type == TILE_SWITCHTIMEDCLOSE)
+	{
+		CSwitchTimer &Timer = m_SwitchTimers[Key];
+		Timer.m_EndTick = EndTick;
+		Timer.m_Type = Type;
+		Timer.m_Serial = ++m_SwitchTimerSerial;
+		AddSwitchTimer(Key, EndTick);
+	}
+	else
+		m_SwitchTimers.erase(Key);
+}
+
+int CCollision::SwitchEndTick(int Number, int Team)
+{
+	std::map<int, CSwitchTimer>::const_iterator It = m_SwitchTimers.find(Number*SWITCH_TEAMS + Team);
+	return It != m_SwitchTimers.end() ? It->second.m_EndTick : 0;
+}
+
+int CCollision::SwitchType(int Number, int Team)
+{
+	std::map<int, CSwitchTimer>::const_iterator It = m_SwitchTimers.find(Number*SWITCH_TEAMS + Team);
+	if(It != m_SwitchTimers.end())
+		return It->second.m_Type;
+	return SwitchStatus(Number, Team) ? TILE_SWITCHOPEN : TILE_SWITCHCLOSE;
+}
+
+bool CCollision::SwitchInitial(int Number)
+{
+	if(!m_pSwitchInitial || Number < 0 || Number > m_NumSwitchers)
+		return true;
+	return m_pSwitchInitial[Number];
+}
+
+void CCollision::SetSwitchInitial(int Number, bool Initial)
+{
+	if(!m_pSwitchInitial || Number < 0 || Number > m_NumSwitchers)
+		return;
+	m_pSwitchInitial[Number] = Initial;
+}
+
+void CCollision::ResetSwitches(int Team)
+{
+	if(!m_pSwitchStatus || Team < 0 || Team >= SWITCH_TEAMS)
+		return;
+
+	for(int i = 0; i < m_NumSwitchers+1; i++)
+	{
+		if(m_pSwitchInitial[i])
+			m_pSwitchStatus[i*SWITCH_WORDS + Team/32] |= 1u<<(Team%32);
+		else
+			m_pSwitchStatus[i*SWITCH_WORDS + Team/32] &= ~(1u<<(Team%32));
+	}
+
+	for(std::map<int, CSwitchTimer>::iterator It = m_SwitchTimers.begin(); It != m_SwitchTimers.end();)
+	{
+		if(It->first%SWITCH_TEAMS == Team)
+			m_SwitchTimers.erase(It++);
+		else
+			++It;
+	}
+}
+
+void CCollision::AddSwitchTimer(int Key, int EndTick)
+{
+	// timers that are already due fire on the next processed tick
+	if(m_SwitchWheelTick >= 0 && EndTick <= m_SwitchWheelTick)
+		EndTick = m_SwitchWheelTick+1;
+
+	CSwitchWheelEntry Entry;
+	Entry.m_Key = Key;
+	Entry.m_Serial = m_SwitchTimers[Key].m_Serial;
+	m_aSwitchWheel[((EndTick%SWITCH_WHEEL_SIZE)+SWITCH_WHEEL_SIZE)%SWITCH_WHEEL_SIZE].push_back(Entry);
+}
+
+void CCollision::TickSwitches(int Tick)
+{
+	if(m_SwitchTimers.empty())
+	{
+		m_SwitchWheelTick = Tick;
+		return;
+	}
+
+	int FirstTick = m_SwitchWheelTick >= 0 ? max(m_SwitchWheelTick+1, Tick-SWITCH_WHEEL_SIZE+1) : Tick-SWITCH_WHEEL_SIZE+1;
+	m_SwitchWheelTick = Tick;
+
+	for(int t = FirstTick; t <= Tick; t++)
+	{
+		std::vector<CSwitchWheelEntry> &Bucket = m_aSwitchWheel[((t%SWITCH_WHEEL_SIZE)+SWITCH_WHEEL_SIZE)%SWITCH_WHEEL_SIZE];
+		unsigned Kept = 0;
+		for(unsigned i = 0; i < Bucket.size(); i++)
+		{
+			std::map<int, CSwitchTimer>::iterator It = m_SwitchTimers.find(Bucket[i].m_Key);
+			if(It == m_SwitchTimers.end() || It->second.m_Serial != Bucket[i].m_Serial)
+				continue; // cancelled or rescheduled
+
+			if(It->second.m_EndTick > Tick)
+			{
+				// due in a later turn of the wheel
+				Bucket[Kept++] = Bucket[i];
+				continue;
+			}
+
+			int Number = It->first/SWITCH_TEAMS;
+			int Team = It->first%SWITCH_TEAMS;
+			if(It->second.m_Type == TILE_SWITCHTIMEDOPEN)
+				m_pSwitchStatus[Number*SWITCH_WORDS + Team/32] &= ~(1u<<(Team%32));
+			else
+				m_pSwitchStatus[Number*SWITCH_WORDS + Team/32] |= 1u<<(Team%32);
+			m_SwitchTimers.erase(It);
+		}
+		Bucket.resize(Kept);
+	}
+}
+
+int CCollision::SwitchMemoryUsage()
+{
+	if(!m_pSwitchStatus)
 		return 0;
-	return m_pDoor[Index].m_Flags;
+	int Size = (m_NumSwitchers+1)*(SWITCH_WORDS*sizeof(unsigned)+sizeof(bool));
+	Size += m_SwitchTimers.size()*(sizeof(CSwitchTimer)+sizeof(int));
+	for(int i = 0; i < SWITCH_WHEEL_SIZE; i++)
+		Size += m_aSwitchWheel[i].capacity()*sizeof(CSwitchWheelEntry);
+	if(m_pDoorMask)
+		Size += (m_Width*m_Height+31)/32*sizeof(unsigned) + m_Doors.size()*(sizeof(CDoorTile)+sizeof(int));
+	return Size;
 }
 
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *Ox, int *Oy)
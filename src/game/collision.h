@@ -5,8 +5,11 @@
 
 #include <base/vmath.h>
 #include <engine/shared/protocol.h>
+#include <game/mapitems.h>
 
 #include <list>
+#include <map>
+#include <vector>
 
 class CCollision
 {
@@ -109,25 +112,58 @@ public:
 	class CLayers *Layers() { return m_pLayers; }
 	int m_NumSwitchers;
 
+	// switch states per team, timed switches are expired by TickSwitches
+	bool SwitchStatus(int Number, int Team);
+	void SetSwitchStatus(int Number, int Team, bool Status, int EndTick, int Type);
+	int SwitchEndTick(int Number, int Team);
+	int SwitchType(int Number, int Team);
+	bool SwitchInitial(int Number);
+	void SetSwitchInitial(int Number, bool Initial);
+	void ResetSwitches(int Team);
+	void TickSwitches(int Tick);
+	void InitSwitches(int NumSwitchers);
+	int SwitchMemoryUsage();
+
 private:
 
+	enum
+	{
+		SWITCH_TEAMS=MAX_CLIENTS+1,
+		SWITCH_WORDS=(SWITCH_TEAMS+31)/32,
+		SWITCH_WHEEL_SIZE=256,
+	};
+
+	struct CSwitchTimer
+	{
+		int m_EndTick;
+		int m_Type;
+		int m_Serial;
+	};
+
+	struct CSwitchWheelEntry
+	{
+		int m_Key;
+		int m_Serial;
+	};
+
 	class CTeleTile *m_pTele;
 	class CSpeedupTile *m_pSpeedup;
 	class CTile *m_pFront;
 	class CSwitchTile *m_pSwitch;
 	class CTuneTile *m_pTune;
-	class CDoorTile *m_pDoor;
-	struct SSwitchers
-	{
-		bool m_Status[MAX_CLIENTS];
-		bool m_Initial;
-		int m_EndTick[MAX_CLIENTS];
-		int m_Type[MAX_CLIENTS];
-	};
-
-public:
 
-	SSwitchers* m_pSwitchers;
+	// doors are only placed by entities, so they are kept sparse
+	unsigned *m_pDoorMask;
+	std::map<int, CDoorTile> m_Doors;
+	const CDoorTile *DoorTile(int Index);
+
+	unsigned *m_pSwitchStatus;
+	bool *m_pSwitchInitial;
+	std::map<int, CSwitchTimer> m_SwitchTimers;
+	std::vector<CSwitchWheelEntry> m_aSwitchWheel[SWITCH_WHEEL_SIZE];
+	int m_SwitchWheelTick;
+	int m_SwitchTimerSerial;
+	void AddSwitchTimer(int Key, int EndTick);
 };
 
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *Ox, int *Oy);
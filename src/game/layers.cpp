@@ -1,5 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/shared/config.h>
+
 #include "layers.h"
 
 CLayers::CLayers()
@@ -160,6 +162,47 @@ void CLayers::InitBackground(class IMap *pMap)
 	}
 }
 
+void CLayers::PrefetchData(bool Render)
+{
+	// without extra threads the lazy loads are just as fast, and on a single
+	// core the threads only take turns with the one loading the map
+	if(g_Config.m_MapDecodeThreads <= 0 || thread_num_cores() <= 1)
+		return;
+
+	// the layers collision uses, for rendering also the design layers. they
+	// stay loaded anyway, unlike the images that are unloaded after their
+	// upload and so are left to load one at a time
+	int *pIndices = (int *)mem_alloc(NumLayers()*2*sizeof(int), 1);
+	int Num = 0;
+	for(int l = 0; l < NumLayers(); l++)
+	{
+		CMapItemLayer *pLayer = GetLayer(l);
+		if(pLayer->m_Type != LAYERTYPE_TILES)
+			continue;
+
+		CMapItemLayerTilemap *pTilemap = reinterpret_cast<CMapItemLayerTilemap *>(pLayer);
+		int Special = -1;
+		if(pTilemap == m_pTeleLayer)
+			Special = pTilemap->m_Tele;
+		else if(pTilemap == m_pSpeedupLayer)
+			Special = pTilemap->m_Speedup;
+		else if(pTilemap == m_pFrontLayer)
+			Special = pTilemap->m_Front;
+		else if(pTilemap == m_pSwitchLayer)
+			Special = pTilemap->m_Switch;
+		else if(pTilemap == m_pTuneLayer)
+			Special = pTilemap->m_Tune;
+
+		if(Special >= 0)
+			pIndices[Num++] = Special;
+		if(Render || pTilemap == m_pGameLayer)
+			pIndices[Num++] = pTilemap->m_Data;
+	}
+
+	m_pMap->PrefetchData(pIndices, Num);
+	mem_free(pIndices);
+}
+
 CMapItemGroup *CLayers::GetGroup(int Index) const
 {
 	return static_cast<CMapItemGroup *>(m_pMap->GetItem(m_GroupsStart+Index, 0, 0));
@@ -20,7 +20,9 @@ public:
 	CLayers();
 	void Init(class IKernel *pKernel);
 	void InitBackground(class IMap *pMap);
+	void PrefetchData(bool Render);
 	int NumGroups() const { return m_GroupsNum; };
+	int NumLayers() const { return m_LayersNum; };
 	class IMap *Map() const { return m_pMap; };
 	CMapItemGroup *GameGroup() const { return m_pGameGroup; };
 	CMapItemLayerTilemap *GameLayer() const { return m_pGameLayer; };
@@ -46,6 +46,11 @@ public:
 	virtual void Tick();
 	virtual void TickDefered();
 	virtual void TickPaused();
+
+	// the two halves of TickDefered, moving characters that can't collide
+	// with each other may run in parallel, the rest has to stay serial
+	void TickDeferedMove();
+	void TickDeferedPost();
 	virtual void Snap(int SnappingClient);
 	virtual int NetworkClipped(int SnappingClient);
 	virtual int NetworkClipped(int SnappingClient, vec2 CheckPos);
@@ -155,6 +160,13 @@ private:
 	CCharacterCore m_SendCore; // core that we should send
 	CCharacterCore m_ReckoningCore; // the dead reckoning core
 
+	// movement results for TickDeferedPost
+	vec2 m_DeferedStartPos;
+	vec2 m_DeferedStartVel;
+	bool m_StuckBefore;
+	bool m_StuckAfterMove;
+	bool m_StuckAfterQuant;
+
 	// DDRace
 
 
@@ -91,7 +91,7 @@ void CDoor::Snap(int SnappingClient)
 		return;
 
 	if (Char->IsAlive() && GameServer()->Collision()->m_NumSwitchers > 0
-			&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()]
+			&& !GameServer()->Collision()->SwitchStatus(m_Number, Char->Team())
 			&& (!Tick))
 		return;
 
@@ -101,7 +101,7 @@ void CDoor::Snap(int SnappingClient)
 		pObj->m_FromY = (int) m_Pos.y;
 	}
 	else if (Char->IsAlive() && GameServer()->Collision()->m_NumSwitchers > 0
-		&& GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()])
+		&& GameServer()->Collision()->SwitchStatus(m_Number, Char->Team()))
 	{
 		pObj->m_FromX = (int) m_To.x;
 		pObj->m_FromY = (int) m_To.y;
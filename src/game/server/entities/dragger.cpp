@@ -32,7 +32,7 @@ void CDragger::Move()
 	if (m_Target && (!m_Target->IsAlive() || (m_Target->IsAlive()
 			&& (m_Target->m_Super || m_Target->IsPaused()
 					|| (m_Layer == LAYER_SWITCH
-							&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[m_Target->Team()])))))
+							&& !GameServer()->Collision()->SwitchStatus(m_Number, m_Target->Team()))))))
 		m_Target = 0;
 
 	mem_zero(m_SoloEnts, sizeof(m_SoloEnts));
@@ -54,7 +54,7 @@ void CDragger::Move()
 			continue;
 		}
 		if (m_Layer == LAYER_SWITCH
-				&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Temp->Team()])
+				&& !GameServer()->Collision()->SwitchStatus(m_Number, Temp->Team()))
 		{
 			m_SoloEnts[i] = 0;
 			continue;
@@ -327,7 +327,7 @@ void CDragger::Snap(int SnappingClient)
 		int Tick = (Server()->Tick() % Server()->TickSpeed()) % 11;
 		if (Char && Char->IsAlive()
 				&& (m_Layer == LAYER_SWITCH
-						&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()]
+						&& !GameServer()->Collision()->SwitchStatus(m_Number, Char->Team())
 						&& (!Tick)))
 			continue;
 		if (Char && Char->IsAlive())
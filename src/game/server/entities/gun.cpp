@@ -46,7 +46,7 @@ void CGun::Fire()
 		//now gun doesn't affect on super
 		if(Target->Team() == TEAM_SUPER)
 			continue;
-		if(m_Layer == LAYER_SWITCH && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Target->Team()])
+		if(m_Layer == LAYER_SWITCH && !GameServer()->Collision()->SwitchStatus(m_Number, Target->Team()))
 			continue;
 		int res = GameServer()->Collision()->IntersectLine(m_Pos, Target->m_Pos,0,0,false);
 		if (!res)
@@ -123,7 +123,7 @@ void CGun::Snap(int SnappingClient)
 		Char = GameServer()->GetPlayerChar(GameServer()->m_apPlayers[SnappingClient]->m_SpectatorID);
 
 	int Tick = (Server()->Tick()%Server()->TickSpeed())%11;
-	if (Char && Char->IsAlive() && (m_Layer == LAYER_SWITCH && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()]) && (!Tick)) return;
+	if (Char && Char->IsAlive() && (m_Layer == LAYER_SWITCH && !GameServer()->Collision()->SwitchStatus(m_Number, Char->Team())) && (!Tick)) return;
 	CNetObj_Laser *pObj = static_cast<CNetObj_Laser *>(Server()->SnapNewItem(NETOBJTYPE_LASER, m_ID, sizeof(CNetObj_Laser)));
 
 	if (!pObj)
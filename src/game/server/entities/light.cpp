@@ -32,7 +32,7 @@ bool CLight::HitCharacter()
 	{
 		CCharacter * Char = *i;
 		if (m_Layer == LAYER_SWITCH
-				&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()])
+				&& !GameServer()->Collision()->SwitchStatus(m_Number, Char->Team()))
 			continue;
 		Char->Freeze();
 	}
@@ -119,7 +119,7 @@ void CLight::Snap(int SnappingClient)
 
 	if (Char && Char->IsAlive()
 			&& m_Layer == LAYER_SWITCH
-			&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()]
+			&& !GameServer()->Collision()->SwitchStatus(m_Number, Char->Team())
 			&& (Tick))
 		return;
 
@@ -138,7 +138,7 @@ void CLight::Snap(int SnappingClient)
 		pObj->m_FromY = (int) m_Pos.y;
 	}
 	else if (Char && m_Layer == LAYER_SWITCH
-			&& GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Char->Team()])
+			&& GameServer()->Collision()->SwitchStatus(m_Number, Char->Team()))
 	{
 		pObj->m_FromX = (int) m_To.x;
 		pObj->m_FromY = (int) m_To.y;
@@ -92,7 +92,7 @@ void CPlasma::Snap(int SnappingClient)
 
 	if (SnapChar && SnapChar->IsAlive()
 			&& (m_Layer == LAYER_SWITCH
-					&& !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[SnapChar->Team()])
+					&& !GameServer()->Collision()->SwitchStatus(m_Number, SnapChar->Team()))
 			&& (!Tick))
 		return;
 
@@ -157,7 +157,7 @@ void CProjectile::Tick()
 			GameServer()->CreateSound(ColPos, m_SoundImpact,
 			(m_Owner != -1)? TeamMask : -1LL);
 		}
-		else if(pTargetChr && m_Freeze && ((m_Layer == LAYER_SWITCH && GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[pTargetChr->Team()]) || m_Layer != LAYER_SWITCH))
+		else if(pTargetChr && m_Freeze && ((m_Layer == LAYER_SWITCH && GameServer()->Collision()->SwitchStatus(m_Number, pTargetChr->Team())) || m_Layer != LAYER_SWITCH))
 			pTargetChr->Freeze();
 		if(Collide && m_Bouncing != 0)
 		{
@@ -241,7 +241,7 @@ void CProjectile::Snap(int SnappingClient)
 
 	CCharacter* pSnapChar = GameServer()->GetPlayerChar(SnappingClient);
 	int Tick = (Server()->Tick()%Server()->TickSpeed())%((m_Explosive)?6:20);
-	if (pSnapChar && pSnapChar->IsAlive() && (m_Layer == LAYER_SWITCH && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[pSnapChar->Team()] && (!Tick)))
+	if (pSnapChar && pSnapChar->IsAlive() && (m_Layer == LAYER_SWITCH && !GameServer()->Collision()->SwitchStatus(m_Number, pSnapChar->Team()) && (!Tick)))
 		return;
 
 	CCharacter *pOwnerChar = 0;
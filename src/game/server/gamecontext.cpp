@@ -767,25 +767,7 @@ void CGameContext::OnTick()
 			SendChat(-1, CGameContext::CHAT_ALL, Line);
 	}
 
-	if(Collision()->m_NumSwitchers > 0)
-		for (int i = 0; i < Collision()->m_NumSwitchers+1; ++i)
-		{
-			for (int j = 0; j < MAX_CLIENTS; ++j)
-			{
-				if(Collision()->m_pSwitchers[i].m_EndTick[j] <= Server()->Tick() && Collision()->m_pSwitchers[i].m_Type[j] == TILE_SWITCHTIMEDOPEN)
-				{
-					Collision()->m_pSwitchers[i].m_Status[j] = false;
-					Collision()->m_pSwitchers[i].m_EndTick[j] = 0;
-					Collision()->m_pSwitchers[i].m_Type[j] = TILE_SWITCHCLOSE;
-				}
-				else if(Collision()->m_pSwitchers[i].m_EndTick[j] <= Server()->Tick() && Collision()->m_pSwitchers[i].m_Type[j] == TILE_SWITCHTIMEDCLOSE)
-				{
-					Collision()->m_pSwitchers[i].m_Status[j] = true;
-					Collision()->m_pSwitchers[i].m_EndTick[j] = 0;
-					Collision()->m_pSwitchers[i].m_Type[j] = TILE_SWITCHOPEN;
-				}
-			}
-		}
+	Collision()->TickSwitches(Server()->Tick());
 
 #ifdef CONF_DEBUG
 	if(g_Config.m_DbgDummies)
@@ -1862,7 +1844,7 @@ void CGameContext::ConSwitchOpen(IConsole::IResult *pResult, void *pUserData)
 
 	if (pSelf->Collision()->m_NumSwitchers > 0 && Switch >= 0 && Switch < pSelf->Collision()->m_NumSwitchers+1)
 	{
-		pSelf->Collision()->m_pSwitchers[Switch].m_Initial = false;
+		pSelf->Collision()->SetSwitchInitial(Switch, false);
 		char aBuf[256];
 		str_format(aBuf, sizeof(aBuf), "switch %d opened by default", Switch);
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
@@ -2360,6 +2342,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 		Server()->SnapSetStaticsize(i, m_NetObjHandler.GetObjSize(i));
 
 	m_Layers.Init(Kernel());
+	m_Layers.PrefetchData(false);
 	m_Collision.Init(&m_Layers);
 
 	// reset everything here
@@ -2410,7 +2393,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 
 		if(Collision()->m_NumSwitchers > 0)
 			for (int i = 0; i < Collision()->m_NumSwitchers+1; ++i)
-				Collision()->m_pSwitchers[i].m_Initial = true;
+				Collision()->SetSwitchInitial(i, true);
 	}
 
 	Console()->ExecuteFile(g_Config.m_SvResetFile);
@@ -2559,6 +2542,9 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 
 	//game.world.insert_entity(game.Controller);
 
+	// everything the game needs from the map is loaded by now
+	Kernel()->RequestInterface<IMap>()->DropFileCopy();
+
 #ifdef CONF_DEBUG
 	if(g_Config.m_DbgDummies)
 	{
@@ -2620,6 +2606,7 @@ void CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 		mem_free(aLines[i]);
 	}
 
+	int64 StartTime = time_get();
 	CDataFileReader Reader;
 	Reader.Open(pStorage, pNewMapName, IStorage::TYPE_ALL);
 
@@ -2692,13 +2679,22 @@ void CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 			Writer.AddData(TotalLength, pSettings);
 			continue;
 		}
-		unsigned char *pData = (unsigned char *)Reader.GetData(i);
+
+		// copy the compressed blocks as they are, only old maps need recompressing
 		int Size = Reader.GetUncompressedDataSize(i);
-		Writer.AddData(Size, pData);
-		Reader.UnloadData(i);
+		int CompressedSize = Reader.GetDataSize(i);
+		void *pCompressed = mem_alloc(max(CompressedSize, 1), 1);
+		if(Reader.GetCompressedData(i, pCompressed))
+			Writer.AddDataCompressed(Size, CompressedSize, pCompressed);
+		else
+		{
+			Writer.AddData(Size, Reader.GetData(i));
+			Reader.UnloadData(i);
+		}
+		mem_free(pCompressed);
 	}
 
-	dbg_msg("mapchange", "imported settings");
+	dbg_msg("mapchange", "imported settings in %.2fms", (time_get()-StartTime)*1000.0f/time_freq());
 	Reader.Close();
 	Writer.OpenFile(pStorage, aTemp);
 	Writer.Finish();
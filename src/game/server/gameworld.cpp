@@ -4,9 +4,11 @@
 #include "gameworld.h"
 #include "entity.h"
 #include "gamecontext.h"
+#include "teams.h"
 #include <algorithm>
 #include <utility>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
 
 //////////////////////////////////////////////////
 // game world
@@ -257,13 +259,7 @@ void CGameWorld::Tick()
 				pEnt = m_pNextTraverseEntity;
 			}
 
-		for(int i = 0; i < NUM_ENTTYPES; i++)
-			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
-			{
-				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-				pEnt->TickDefered();
-				pEnt = m_pNextTraverseEntity;
-			}
+		TickDefered();
 	}
 	else
 	{
@@ -282,6 +278,161 @@ void CGameWorld::Tick()
 	UpdatePlayerMaps();
 }
 
+struct CMoveJob
+{
+	CJob m_Job;
+	CCharacter *m_apChars[MAX_CLIENTS];
+	int m_NumChars;
+};
+
+static int MoveCharactersJob(void *pUser)
+{
+	CMoveJob *pMoveJob = (CMoveJob *)pUser;
+	for(int i = 0; i < pMoveJob->m_NumChars; i++)
+		pMoveJob->m_apChars[i]->TickDeferedMove();
+	return 0;
+}
+
+void CGameWorld::MoveCharactersParallel(CCharacter **apChars, int NumChars)
+{
+	static CJobPool s_Pool;
+	static int s_NumThreads = 0;
+	if(s_NumThreads < g_Config.m_SvParallelTick)
+	{
+		s_Pool.Init(g_Config.m_SvParallelTick - s_NumThreads);
+		s_NumThreads = g_Config.m_SvParallelTick;
+	}
+
+	// characters only collide with their own team, solo players with nobody
+	// and the super team with everyone, which forces a single island
+	enum
+	{
+		ISLAND_SOLO=TEAM_SUPER+1,
+		NUM_ISLANDS=ISLAND_SOLO+MAX_CLIENTS,
+	};
+	CTeamsCore *pTeams = &apChars[0]->Teams()->m_Core;
+	int SuperTeam = pTeams->m_IsDDRace16 ? VANILLA_TEAM_SUPER : TEAM_SUPER;
+	int aIsland[MAX_CLIENTS];
+	int aIslandSize[NUM_ISLANDS] = {0};
+	for(int i = 0; i < NumChars; i++)
+	{
+		int ClientID = apChars[i]->GetPlayer()->GetCID();
+		if(pTeams->Team(ClientID) == SuperTeam)
+		{
+			for(int j = 0; j < NumChars; j++)
+				apChars[j]->TickDeferedMove();
+			return;
+		}
+		aIsland[i] = pTeams->GetSolo(ClientID) ? ISLAND_SOLO + ClientID : pTeams->Team(ClientID);
+		aIslandSize[aIsland[i]]++;
+	}
+
+	// hand out whole islands to the jobs with the least work, the characters
+	// of an island keep their world order so the result matches the serial tick
+	int NumJobs = min(g_Config.m_SvParallelTick+1, NumChars);
+	CMoveJob aJobs[MAX_CLIENTS];
+	int aJobOfIsland[NUM_ISLANDS];
+	for(int i = 0; i < NumJobs; i++)
+		aJobs[i].m_NumChars = 0;
+	for(int i = 0; i < NUM_ISLANDS; i++)
+		aJobOfIsland[i] = -1;
+	int aJobSize[MAX_CLIENTS] = {0};
+	for(int i = 0; i < NumChars; i++)
+	{
+		int Island = aIsland[i];
+		if(aJobOfIsland[Island] == -1)
+		{
+			int Best = 0;
+			for(int j = 1; j < NumJobs; j++)
+				if(aJobSize[j] < aJobSize[Best])
+					Best = j;
+			aJobOfIsland[Island] = Best;
+			aJobSize[Best] += aIslandSize[Island];
+		}
+		CMoveJob *pMoveJob = &aJobs[aJobOfIsland[Island]];
+		pMoveJob->m_apChars[pMoveJob->m_NumChars++] = apChars[i];
+	}
+
+	for(int i = 1; i < NumJobs; i++)
+		if(aJobs[i].m_NumChars)
+			s_Pool.Add(&aJobs[i].m_Job, MoveCharactersJob, &aJobs[i]);
+	MoveCharactersJob(&aJobs[0]);
+	for(int i = 1; i < NumJobs; i++)
+		if(aJobs[i].m_NumChars)
+			s_Pool.Wait(&aJobs[i].m_Job);
+}
+
+// on a single core the threads would only take turns, the comparison
+// still runs the parallel path so it can be checked anywhere
+static bool ParallelTick()
+{
+	static int s_NumCores = thread_num_cores();
+	return g_Config.m_SvParallelTick && (s_NumCores > 1 || g_Config.m_DbgParallelTick);
+}
+
+void CGameWorld::TickDefered()
+{
+	bool Parallel = ParallelTick();
+
+	// characters are the last entity type, so everything else keeps its order
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		if(i == ENTTYPE_CHARACTER && Parallel)
+			break;
+		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
+		{
+			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			pEnt->TickDefered();
+			pEnt = m_pNextTraverseEntity;
+		}
+	}
+
+	if(!Parallel)
+		return;
+
+	CCharacter *apChars[MAX_CLIENTS];
+	int NumChars = 0;
+	for(CCharacter *pChr = (CCharacter *)FindFirst(ENTTYPE_CHARACTER); pChr && NumChars < MAX_CLIENTS; pChr = (CCharacter *)pChr->TypeNext())
+		apChars[NumChars++] = pChr;
+	if(!NumChars)
+		return;
+
+	if(g_Config.m_DbgParallelTick)
+	{
+		// run both variants from the same state and compare the outcome
+		CCharacterCore aBefore[MAX_CLIENTS];
+		CNetObj_CharacterCore aParallel[MAX_CLIENTS];
+		for(int i = 0; i < NumChars; i++)
+			aBefore[i] = *apChars[i]->Core();
+
+		MoveCharactersParallel(apChars, NumChars);
+		for(int i = 0; i < NumChars; i++)
+		{
+			apChars[i]->Core()->Write(&aParallel[i]);
+			*apChars[i]->Core() = aBefore[i];
+		}
+
+		for(int i = 0; i < NumChars; i++)
+			apChars[i]->TickDeferedMove();
+		for(int i = 0; i < NumChars; i++)
+		{
+			CNetObj_CharacterCore Serial;
+			apChars[i]->Core()->Write(&Serial);
+			if(mem_comp(&Serial, &aParallel[i], sizeof(Serial)) != 0)
+			{
+				char aBuf[128];
+				str_format(aBuf, sizeof(aBuf), "parallel tick mismatch tick=%d cid=%d", Server()->Tick(), apChars[i]->GetPlayer()->GetCID());
+				GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "game", aBuf);
+			}
+		}
+	}
+	else
+		MoveCharactersParallel(apChars, NumChars);
+
+	for(int i = 0; i < NumChars; i++)
+		apChars[i]->TickDeferedPost();
+}
+
 // TODO: should be more general
 //CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CEntity *pNotThis)
 CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2& NewPos, CCharacter *pNotThis, int CollideWith, class CCharacter *pThisOnly)
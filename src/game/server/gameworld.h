@@ -40,6 +40,9 @@ private:
 
 	void UpdatePlayerMaps();
 
+	void TickDefered();
+	void MoveCharactersParallel(class CCharacter **apChars, int NumChars);
+
 public:
 	class CGameContext *GameServer() { return m_pGameServer; }
 	class IServer *Server() { return m_pServer; }
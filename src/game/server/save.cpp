@@ -249,12 +249,12 @@ int CSaveTeam::save(int Team)
 
 			for(int i=1; i < m_pController->GameServer()->Collision()->m_NumSwitchers+1; i++)
 			{
-				m_Switchers[i].m_Status = m_pController->GameServer()->Collision()->m_pSwitchers[i].m_Status[Team];
-				if(m_pController->GameServer()->Collision()->m_pSwitchers[i].m_EndTick[Team])
-					m_Switchers[i].m_EndTime = m_pController->Server()->Tick() - m_pController->GameServer()->Collision()->m_pSwitchers[i].m_EndTick[Team];
+				m_Switchers[i].m_Status = m_pController->GameServer()->Collision()->SwitchStatus(i, Team);
+				if(m_pController->GameServer()->Collision()->SwitchEndTick(i, Team))
+					m_Switchers[i].m_EndTime = m_pController->Server()->Tick() - m_pController->GameServer()->Collision()->SwitchEndTick(i, Team);
 				else
 					m_Switchers[i].m_EndTime = 0;
-				m_Switchers[i].m_Type = m_pController->GameServer()->Collision()->m_pSwitchers[i].m_Type[Team];
+				m_Switchers[i].m_Type = m_pController->GameServer()->Collision()->SwitchType(i, Team);
 			}
 		}
 		return 0;
@@ -300,10 +300,8 @@ int CSaveTeam::load(int Team)
 	if(m_pController->GameServer()->Collision()->m_NumSwitchers)
 		for(int i=1; i < m_pController->GameServer()->Collision()->m_NumSwitchers+1; i++)
 		{
-			m_pController->GameServer()->Collision()->m_pSwitchers[i].m_Status[Team] = m_Switchers[i].m_Status;
-			if(m_Switchers[i].m_EndTime)
-				m_pController->GameServer()->Collision()->m_pSwitchers[i].m_EndTick[Team] = m_pController->Server()->Tick() - m_Switchers[i].m_EndTime;
-			m_pController->GameServer()->Collision()->m_pSwitchers[i].m_Type[Team] = m_Switchers[i].m_Type;
+			int EndTick = m_Switchers[i].m_EndTime ? m_pController->Server()->Tick() - m_Switchers[i].m_EndTime : 0;
+			m_pController->GameServer()->Collision()->SetSwitchStatus(i, Team, m_Switchers[i].m_Status, EndTick, m_Switchers[i].m_Type);
 		}
 	return 0;
 }
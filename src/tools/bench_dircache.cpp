@@ -0,0 +1,128 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <engine/storage.h>
+
+// times the directory listings of the storage with and without the listing
+// cache over a folder of NUM_FILES files and NUM_FOLDERS subfolders in the
+// save path, FindFile has to search all subfolders for its file.
+
+enum
+{
+	NUM_FILES=10000,
+	NUM_FOLDERS=20,
+	NUM_RUNS=50,
+};
+
+static const char *s_pDir = "bench_dircache";
+static int s_Count = 0;
+
+static int CountCallback(const char *pName, int IsDir, int Type, void *pUser)
+{
+	s_Count++;
+	return 0;
+}
+
+static int CountInfoCallback(const char *pName, time_t Date, int IsDir, int Type, void *pUser)
+{
+	s_Count++;
+	return 0;
+}
+
+static void TouchFile(IStorage *pStorage, const char *pPath)
+{
+	IOHANDLE File = pStorage->OpenFile(pPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(File)
+		io_close(File);
+}
+
+static void Setup(IStorage *pStorage)
+{
+	char aPath[512];
+	str_format(aPath, sizeof(aPath), "%s/%d.demo", s_pDir, NUM_FILES-1);
+	IOHANDLE File = pStorage->OpenFile(aPath, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(File)
+	{
+		io_close(File);
+		return;
+	}
+
+	dbg_msg("bench_dircache", "creating %d files and %d folders in '%s'", NUM_FILES, NUM_FOLDERS, s_pDir);
+	pStorage->CreateFolder(s_pDir, IStorage::TYPE_SAVE);
+	for(int i = 0; i < NUM_FOLDERS; i++)
+	{
+		str_format(aPath, sizeof(aPath), "%s/folder%d", s_pDir, i);
+		pStorage->CreateFolder(aPath, IStorage::TYPE_SAVE);
+	}
+	str_format(aPath, sizeof(aPath), "%s/folder%d/target.map", s_pDir, NUM_FOLDERS-1);
+	TouchFile(pStorage, aPath);
+	for(int i = 0; i < NUM_FILES; i++)
+	{
+		str_format(aPath, sizeof(aPath), "%s/%d.demo", s_pDir, i);
+		TouchFile(pStorage, aPath);
+	}
+}
+
+static float Run(IStorage *pStorage, int Kind, bool Cached)
+{
+	char aBuf[512];
+	int64 StartTime = time_get();
+	for(int i = 0; i < NUM_RUNS; i++)
+	{
+		if(!Cached)
+			pStorage->RefreshDirectory(IStorage::TYPE_ALL, 0);
+		s_Count = 0;
+		if(Kind == 0)
+			pStorage->ListDirectory(IStorage::TYPE_SAVE, s_pDir, CountCallback, 0);
+		else if(Kind == 1)
+			pStorage->ListDirectoryInfo(IStorage::TYPE_SAVE, s_pDir, CountInfoCallback, 0);
+		else
+			s_Count = pStorage->FindFile("target.map", s_pDir, IStorage::TYPE_SAVE, aBuf, sizeof(aBuf));
+	}
+	return (time_get()-StartTime)*1000.0f/time_freq()/NUM_RUNS;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+	Setup(pStorage);
+
+	// listings of folders that changed within the last seconds aren't kept
+	char aPath[512];
+	pStorage->GetCompletePath(IStorage::TYPE_SAVE, s_pDir, aPath, sizeof(aPath));
+	while(fs_getmtime(aPath) >= time_timestamp()-1)
+		thread_sleep(100);
+
+	int64 StartTime = time_get();
+	for(int i = 0; i < NUM_RUNS; i++)
+		fs_listdir(aPath, CountCallback, 0, 0);
+	dbg_msg("bench_dircache", "fs_listdir %.3fms", (time_get()-StartTime)*1000.0f/time_freq()/NUM_RUNS);
+	StartTime = time_get();
+	for(int i = 0; i < NUM_RUNS; i++)
+		fs_listdir_info(aPath, CountInfoCallback, 0, 0);
+	dbg_msg("bench_dircache", "fs_listdir_info %.3fms", (time_get()-StartTime)*1000.0f/time_freq()/NUM_RUNS);
+
+	static const char *s_apNames[] = {"ListDirectory", "ListDirectoryInfo", "FindFile"};
+	for(int Kind = 0; Kind < 3; Kind++)
+	{
+		float Uncached = Run(pStorage, Kind, false);
+		float Cached = Run(pStorage, Kind, true);
+		dbg_msg("bench_dircache", "%s uncached %.3fms, cached %.3fms (%d)", s_apNames[Kind], Uncached, Cached, s_Count);
+	}
+
+	// a write through the storage drops the listing
+	str_format(aPath, sizeof(aPath), "%s/new.demo", s_pDir);
+	TouchFile(pStorage, aPath);
+	s_Count = 0;
+	pStorage->ListDirectory(IStorage::TYPE_SAVE, s_pDir, CountCallback, 0);
+	int NumAfterWrite = s_Count;
+	pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE);
+	s_Count = 0;
+	pStorage->ListDirectory(IStorage::TYPE_SAVE, s_pDir, CountCallback, 0);
+	dbg_msg("bench_dircache", "entries after a write %d, after removing it %d", NumAfterWrite, s_Count);
+	return 0;
+}
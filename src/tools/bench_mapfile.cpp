@@ -0,0 +1,138 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <engine/graphics.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/datafile.h>
+#include <engine/shared/png.h>
+
+#if defined(CONF_PLATFORM_LINUX)
+	#include <stdio.h>
+#endif
+
+// loads all data of every map and decodes every png in the storage paths,
+// then prints the time and the memory in use. files in the save path are
+// read into memory, the ones in later paths are mapped where possible, so
+// running it once with the data as save path and once with the data as a
+// later path compares both ways of loading. every map is opened twice, the
+// second open finds its crc cached like a map the server checked before.
+
+enum
+{
+	MAX_MAPS=256,
+};
+
+static IStorage *s_pStorage = 0;
+static CDataFileReader *s_apMaps[MAX_MAPS];
+static int s_NumMaps = 0;
+static int s_NumPngs = 0;
+static int64 s_DecodedSize = 0;
+static unsigned s_CrcSum = 0;
+static int64 s_aOpenTime[2] = {0, 0};
+
+static bool HasExtension(const char *pName, const char *pExtension)
+{
+	int Length = str_length(pName);
+	int ExtLength = str_length(pExtension);
+	return Length > ExtLength && str_comp_nocase(pName+Length-ExtLength, pExtension) == 0;
+}
+
+static void LoadMap(const char *pFilename, int StorageType)
+{
+	if(s_NumMaps == MAX_MAPS)
+		return;
+	CDataFileReader *pReader = new CDataFileReader;
+	int64 StartTime = time_get();
+	if(!pReader->Open(s_pStorage, pFilename, StorageType))
+	{
+		delete pReader;
+		return;
+	}
+	s_aOpenTime[0] += time_get()-StartTime;
+
+	CDataFileReader Again;
+	StartTime = time_get();
+	if(Again.Open(s_pStorage, pFilename, StorageType))
+		s_aOpenTime[1] += time_get()-StartTime;
+	Again.Close();
+
+	for(int i = 0; i < pReader->NumData(); i++)
+	{
+		pReader->GetData(i);
+		s_DecodedSize += pReader->GetUncompressedDataSize(i);
+		pReader->UnloadData(i);
+	}
+	s_CrcSum ^= pReader->Crc();
+	// the maps stay open like loaded maps do, with their files mapped
+	s_apMaps[s_NumMaps++] = pReader;
+}
+
+static void LoadPng(const char *pFilename, int StorageType)
+{
+	CImageInfo Img;
+	if(!CPngLoader::Load(s_pStorage, pFilename, StorageType, &Img))
+		return;
+	s_DecodedSize += Img.m_Width*Img.m_Height*(Img.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3);
+	mem_free(Img.m_pData);
+	s_NumPngs++;
+}
+
+static int ListCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	if(pName[0] == '.')
+		return 0;
+
+	char aPath[512];
+	if(((const char *)pUser)[0])
+		str_format(aPath, sizeof(aPath), "%s/%s", (const char *)pUser, pName);
+	else
+		str_copy(aPath, pName, sizeof(aPath));
+
+	if(IsDir)
+		s_pStorage->ListDirectory(StorageType, aPath, ListCallback, aPath);
+	else if(HasExtension(pName, ".map"))
+		LoadMap(aPath, StorageType);
+	else if(HasExtension(pName, ".png"))
+		LoadPng(aPath, StorageType);
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+	s_pStorage = pStorage;
+	g_Config.m_MapDecodeThreads = 0;
+
+	int64 StartTime = time_get();
+	pStorage->ListDirectory(IStorage::TYPE_ALL, "", ListCallback, (void *)"");
+	float Time = (time_get()-StartTime)*1000.0f/time_freq();
+
+	dbg_msg("bench_mapfile", "%d maps, %d pngs, %dk decoded in %.1fms, map crcs %08x", s_NumMaps, s_NumPngs, (int)(s_DecodedSize/1024), Time, s_CrcSum);
+	dbg_msg("bench_mapfile", "map opens %.1fms, again with the crc cached %.1fms",
+		s_aOpenTime[0]*1000.0f/time_freq(), s_aOpenTime[1]*1000.0f/time_freq());
+
+#if defined(CONF_PLATFORM_LINUX)
+	// anonymous memory is what was allocated, file backed memory the mappings
+	FILE *pStatus = fopen("/proc/self/status", "r");
+	if(pStatus)
+	{
+		char aLine[256];
+		while(fgets(aLine, sizeof(aLine), pStatus))
+			if(str_comp_num(aLine, "RssAnon:", 8) == 0 || str_comp_num(aLine, "RssFile:", 8) == 0 || str_comp_num(aLine, "VmHWM:", 6) == 0)
+			{
+				aLine[str_length(aLine)-1] = 0;
+				dbg_msg("bench_mapfile", "%s", aLine);
+			}
+		fclose(pStatus);
+	}
+#endif
+
+	for(int i = 0; i < s_NumMaps; i++)
+		delete s_apMaps[i];
+	return 0;
+}
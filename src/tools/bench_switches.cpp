@@ -0,0 +1,115 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+#include <base/math.h>
+#include <engine/shared/protocol.h>
+#include <game/collision.h>
+#include <game/mapitems.h>
+
+// times the per tick expiry of timed switches. the same random switch
+// activations are fed to the timer wheel of CCollision and to the arrays of
+// every switch and team that used to be scanned each tick.
+
+enum
+{
+	NUM_SWITCHERS=255,
+	NUM_TEAMS=MAX_CLIENTS+1,
+	NUM_TICKS=50*60*5,
+	TICK_SPEED=50,
+};
+
+struct CScanSwitcher
+{
+	bool m_Status[NUM_TEAMS];
+	int m_EndTick[NUM_TEAMS];
+	int m_Type[NUM_TEAMS];
+};
+
+static CScanSwitcher s_aScan[NUM_SWITCHERS+1];
+
+static void ScanTick(int Tick)
+{
+	for(int i = 0; i < NUM_SWITCHERS+1; i++)
+		for(int j = 0; j < NUM_TEAMS; j++)
+		{
+			if(s_aScan[i].m_EndTick[j] <= Tick && s_aScan[i].m_Type[j] == TILE_SWITCHTIMEDOPEN)
+			{
+				s_aScan[i].m_Status[j] = false;
+				s_aScan[i].m_EndTick[j] = 0;
+				s_aScan[i].m_Type[j] = TILE_SWITCHCLOSE;
+			}
+			else if(s_aScan[i].m_EndTick[j] <= Tick && s_aScan[i].m_Type[j] == TILE_SWITCHTIMEDCLOSE)
+			{
+				s_aScan[i].m_Status[j] = true;
+				s_aScan[i].m_EndTick[j] = 0;
+				s_aScan[i].m_Type[j] = TILE_SWITCHOPEN;
+			}
+		}
+}
+
+static unsigned NextRand(unsigned *pSeed)
+{
+	*pSeed = *pSeed*1103515245+12345;
+	return *pSeed>>16;
+}
+
+// activations per tick, roughly what a full server on a switch heavy map does
+static void Run(int ActivationsPerTick)
+{
+	CCollision Collision;
+	Collision.InitSwitches(NUM_SWITCHERS);
+	for(int i = 0; i < NUM_SWITCHERS+1; i++)
+		for(int j = 0; j < NUM_TEAMS; j++)
+		{
+			s_aScan[i].m_Status[j] = true;
+			s_aScan[i].m_EndTick[j] = 0;
+			s_aScan[i].m_Type[j] = 0;
+		}
+
+	unsigned Seed = 1;
+	int64 WheelTime = 0;
+	int64 ScanTime = 0;
+	int Mismatches = 0;
+	for(int Tick = 1; Tick <= NUM_TICKS; Tick++)
+	{
+		for(int a = 0; a < ActivationsPerTick; a++)
+		{
+			int Number = NextRand(&Seed)%NUM_SWITCHERS+1;
+			int Team = NextRand(&Seed)%NUM_TEAMS;
+			int Type = NextRand(&Seed)%2 ? TILE_SWITCHTIMEDOPEN : TILE_SWITCHTIMEDCLOSE;
+			int EndTick = Tick + NextRand(&Seed)%(10*TICK_SPEED);
+			bool Status = Type == TILE_SWITCHTIMEDOPEN;
+			Collision.SetSwitchStatus(Number, Team, Status, EndTick, Type);
+			s_aScan[Number].m_Status[Team] = Status;
+			s_aScan[Number].m_EndTick[Team] = EndTick;
+			s_aScan[Number].m_Type[Team] = Type;
+		}
+
+		int64 Start = time_get();
+		Collision.TickSwitches(Tick);
+		int64 Now = time_get();
+		WheelTime += Now-Start;
+		ScanTick(Tick);
+		ScanTime += time_get()-Now;
+
+		if(Tick%TICK_SPEED == 0)
+			for(int i = 1; i < NUM_SWITCHERS+1; i++)
+				for(int j = 0; j < NUM_TEAMS; j++)
+					if(Collision.SwitchStatus(i, j) != s_aScan[i].m_Status[j])
+						Mismatches++;
+	}
+
+	dbg_msg("bench_switches", "%3d activations/tick: wheel %7.3fus/tick, scan %7.3fus/tick, %d mismatches",
+		ActivationsPerTick, WheelTime*1000000.0f/time_freq()/NUM_TICKS, ScanTime*1000000.0f/time_freq()/NUM_TICKS, Mismatches);
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	Run(0);
+	Run(1);
+	Run(10);
+	Run(100);
+	return 0;
+}
@@ -0,0 +1,401 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <game/generated/protocol.h>
+
+#include <zlib.h>
+
+// runs one command over many demos, for example the demos/auto folder of a
+// server. every worker thread has its own player and takes the next demo when
+// it is done with one. results go to the output folder in the save path.
+
+enum
+{
+	COMMAND_VALIDATE=0,
+	COMMAND_POSITIONS,
+	COMMAND_REENCODE,
+	COMMAND_SLICE,
+
+	DEFAULT_THREADS=4,
+	MAX_THREADS=64,
+};
+
+struct CDemoTask
+{
+	char m_aFilename[256];
+	bool m_Ok;
+	char m_aResult[128];
+};
+
+static IStorage *s_pStorage = 0;
+static IConsole *s_pConsole = 0;
+static int s_Command = -1;
+static int s_SliceFrom = -1;
+static int s_SliceTo = -1;
+static const char *s_pOutput = "demos/processed";
+
+static CDemoTask *s_pTasks = 0;
+static int s_NumTasks = 0;
+static int s_TasksCapacity = 0;
+static int s_NextTask = 0;
+static LOCK s_TaskLock;
+
+static void AddTask(const char *pFilename)
+{
+	for(int i = 0; i < s_NumTasks; i++)
+		if(str_comp(s_pTasks[i].m_aFilename, pFilename) == 0)
+			return;
+
+	if(s_NumTasks == s_TasksCapacity)
+	{
+		s_TasksCapacity = max(s_TasksCapacity*2, 256);
+		CDemoTask *pTasks = (CDemoTask *)mem_alloc(s_TasksCapacity*sizeof(CDemoTask), 1);
+		if(s_pTasks)
+			mem_copy(pTasks, s_pTasks, s_NumTasks*sizeof(CDemoTask));
+		mem_free(s_pTasks);
+		s_pTasks = pTasks;
+	}
+	CDemoTask *pTask = &s_pTasks[s_NumTasks++];
+	str_copy(pTask->m_aFilename, pFilename, sizeof(pTask->m_aFilename));
+	pTask->m_Ok = false;
+	pTask->m_aResult[0] = 0;
+}
+
+static bool IsDemo(const char *pName)
+{
+	int Length = str_length(pName);
+	return Length > 5 && str_comp_nocase(pName+Length-5, ".demo") == 0;
+}
+
+static int ListDemoCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	if(!IsDir && IsDemo(pName))
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "%s/%s", (const char *)pUser, pName);
+		AddTask(aBuf);
+	}
+	return 0;
+}
+
+// keeps the folders of the demo below the output folder, demos with the same
+// name from different folders would overwrite each other otherwise
+static void OutputPath(const char *pFilename, const char *pExtension, char *pPath, int PathSize)
+{
+	str_copy(pPath, s_pOutput, PathSize);
+	const char *pComponent = pFilename;
+	while(*pComponent)
+	{
+		const char *pEnd = pComponent;
+		while(*pEnd && *pEnd != '/' && *pEnd != '\\')
+			pEnd++;
+		int Length = pEnd-pComponent;
+		bool Skip = Length == 0 || str_comp_num(pComponent, ".", Length) == 0 || str_comp_num(pComponent, "..", Length) == 0 ||
+			(Length == 2 && pComponent[1] == ':');
+		if(!Skip)
+		{
+			// the last component is the demo, without its extension
+			char aComponent[256];
+			str_copy(aComponent, pComponent, min(*pEnd ? Length+1 : Length-4, (int)sizeof(aComponent)));
+			str_append(pPath, "/", PathSize);
+			str_append(pPath, aComponent, PathSize);
+			if(*pEnd)
+				s_pStorage->CreateFolder(pPath, IStorage::TYPE_SAVE);
+		}
+		pComponent = *pEnd ? pEnd+1 : pEnd;
+	}
+	str_append(pPath, pExtension, PathSize);
+}
+
+class CDemoJob : public CDemoPlayer::IListner
+{
+	CSnapshotDelta m_SnapshotDelta;
+	CDemoPlayer m_Player;
+	CDemoRecorder m_Recorder;
+	IOHANDLE m_PositionsFile;
+	int m_NumSnapshots;
+	int m_NumTickErrors;
+	int m_LastTick;
+
+	// the map embedded in the demo, its crc is checked against the header
+	unsigned char *ReadMap(const char *pFilename, unsigned *pSize, unsigned *pCrc)
+	{
+		const CDemoPlayer::CPlaybackInfo *pInfo = m_Player.Info();
+		const CDemoHeader *pHeader = &pInfo->m_Header;
+		unsigned Size = (pHeader->m_aMapSize[0]<<24) | (pHeader->m_aMapSize[1]<<16) | (pHeader->m_aMapSize[2]<<8) | pHeader->m_aMapSize[3];
+		*pSize = Size;
+		*pCrc = 0;
+		if(!Size)
+			return 0;
+
+		IOHANDLE File = s_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+		if(!File)
+			return 0;
+		io_skip(File, sizeof(CDemoHeader));
+		if(pHeader->m_Version > 3)
+			io_skip(File, sizeof(CTimelineMarkers));
+		unsigned char *pData = (unsigned char *)mem_alloc(Size, 1);
+		if(io_read(File, pData, Size) != Size)
+		{
+			mem_free(pData);
+			pData = 0;
+		}
+		else
+			*pCrc = crc32(0, pData, Size);
+		io_close(File);
+		return pData;
+	}
+
+	bool InRange(int Tick)
+	{
+		if(s_Command != COMMAND_SLICE)
+			return true;
+		if(s_SliceTo != -1 && Tick > s_SliceTo)
+		{
+			m_Player.Pause();
+			return false;
+		}
+		return s_SliceFrom == -1 || Tick >= s_SliceFrom;
+	}
+
+	virtual void OnDemoPlayerSnapshot(void *pData, int Size)
+	{
+		int Tick = m_Player.Info()->m_Info.m_CurrentTick;
+		m_NumSnapshots++;
+		if(Tick <= m_LastTick)
+			m_NumTickErrors++;
+		m_LastTick = Tick;
+
+		if(m_PositionsFile)
+		{
+			CSnapshot *pSnap = (CSnapshot *)pData;
+			for(int i = 0; i < pSnap->NumItems(); i++)
+			{
+				CSnapshotItem *pItem = pSnap->GetItem(i);
+				if(pItem->Type() != NETOBJTYPE_CHARACTER)
+					continue;
+				const CNetObj_Character *pChar = (const CNetObj_Character *)pItem->Data();
+				char aLine[64];
+				str_format(aLine, sizeof(aLine), "%d,%d,%d,%d", Tick, pItem->ID(), pChar->m_X, pChar->m_Y);
+				io_write(m_PositionsFile, aLine, str_length(aLine));
+				io_write_newline(m_PositionsFile);
+			}
+		}
+
+		if((s_Command == COMMAND_REENCODE || s_Command == COMMAND_SLICE) && InRange(Tick))
+			m_Recorder.RecordSnapshot(Tick, pData, Size);
+	}
+
+	virtual void OnDemoPlayerMessage(void *pData, int Size)
+	{
+		if((s_Command == COMMAND_REENCODE || s_Command == COMMAND_SLICE) && InRange(m_Player.Info()->m_Info.m_CurrentTick))
+			m_Recorder.RecordMessage(pData, Size);
+	}
+
+public:
+	CJob m_Job;
+
+	CDemoJob() : m_Player(&m_SnapshotDelta), m_Recorder(&m_SnapshotDelta, true)
+	{
+		// the demos were recorded with the static item sizes of the protocol
+		CNetObjHandler NetObjHandler;
+		for(int i = 0; i < NUM_NETOBJTYPES; i++)
+			m_SnapshotDelta.SetStaticsize(i, NetObjHandler.GetObjSize(i));
+		m_Player.SetListner(this);
+	}
+
+	void Process(CDemoTask *pTask)
+	{
+		if(m_Player.Load(s_pStorage, s_pConsole, pTask->m_aFilename, IStorage::TYPE_ALL) != 0)
+		{
+			str_copy(pTask->m_aResult, "could not load", sizeof(pTask->m_aResult));
+			return;
+		}
+
+		// demos recorded without the map only carry its name and crc,
+		// the positions don't need it at all
+		const CDemoPlayer::CMapInfo *pMapInfo = m_Player.GetMapInfo();
+		unsigned MapSize = 0, MapCrc = 0;
+		unsigned char *pMapData = 0;
+		if(s_Command != COMMAND_POSITIONS)
+		{
+			pMapData = ReadMap(pTask->m_aFilename, &MapSize, &MapCrc);
+			if(MapSize && (!pMapData || MapCrc != (unsigned)pMapInfo->m_Crc))
+			{
+				str_format(pTask->m_aResult, sizeof(pTask->m_aResult), "map crc mismatch, header=%08x data=%08x", pMapInfo->m_Crc, MapCrc);
+				mem_free(pMapData);
+				m_Player.Stop();
+				return;
+			}
+		}
+
+		char aPath[512];
+		bool Recording = false;
+		bool OutputFailed = false;
+		m_PositionsFile = 0;
+		if(s_Command == COMMAND_POSITIONS)
+		{
+			OutputPath(pTask->m_aFilename, ".csv", aPath, sizeof(aPath));
+			m_PositionsFile = s_pStorage->OpenFile(aPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+			OutputFailed = !m_PositionsFile;
+		}
+		else if(s_Command == COMMAND_REENCODE || s_Command == COMMAND_SLICE)
+		{
+			const CDemoHeader *pHeader = &m_Player.Info()->m_Header;
+			OutputPath(pTask->m_aFilename, ".demo", aPath, sizeof(aPath));
+			Recording = m_Recorder.Start(s_pStorage, s_pConsole, aPath, pHeader->m_aNetversion, pMapInfo->m_aName, pMapInfo->m_Crc, pHeader->m_aType, MapSize, pMapData) == 0;
+			OutputFailed = !Recording;
+		}
+
+		m_NumSnapshots = 0;
+		m_NumTickErrors = 0;
+		m_LastTick = -1;
+		m_Player.Play();
+		while(m_Player.IsPlaying() && !m_Player.Info()->m_Info.m_Paused)
+			m_Player.Update(false);
+
+		// the player stops on broken chunks and pauses at the end of the file
+		bool Complete = m_Player.IsPlaying();
+		int LastTick = m_Player.Info()->m_Info.m_LastTick;
+		m_Player.Stop();
+
+		if(m_PositionsFile)
+			io_close(m_PositionsFile);
+		if(Recording)
+			m_Recorder.Stop(true);
+		mem_free(pMapData);
+
+		if(!Complete)
+			str_format(pTask->m_aResult, sizeof(pTask->m_aResult), "broken after tick %d of %d", m_LastTick, LastTick);
+		else if(m_NumTickErrors)
+			str_format(pTask->m_aResult, sizeof(pTask->m_aResult), "%d ticks out of order", m_NumTickErrors);
+		else if(OutputFailed)
+			str_format(pTask->m_aResult, sizeof(pTask->m_aResult), "could not write '%s'", aPath);
+		else
+		{
+			str_format(pTask->m_aResult, sizeof(pTask->m_aResult), "%d snapshots, ticks %d-%d", m_NumSnapshots, m_Player.Info()->m_Info.m_FirstTick, LastTick);
+			pTask->m_Ok = true;
+		}
+	}
+};
+
+static int DemoJob(void *pData)
+{
+	CDemoJob *pJob = (CDemoJob *)pData;
+	while(1)
+	{
+		lock_wait(s_TaskLock);
+		int Task = s_NextTask < s_NumTasks ? s_NextTask++ : -1;
+		lock_unlock(s_TaskLock);
+		if(Task == -1)
+			break;
+		pJob->Process(&s_pTasks[Task]);
+	}
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	int NumThreads = DEFAULT_THREADS;
+	int Arg = 1;
+	for(; Arg < argc && argv[Arg][0] == '-'; Arg++)
+	{
+		if(str_comp(argv[Arg], "-j") == 0 && Arg+1 < argc)
+			NumThreads = clamp(str_toint(argv[++Arg]), 1, (int)MAX_THREADS);
+		else if(str_comp(argv[Arg], "-o") == 0 && Arg+1 < argc)
+			s_pOutput = argv[++Arg];
+	}
+
+	if(Arg < argc)
+	{
+		if(str_comp(argv[Arg], "validate") == 0)
+			s_Command = COMMAND_VALIDATE;
+		else if(str_comp(argv[Arg], "positions") == 0)
+			s_Command = COMMAND_POSITIONS;
+		else if(str_comp(argv[Arg], "reencode") == 0)
+			s_Command = COMMAND_REENCODE;
+		else if(str_comp(argv[Arg], "slice") == 0 && Arg+2 < argc)
+		{
+			s_Command = COMMAND_SLICE;
+			s_SliceFrom = str_toint(argv[++Arg]);
+			s_SliceTo = str_toint(argv[++Arg]);
+		}
+		Arg++;
+	}
+
+	if(s_Command == -1 || Arg >= argc)
+	{
+		dbg_msg("usage", "%s [-j threads] [-o output folder] <validate|positions|reencode|slice <from tick> <to tick>> <demos or folders>", argv[0]);
+		return -1;
+	}
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+	s_pStorage = pStorage;
+	s_pConsole = CreateConsole(CFGFLAG_SERVER);
+
+	// the player writes the embedded maps and the keyframe indices
+	pStorage->CreateFolder("downloadedmaps", IStorage::TYPE_SAVE);
+	pStorage->CreateFolder("democache", IStorage::TYPE_SAVE);
+	if(s_Command != COMMAND_VALIDATE)
+		pStorage->CreateFolder(s_pOutput, IStorage::TYPE_SAVE);
+
+	for(; Arg < argc; Arg++)
+	{
+		if(IsDemo(argv[Arg]))
+			AddTask(argv[Arg]);
+		else
+			pStorage->ListDirectory(IStorage::TYPE_ALL, argv[Arg], ListDemoCallback, (void *)argv[Arg]);
+	}
+	if(!s_NumTasks)
+	{
+		dbg_msg("demo_tool", "no demos found");
+		return -1;
+	}
+
+	CNetBase::Init();
+	s_TaskLock = lock_create();
+	int64 StartTime = time_get();
+
+	// the calling thread is the first worker
+	NumThreads = min(NumThreads, s_NumTasks);
+	static CJobPool s_Pool;
+	if(NumThreads > 1)
+		s_Pool.Init(NumThreads-1);
+	CDemoJob **ppJobs = new CDemoJob*[NumThreads];
+	for(int i = 0; i < NumThreads; i++)
+		ppJobs[i] = new CDemoJob();
+	for(int i = 1; i < NumThreads; i++)
+		s_Pool.Add(&ppJobs[i]->m_Job, DemoJob, ppJobs[i]);
+	DemoJob(ppJobs[0]);
+	for(int i = 1; i < NumThreads; i++)
+		s_Pool.Wait(&ppJobs[i]->m_Job);
+
+	int NumFailed = 0;
+	for(int i = 0; i < s_NumTasks; i++)
+	{
+		dbg_msg("demo_tool", "%s %s: %s", s_pTasks[i].m_Ok ? "ok" : "FAILED", s_pTasks[i].m_aFilename, s_pTasks[i].m_aResult);
+		if(!s_pTasks[i].m_Ok)
+			NumFailed++;
+	}
+	dbg_msg("demo_tool", "%d demos, %d failed, %.2fs with %d threads", s_NumTasks, NumFailed,
+		(time_get()-StartTime)/(float)time_freq(), NumThreads);
+
+	for(int i = 0; i < NumThreads; i++)
+		delete ppJobs[i];
+	delete[] ppJobs;
+	lock_destroy(s_TaskLock);
+	mem_free(s_pTasks);
+	return NumFailed ? 1 : 0;
+}
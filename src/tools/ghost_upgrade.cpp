@@ -0,0 +1,126 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/storage.h>
+#include <engine/shared/ghost.h>
+#include <engine/shared/network.h>
+#include <game/generated/protocol.h>
+
+// rewrites ghosts in the current format. the new file is written next to the
+// old one and renamed over it, ghosts that are up to date are left alone.
+
+static IStorage *s_pStorage = 0;
+static int s_NumUpgraded = 0;
+static int s_NumFailed = 0;
+
+static void Upgrade(const char *pFilename)
+{
+	IOHANDLE File = s_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		dbg_msg("ghost_upgrade", "failed to open '%s'", pFilename);
+		s_NumFailed++;
+		return;
+	}
+
+	CGhostReader Reader;
+	CNetObj_ClientInfo Info;
+	if(!Reader.Open(File, &Info, sizeof(Info)))
+	{
+		dbg_msg("ghost_upgrade", "'%s' is not a ghost", pFilename);
+		s_NumFailed++;
+		return;
+	}
+	if(Reader.Header()->m_Version == CGhostReader::VERSION_DELTA)
+		return;
+
+	int Num = Reader.NumSamples();
+	CGhostCharacter *pSamples = (CGhostCharacter *)mem_alloc(max(Num, 1)*sizeof(CGhostCharacter), 1);
+	for(int i = 0; i < Num; i++)
+	{
+		const CGhostCharacter *pSample = Reader.Sample(i);
+		if(!pSample)
+		{
+			Num = i;
+			break;
+		}
+		pSamples[i] = *pSample;
+	}
+	CGhostHeader Header = *Reader.Header();
+	Reader.Close();
+
+	// the broken part could still be recovered by hand, don't lose it
+	if(Num < Header.m_NumShots)
+	{
+		dbg_msg("ghost_upgrade", "%s: only %d of %d samples could be read, keeping the old file", pFilename, Num, Header.m_NumShots);
+		mem_free(pSamples);
+		s_NumFailed++;
+		return;
+	}
+
+	char aTmp[512];
+	str_format(aTmp, sizeof(aTmp), "%s.tmp", pFilename);
+	File = s_pStorage->OpenFile(aTmp, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	bool Written = File && CGhostWriter::Write(File, &Header, &Info, sizeof(Info), pSamples, Num);
+	if(File)
+		io_close(File);
+	mem_free(pSamples);
+
+	if(!Written || !s_pStorage->RenameFile(aTmp, pFilename, IStorage::TYPE_SAVE))
+	{
+		dbg_msg("ghost_upgrade", "failed to write '%s'", pFilename);
+		s_pStorage->RemoveFile(aTmp, IStorage::TYPE_SAVE);
+		s_NumFailed++;
+		return;
+	}
+
+	dbg_msg("ghost_upgrade", "%s: %d samples", pFilename, Num);
+	s_NumUpgraded++;
+}
+
+static bool IsGhost(const char *pName)
+{
+	int Length = str_length(pName);
+	return Length > 4 && str_comp_nocase(pName+Length-4, ".gho") == 0;
+}
+
+static int ListGhostCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	if(!IsDir && IsGhost(pName))
+	{
+		char aBuf[512];
+		str_format(aBuf, sizeof(aBuf), "%s/%s", (const char *)pUser, pName);
+		Upgrade(aBuf);
+	}
+	return 0;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+	{
+		dbg_msg("usage", "%s [ghost files or folders, ghosts by default]", argv[0]);
+		return -1;
+	}
+	s_pStorage = pStorage;
+
+	// version 2 ghosts are huffman compressed
+	CNetBase::Init();
+
+	if(argc < 2)
+		pStorage->ListDirectory(IStorage::TYPE_SAVE, "ghosts", ListGhostCallback, (void *)"ghosts");
+	for(int i = 1; i < argc; i++)
+	{
+		if(IsGhost(argv[i]))
+			Upgrade(argv[i]);
+		else
+			pStorage->ListDirectory(IStorage::TYPE_SAVE, argv[i], ListGhostCallback, (void *)argv[i]);
+	}
+
+	dbg_msg("ghost_upgrade", "%d upgraded, %d failed", s_NumUpgraded, s_NumFailed);
+	return s_NumFailed ? 1 : 0;
+}
@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
@@ -13,8 +14,11 @@ int main(int argc, const char **argv)
 	CDataFileReader DataFile;
 	CDataFileWriter df;
 
-	if(!pStorage || argc != 3)
+	if(!pStorage || argc < 3 || argc > 4)
+	{
+		dbg_msg("usage", "%s <source map> <destination map> [compression level 0-9]", argv[0]);
 		return -1;
+	}
 
 	str_format(aFileName, sizeof(aFileName), "%s", argv[2]);
 
@@ -22,6 +26,8 @@ int main(int argc, const char **argv)
 		return -1;
 	if(!df.Open(pStorage, aFileName))
 		return -1;
+	if(argc == 4)
+		df.SetCompressionLevel(clamp(str_toint(argv[3]), 0, 9));
 
 	// add all items
 	for(Index = 0; Index < DataFile.NumItems(); Index++)
@@ -0,0 +1,199 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/graphics.h>
+#include <engine/shared/datafile.h>
+#include <engine/shared/png.h>
+#include <engine/shared/texconv.h>
+#include <engine/storage.h>
+#include <game/mapitems.h>
+
+// fills texcache/ ahead of time with the files the client would write on the
+// first load. pngs are keyed by their file, embedded map images by their pixels.
+
+static int s_Options = 0;
+static bool s_Check = false;
+static const char *s_pOutput = 0;
+
+// the texels expanded again have to be within the precision of their format,
+// and untwiddling has to give back the texels that were twiddled
+static bool CheckRoundTrip(const char *pName, int Width, int Height, int Format, const unsigned char *pData)
+{
+	static const int s_aaBits[CTextureConverter::NUM_FORMATS][4] = {{5, 6, 5, 8}, {5, 5, 5, 1}, {4, 4, 4, 4}};
+
+	unsigned char *pTmpData = CTextureConverter::Downscale(&Width, &Height, Format, pData, s_Options);
+	if(pTmpData)
+		pData = pTmpData;
+
+	int Bpp = Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int DstFormat = CTextureConverter::ChooseFormat(Format, pData, Width, Height);
+	unsigned short *pTexels = (unsigned short *)mem_alloc(Width*Height*sizeof(unsigned short), 1);
+	unsigned char *pRgba = (unsigned char *)mem_alloc(Width*Height*4, 1);
+	CTextureConverter::Convert(Format, pData, Width, Height, DstFormat, pTexels);
+	CTextureConverter::Expand(DstFormat, pTexels, Width, Height, pRgba);
+
+	int Mismatches = 0;
+	for(int i = 0; i < Width*Height; i++)
+		for(int c = 0; c < 4; c++)
+		{
+			int In = c < Bpp ? pData[i*Bpp+c] : 255;
+			if(absolute(In-pRgba[i*4+c]) > (1<<(8-s_aaBits[DstFormat][c]))-1)
+				Mismatches++;
+		}
+
+	bool Twiddled = CTextureConverter::CanTwiddle(Width, Height);
+	bool Untwiddled = true;
+	if(Twiddled)
+	{
+		unsigned short *pTwiddled = (unsigned short *)mem_alloc(Width*Height*sizeof(unsigned short), 1);
+		unsigned short *pBack = (unsigned short *)mem_alloc(Width*Height*sizeof(unsigned short), 1);
+		CTextureConverter::Twiddle(pTexels, Width, Height, pTwiddled);
+		CTextureConverter::Untwiddle(pTwiddled, Width, Height, pBack);
+		Untwiddled = mem_comp(pBack, pTexels, Width*Height*sizeof(unsigned short)) == 0;
+		mem_free(pTwiddled);
+		mem_free(pBack);
+	}
+
+	mem_free(pTexels);
+	mem_free(pRgba);
+	if(pTmpData)
+		mem_free(pTmpData);
+
+	if(Mismatches || !Untwiddled)
+	{
+		dbg_msg("texconv", "%s: round trip failed, %d channels off, twiddling %s", pName, Mismatches, Untwiddled ? "ok" : "failed");
+		return false;
+	}
+	dbg_msg("texconv", "%s: round trip ok, %dx%d format=%d%s", pName, Width, Height, DstFormat, Twiddled ? " twiddled" : "");
+	return true;
+}
+
+static bool WriteCache(unsigned Hash, int Width, int Height, int Format, const unsigned char *pData)
+{
+	char aName[64];
+	CTextureConverter::CacheName(aName, sizeof(aName), Hash, s_Options);
+	if(s_Check && !CheckRoundTrip(aName, Width, Height, Format, pData))
+		return false;
+
+	CTextureConverter::CHeader Header;
+	unsigned short *pTexels = CTextureConverter::Build(Width, Height, Format, pData, s_Options, true, &Header);
+	if(!pTexels)
+		return false;
+	Header.m_Hash = Hash;
+
+	char aPath[1024];
+	str_format(aPath, sizeof(aPath), "%s/%s", s_pOutput, aName);
+
+	bool Result = false;
+	IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+	if(File)
+	{
+		Result = CTextureConverter::Save(File, &Header, pTexels);
+		io_close(File);
+	}
+	mem_free(pTexels);
+
+	if(Result)
+		dbg_msg("texconv", "%s: %dx%d format=%d flags=%d", aName, Header.m_Width, Header.m_Height, Header.m_Format, Header.m_Flags);
+	else
+		dbg_msg("texconv", "failed to write '%s'", aPath);
+	return Result;
+}
+
+static int ConvertPNG(const char *pFilename)
+{
+	// the hash and the pixels come from the same read, like in the client
+	IOMAP Map;
+	if(!io_map(pFilename, &Map, IOMAP_FALLBACK))
+	{
+		dbg_msg("texconv", "failed to open '%s'", pFilename);
+		return 1;
+	}
+	unsigned Hash = CTextureConverter::Hash(Map.data, Map.size);
+
+	CImageInfo Img;
+	bool Loaded = CPngLoader::Load(&Map, pFilename, &Img);
+	io_unmap(&Map);
+	if(!Loaded)
+		return 1;
+
+	bool Result = WriteCache(Hash, Img.m_Width, Img.m_Height, Img.m_Format, (const unsigned char *)Img.m_pData);
+	mem_free(Img.m_pData);
+	return Result ? 0 : 1;
+}
+
+static int ConvertMap(IStorage *pStorage, const char *pFilename)
+{
+	CDataFileReader Map;
+	if(!Map.Open(pStorage, pFilename, IStorage::TYPE_ALL))
+	{
+		dbg_msg("texconv", "failed to open '%s'", pFilename);
+		return 1;
+	}
+
+	int Start, Num;
+	int Errors = 0;
+	Map.GetType(MAPITEMTYPE_IMAGE, &Start, &Num);
+	for(int i = 0; i < Num; i++)
+	{
+		CMapItemImage *pImg = (CMapItemImage *)Map.GetItem(Start+i, 0, 0);
+		if(pImg->m_External)
+			continue;
+
+		const unsigned char *pData = (const unsigned char *)Map.GetData(pImg->m_ImageData);
+		unsigned Hash = CTextureConverter::Hash(pData, pImg->m_Width*pImg->m_Height*4);
+		if(!WriteCache(Hash, pImg->m_Width, pImg->m_Height, CImageInfo::FORMAT_RGBA, pData))
+			Errors++;
+		Map.UnloadData(pImg->m_ImageData);
+	}
+	Map.Close();
+	return Errors ? 1 : 0;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	int Arg = 1;
+	for(; Arg < argc && argv[Arg][0] == '-'; Arg++)
+	{
+		if(str_comp(argv[Arg], "-lowquality") == 0)
+			s_Options |= CTextureConverter::OPTION_LOWQUALITY;
+		else if(str_comp(argv[Arg], "-noresample") == 0)
+			s_Options |= CTextureConverter::OPTION_NORESAMPLE;
+		else if(str_comp(argv[Arg], "-check") == 0)
+			s_Check = true;
+		else
+		{
+			dbg_msg("texconv", "unknown option '%s'", argv[Arg]);
+			break;
+		}
+	}
+
+	if(argc - Arg < 2 || argv[Arg][0] == '-')
+	{
+		dbg_msg("usage", "%s [-lowquality] [-noresample] [-check] <data dir> <png or map files>", argv[0]);
+		return -1;
+	}
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+
+	s_pOutput = argv[Arg++];
+	char aPath[1024];
+	str_format(aPath, sizeof(aPath), "%s/texcache", s_pOutput);
+	fs_makedir(aPath);
+
+	int Errors = 0;
+	for(; Arg < argc; Arg++)
+	{
+		int Length = str_length(argv[Arg]);
+		if(Length > 4 && str_comp_nocase(argv[Arg]+Length-4, ".map") == 0)
+			Errors += ConvertMap(pStorage, argv[Arg]);
+		else
+			Errors += ConvertPNG(argv[Arg]);
+	}
+	return Errors ? 1 : 0;
+}